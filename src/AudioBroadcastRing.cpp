@@ -0,0 +1,135 @@
+#include "AudioBroadcastRing.h"
+
+#include <algorithm>
+
+AudioBroadcastRing::Reader::Reader(const AudioBroadcastRing* ring, size_t position)
+    : _ring(ring)
+    , _position(position)
+{
+}
+
+AudioBroadcastRing::ReadStatus AudioBroadcastRing::Reader::Read(float* samples, size_t maxCount, size_t& count)
+{
+    count = 0;
+
+    const auto capacity = _ring->Capacity();
+    const auto writePosition = _ring->_writePosition.load(std::memory_order_acquire);
+    if (writePosition - _position > capacity)
+    {
+        _position = writePosition;
+        return ReadStatus::Lagged;
+    }
+
+    const auto readCount = std::min(maxCount, writePosition - _position);
+    if (readCount == 0)
+    {
+        return ReadStatus::Ok;
+    }
+
+    // The producer may overwrite the slots while they are copied. Relaxed loads make this well-defined and
+    // compile to plain moves, the check below then discards a copy which may be torn.
+    for (size_t index = 0; index < readCount; index++)
+    {
+        samples[index] = _ring->_buffer[(_position + index) & _ring->_mask].load(std::memory_order_relaxed);
+    }
+
+    // The acquire fence pairs with the release fence in BeginWrite(): if the copy saw any newly written
+    // sample, the announcement of that write is visible here as well.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_ring->_writeEnd.load(std::memory_order_relaxed) - _position > capacity)
+    {
+        _position = _ring->_writePosition.load(std::memory_order_acquire);
+        return ReadStatus::Lagged;
+    }
+
+    _position += readCount;
+    count = readCount;
+
+    return ReadStatus::Ok;
+}
+
+size_t AudioBroadcastRing::Reader::Discard(size_t count)
+{
+    count = std::min(count, Available());
+    _position += count;
+
+    return count;
+}
+
+size_t AudioBroadcastRing::Reader::Available() const
+{
+    return _ring->_writePosition.load(std::memory_order_acquire) - _position;
+}
+
+void AudioBroadcastRing::Reader::SkipToLatest()
+{
+    _position = _ring->_writePosition.load(std::memory_order_acquire);
+}
+
+size_t AudioBroadcastRing::Reader::Position() const
+{
+    return _position;
+}
+
+AudioBroadcastRing::AudioBroadcastRing(size_t minimumCapacity)
+{
+    size_t capacity{1};
+    while (capacity < minimumCapacity)
+    {
+        capacity <<= 1;
+    }
+
+    _buffer.reset(new std::atomic<float>[capacity]);
+    for (size_t index = 0; index < capacity; index++)
+    {
+        _buffer[index].store(0.0f, std::memory_order_relaxed);
+    }
+    _mask = capacity - 1;
+}
+
+void AudioBroadcastRing::Write(const float* samples, size_t count)
+{
+    if (count > Capacity())
+    {
+        samples += count - Capacity();
+        count = Capacity();
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    const auto writePosition = _writePosition.load(std::memory_order_relaxed);
+    BeginWrite(writePosition + count);
+
+    for (size_t index = 0; index < count; index++)
+    {
+        _buffer[(writePosition + index) & _mask].store(samples[index], std::memory_order_relaxed);
+    }
+
+    _writePosition.store(writePosition + count, std::memory_order_release);
+}
+
+AudioBroadcastRing::Reader AudioBroadcastRing::CreateReader() const
+{
+    return {this, _writePosition.load(std::memory_order_acquire)};
+}
+
+size_t AudioBroadcastRing::WritePosition() const
+{
+    return _writePosition.load(std::memory_order_acquire);
+}
+
+size_t AudioBroadcastRing::Capacity() const
+{
+    return _mask + 1;
+}
+
+void AudioBroadcastRing::BeginWrite(size_t end)
+{
+    _writeEnd.store(end, std::memory_order_relaxed);
+
+    // Orders the announcement before the sample stores following it, see Reader::Read().
+    std::atomic_thread_fence(std::memory_order_release);
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "CacheLineAligned.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief Lock-free single-producer/multi-consumer ring buffer for interleaved float samples.
+ *
+ * Distributes one captured stream to any number of consumers, e.g. projectM and additional analyzers.
+ * The producer writes each sample exactly once and never waits for a consumer: if the ring is full, the
+ * oldest samples are overwritten. Each consumer owns a Reader with its own read position, so consumers
+ * don't affect each other or the producer.
+ *
+ * A reader which fell behind by more than the capacity can't get its data back. Instead of returning
+ * samples which were overwritten, possibly while they were being copied, Read() reports this with
+ * ReadStatus::Lagged and moves the reader to the newest sample. To detect overwrites during the copy,
+ * the producer announces the range it is about to write before writing it, and each read checks the
+ * announcement after copying, like a sequence lock. The samples are stored as relaxed atomics, so a copy
+ * racing with the producer is well-defined and merely discarded, instead of being a data race.
+ *
+ * All memory is allocated once in the constructor, so neither side allocates or locks. The producer's
+ * positions and the sample storage start separate cache lines. This only holds for heap instances, which
+ * are aligned by CacheLineAligned, so owners should hold the ring by pointer.
+ */
+class AudioBroadcastRing : public CacheLineAligned
+{
+public:
+    /**
+     * @brief Result of a read.
+     */
+    enum class ReadStatus
+    {
+        Ok, //!< The returned samples are valid. May be zero samples if none were available.
+        Lagged //!< The reader fell behind and lost data. No samples were returned, the reader continues with the newest data.
+    };
+
+    /**
+     * @brief Read position of a single consumer.
+     *
+     * Obtained from AudioBroadcastRing::CreateReader(). Each reader may only be used by one thread at a time,
+     * and must not outlive the ring it was created from.
+     */
+    class Reader
+    {
+    public:
+        /**
+         * @brief Copies the next samples into the given memory.
+         * @param samples Destination memory with space for at least @a maxCount floats.
+         * @param maxCount Maximum number of floats to read.
+         * @param count Receives the number of floats actually read.
+         * @return ReadStatus::Lagged if the requested samples were overwritten, ReadStatus::Ok otherwise.
+         */
+        ReadStatus Read(float* samples, size_t maxCount, size_t& count);
+
+        /**
+         * @brief Skips up to the given number of samples without copying them.
+         * @param count Maximum number of floats to skip.
+         * @return The number of floats actually skipped.
+         */
+        size_t Discard(size_t count);
+
+        /**
+         * @brief Returns the number of floats written since the reader's position.
+         *
+         * If this exceeds the ring's capacity, the reader has lagged and the next Read() will fail unless
+         * enough samples are discarded first.
+         *
+         * @return The number of unread floats.
+         */
+        size_t Available() const;
+
+        /**
+         * @brief Moves the reader to the newest sample, dropping everything not yet read.
+         */
+        void SkipToLatest();
+
+        /**
+         * @brief Returns the reader's position in the stream.
+         * @return The total number of floats written to the ring before the next one to read.
+         */
+        size_t Position() const;
+
+    protected:
+        friend class AudioBroadcastRing;
+
+        /**
+         * @brief Constructor.
+         * @param ring The ring to read from.
+         * @param position The initial read position.
+         */
+        Reader(const AudioBroadcastRing* ring, size_t position);
+
+        const AudioBroadcastRing* _ring{nullptr}; //!< The ring this reader belongs to.
+        size_t _position{0}; //!< Total number of floats written before the next one to read.
+    };
+
+    AudioBroadcastRing() = delete;
+    AudioBroadcastRing(const AudioBroadcastRing& other) = delete;
+    AudioBroadcastRing& operator=(const AudioBroadcastRing& other) = delete;
+
+    /**
+     * @brief Constructor.
+     * @param minimumCapacity The minimum number of floats the buffer should hold. Will be rounded up
+     *                        to the next power of two.
+     */
+    explicit AudioBroadcastRing(size_t minimumCapacity);
+
+    /**
+     * @brief Appends samples to the buffer, overwriting the oldest ones if required. Producer side only.
+     *
+     * The caller is responsible for keeping the count a multiple of the channel count. If more samples than
+     * the capacity are passed, only the newest ones are stored.
+     *
+     * @param samples Pointer to the samples to copy.
+     * @param count Number of floats to write.
+     */
+    void Write(const float* samples, size_t count);
+
+    /**
+     * @brief Creates a new reader starting at the newest sample.
+     * @return The reader. Can be called from any thread.
+     */
+    Reader CreateReader() const;
+
+    /**
+     * @brief Returns the producer's position in the stream.
+     * @return The total number of floats published so far.
+     */
+    size_t WritePosition() const;
+
+    /**
+     * @brief Returns the total capacity of the buffer.
+     * @return The capacity in floats.
+     */
+    size_t Capacity() const;
+
+protected:
+    /**
+     * @brief Announces that the slots up to the given position are about to be overwritten.
+     * @param end The total number of floats written after the pending write.
+     */
+    void BeginWrite(size_t end);
+
+    alignas(CacheLineSize) std::atomic<size_t> _writePosition{0}; //!< Total number of floats published. Only modified by the producer.
+    std::atomic<size_t> _writeEnd{0}; //!< End of the range currently being written. Only modified by the producer.
+
+    alignas(CacheLineSize) size_t _mask{0}; //!< Capacity minus one, used to wrap positions into the buffer. Never modified, so kept off the positions' line.
+    std::unique_ptr<std::atomic<float>[]> _buffer; //!< The sample storage, _mask + 1 slots.
+};
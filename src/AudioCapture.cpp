@@ -1,15 +1,33 @@
 #include "AudioCapture.h"
 
-#include AUDIO_IMPL_HEADER
+#include "AudioCaptureImpl.h"
+#include "AudioCaptureImpl_File.h"
+#include "AudioCaptureImpl_Tape.h"
 
+#ifndef _WIN32
+#include "AudioCaptureImpl_Pipe.h"
+#endif
+#include "AudioCaptureRegistry.h"
+#include "AudioDelayLine.h"
+#include "AudioLevelMeter.h"
+#include "ProjectMSDLApplication.h"
 #include "ProjectMWrapper.h"
 
 #include "notifications/DisplayToastNotification.h"
 
+#include <Poco/Delegate.h>
 #include <Poco/NotificationCenter.h>
+#include <Poco/Stopwatch.h>
+#include <Poco/String.h>
 
 #include <Poco/Util/Application.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
 const char* AudioCapture::name() const
 {
     return "Audio Capturing";
@@ -18,88 +36,525 @@ const char* AudioCapture::name() const
 void AudioCapture::initialize(Poco::Util::Application& app)
 {
     _config = app.config().createView("audio");
+    _deviceRefreshInterval = _config->getDouble("deviceRefreshInterval", 5.0);
+    _levelLogInterval = _config->getDouble("meter.logInterval", 60.0);
+    UpdateSyncOffset();
+
+    _userConfig = ProjectMSDLApplication::instance().UserConfiguration();
+    _userConfig->propertyChanged += Poco::delegate(this, &AudioCapture::OnConfigurationPropertyChanged);
+    _userConfig->propertyRemoved += Poco::delegate(this, &AudioCapture::OnConfigurationPropertyRemoved);
 
     auto& projectMWrapper = app.getSubsystem<ProjectMWrapper>();
+    _projectMHandle = projectMWrapper.ProjectM();
 
     if (!_impl)
     {
-        _impl = new AudioCaptureImpl;
+        StartBackend(_projectMHandle);
     }
-
-    auto deviceList = _impl->AudioDeviceList();
-    int audioDeviceIndex = GetInitialAudioDeviceIndex(deviceList);
-
-    PrintDeviceList(deviceList);
-
-    _impl->StartRecording(projectMWrapper.ProjectM(), audioDeviceIndex);
 }
 
 void AudioCapture::uninitialize()
 {
+    _userConfig->propertyRemoved -= Poco::delegate(this, &AudioCapture::OnConfigurationPropertyRemoved);
+    _userConfig->propertyChanged -= Poco::delegate(this, &AudioCapture::OnConfigurationPropertyChanged);
+
+    {
+        std::lock_guard<std::mutex> lock(_switchMutex);
+        _switchPending = false;
+        _refreshPending = false;
+    }
+
+    if (_workerStarted)
+    {
+        _deviceSwitchResult.wait();
+        _workerStarted = false;
+    }
+
     if (_impl)
     {
+        poco_information_f3(_logger, "Audio buffer statistics: %?u underruns, %?u overruns, %?u missed capture deadlines.",
+                            _impl->BufferUnderruns(), _impl->BufferOverruns(), _impl->MissedDeadlines());
+
         _impl->StopRecording();
         delete _impl;
         _impl = nullptr;
     }
+
+    _backendName.clear();
 }
 
 void AudioCapture::NextAudioDevice()
 {
-    if (_impl)
-    {
-        _impl->NextAudioDevice();
-        Poco::NotificationCenter::defaultCenter().postNotification(new DisplayToastNotification(_impl->AudioDeviceName()));
-    }
+    RequestDeviceSwitch(true, -1);
 }
 
 void AudioCapture::AudioDeviceIndex(int index)
 {
-    if (_impl)
+    RequestDeviceSwitch(false, index);
+}
+
+int AudioCapture::AudioDeviceIndex() const
+{
+    std::lock_guard<std::mutex> lock(_switchMutex);
+    return _deviceIndex;
+}
+
+AudioCapture::DeviceState AudioCapture::State() const
+{
+    return _state;
+}
+
+std::string AudioCapture::AudioDeviceName() const
+{
+    std::lock_guard<std::mutex> lock(_switchMutex);
+    return _deviceName;
+}
+
+std::string AudioCapture::BackendName() const
+{
+    return _backendName;
+}
+
+AudioCapture::AudioDeviceMap AudioCapture::AudioDeviceList() const
+{
+    std::lock_guard<std::mutex> lock(_switchMutex);
+    if (_deviceList.empty())
     {
-        _impl->AudioDeviceIndex(index);
-        Poco::NotificationCenter::defaultCenter().postNotification(new DisplayToastNotification(_impl->AudioDeviceName()));
+        return {{-1, "(No audio devices available)"}};
     }
+
+    return _deviceList;
 }
 
-int AudioCapture::AudioDeviceIndex() const
+uint64_t AudioCapture::DeviceListVersion() const
 {
-    if (_impl)
+    std::lock_guard<std::mutex> lock(_switchMutex);
+    return _deviceListVersion;
+}
+
+void AudioCapture::RefreshDeviceList()
+{
+    if (!_impl)
     {
-        return _impl->AudioDeviceIndex();
+        return;
     }
 
-    return -1;
+    std::lock_guard<std::mutex> lock(_switchMutex);
+    _refreshPending = true;
+    StartWorker();
 }
 
-std::string AudioCapture::AudioDeviceName() const
+void AudioCapture::FillBuffer()
 {
+    if (_switchCompleted.exchange(false))
+    {
+        std::string message;
+        {
+            std::lock_guard<std::mutex> lock(_switchMutex);
+            message = _switchMessage;
+        }
+        Poco::NotificationCenter::defaultCenter().postNotification(new DisplayToastNotification(message));
+    }
+
     if (!_impl)
+    {
+        return;
+    }
+
+    if (_deviceRefreshInterval > 0.0 && static_cast<double>(_deviceRefreshTimer.elapsed()) / 1000000.0 >= _deviceRefreshInterval)
+    {
+        _deviceRefreshTimer.restart();
+        RefreshDeviceList();
+    }
+
+    // Keep rendering without new audio data while the device is being switched.
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!implLock.owns_lock())
+    {
+        return;
+    }
+
+    if (_syncOffsetChanged)
+    {
+        _impl->SyncOffset(_syncOffset);
+        _syncOffsetChanged = false;
+    }
+
+    _impl->FillBuffer();
+
+    if (_levelLogInterval > 0.0 && static_cast<double>(_levelLogTimer.elapsed()) / 1000000.0 >= _levelLogInterval)
+    {
+        LogInputLevels();
+        _levelLogTimer.restart();
+    }
+}
+
+uint64_t AudioCapture::BufferUnderruns() const
+{
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!_impl || !implLock.owns_lock())
+    {
+        return 0;
+    }
+
+    return _impl->BufferUnderruns();
+}
+
+uint64_t AudioCapture::BufferOverruns() const
+{
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!_impl || !implLock.owns_lock())
+    {
+        return 0;
+    }
+
+    return _impl->BufferOverruns();
+}
+
+uint64_t AudioCapture::MissedDeadlines() const
+{
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!_impl || !implLock.owns_lock())
+    {
+        return 0;
+    }
+
+    return _impl->MissedDeadlines();
+}
+
+bool AudioCapture::EndOfStream() const
+{
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!_impl || !implLock.owns_lock())
+    {
+        return false;
+    }
+
+    return _impl->EndOfStream();
+}
+
+double AudioCapture::Latency() const
+{
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!_impl || !implLock.owns_lock())
+    {
+        return 0.0;
+    }
+
+    return _impl->Latency();
+}
+
+double AudioCapture::SilenceDuration() const
+{
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!_impl || !implLock.owns_lock())
+    {
+        return 0.0;
+    }
+
+    return _impl->LevelMeter().SilenceDuration();
+}
+
+AudioLevelMeter::Levels AudioCapture::InputLevels() const
+{
+    std::unique_lock<std::mutex> implLock(_implMutex, std::try_to_lock);
+    if (!_impl || !implLock.owns_lock())
     {
         return {};
     }
 
-    return _impl->AudioDeviceName();
+    return _impl->LevelMeter().CurrentLevels();
 }
 
-AudioCapture::AudioDeviceMap AudioCapture::AudioDeviceList()
+std::unique_ptr<AudioBroadcastRing::Reader> AudioCapture::CreateReader() const
 {
+    // The backend and its ring live until uninitialize(), so a switch in progress doesn't matter here.
     if (!_impl)
     {
-        return {{-1, "(No audio devices available)"}};
+        return {};
     }
 
-    return _impl->AudioDeviceList();
+    return _impl->CreateReader();
 }
 
-void AudioCapture::FillBuffer()
+void AudioCapture::StartBackend(projectm* projectMHandle)
+{
+    auto requestedBackend = _config->getString("backend", "auto");
+
+    // A file or pipe given as the audio device implies the respective backend.
+    auto deviceName = _config->getString("device", "");
+    if (AudioCaptureImpl_File::IsFileDevice(deviceName))
+    {
+        requestedBackend = "file";
+    }
+    else if (AudioCaptureImpl_Tape::IsTapeDevice(deviceName))
+    {
+        requestedBackend = "tape";
+    }
+#ifndef _WIN32
+    else if (AudioCaptureImpl_Pipe::IsPipeDevice(deviceName))
+    {
+        requestedBackend = "pipe";
+    }
+#endif
+
+    if (Poco::icompare(requestedBackend, "auto") != 0 && !AudioCaptureRegistry::Find(requestedBackend))
+    {
+        poco_warning_f1(_logger, R"(Unknown audio backend "%s" requested, using automatic selection.)", requestedBackend);
+    }
+
+    for (const auto* backend : AudioCaptureRegistry::Candidates(requestedBackend, _config->getBool("backendFallback", true)))
+    {
+        Poco::Stopwatch startupTime;
+        startupTime.start();
+
+        std::unique_ptr<AudioCaptureImpl> impl(backend->create());
+
+        auto deviceList = impl->AudioDeviceList();
+        int audioDeviceIndex = GetInitialAudioDeviceIndex(deviceList);
+
+        PrintDeviceList(deviceList);
+
+        bool started = impl->StartRecording(projectMHandle, audioDeviceIndex);
+        startupTime.stop();
+
+        if (started)
+        {
+            poco_information_f2(_logger, R"(Started audio backend "%s" in %.1f ms.)",
+                                std::string(backend->name), static_cast<double>(startupTime.elapsed()) / 1000.0);
+
+            _impl = impl.release();
+            _backendName = backend->name;
+            _state = DeviceState::Running;
+            _deviceRefreshTimer.restart();
+            _levelLogTimer.restart();
+            _syncOffsetChanged = true;
+
+            std::lock_guard<std::mutex> lock(_switchMutex);
+            StoreDeviceList(deviceList);
+            _deviceIndex = audioDeviceIndex;
+            _deviceName = deviceList.at(audioDeviceIndex);
+            return;
+        }
+
+        poco_warning_f2(_logger, R"(Audio backend "%s" failed to start after %.1f ms.)",
+                        std::string(backend->name), static_cast<double>(startupTime.elapsed()) / 1000.0);
+    }
+
+    poco_error(_logger, "No audio backend could be started. Visualizations will not react to sound.");
+}
+
+void AudioCapture::RequestDeviceSwitch(bool next, int index)
 {
     if (!_impl)
     {
         return;
     }
 
-    _impl->FillBuffer();
+    std::lock_guard<std::mutex> lock(_switchMutex);
+
+    _switchPending = true;
+    _switchToNext = next;
+    _switchIndex = index;
+
+    StartWorker();
+}
+
+void AudioCapture::StartWorker()
+{
+    if (!_workerRunning)
+    {
+        _workerRunning = true;
+        _workerStarted = true;
+        _deviceSwitchResult = _deviceSwitchWorker();
+    }
+}
+
+void AudioCapture::DeviceSwitchThread()
+{
+    while (true)
+    {
+        bool switchPending;
+        bool next;
+        int index;
+        {
+            std::lock_guard<std::mutex> lock(_switchMutex);
+            if (!_switchPending && !_refreshPending)
+            {
+                _workerRunning = false;
+                return;
+            }
+
+            switchPending = _switchPending;
+            next = _switchToNext;
+            index = _switchIndex;
+            _switchPending = false;
+
+            // A switch enumerates the devices anyway.
+            _refreshPending = false;
+        }
+
+        if (switchPending)
+        {
+            std::lock_guard<std::mutex> implLock(_implMutex);
+            SwitchDevice(next, index);
+        }
+        else
+        {
+            UpdateDeviceList();
+        }
+    }
+}
+
+void AudioCapture::UpdateDeviceList()
+{
+    // Not all audio APIs allow enumerating devices while another thread reads captured data, e.g. SDL's device
+    // list is shared with its capture code. The render thread only try-locks this, so at worst one frame passes
+    // no new samples to projectM, which stay queued for the next one.
+    std::lock_guard<std::mutex> implLock(_implMutex);
+    auto deviceList = _impl->AudioDeviceList();
+
+    bool activeDeviceRemoved{false};
+    {
+        std::lock_guard<std::mutex> lock(_switchMutex);
+        StoreDeviceList(deviceList);
+
+        // Indices may have shifted, so look up the active device by name.
+        if (_deviceIndex != -1)
+        {
+            auto activeDevice = std::find_if(deviceList.begin(), deviceList.end(), [this](const AudioDeviceMap::value_type& device) {
+                return device.second == _deviceName;
+            });
+
+            if (activeDevice != deviceList.end())
+            {
+                _deviceIndex = activeDevice->first;
+            }
+            else
+            {
+                activeDeviceRemoved = true;
+            }
+        }
+    }
+
+    if (activeDeviceRemoved && deviceList.find(-1) != deviceList.end())
+    {
+        poco_warning_f1(_logger, R"(Audio device "%s" was removed, switching to the default device.)", AudioDeviceName());
+
+        SwitchDevice(false, -1);
+    }
+}
+
+void AudioCapture::StoreDeviceList(const AudioDeviceMap& deviceList)
+{
+    if (deviceList != _deviceList)
+    {
+        _deviceList = deviceList;
+        _deviceListVersion++;
+
+        poco_debug_f2(_logger, "Audio device list changed, %?u devices available (version %?u).",
+                      _deviceList.size(), _deviceListVersion);
+    }
+}
+
+void AudioCapture::SwitchDevice(bool next, int index)
+{
+    Poco::Stopwatch switchTime;
+    switchTime.start();
+
+    auto deviceList = _impl->AudioDeviceList();
+    if (next)
+    {
+        // Wraps around to the first entry, which is the default device (-1).
+        auto currentDevice = deviceList.find(AudioDeviceIndex());
+        if (currentDevice == deviceList.end() || ++currentDevice == deviceList.end())
+        {
+            currentDevice = deviceList.begin();
+        }
+        index = currentDevice->first;
+    }
+
+    if (deviceList.find(index) == deviceList.end())
+    {
+        poco_warning_f1(_logger, "Requested audio device index %?d is not available.", index);
+        return;
+    }
+
+    // Indices may have shifted since the previous device was opened, so look it up by name.
+    int previousIndex{-1};
+    {
+        std::lock_guard<std::mutex> lock(_switchMutex);
+        StoreDeviceList(deviceList);
+        auto previousDevice = std::find_if(deviceList.begin(), deviceList.end(), [this](const AudioDeviceMap::value_type& device) {
+            return device.second == _deviceName;
+        });
+        if (previousDevice != deviceList.end())
+        {
+            previousIndex = previousDevice->first;
+        }
+        _deviceIndex = index;
+        _deviceName = deviceList.at(index);
+    }
+
+    _state = DeviceState::Closing;
+    _impl->StopRecording();
+
+    _state = DeviceState::Opening;
+    bool started = _impl->StartRecording(_projectMHandle, index);
+
+    switchTime.stop();
+    auto elapsedMilliseconds = static_cast<double>(switchTime.elapsed()) / 1000.0;
+
+    std::string message;
+    if (started)
+    {
+        _state = DeviceState::Running;
+        message = deviceList.at(index);
+        poco_information_f2(_logger, R"(Switched audio device to "%s" in %.1f ms.)", message, elapsedMilliseconds);
+    }
+    else
+    {
+        _state = DeviceState::Failed;
+        message = "Could not open " + deviceList.at(index);
+        poco_error_f2(_logger, R"(Failed to open audio device "%s" after %.1f ms.)", deviceList.at(index), elapsedMilliseconds);
+
+        // Don't leave capturing stopped. Go back to the previous device, or to the default one if that fails too.
+        std::vector<int> fallbackIndices{previousIndex};
+        if (previousIndex != -1)
+        {
+            fallbackIndices.push_back(-1);
+        }
+
+        for (int fallbackIndex : fallbackIndices)
+        {
+            if (fallbackIndex == index || deviceList.find(fallbackIndex) == deviceList.end())
+            {
+                continue;
+            }
+
+            if (_impl->StartRecording(_projectMHandle, fallbackIndex))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_switchMutex);
+                    _deviceIndex = fallbackIndex;
+                    _deviceName = deviceList.at(fallbackIndex);
+                }
+
+                _state = DeviceState::Running;
+                message += ", using " + deviceList.at(fallbackIndex);
+                poco_information_f1(_logger, R"(Reopened audio device "%s" instead.)", deviceList.at(fallbackIndex));
+                break;
+            }
+
+            poco_error_f1(_logger, R"(Failed to reopen audio device "%s".)", deviceList.at(fallbackIndex));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_switchMutex);
+        _switchMessage = message;
+    }
+    _switchCompleted = true;
 }
 
 void AudioCapture::PrintDeviceList(const AudioDeviceMap& deviceList) const
@@ -150,4 +605,62 @@ int AudioCapture::GetInitialAudioDeviceIndex(const AudioDeviceMap& deviceList)
                         deviceList.at(audioDeviceIndex), audioDeviceIndex);
 
     return audioDeviceIndex;
-}
\ No newline at end of file
+}
+
+void AudioCapture::LogInputLevels()
+{
+    auto& levelMeter = _impl->LevelMeter();
+    auto levels = levelMeter.CurrentLevels();
+    auto interval = levelMeter.TakeInterval();
+
+    if (interval.frames == 0)
+    {
+        poco_information_f1(_logger, "Input level: no audio received in the last %.0f seconds.", _levelLogInterval);
+        return;
+    }
+
+    auto elapsedTime = static_cast<double>(_levelLogTimer.elapsed()) / 1000000.0;
+    auto toDb = [](float level) {
+        return level > 0.0f ? 20.0 * std::log10(static_cast<double>(level)) : -std::numeric_limits<double>::infinity();
+    };
+
+    poco_information(_logger, Poco::format("Input level: RMS %.1f dBFS, peak %.1f dBFS, DC offset %.4f, %?u clipped samples, "
+                                           "%?u frames in %.0f seconds. Metering load %.3f%% of a CPU core.",
+                                           toDb(levels.rms), toDb(interval.maxPeak), static_cast<double>(levels.dcOffset),
+                                           interval.clippedSamples, interval.frames, elapsedTime,
+                                           interval.processingTime / elapsedTime * 100.0));
+}
+
+void AudioCapture::UpdateSyncOffset()
+{
+    auto maxOffset = static_cast<int>(AudioDelayLine::MaxDelay * 1000.0);
+    auto offset = std::min(std::max(_config->getInt("syncOffset", 0), -maxOffset), maxOffset);
+
+    _syncOffset = static_cast<double>(offset) / 1000.0;
+    _syncOffsetChanged = true;
+
+    if (offset < 0)
+    {
+        poco_debug_f1(_logger, "A/V sync offset set to %?d ms, minimizing capture buffering.", offset);
+    }
+    else
+    {
+        poco_debug_f1(_logger, "A/V sync offset set to %?d ms.", offset);
+    }
+}
+
+void AudioCapture::OnConfigurationPropertyChanged(const Poco::Util::AbstractConfiguration::KeyValue& property)
+{
+    if (property.key() == "audio.syncOffset")
+    {
+        UpdateSyncOffset();
+    }
+}
+
+void AudioCapture::OnConfigurationPropertyRemoved(const std::string& key)
+{
+    if (key == "audio.syncOffset")
+    {
+        UpdateSyncOffset();
+    }
+}
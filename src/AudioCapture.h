@@ -1,24 +1,59 @@
 #pragma once
 
+#include "AudioBroadcastRing.h"
+#include "AudioLevelMeter.h"
+
+#include <Poco/ActiveMethod.h>
 #include <Poco/Logger.h>
+#include <Poco/Stopwatch.h>
 
 #include <Poco/Util/Subsystem.h>
 #include <Poco/Util/AbstractConfiguration.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 class AudioCaptureImpl;
+struct projectm;
 
 /**
  * @brief Audio capturing proxy class/subsystem.
  *
- * Creates the OS-specific audio recording class and forwards the necessary calls to it.
+ * Creates the audio capture backend selected by audio.backend and forwards the necessary calls to it.
+ * If the selected backend fails to start, the remaining automatic backends are tried in order of preference,
+ * unless audio.backendFallback is false. The time each backend needs to start is logged.
+ *
+ * If audio.device is set to "file:<path>", the file backend is used to play the given file.
+ *
+ * Switching devices can take several hundred milliseconds with some audio APIs, so it is done on a worker
+ * thread. While a switch is in progress, FillBuffer() passes no samples to projectM. Requests made during
+ * a switch are coalesced, so only the latest one is executed afterwards.
+ *
+ * Enumerating devices may require a round trip to the sound server, so the device list is cached. The
+ * same worker refreshes it when RefreshDeviceList() is called, e.g. on SDL hotplug events, and every
+ * audio.deviceRefreshInterval seconds. Each change increments DeviceListVersion(). If the active device
+ * disappears from the list, capturing automatically switches to the default device.
+ *
+ * The A/V sync offset from audio.syncOffset is passed to the backend on the render thread and updated
+ * whenever the setting is changed in the UI.
  */
 class AudioCapture : public Poco::Util::Subsystem
 {
 public:
     using AudioDeviceMap = std::map<int, std::string>;
 
+    /**
+     * @brief State of the audio device, as changed by the device switch worker.
+     */
+    enum class DeviceState
+    {
+        Running, //!< The device is open and capturing.
+        Closing, //!< The previous device is being closed.
+        Opening, //!< The new device is being opened.
+        Failed //!< The new device could not be opened.
+    };
+
     const char* name() const override;
 
     void initialize(Poco::Util::Application& app) override;
@@ -27,15 +62,26 @@ public:
 
     /**
      * @brief Switches to the next available audio recording device.
+     *
+     * Returns immediately, the device is switched asynchronously.
      */
     void NextAudioDevice();
 
     /**
      * @brief Activates the audio device with the given idnex for recording.
+     *
+     * Returns immediately, the device is switched asynchronously.
+     *
      * @param index The index, as listed by @a AudioDeviceList()
      */
     void AudioDeviceIndex(int index);
 
+    /**
+     * @brief Returns the state of the current audio device.
+     * @return The device state. Closing or Opening while a device switch is in progress.
+     */
+    DeviceState State() const;
+
     /**
      * @brief Returns the currently used Audio device index.
      * @return The index of the current audio device, as listed by @a AudioDeviceList()
@@ -48,18 +94,140 @@ public:
      */
     std::string AudioDeviceName() const;
 
+    /**
+     * @brief Returns the name of the active capture backend.
+     * @return The backend name as used in audio.backend, or an empty string if no backend is running.
+     */
+    std::string BackendName() const;
+
     /**
      * @brief Returns a list of currently available audio devices.
-     * @return A map with device index/name pairs.
+     * @return A map with device index/name pairs, as of the last refresh.
+     */
+    AudioDeviceMap AudioDeviceList() const;
+
+    /**
+     * @brief Returns the version of the cached device list.
+     *
+     * Callers displaying the list can compare this value with the one from their last call to AudioDeviceList()
+     * and only fetch the list again if it changed.
+     *
+     * @return A counter which is incremented each time the device list changes.
      */
-    AudioDeviceMap AudioDeviceList();
+    uint64_t DeviceListVersion() const;
+
+    /**
+     * @brief Requests an asynchronous refresh of the cached device list.
+     *
+     * Should be called if the application was notified about added or removed audio devices.
+     */
+    void RefreshDeviceList();
 
     /**
      * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
      */
     void FillBuffer();
 
+    /**
+     * @brief Returns the number of frames which received fewer audio samples than required.
+     * @return The underrun count for the current audio device.
+     */
+    uint64_t BufferUnderruns() const;
+
+    /**
+     * @brief Returns the number of times captured audio samples had to be dropped.
+     * @return The overrun count for the current audio device.
+     */
+    uint64_t BufferOverruns() const;
+
+    /**
+     * @brief Returns the number of times the capture thread didn't run in time.
+     * @return The missed deadline count for the current audio device.
+     */
+    uint64_t MissedDeadlines() const;
+
+    /**
+     * @brief Returns whether the audio source has delivered all of its data, e.g. at the end of a non-looping file.
+     * @return true if the current source has ended, false otherwise or while a device switch is in progress.
+     */
+    bool EndOfStream() const;
+
+    /**
+     * @brief Returns the estimated time from capturing a sample until it is passed to projectM.
+     * @return The latency in seconds, including the A/V sync delay, or 0 while a device switch is in progress.
+     */
+    double Latency() const;
+
+    /**
+     * @brief Returns for how long the captured audio has been silent.
+     * @return The duration of the silence in seconds, or 0 while a device switch is in progress.
+     */
+    double SilenceDuration() const;
+
+    /**
+     * @brief Returns the current input level readings.
+     * @return The peak, RMS and DC offset readings, or zero readings while a device switch is in progress.
+     */
+    AudioLevelMeter::Levels InputLevels() const;
+
+    /**
+     * @brief Attaches an additional consumer to the captured stream.
+     *
+     * The reader receives stereo samples at AudioSampleQueue::OutputSampleFrequency, independent of the
+     * device format, and stays valid across device switches. It must be destroyed before this subsystem is
+     * uninitialized. Can be called from any thread.
+     *
+     * @return A new reader, or an empty pointer if no backend is running or it doesn't support readers.
+     */
+    std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const;
+
 protected:
+    /**
+     * @brief Creates and starts the configured capture backend, falling back to others if it fails.
+     * @param projectMHandle projectM instance handle that will receive the captured data.
+     */
+    void StartBackend(projectm* projectMHandle);
+
+    /**
+     * @brief Queues a device switch and starts the worker thread if it's not already running.
+     * @param next If true, switches to the device following the current one and ignores @a index.
+     * @param index The device index to switch to.
+     */
+    void RequestDeviceSwitch(bool next, int index);
+
+    /**
+     * @brief Starts the worker thread if it's not already running. Must be called with _switchMutex held.
+     */
+    void StartWorker();
+
+    /**
+     * @brief Device worker. Executes queued switch and refresh requests until none is left.
+     */
+    void DeviceSwitchThread();
+
+    /**
+     * @brief Enumerates the devices, updates the cached list and fails over if the active device is gone.
+     *
+     * Holds _implMutex while calling into the backend.
+     */
+    void UpdateDeviceList();
+
+    /**
+     * @brief Stores a new device list in the cache, incrementing the version if it differs. Must be called with _switchMutex held.
+     * @param deviceList The new device list.
+     */
+    void StoreDeviceList(const AudioDeviceMap& deviceList);
+
+    /**
+     * @brief Closes the current device and opens the given one. Called with _implMutex held.
+     *
+     * If the new device can't be opened, the previous device is reopened, or the default device if that
+     * fails as well. The state is only Failed if no device could be opened.
+     * @param next If true, switches to the device following the current one and ignores @a index.
+     * @param index The device index to switch to.
+     */
+    void SwitchDevice(bool next, int index);
+
     /**
      * @brief Prints a list of available audio devices on standard output if requested by the user.
      * @param deviceList The list of available audio devices.
@@ -80,9 +248,64 @@ protected:
      */
     int GetInitialAudioDeviceIndex(const AudioDeviceMap& deviceList);
 
+    /**
+     * @brief Logs the input levels and metering statistics since the last call. Called with _implMutex held.
+     */
+    void LogInputLevels();
+
+    /**
+     * @brief Reads the A/V sync offset from the configuration and schedules passing it to the backend.
+     */
+    void UpdateSyncOffset();
+
+    /**
+     * @brief Event callback if a configuration value has changed.
+     * @param property The key and value that has been changed.
+     */
+    void OnConfigurationPropertyChanged(const Poco::Util::AbstractConfiguration::KeyValue& property);
+
+    /**
+     * @brief Event callback if a configuration value has been removed.
+     * @param key The key of the removed property.
+     */
+    void OnConfigurationPropertyRemoved(const std::string& key);
+
     Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "audio" configuration subkey.
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _userConfig; //!< The "user" configuration, changed by the settings window.
+
+    AudioCaptureImpl* _impl{}; //!< The active capture backend.
+    std::string _backendName; //!< Name of the active capture backend.
+    projectm* _projectMHandle{}; //!< projectM instance receiving the captured data.
+
+    mutable std::mutex _implMutex; //!< Held by the switch worker while it calls into _impl. The render thread only try-locks it.
+
+    mutable std::mutex _switchMutex; //!< Protects the pending requests and the cached device information.
+    bool _switchPending{false}; //!< True if a switch was requested, but not yet started by the worker.
+    bool _switchToNext{false}; //!< If true, the pending request switches to the next device.
+    int _switchIndex{-1}; //!< Device index of the pending request.
+    bool _refreshPending{false}; //!< True if a device list refresh was requested.
+    bool _workerRunning{false}; //!< True while the worker thread executes requests.
+    bool _workerStarted{false}; //!< True if the worker was started at least once, so its result can be waited on.
+    AudioDeviceMap _deviceList; //!< Cached device list.
+    uint64_t _deviceListVersion{0}; //!< Incremented each time _deviceList changes.
+    int _deviceIndex{-1}; //!< Index of the active device in _deviceList.
+    std::string _deviceName; //!< Name of the active device, used to find it again after the list changed.
+    std::string _switchMessage; //!< Toast message to display after the switch, posted on the render thread.
+
+    double _deviceRefreshInterval{5.0}; //!< Time in seconds between device list refreshes, 0 to only refresh on request.
+    Poco::Stopwatch _deviceRefreshTimer; //!< Time since the last periodic refresh request.
+
+    double _levelLogInterval{60.0}; //!< Time in seconds between input level log lines, 0 to disable them.
+    Poco::Stopwatch _levelLogTimer; //!< Time since the last input level log line.
+
+    double _syncOffset{0.0}; //!< A/V sync offset in seconds.
+    bool _syncOffsetChanged{false}; //!< If true, the sync offset still has to be passed to the backend.
+
+    std::atomic<DeviceState> _state{DeviceState::Running}; //!< Current device state.
+    std::atomic_bool _switchCompleted{false}; //!< Set by the worker if _switchMessage should be displayed.
 
-    AudioCaptureImpl* _impl{}; //!< The OS-specific capture implementation.
+    Poco::ActiveMethod<void, void, AudioCapture> _deviceSwitchWorker{this, &AudioCapture::DeviceSwitchThread}; //!< Active method running the switch worker.
+    Poco::ActiveResult<void> _deviceSwitchResult{new Poco::ActiveResultHolder<void>()}; //!< Result of the last worker run.
 
     Poco::Logger& _logger{ Poco::Logger::get("AudioCapture") }; //!< The class logger.
 };
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "AudioBroadcastRing.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+struct projectm;
+
+class AudioLevelMeter;
+
+/**
+ * @brief Interface for audio capture backends.
+ *
+ * Each backend implements a different way to retrieve PCM data, e.g. recording from an audio device using
+ * a specific audio API or playing back a file. The available backends are listed in AudioCaptureRegistry,
+ * and the AudioCapture subsystem forwards all calls to the active one.
+ *
+ * Backends don't switch devices themselves. AudioCapture does that on its worker thread by calling
+ * StopRecording() and StartRecording() with the new device index.
+ */
+class AudioCaptureImpl
+{
+public:
+    virtual ~AudioCaptureImpl() = default;
+
+    /**
+     * @brief Returns a map of available recording devices.
+     *
+     * May be called on a worker thread while FillBuffer() runs on the render thread.
+     *
+     * @return A vector of available audio device IDs and names.
+     */
+    virtual std::map<int, std::string> AudioDeviceList() = 0;
+
+    /**
+     * @brief Starts audio capturing with the first available device.
+     * @param projectMHandle projectM instance handle that will receive the captured data.
+     * @param audioDeviceIndex The initial audio device ID to capture from. Use -1 to select the implementation's
+     *                      default device.
+     * @return true if capturing was started, false if the backend could not be opened.
+     */
+    virtual bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) = 0;
+
+    /**
+     * @brief Stops audio recording.
+     */
+    virtual void StopRecording() = 0;
+
+    /**
+     * @brief Returns the currently used Audio device index.
+     * @return The index of the current audio device, as listed by @a AudioDeviceList()
+     */
+    virtual int AudioDeviceIndex() const = 0;
+
+    /**
+     * @brief Retrieves the current audio device name.
+     * @return The name of the currently selected audio recording device.
+     */
+    virtual std::string AudioDeviceName() const = 0;
+
+    /**
+     * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
+     */
+    virtual void FillBuffer() = 0;
+
+    /**
+     * @brief Sets the A/V sync offset. Called on the render thread.
+     *
+     * Positive values delay the samples passed to projectM. Negative values reduce the capture buffering
+     * as far as possible, if the backend supports it.
+     *
+     * @param offset The offset in seconds, at most AudioDelayLine::MaxDelay.
+     */
+    virtual void SyncOffset(double offset) = 0;
+
+    /**
+     * @brief Returns the estimated time from capturing a sample until it is passed to projectM.
+     * @return The latency in seconds, including the sync delay.
+     */
+    virtual double Latency() const = 0;
+
+    /**
+     * @brief Returns the meter analyzing the captured audio.
+     * @return The backend's level meter, which stays valid until the backend is destroyed.
+     */
+    virtual AudioLevelMeter& LevelMeter() = 0;
+
+    /**
+     * @brief Attaches an additional consumer to the captured stream.
+     *
+     * The reader receives stereo samples at AudioSampleQueue::OutputSampleFrequency, starting at the newest
+     * sample, and stays valid across device switches until the backend is destroyed. Backends without a
+     * sample queue don't support additional consumers and return an empty pointer.
+     *
+     * @return A new reader, or an empty pointer if the backend doesn't support readers.
+     */
+    virtual std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const
+    {
+        return {};
+    }
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     * @return The underrun count since the device was opened.
+     */
+    virtual uint64_t BufferUnderruns() const = 0;
+
+    /**
+     * @brief Returns the number of times captured samples had to be dropped.
+     * @return The overrun count since the device was opened.
+     */
+    virtual uint64_t BufferOverruns() const = 0;
+
+    /**
+     * @brief Returns the number of times the capture thread didn't run in time.
+     *
+     * Backends without a periodically scheduled capture thread don't track this and always return 0.
+     *
+     * @return The missed deadline count since the device was opened.
+     */
+    virtual uint64_t MissedDeadlines() const
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Returns whether the source has delivered all of its audio data.
+     *
+     * Only finite sources like non-looping files ever end. All other backends always return false.
+     *
+     * @return true if no more audio data will be passed to projectM.
+     */
+    virtual bool EndOfStream() const
+    {
+        return false;
+    }
+};
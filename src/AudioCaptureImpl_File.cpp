@@ -0,0 +1,462 @@
+#include "AudioCaptureImpl_File.h"
+
+#include <projectM-4/projectM.h>
+
+#include <SDL2/SDL.h>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+constexpr char FilePrefix[] = "file:";
+constexpr size_t FilePrefixLength = sizeof(FilePrefix) - 1;
+
+constexpr uint16_t WaveFormatPcm{0x0001};
+constexpr uint16_t WaveFormatIeeeFloat{0x0003};
+constexpr uint16_t WaveFormatExtensible{0xFFFE};
+
+uint16_t ReadUInt16LE(const unsigned char* data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t ReadUInt32LE(const unsigned char* data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+} // namespace
+
+constexpr size_t AudioCaptureImpl_File::ChunkFrames;
+constexpr double AudioCaptureImpl_File::MaxElapsedTime;
+
+AudioCaptureImpl_File::AudioCaptureImpl_File()
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    auto deviceName = config.getString("audio.device", "");
+    _fileName = IsFileDevice(deviceName) ? deviceName.substr(FilePrefixLength) : config.getString("audio.file.path", "");
+
+    _realTime = config.getBool("audio.file.realtime", true);
+    _loop = config.getBool("audio.file.loop", true);
+    _rawFormat = config.getString("audio.file.format", "f32");
+    _rawChannels = config.getUInt("audio.file.channels", 2);
+    _rawSampleRate = config.getUInt("audio.file.sampleRate", 44100);
+
+    _targetFps = config.getUInt("projectM.fps", 60);
+    if (_targetFps == 0)
+    {
+        _targetFps = 60;
+    }
+}
+
+bool AudioCaptureImpl_File::IsFileDevice(const std::string& deviceName)
+{
+    return deviceName.compare(0, FilePrefixLength, FilePrefix) == 0;
+}
+
+std::map<int, std::string> AudioCaptureImpl_File::AudioDeviceList()
+{
+    return {{-1, AudioDeviceName()}};
+}
+
+bool AudioCaptureImpl_File::StartRecording(projectm* projectMHandle, int)
+{
+    StopRecording();
+
+    _projectMHandle = projectMHandle;
+
+    if (_fileName.empty())
+    {
+        poco_error(_logger, "No audio file specified. Set audio.device to \"file:<path>\" or audio.file.path to a file name.");
+        return false;
+    }
+
+    try
+    {
+        _mapping.reset(new Poco::SharedMemory(Poco::File(_fileName), Poco::SharedMemory::AM_READ));
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not open audio file "%s": %s)", _fileName, ex.displayText());
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(_mapping->end() - _mapping->begin());
+    if (fileSize >= 4 && std::memcmp(_mapping->begin(), "fLaC", 4) == 0)
+    {
+        poco_error_f1(_logger, R"(Audio file "%s" is FLAC-encoded, which is not supported. Please convert it to WAV or raw PCM.)", _fileName);
+        _mapping.reset();
+        return false;
+    }
+
+    bool formatValid = (fileSize >= 12 && std::memcmp(_mapping->begin(), "RIFF", 4) == 0)
+                           ? ParseWaveHeader()
+                           : ConfigureRawFormat();
+    if (!formatValid || _totalFrames == 0 || _channels > AudioDownmixer::MaxChannels)
+    {
+        poco_error_f1(_logger, R"(Audio file "%s" has an unsupported format or contains no samples.)", _fileName);
+        _mapping.reset();
+        return false;
+    }
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> audioConfig = Poco::Util::Application::instance().config().createView("audio");
+
+    _downmixer.Configure(_channels, *audioConfig);
+    _decodeBuffer.resize(ChunkFrames * _channels);
+
+    _resampler.Configure(_sampleRate, OutputSampleFrequency, _downmixer.OutputChannels(), ChunkFrames);
+    if (_resampler.Active())
+    {
+        _resampleBuffer.resize(_resampler.MaxOutputFrames(ChunkFrames) * _downmixer.OutputChannels());
+    }
+
+    _delayLine.Configure(OutputSampleFrequency, _downmixer.OutputChannels());
+    _levelMeter.Configure(OutputSampleFrequency, _downmixer.OutputChannels(), audioConfig->getDouble("silenceThreshold", -60.0));
+
+    _position = 0;
+    _pendingFrames = 0.0;
+    _started = false;
+    _endReached = false;
+    _underruns = 0;
+    _overruns = 0;
+
+    poco_information_f4(_logger, R"(Playing audio file "%s" with %?u channels at %?u Hz (%s mode).)",
+                        _fileName, _channels, _sampleRate, std::string(_realTime ? "real-time" : "fixed-step"));
+
+    return true;
+}
+
+void AudioCaptureImpl_File::StopRecording()
+{
+    if (_mapping)
+    {
+        _mapping.reset();
+        _sampleData = nullptr;
+        _totalFrames = 0;
+
+        poco_debug(_logger, "Stopped audio file playback.");
+    }
+}
+
+int AudioCaptureImpl_File::AudioDeviceIndex() const
+{
+    return -1;
+}
+
+std::string AudioCaptureImpl_File::AudioDeviceName() const
+{
+    return FilePrefix + _fileName;
+}
+
+void AudioCaptureImpl_File::FillBuffer()
+{
+    if (!_mapping || !_projectMHandle)
+    {
+        return;
+    }
+
+    size_t frames;
+    if (_realTime)
+    {
+        auto now = static_cast<double>(SDL_GetPerformanceCounter()) / static_cast<double>(SDL_GetPerformanceFrequency());
+        if (!_started)
+        {
+            // Start with a single frame's worth of audio, there's no elapsed time yet.
+            _lastTime = now - 1.0 / _targetFps;
+            _started = true;
+        }
+
+        auto elapsed = now - _lastTime;
+        _lastTime = now;
+        if (elapsed > MaxElapsedTime)
+        {
+            // Skip ahead instead of flooding projectM with seconds of audio after a stall.
+            auto skippedFrames = static_cast<size_t>((elapsed - MaxElapsedTime) * _sampleRate);
+            _position = _loop ? (_position + skippedFrames) % _totalFrames : std::min(_position + skippedFrames, _totalFrames);
+            _overruns++;
+            elapsed = MaxElapsedTime;
+        }
+
+        _pendingFrames += elapsed * _sampleRate;
+        frames = static_cast<size_t>(_pendingFrames);
+        _pendingFrames -= static_cast<double>(frames);
+    }
+    else
+    {
+        // Distribute the remainder, so the average rate exactly matches the sample rate.
+        _pendingFrames += static_cast<double>(_sampleRate) / _targetFps;
+        frames = static_cast<size_t>(_pendingFrames);
+        _pendingFrames -= static_cast<double>(frames);
+    }
+
+    Deliver(frames);
+}
+
+void AudioCaptureImpl_File::SyncOffset(double offset)
+{
+    _delayLine.Delay(offset);
+}
+
+double AudioCaptureImpl_File::Latency() const
+{
+    return _delayLine.Delay();
+}
+
+AudioLevelMeter& AudioCaptureImpl_File::LevelMeter()
+{
+    return _levelMeter;
+}
+
+uint64_t AudioCaptureImpl_File::BufferUnderruns() const
+{
+    return _underruns;
+}
+
+uint64_t AudioCaptureImpl_File::BufferOverruns() const
+{
+    return _overruns;
+}
+
+bool AudioCaptureImpl_File::EndOfStream() const
+{
+    return _mapping && !_loop && _position >= _totalFrames;
+}
+
+bool AudioCaptureImpl_File::ParseWaveHeader()
+{
+    const auto* fileStart = reinterpret_cast<const unsigned char*>(_mapping->begin());
+    const auto* fileEnd = reinterpret_cast<const unsigned char*>(_mapping->end());
+
+    if (std::memcmp(fileStart + 8, "WAVE", 4) != 0)
+    {
+        poco_error(_logger, "RIFF file is not a WAVE file.");
+        return false;
+    }
+
+    bool formatFound{false};
+    uint16_t formatTag{0};
+    uint16_t bitsPerSample{0};
+    uint16_t blockAlign{0};
+
+    const auto* chunk = fileStart + 12;
+    while (fileEnd - chunk >= 8)
+    {
+        uint32_t chunkSize = ReadUInt32LE(chunk + 4);
+        const auto* chunkData = chunk + 8;
+        size_t availableSize = std::min(static_cast<size_t>(chunkSize), static_cast<size_t>(fileEnd - chunkData));
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && availableSize >= 16)
+        {
+            formatTag = ReadUInt16LE(chunkData);
+            _channels = ReadUInt16LE(chunkData + 2);
+            _sampleRate = ReadUInt32LE(chunkData + 4);
+            blockAlign = ReadUInt16LE(chunkData + 12);
+            bitsPerSample = ReadUInt16LE(chunkData + 14);
+
+            // The actual format is stored in the first two bytes of the sub format GUID.
+            if (formatTag == WaveFormatExtensible && availableSize >= 26)
+            {
+                formatTag = ReadUInt16LE(chunkData + 24);
+            }
+
+            formatFound = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            if (!formatFound)
+            {
+                poco_error(_logger, "WAVE data chunk found before the format chunk.");
+                return false;
+            }
+
+            if (formatTag == WaveFormatPcm && bitsPerSample == 16)
+            {
+                _format = SampleFormat::Int16;
+            }
+            else if (formatTag == WaveFormatPcm && bitsPerSample == 24)
+            {
+                _format = SampleFormat::Int24;
+            }
+            else if (formatTag == WaveFormatPcm && bitsPerSample == 32)
+            {
+                _format = SampleFormat::Int32;
+            }
+            else if (formatTag == WaveFormatIeeeFloat && bitsPerSample == 32)
+            {
+                _format = SampleFormat::Float32;
+            }
+            else
+            {
+                poco_error_f2(_logger, "Unsupported WAVE sample format 0x%04?x with %?u bits per sample.", formatTag, bitsPerSample);
+                return false;
+            }
+
+            _bytesPerSample = bitsPerSample / 8;
+            if (_channels == 0 || _sampleRate == 0 || blockAlign != _channels * _bytesPerSample)
+            {
+                poco_error(_logger, "WAVE format chunk contains invalid values.");
+                return false;
+            }
+
+            _sampleData = reinterpret_cast<const char*>(chunkData);
+            _totalFrames = availableSize / blockAlign;
+            return true;
+        }
+
+        // Chunks are padded to an even size.
+        size_t paddedSize = static_cast<size_t>(chunkSize) + (chunkSize & 1);
+        if (paddedSize >= static_cast<size_t>(fileEnd - chunkData))
+        {
+            break;
+        }
+        chunk = chunkData + paddedSize;
+    }
+
+    poco_error(_logger, "WAVE file contains no data chunk.");
+    return false;
+}
+
+bool AudioCaptureImpl_File::ConfigureRawFormat()
+{
+    if (_rawFormat == "s16")
+    {
+        _format = SampleFormat::Int16;
+        _bytesPerSample = 2;
+    }
+    else if (_rawFormat == "s24")
+    {
+        _format = SampleFormat::Int24;
+        _bytesPerSample = 3;
+    }
+    else if (_rawFormat == "s32")
+    {
+        _format = SampleFormat::Int32;
+        _bytesPerSample = 4;
+    }
+    else if (_rawFormat == "f32")
+    {
+        _format = SampleFormat::Float32;
+        _bytesPerSample = 4;
+    }
+    else
+    {
+        poco_error_f1(_logger, R"(Unknown raw sample format "%s" in audio.file.format. Use one of s16, s24, s32 or f32.)", _rawFormat);
+        return false;
+    }
+
+    if (_rawChannels == 0 || _rawSampleRate == 0)
+    {
+        poco_error(_logger, "audio.file.channels and audio.file.sampleRate must be greater than zero.");
+        return false;
+    }
+
+    _channels = _rawChannels;
+    _sampleRate = _rawSampleRate;
+    _sampleData = _mapping->begin();
+    _totalFrames = static_cast<size_t>(_mapping->end() - _mapping->begin()) / (_channels * _bytesPerSample);
+
+    return true;
+}
+
+void AudioCaptureImpl_File::Decode(size_t firstFrame, size_t frames, float* output) const
+{
+    const size_t samples = frames * _channels;
+    const auto* input = reinterpret_cast<const unsigned char*>(_sampleData) + firstFrame * _channels * _bytesPerSample;
+
+    // All supported platforms are little-endian, so samples can be copied directly from the file.
+    switch (_format)
+    {
+        case SampleFormat::Int16:
+            for (size_t sample = 0; sample < samples; sample++)
+            {
+                int16_t value;
+                std::memcpy(&value, input + sample * 2, sizeof(value));
+                output[sample] = static_cast<float>(value) * (1.0f / 32768.0f);
+            }
+            break;
+
+        case SampleFormat::Int24:
+            for (size_t sample = 0; sample < samples; sample++)
+            {
+                const auto* bytes = input + sample * 3;
+                auto value = static_cast<int32_t>(static_cast<uint32_t>(bytes[0]) << 8 |
+                                                  static_cast<uint32_t>(bytes[1]) << 16 |
+                                                  static_cast<uint32_t>(bytes[2]) << 24);
+                output[sample] = static_cast<float>(value) * (1.0f / 2147483648.0f);
+            }
+            break;
+
+        case SampleFormat::Int32:
+            for (size_t sample = 0; sample < samples; sample++)
+            {
+                int32_t value;
+                std::memcpy(&value, input + sample * 4, sizeof(value));
+                output[sample] = static_cast<float>(value) * (1.0f / 2147483648.0f);
+            }
+            break;
+
+        case SampleFormat::Float32:
+            std::memcpy(output, input, samples * sizeof(float));
+            break;
+    }
+}
+
+void AudioCaptureImpl_File::Deliver(size_t frames)
+{
+    const auto outputChannels = _downmixer.OutputChannels();
+
+    while (frames > 0)
+    {
+        if (_position >= _totalFrames)
+        {
+            if (!_loop)
+            {
+                if (!_endReached)
+                {
+                    poco_information(_logger, "Reached the end of the audio file.");
+                    _endReached = true;
+                }
+                _underruns++;
+                return;
+            }
+
+            _position = 0;
+        }
+
+        auto chunkFrames = std::min({frames, ChunkFrames, _totalFrames - _position});
+
+        Decode(_position, chunkFrames, _decodeBuffer.data());
+        _position += chunkFrames;
+        frames -= chunkFrames;
+
+        if (_downmixer.Active())
+        {
+            _downmixer.Process(_decodeBuffer.data(), chunkFrames, _decodeBuffer.data());
+        }
+
+        float* samples = _decodeBuffer.data();
+        size_t outputFrames = chunkFrames;
+        if (_resampler.Active())
+        {
+            outputFrames = _resampler.Process(samples, chunkFrames, _resampleBuffer.data());
+            samples = _resampleBuffer.data();
+        }
+
+        if (outputFrames > 0)
+        {
+            _levelMeter.Process(samples, outputFrames);
+            _delayLine.Process(samples, outputFrames, samples);
+            projectm_pcm_add_float(_projectMHandle, samples, static_cast<unsigned int>(outputFrames),
+                                   static_cast<projectm_channels>(outputChannels));
+        }
+    }
+}
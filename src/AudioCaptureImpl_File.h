@@ -0,0 +1,206 @@
+#pragma once
+
+#include "AudioCaptureImpl.h"
+#include "AudioDelayLine.h"
+#include "AudioDownmixer.h"
+#include "AudioResampler.h"
+#include "AudioLevelMeter.h"
+
+#include <Poco/Logger.h>
+#include <Poco/SharedMemory.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Audio source which streams PCM data from a file instead of a capture device.
+ *
+ * Used for reproducible benchmarks and regression runs without any audio hardware. Selected by setting
+ * audio.device to "file:<path>", or with audio.backend set to "file" and the path in audio.file.path. Supported formats are WAV files with 16, 24 or 32 bit integer or 32 bit
+ * float samples, and headerless raw PCM files, which are described by the audio.file.* settings.
+ *
+ * The file is memory-mapped, so the operating system's read-ahead takes care of loading it in large
+ * chunks. Samples are decoded, downmixed and resampled on the render thread directly into projectM.
+ *
+ * By default, the number of frames passed to projectM each frame matches the elapsed wall-clock time.
+ * If audio.file.realtime is false, exactly one frame's worth of audio at the configured target FPS
+ * is passed on each call to FillBuffer(), so the visuals are deterministic regardless of render speed.
+ */
+class AudioCaptureImpl_File : public AudioCaptureImpl
+{
+public:
+    /**
+     * @brief Creates a new file source.
+     *
+     * The file name is taken from audio.device if it has the "file:" prefix, otherwise from audio.file.path.
+     */
+    AudioCaptureImpl_File();
+
+    /**
+     * @brief Checks whether a configured device name refers to a file.
+     * @param deviceName The audio.device value.
+     * @return true if the name starts with the "file:" prefix.
+     */
+    static bool IsFileDevice(const std::string& deviceName);
+
+    /**
+     * @brief Returns a list with the file as the only device.
+     * @return A map with a single entry.
+     */
+    std::map<int, std::string> AudioDeviceList() override;
+
+    /**
+     * @brief Opens and maps the file and starts playback from the beginning.
+     * @param projectMHandle projectM instance handle that will receive the audio data.
+     * @param audioDeviceIndex Ignored, as there is only one device.
+     * @return true if the file could be opened and its format is supported.
+     */
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
+
+    /**
+     * @brief Stops playback and unmaps the file.
+     */
+    void StopRecording() override;
+
+    /**
+     * @brief Returns the device index of the file.
+     * @return Always -1, the file is the backend's default and only device.
+     */
+    int AudioDeviceIndex() const override;
+
+    /**
+     * @brief Returns the file's display name.
+     * @return The file name with the "file:" prefix.
+     */
+    std::string AudioDeviceName() const override;
+
+    /**
+     * @brief Decodes the next block of audio data and passes it to projectM.
+     */
+    void FillBuffer() override;
+
+    /**
+     * @brief Delays the decoded samples by positive offsets.
+     *
+     * Negative offsets have no effect, as the file is decoded right before passing it to projectM.
+     *
+     * @param offset The offset in seconds.
+     */
+    void SyncOffset(double offset) override;
+
+    /**
+     * @brief Returns the time samples are held back by the sync delay.
+     * @return The sync delay in seconds.
+     */
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the decoded audio.
+     * @return The level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     *
+     * This only happens if the end of a non-looping file was reached.
+     *
+     * @return The underrun count since the file was opened.
+     */
+    uint64_t BufferUnderruns() const override;
+
+    /**
+     * @brief Returns the number of times audio data had to be skipped.
+     *
+     * In real-time mode, if a single frame took longer than MaxElapsedTime, the remaining time is skipped
+     * instead of passing a large burst of audio data to projectM.
+     *
+     * @return The overrun count since the file was opened.
+     */
+    uint64_t BufferOverruns() const override;
+
+    /**
+     * @brief Returns whether a non-looping file has been delivered completely.
+     * @return true if the playback position reached the end of the file and looping is disabled.
+     */
+    bool EndOfStream() const override;
+
+protected:
+    /**
+     * @brief Sample encodings supported by the decoder.
+     */
+    enum class SampleFormat
+    {
+        Int16,
+        Int24,
+        Int32,
+        Float32
+    };
+
+    /**
+     * @brief Parses the RIFF header of a WAV file and locates the sample data.
+     * @return true if the file is a valid WAV file with a supported sample format.
+     */
+    bool ParseWaveHeader();
+
+    /**
+     * @brief Sets up the format of a headerless file from the audio.file.* settings.
+     * @return true if the configured format is valid.
+     */
+    bool ConfigureRawFormat();
+
+    /**
+     * @brief Converts sample frames from the mapped file to interleaved floats.
+     * @param firstFrame Index of the first frame to decode.
+     * @param frames Number of frames to decode.
+     * @param output Destination memory for frames * _channels samples.
+     */
+    void Decode(size_t firstFrame, size_t frames, float* output) const;
+
+    /**
+     * @brief Downmixes, resamples and passes the given number of frames to projectM.
+     * @param frames Number of source frames to deliver.
+     */
+    void Deliver(size_t frames);
+
+    static constexpr size_t ChunkFrames{4096}; //!< Number of source frames decoded in one go.
+    static constexpr double MaxElapsedTime{0.25}; //!< Max. time span delivered in a single real-time frame.
+    static constexpr uint32_t OutputSampleFrequency{44100}; //!< Sample frequency passed to projectM.
+
+    std::string _fileName; //!< Path of the audio file.
+    bool _realTime{true}; //!< If true, the number of delivered samples is based on wall-clock time.
+    bool _loop{true}; //!< If true, playback restarts at the beginning when the end of the file is reached.
+    uint32_t _targetFps{60}; //!< Frames per second used to calculate the block size if not in real-time mode.
+
+    std::string _rawFormat{"f32"}; //!< Sample format of headerless files.
+    uint32_t _rawChannels{2}; //!< Channel count of headerless files.
+    uint32_t _rawSampleRate{44100}; //!< Sample rate of headerless files.
+
+    projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
+    std::unique_ptr<Poco::SharedMemory> _mapping; //!< Read-only memory mapping of the whole file.
+
+    const char* _sampleData{nullptr}; //!< Start of the sample data inside the mapping.
+    size_t _totalFrames{0}; //!< Number of sample frames in the file.
+    SampleFormat _format{SampleFormat::Float32}; //!< Encoding of the sample data.
+    uint32_t _channels{2}; //!< Number of interleaved channels in the file.
+    uint32_t _sampleRate{44100}; //!< Sample rate of the file.
+    size_t _bytesPerSample{4}; //!< Size of a single sample in bytes.
+
+    size_t _position{0}; //!< Next frame to deliver.
+    double _lastTime{0.0}; //!< Performance counter time of the last FillBuffer() call.
+    double _pendingFrames{0.0}; //!< Fractional number of frames owed to projectM in real-time mode.
+    bool _started{false}; //!< True after the first call to FillBuffer().
+    bool _endReached{false}; //!< True if a non-looping file has been played completely.
+
+    AudioDownmixer _downmixer; //!< Folds surround files down to stereo.
+    AudioResampler _resampler; //!< Converts the file's sample rate to OutputSampleFrequency.
+    std::vector<float> _decodeBuffer; //!< Preallocated buffer for decoded samples.
+    std::vector<float> _resampleBuffer; //!< Preallocated output buffer for the resampler.
+    AudioDelayLine _delayLine; //!< Delays the samples passed to projectM by the A/V sync offset.
+    AudioLevelMeter _levelMeter; //!< Analyzes each decoded chunk.
+
+    uint64_t _underruns{0}; //!< Number of frames delivered without audio data.
+    uint64_t _overruns{0}; //!< Number of frames which skipped audio data.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioCapture.File")}; //!< The class logger.
+};
@@ -0,0 +1,208 @@
+#include "AudioCaptureImpl_Impulse.h"
+
+#include "LatencyProbe.h"
+#include "ThreadScheduling.h"
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+constexpr double Pi{3.14159265358979323846};
+
+} // namespace
+
+constexpr float AudioCaptureImpl_Impulse::Amplitude;
+
+AudioCaptureImpl_Impulse::AudioCaptureImpl_Impulse()
+    : _latencyProbe(Poco::Util::Application::instance().getSubsystem<LatencyProbe>())
+    , _generatorThread(this, &AudioCaptureImpl_Impulse::GeneratorThread)
+    , _sampleQueue(AudioSampleQueue::OutputSampleFrequency / 2)
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    _periodFrames = config.getUInt("audio.impulse.period", 256);
+    _intervalFrames = static_cast<uint64_t>(config.getDouble("audio.impulse.interval", 1.0) * AudioSampleQueue::OutputSampleFrequency);
+    _durationFrames = static_cast<uint64_t>(config.getDouble("audio.impulse.duration", 0.1) * AudioSampleQueue::OutputSampleFrequency);
+    _frequency = config.getDouble("audio.impulse.frequency", 60.0);
+}
+
+AudioCaptureImpl_Impulse::~AudioCaptureImpl_Impulse()
+{
+    StopRecording();
+}
+
+std::map<int, std::string> AudioCaptureImpl_Impulse::AudioDeviceList()
+{
+    return {{-1, AudioDeviceName()}};
+}
+
+bool AudioCaptureImpl_Impulse::StartRecording(projectm* projectMHandle, int)
+{
+    StopRecording();
+
+    if (_periodFrames < 16 || _periodFrames > AudioSampleQueue::OutputSampleFrequency / 10 ||
+        _durationFrames == 0 || _durationFrames >= _intervalFrames)
+    {
+        poco_error(_logger, "Invalid impulse settings. The period must be between 16 and 4410 frames, and the impulse "
+                            "duration must be shorter than the interval.");
+        return false;
+    }
+
+    _projectMHandle = projectMHandle;
+    _generateBuffer.resize(_periodFrames * 2);
+    _framesConsumed = 0;
+    {
+        std::lock_guard<std::mutex> lock(_impulsesMutex);
+        _impulses.clear();
+    }
+
+    _sampleQueue.Configure(AudioSampleQueue::OutputSampleFrequency, 2, _periodFrames, _periodFrames);
+
+    _isGenerating = true;
+    _generatorThreadResult = _generatorThread();
+
+    poco_information_f3(_logger, "Generating %.0f Hz impulses every %.2f seconds in blocks of %?u frames.",
+                        _frequency, static_cast<double>(_intervalFrames) / AudioSampleQueue::OutputSampleFrequency,
+                        _periodFrames);
+
+    return true;
+}
+
+void AudioCaptureImpl_Impulse::StopRecording()
+{
+    if (!_isGenerating)
+    {
+        return;
+    }
+
+    _isGenerating = false;
+    _generatorThreadResult.wait();
+}
+
+int AudioCaptureImpl_Impulse::AudioDeviceIndex() const
+{
+    return -1;
+}
+
+std::string AudioCaptureImpl_Impulse::AudioDeviceName() const
+{
+    return "Impulse generator";
+}
+
+void AudioCaptureImpl_Impulse::FillBuffer()
+{
+    if (!_projectMHandle)
+    {
+        return;
+    }
+
+    _framesConsumed += _sampleQueue.Drain(_projectMHandle);
+    auto deliveryTime = LatencyProbe::Now();
+
+    std::lock_guard<std::mutex> lock(_impulsesMutex);
+    // The delay line holds back the onset by the sync delay after it was taken from the queue.
+    while (!_impulses.empty() && _impulses.front().onsetFrame + _syncDelayFrames < _framesConsumed)
+    {
+        const auto& impulse = _impulses.front();
+        _latencyProbe.ImpulseDelivered(impulse.emitTime, impulse.queueTime, deliveryTime);
+        _impulses.pop_front();
+    }
+}
+
+void AudioCaptureImpl_Impulse::SyncOffset(double offset)
+{
+    _sampleQueue.SyncOffset(offset);
+    _syncDelayFrames = offset > 0.0 ? static_cast<uint64_t>(offset * AudioSampleQueue::OutputSampleFrequency) : 0;
+}
+
+double AudioCaptureImpl_Impulse::Latency() const
+{
+    return _sampleQueue.Latency();
+}
+
+AudioLevelMeter& AudioCaptureImpl_Impulse::LevelMeter()
+{
+    return _sampleQueue.LevelMeter();
+}
+
+std::unique_ptr<AudioBroadcastRing::Reader> AudioCaptureImpl_Impulse::CreateReader() const
+{
+    return std::unique_ptr<AudioBroadcastRing::Reader>(new AudioBroadcastRing::Reader(_sampleQueue.CreateReader()));
+}
+
+uint64_t AudioCaptureImpl_Impulse::BufferUnderruns() const
+{
+    return _sampleQueue.Underruns();
+}
+
+uint64_t AudioCaptureImpl_Impulse::BufferOverruns() const
+{
+    return _sampleQueue.Overruns();
+}
+
+uint64_t AudioCaptureImpl_Impulse::MissedDeadlines() const
+{
+    return _sampleQueue.MissedDeadlines();
+}
+
+void AudioCaptureImpl_Impulse::GeneratorThread()
+{
+    ThreadScheduling::ForCapture().ApplyToCurrentThread();
+
+    auto startTime = LatencyProbe::Now();
+    uint64_t frame{0};
+
+    while (_isGenerating)
+    {
+        // A device delivers a block once its last sample has been recorded.
+        auto blockEndTime = startTime + static_cast<double>(frame + _periodFrames) / AudioSampleQueue::OutputSampleFrequency;
+        auto waitTime = blockEndTime - LatencyProbe::Now();
+        if (waitTime > 0.0)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<double>(waitTime));
+        }
+
+        Generate(frame, _generateBuffer.data());
+        _sampleQueue.Write(_generateBuffer.data(), _periodFrames);
+
+        // Onsets are at multiples of the interval. The first interval is silent, so the probe can settle on the
+        // preset's idle luminance.
+        auto onsetFrame = std::max<uint64_t>((frame + _intervalFrames - 1) / _intervalFrames, 1) * _intervalFrames;
+        if (onsetFrame < frame + _periodFrames)
+        {
+            Impulse impulse;
+            impulse.onsetFrame = onsetFrame;
+            impulse.emitTime = startTime + static_cast<double>(onsetFrame) / AudioSampleQueue::OutputSampleFrequency;
+            impulse.queueTime = LatencyProbe::Now();
+
+            std::lock_guard<std::mutex> lock(_impulsesMutex);
+            _impulses.push_back(impulse);
+        }
+
+        frame += _periodFrames;
+    }
+}
+
+void AudioCaptureImpl_Impulse::Generate(uint64_t firstFrame, float* output) const
+{
+    for (uint32_t index = 0; index < _periodFrames; index++)
+    {
+        auto frame = firstFrame + index;
+        auto position = frame % _intervalFrames;
+
+        float value{0.0f};
+        if (frame >= _intervalFrames && position < _durationFrames)
+        {
+            value = Amplitude * static_cast<float>(std::sin(2.0 * Pi * _frequency * static_cast<double>(position) /
+                                                            AudioSampleQueue::OutputSampleFrequency));
+        }
+
+        output[index * 2] = value;
+        output[index * 2 + 1] = value;
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "AudioCaptureImpl.h"
+#include "AudioSampleQueue.h"
+
+#include <Poco/ActiveMethod.h>
+#include <Poco/Logger.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class LatencyProbe;
+
+/**
+ * @brief Synthetic audio source emitting short low-frequency bursts at a fixed interval.
+ *
+ * Used by the latency measurement harness as a stand-in for a capture device. A generator thread
+ * produces blocks of audio.impulse.period frames in real time and writes each block into the sample
+ * queue once its last sample is due, just like a device driver delivering a full buffer. This way, the
+ * measured latency includes the same capture buffering and ring backlog as a real device.
+ *
+ * For each burst, the time its first sample was "recorded" and the time it was queued are kept. When
+ * FillBuffer() passes the burst onset to projectM, both are handed to the LatencyProbe together with
+ * the delivery time.
+ */
+class AudioCaptureImpl_Impulse : public AudioCaptureImpl
+{
+public:
+    AudioCaptureImpl_Impulse();
+
+    ~AudioCaptureImpl_Impulse() override;
+
+    /**
+     * @brief Returns a list with the generator as the only device.
+     * @return A map with a single entry.
+     */
+    std::map<int, std::string> AudioDeviceList() override;
+
+    /**
+     * @brief Starts the generator thread.
+     * @param projectMHandle projectM instance handle that will receive the audio data.
+     * @param audioDeviceIndex Ignored, as there is only one device.
+     * @return true if the generator settings are valid.
+     */
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
+
+    /**
+     * @brief Stops the generator thread.
+     */
+    void StopRecording() override;
+
+    /**
+     * @brief Returns the device index of the generator.
+     * @return Always -1, the generator is the backend's default and only device.
+     */
+    int AudioDeviceIndex() const override;
+
+    /**
+     * @brief Returns the generator's display name.
+     * @return A fixed name describing the generator.
+     */
+    std::string AudioDeviceName() const override;
+
+    /**
+     * @brief Passes the generated samples for the next frame to projectM and reports delivered bursts.
+     */
+    void FillBuffer() override;
+
+    /**
+     * @brief Delays the generated samples or lowers the buffering, depending on the offset's sign.
+     *
+     * The delay is included in the delivery time reported to the latency probe.
+     *
+     * @param offset The offset in seconds.
+     */
+    void SyncOffset(double offset) override;
+
+    /**
+     * @brief Returns the estimated capture latency.
+     * @return The device buffer duration, paced backlog and sync delay in seconds.
+     */
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the captured audio.
+     * @return The sample queue's level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Attaches an additional consumer to the sample queue.
+     * @return A new reader of the processed stream.
+     */
+    std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     * @return The underrun count since the generator was started.
+     */
+    uint64_t BufferUnderruns() const override;
+
+    /**
+     * @brief Returns the number of times generated samples had to be skipped.
+     * @return The overrun count since the generator was started.
+     */
+    uint64_t BufferOverruns() const override;
+
+    /**
+     * @brief Returns the number of times the generator thread didn't run in time.
+     * @return The missed deadline count since the generator was started.
+     */
+    uint64_t MissedDeadlines() const override;
+
+protected:
+    /**
+     * @brief Timing of a single burst on its way to the render thread.
+     */
+    struct Impulse
+    {
+        uint64_t onsetFrame{0}; //!< Index of the burst's first sample frame since the generator started.
+        double emitTime{0.0}; //!< Time the first sample would have been recorded by a device.
+        double queueTime{0.0}; //!< Time the block containing the first sample was written to the queue.
+    };
+
+    /**
+     * @brief Generates blocks in real time and writes them to the sample queue until stopped.
+     */
+    void GeneratorThread();
+
+    /**
+     * @brief Renders a block of the impulse signal.
+     * @param firstFrame Index of the first frame to generate.
+     * @param output Destination memory for _periodFrames stereo frames.
+     */
+    void Generate(uint64_t firstFrame, float* output) const;
+
+    static constexpr float Amplitude{0.8f}; //!< Peak level of the bursts.
+
+    uint32_t _periodFrames{256}; //!< Number of frames generated and queued at once.
+    uint64_t _intervalFrames{44100}; //!< Distance between two burst onsets in frames.
+    uint64_t _durationFrames{4410}; //!< Length of a burst in frames.
+    double _frequency{60.0}; //!< Tone frequency of the bursts in Hz.
+
+    projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
+    LatencyProbe& _latencyProbe; //!< Receives the timing of each delivered burst.
+
+    std::vector<float> _generateBuffer; //!< Preallocated buffer for one generated block.
+    uint64_t _framesConsumed{0}; //!< Number of frames taken from the queue by FillBuffer().
+    uint64_t _syncDelayFrames{0}; //!< Delay added by the A/V sync offset in frames.
+
+    std::mutex _impulsesMutex; //!< Protects _impulses, which is appended to by the generator thread.
+    std::deque<Impulse> _impulses; //!< Queued bursts not yet passed to projectM.
+
+    Poco::ActiveMethod<void, void, AudioCaptureImpl_Impulse> _generatorThread; //!< Active method running the generator thread.
+    Poco::ActiveResult<void> _generatorThreadResult{new Poco::ActiveResultHolder<void>()}; //!< Result of the generator thread.
+    std::atomic_bool _isGenerating{false}; //!< If true, the generator thread is running. It exits if set to false.
+
+    AudioSampleQueue _sampleQueue; //!< Ring receiving the generated samples, drained in FillBuffer().
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioCapture.Impulse")}; //!< The class logger.
+};
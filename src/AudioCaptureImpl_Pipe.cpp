@@ -0,0 +1,287 @@
+#include "AudioCaptureImpl_Pipe.h"
+
+#include "ThreadScheduling.h"
+
+#include <Poco/Thread.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char PipePrefix[] = "pipe:";
+constexpr size_t PipePrefixLength = sizeof(PipePrefix) - 1;
+
+constexpr char StdinPath[] = "-";
+
+} // namespace
+
+constexpr int AudioCaptureImpl_Pipe::PollTimeout;
+constexpr double AudioCaptureImpl_Pipe::StallTime;
+constexpr uint32_t AudioCaptureImpl_Pipe::PeriodFrames;
+constexpr size_t AudioCaptureImpl_Pipe::MaxFrameBytes;
+
+AudioCaptureImpl_Pipe::AudioCaptureImpl_Pipe()
+    : _readBuffer(PeriodFrames * MaxFrameBytes / sizeof(float))
+    , _readerThread(this, &AudioCaptureImpl_Pipe::ReaderThread)
+    , _sampleQueue(AudioSampleQueue::OutputSampleFrequency / 2)
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    auto deviceName = config.getString("audio.device", "");
+    _path = IsPipeDevice(deviceName) ? deviceName.substr(PipePrefixLength) : config.getString("audio.pipe.path", StdinPath);
+
+    _int16 = config.getString("audio.pipe.format", "f32") == "s16";
+    _channels = config.getUInt("audio.pipe.channels", 2);
+}
+
+AudioCaptureImpl_Pipe::~AudioCaptureImpl_Pipe()
+{
+    StopRecording();
+}
+
+bool AudioCaptureImpl_Pipe::IsPipeDevice(const std::string& deviceName)
+{
+    return deviceName.compare(0, PipePrefixLength, PipePrefix) == 0;
+}
+
+std::map<int, std::string> AudioCaptureImpl_Pipe::AudioDeviceList()
+{
+    return {{-1, AudioDeviceName()}};
+}
+
+bool AudioCaptureImpl_Pipe::StartRecording(projectm* projectMHandle, int)
+{
+    StopRecording();
+
+    _projectMHandle = projectMHandle;
+
+    auto format = Poco::Util::Application::instance().config().getString("audio.pipe.format", "f32");
+    if ((format != "f32" && format != "s16") || _channels < 1 || _channels > 2)
+    {
+        poco_error_f2(_logger, R"(Unsupported pipe input format "%s" with %?u channels. Use f32 or s16 with one or two channels.)",
+                      format, _channels);
+        return false;
+    }
+
+    _frameBytes = (_int16 ? sizeof(int16_t) : sizeof(float)) * _channels;
+    _partialFrameBytes = 0;
+    _stalled = false;
+
+    if (!OpenPipe())
+    {
+        return false;
+    }
+
+    _sampleQueue.Configure(AudioSampleQueue::OutputSampleFrequency, _channels, PeriodFrames, PeriodFrames);
+
+    _isCapturing = true;
+    _readerThreadResult = _readerThread();
+
+    poco_information_f3(_logger, R"(Reading %?u channel %s PCM data from "%s".)", _channels, format, _path);
+
+    return true;
+}
+
+void AudioCaptureImpl_Pipe::StopRecording()
+{
+    if (!_isCapturing && _fileDescriptor < 0)
+    {
+        return;
+    }
+
+    _isCapturing = false;
+    _readerThreadResult.wait();
+
+    ClosePipe();
+}
+
+int AudioCaptureImpl_Pipe::AudioDeviceIndex() const
+{
+    return -1;
+}
+
+std::string AudioCaptureImpl_Pipe::AudioDeviceName() const
+{
+    return PipePrefix + _path;
+}
+
+void AudioCaptureImpl_Pipe::FillBuffer()
+{
+    if (!_projectMHandle)
+    {
+        return;
+    }
+
+    _sampleQueue.Drain(_projectMHandle);
+}
+
+void AudioCaptureImpl_Pipe::SyncOffset(double offset)
+{
+    _sampleQueue.SyncOffset(offset);
+}
+
+double AudioCaptureImpl_Pipe::Latency() const
+{
+    return _sampleQueue.Latency();
+}
+
+AudioLevelMeter& AudioCaptureImpl_Pipe::LevelMeter()
+{
+    return _sampleQueue.LevelMeter();
+}
+
+std::unique_ptr<AudioBroadcastRing::Reader> AudioCaptureImpl_Pipe::CreateReader() const
+{
+    return std::unique_ptr<AudioBroadcastRing::Reader>(new AudioBroadcastRing::Reader(_sampleQueue.CreateReader()));
+}
+
+uint64_t AudioCaptureImpl_Pipe::BufferUnderruns() const
+{
+    return _sampleQueue.Underruns();
+}
+
+uint64_t AudioCaptureImpl_Pipe::BufferOverruns() const
+{
+    return _sampleQueue.Overruns();
+}
+
+bool AudioCaptureImpl_Pipe::OpenPipe()
+{
+    if (_path == StdinPath)
+    {
+        _fileDescriptor = STDIN_FILENO;
+        return true;
+    }
+
+    // Non-blocking, so opening a FIFO doesn't wait until a writer connects.
+    _fileDescriptor = open(_path.c_str(), O_RDONLY | O_NONBLOCK);
+    if (_fileDescriptor < 0)
+    {
+        poco_error_f2(_logger, R"(Could not open PCM input "%s": %s)", _path, std::string(std::strerror(errno)));
+        return false;
+    }
+
+    return true;
+}
+
+void AudioCaptureImpl_Pipe::ClosePipe()
+{
+    if (_fileDescriptor > STDIN_FILENO)
+    {
+        close(_fileDescriptor);
+    }
+
+    _fileDescriptor = -1;
+}
+
+void AudioCaptureImpl_Pipe::ReaderThread()
+{
+    ThreadScheduling::ForCapture().ApplyToCurrentThread();
+
+    auto lastDataTime = std::chrono::steady_clock::now();
+
+    while (_isCapturing)
+    {
+        pollfd pollDescriptor{_fileDescriptor, POLLIN, 0};
+        int ready = poll(&pollDescriptor, 1, PollTimeout);
+        if (ready < 0 && errno != EINTR)
+        {
+            poco_error_f1(_logger, "Polling the PCM input failed, reading stopped: %s", std::string(std::strerror(errno)));
+            break;
+        }
+
+        if (ready > 0)
+        {
+            if (!ReadIntoRing())
+            {
+                if (_path == StdinPath)
+                {
+                    poco_information(_logger, "End of PCM input on stdin reached, reading stopped.");
+                    break;
+                }
+
+                // The writer closed the FIFO. Reopen it, so the next writer can connect.
+                poco_information(_logger, "PCM input writer disconnected, waiting for a new one.");
+                ClosePipe();
+                _partialFrameBytes = 0;
+                if (!OpenPipe())
+                {
+                    break;
+                }
+                continue;
+            }
+
+            lastDataTime = std::chrono::steady_clock::now();
+            if (_stalled)
+            {
+                _stalled = false;
+                poco_information(_logger, "PCM input resumed.");
+            }
+            continue;
+        }
+
+        // Missing samples are counted as underruns by the pacer, this only adds a hint to the log.
+        std::chrono::duration<double> idleTime = std::chrono::steady_clock::now() - lastDataTime;
+        if (!_stalled && idleTime.count() > StallTime)
+        {
+            _stalled = true;
+            poco_warning_f1(_logger, "No PCM input received for %.1f seconds.", idleTime.count());
+        }
+    }
+}
+
+bool AudioCaptureImpl_Pipe::ReadIntoRing()
+{
+    auto maxFrames = std::min(_sampleQueue.WriteAvailable(), static_cast<size_t>(PeriodFrames));
+    if (maxFrames == 0)
+    {
+        // Ring is full. The render thread skips excess samples, so space will be available shortly.
+        Poco::Thread::sleep(1);
+        return true;
+    }
+
+    // Input frames are never larger than the output frames, so the raw data always fits into the buffer.
+    auto* samples = _readBuffer.data();
+    auto* bytes = reinterpret_cast<unsigned char*>(samples);
+    std::memcpy(bytes, _partialFrame, _partialFrameBytes);
+
+    auto bytesRead = read(_fileDescriptor, bytes + _partialFrameBytes, maxFrames * _frameBytes - _partialFrameBytes);
+    if (bytesRead == 0)
+    {
+        return false;
+    }
+    if (bytesRead < 0)
+    {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    size_t totalBytes = _partialFrameBytes + static_cast<size_t>(bytesRead);
+    size_t frames = totalBytes / _frameBytes;
+
+    _partialFrameBytes = totalBytes - frames * _frameBytes;
+    std::memcpy(_partialFrame, bytes + frames * _frameBytes, _partialFrameBytes);
+
+    if (_int16)
+    {
+        // Expand back to front, so each float only overwrites 16 bit samples which were already converted.
+        for (size_t sample = frames * _channels; sample-- > 0;)
+        {
+            int16_t value;
+            std::memcpy(&value, bytes + sample * sizeof(int16_t), sizeof(int16_t));
+            samples[sample] = static_cast<float>(value) / 32768.0f;
+        }
+    }
+
+    _sampleQueue.Write(samples, frames);
+
+    return true;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "AudioCaptureImpl.h"
+#include "AudioSampleQueue.h"
+
+#include <Poco/ActiveMethod.h>
+#include <Poco/Logger.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Audio source reading raw interleaved PCM data from stdin or a named pipe.
+ *
+ * Intended for audio pipelines which already have the samples in memory and would otherwise need a
+ * loopback device. Selected by setting audio.device to "pipe:<path>", where "pipe:-" reads from stdin, or
+ * with audio.backend set to "pipe" and the path in audio.pipe.path.
+ *
+ * The data must be 44.1 kHz mono or stereo, either 32 bit float (audio.pipe.format = f32) or signed 16 bit
+ * integer (s16) samples in native byte order. A reader thread reads the data in blocks of up to
+ * PeriodFrames frames, never more than the sample ring can take without overwriting unread samples, so a
+ * writer delivering faster than real time is throttled. 16 bit samples are expanded to float in place.
+ *
+ * If the writer stalls, the render thread receives fewer samples than required, which is reported as a
+ * buffer underrun. On a named pipe, the source waits for a new writer if the current one disconnects.
+ */
+class AudioCaptureImpl_Pipe : public AudioCaptureImpl
+{
+public:
+    /**
+     * @brief Creates a new pipe source.
+     *
+     * The path is taken from audio.device if it has the "pipe:" prefix, otherwise from audio.pipe.path.
+     */
+    AudioCaptureImpl_Pipe();
+
+    ~AudioCaptureImpl_Pipe() override;
+
+    /**
+     * @brief Checks whether a configured device name refers to a pipe.
+     * @param deviceName The audio.device value.
+     * @return true if the name starts with the "pipe:" prefix.
+     */
+    static bool IsPipeDevice(const std::string& deviceName);
+
+    /**
+     * @brief Returns a list with the pipe as the only device.
+     * @return A map with a single entry.
+     */
+    std::map<int, std::string> AudioDeviceList() override;
+
+    /**
+     * @brief Opens the pipe and starts the reader thread.
+     * @param projectMHandle projectM instance handle that will receive the audio data.
+     * @param audioDeviceIndex Ignored, as there is only one device.
+     * @return true if the pipe could be opened and the configured format is supported.
+     */
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
+
+    /**
+     * @brief Stops the reader thread and closes the pipe.
+     */
+    void StopRecording() override;
+
+    /**
+     * @brief Returns the device index of the pipe.
+     * @return Always -1, the pipe is the backend's default and only device.
+     */
+    int AudioDeviceIndex() const override;
+
+    /**
+     * @brief Returns the pipe's display name.
+     * @return The path with the "pipe:" prefix.
+     */
+    std::string AudioDeviceName() const override;
+
+    /**
+     * @brief Passes the received samples for the next frame to projectM.
+     */
+    void FillBuffer() override;
+
+    /**
+     * @brief Delays the captured samples or lowers the buffering, depending on the offset's sign.
+     * @param offset The offset in seconds.
+     */
+    void SyncOffset(double offset) override;
+
+    /**
+     * @brief Returns the estimated capture latency.
+     * @return The device buffer duration, paced backlog and sync delay in seconds.
+     */
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the captured audio.
+     * @return The sample queue's level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Attaches an additional consumer to the sample queue.
+     * @return A new reader of the processed stream.
+     */
+    std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required, e.g. due to a stalled writer.
+     * @return The underrun count since the pipe was opened.
+     */
+    uint64_t BufferUnderruns() const override;
+
+    /**
+     * @brief Returns the number of times received samples had to be skipped.
+     * @return The overrun count since the pipe was opened.
+     */
+    uint64_t BufferOverruns() const override;
+
+protected:
+    /**
+     * @brief Opens the configured path for non-blocking reading.
+     * @return true if the file descriptor is valid.
+     */
+    bool OpenPipe();
+
+    /**
+     * @brief Closes the pipe, unless it is stdin.
+     */
+    void ClosePipe();
+
+    /**
+     * @brief Reads from the pipe into the sample ring until stopped.
+     */
+    void ReaderThread();
+
+    /**
+     * @brief Reads available data and writes all complete sample frames into the ring.
+     * @return false on end of file or a read error, true otherwise.
+     */
+    bool ReadIntoRing();
+
+    static constexpr int PollTimeout{50}; //!< Max. time in milliseconds to wait for data before checking the stop flag.
+    static constexpr double StallTime{0.5}; //!< Time in seconds without data after which a stall is logged.
+    static constexpr uint32_t PeriodFrames{512}; //!< Expected number of frames per write, used as the pacer's base step.
+    static constexpr size_t MaxFrameBytes{8}; //!< Size of the largest supported sample frame (stereo float).
+
+    std::string _path{"-"}; //!< Path of the named pipe, or "-" for stdin.
+    bool _int16{false}; //!< If true, the input is signed 16 bit integer, otherwise float.
+    uint32_t _channels{2}; //!< Number of interleaved channels, 1 or 2.
+    size_t _frameBytes{8}; //!< Size of a single input sample frame in bytes.
+
+    projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
+    int _fileDescriptor{-1}; //!< The open pipe.
+
+    std::vector<float> _readBuffer; //!< Preallocated buffer receiving the raw data, large enough for PeriodFrames stereo float frames.
+    unsigned char _partialFrame[MaxFrameBytes]{}; //!< Bytes of an incomplete frame left over from the last read.
+    size_t _partialFrameBytes{0}; //!< Number of valid bytes in _partialFrame.
+    bool _stalled{false}; //!< True while the writer hasn't sent data for StallTime seconds.
+
+    Poco::ActiveMethod<void, void, AudioCaptureImpl_Pipe> _readerThread; //!< Active method running the reader thread.
+    Poco::ActiveResult<void> _readerThreadResult{new Poco::ActiveResultHolder<void>()}; //!< Result of the reader thread.
+    std::atomic_bool _isCapturing{false}; //!< If true, the reader thread is running. It exits if set to false.
+
+    AudioSampleQueue _sampleQueue; //!< Ring receiving the samples, drained in FillBuffer().
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioCapture.Pipe")}; //!< The class logger.
+};
@@ -0,0 +1,456 @@
+#include "AudioCaptureImpl_PipeWire.h"
+
+#include <spa/param/audio/format-utils.h>
+#include <spa/utils/result.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+constexpr char DefaultDeviceName[] = "Default capturing device";
+
+} // namespace
+
+constexpr double AudioCaptureImpl_PipeWire::ConnectTimeout;
+constexpr uint32_t AudioCaptureImpl_PipeWire::MaxQuantum;
+
+AudioCaptureImpl_PipeWire::AudioCaptureImpl_PipeWire()
+    : _sampleQueue(MaxQuantum * 4)
+{
+    _quantum = Poco::Util::Application::instance().config().getUInt("audio.quantum", 256);
+    _quantum = std::max(32U, std::min(_quantum, MaxQuantum));
+
+    _coreEvents.version = PW_VERSION_CORE_EVENTS;
+    _coreEvents.done = &AudioCaptureImpl_PipeWire::OnCoreDone;
+
+    _registryEvents.version = PW_VERSION_REGISTRY_EVENTS;
+    _registryEvents.global = &AudioCaptureImpl_PipeWire::OnRegistryGlobal;
+    _registryEvents.global_remove = &AudioCaptureImpl_PipeWire::OnRegistryGlobalRemove;
+
+    _streamEvents.version = PW_VERSION_STREAM_EVENTS;
+    _streamEvents.state_changed = &AudioCaptureImpl_PipeWire::OnStreamStateChanged;
+    _streamEvents.process = &AudioCaptureImpl_PipeWire::OnStreamProcess;
+
+    pw_init(nullptr, nullptr);
+}
+
+AudioCaptureImpl_PipeWire::~AudioCaptureImpl_PipeWire()
+{
+    StopRecording();
+    Disconnect();
+
+    pw_deinit();
+}
+
+std::map<int, std::string> AudioCaptureImpl_PipeWire::AudioDeviceList()
+{
+    std::map<int, std::string> deviceList{
+        {-1, DefaultDeviceName}};
+
+    if (!Connect())
+    {
+        return deviceList;
+    }
+
+    int index{0};
+    for (const auto& node : Nodes())
+    {
+        deviceList.insert(std::make_pair(index, node.isSink ? "Monitor of " + node.description : node.description));
+        index++;
+    }
+
+    return deviceList;
+}
+
+bool AudioCaptureImpl_PipeWire::StartRecording(projectm* projectMHandle, int audioDeviceIndex)
+{
+    _projectMHandle = projectMHandle;
+    _currentAudioDeviceIndex = audioDeviceIndex;
+
+    if (!Connect())
+    {
+        return false;
+    }
+
+    Node target;
+    auto nodes = Nodes();
+    bool hasTarget = audioDeviceIndex >= 0 && audioDeviceIndex < static_cast<int>(nodes.size());
+    if (hasTarget)
+    {
+        target = nodes.at(audioDeviceIndex);
+        _currentAudioDeviceName = target.isSink ? "Monitor of " + target.description : target.description;
+    }
+    else
+    {
+        _currentAudioDeviceIndex = -1;
+        _currentAudioDeviceName = DefaultDeviceName;
+    }
+
+    // The stream isn't connected yet, so the data thread can't access the queue.
+    _sampleQueue.Configure(AudioSampleQueue::OutputSampleFrequency, 2, MaxQuantum, _quantum);
+
+    pw_thread_loop_lock(_loop);
+
+    auto* props = pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio",
+                                    PW_KEY_MEDIA_CATEGORY, "Capture",
+                                    PW_KEY_MEDIA_ROLE, "Music",
+                                    PW_KEY_NODE_NAME, "projectM",
+                                    PW_KEY_NODE_DESCRIPTION, "projectM Visualizer",
+                                    nullptr);
+    pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%u/%u", _quantum, AudioSampleQueue::OutputSampleFrequency);
+    if (hasTarget)
+    {
+#ifdef PW_KEY_TARGET_OBJECT
+        pw_properties_set(props, PW_KEY_TARGET_OBJECT, target.name.c_str());
+#else
+        pw_properties_setf(props, PW_KEY_NODE_TARGET, "%u", target.id);
+#endif
+        if (target.isSink)
+        {
+            pw_properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, "true");
+        }
+    }
+
+    _streamState = PW_STREAM_STATE_UNCONNECTED;
+    _stream = pw_stream_new(_core, "projectM audio capture", props);
+    if (!_stream)
+    {
+        pw_thread_loop_unlock(_loop);
+        poco_error_f1(_logger, "pw_stream_new failed: %s", std::string(std::strerror(errno)));
+        return false;
+    }
+
+    pw_stream_add_listener(_stream, &_streamListener, &_streamEvents, this);
+
+    spa_audio_info_raw format{};
+    format.format = SPA_AUDIO_FORMAT_F32;
+    format.rate = AudioSampleQueue::OutputSampleFrequency;
+    format.channels = 2;
+    format.position[0] = SPA_AUDIO_CHANNEL_FL;
+    format.position[1] = SPA_AUDIO_CHANNEL_FR;
+
+    uint8_t podBuffer[1024];
+    spa_pod_builder builder{};
+    spa_pod_builder_init(&builder, podBuffer, sizeof(podBuffer));
+    const spa_pod* params[1]{spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &format)};
+
+    auto flags = static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_RT_PROCESS);
+    int result = pw_stream_connect(_stream, PW_DIRECTION_INPUT, PW_ID_ANY, flags, params, 1);
+
+    // Wait until the stream is either running or has failed, so a broken setup can fall back to another backend.
+    while (result >= 0 && _streamState != PW_STREAM_STATE_STREAMING && _streamState != PW_STREAM_STATE_PAUSED &&
+           _streamState != PW_STREAM_STATE_ERROR)
+    {
+        if (pw_thread_loop_timed_wait(_loop, static_cast<int>(ConnectTimeout)) != 0)
+        {
+            result = -ETIMEDOUT;
+        }
+    }
+
+    bool started = result >= 0 && _streamState != PW_STREAM_STATE_ERROR;
+
+    pw_thread_loop_unlock(_loop);
+
+    if (!started)
+    {
+        poco_error_f2(_logger, R"(Failed to start PipeWire capture from "%s": %s)", _currentAudioDeviceName,
+                      std::string(result < 0 ? spa_strerror(result) : "stream error"));
+        StopRecording();
+        return false;
+    }
+
+    poco_information_f2(_logger, R"(Capturing audio from "%s" with a quantum of %?u frames.)", _currentAudioDeviceName, _quantum);
+
+    return true;
+}
+
+void AudioCaptureImpl_PipeWire::StopRecording()
+{
+    if (!_stream)
+    {
+        return;
+    }
+
+    pw_thread_loop_lock(_loop);
+    spa_hook_remove(&_streamListener);
+    pw_stream_disconnect(_stream);
+    pw_stream_destroy(_stream);
+    _stream = nullptr;
+    pw_thread_loop_unlock(_loop);
+
+    poco_debug(_logger, "Stopped audio recording and destroyed stream.");
+}
+
+int AudioCaptureImpl_PipeWire::AudioDeviceIndex() const
+{
+    return _currentAudioDeviceIndex;
+}
+
+std::string AudioCaptureImpl_PipeWire::AudioDeviceName() const
+{
+    return _currentAudioDeviceName;
+}
+
+void AudioCaptureImpl_PipeWire::FillBuffer()
+{
+    if (!_stream || !_projectMHandle)
+    {
+        return;
+    }
+
+    _sampleQueue.Drain(_projectMHandle);
+}
+
+void AudioCaptureImpl_PipeWire::SyncOffset(double offset)
+{
+    _sampleQueue.SyncOffset(offset);
+}
+
+double AudioCaptureImpl_PipeWire::Latency() const
+{
+    return _sampleQueue.Latency();
+}
+
+AudioLevelMeter& AudioCaptureImpl_PipeWire::LevelMeter()
+{
+    return _sampleQueue.LevelMeter();
+}
+
+std::unique_ptr<AudioBroadcastRing::Reader> AudioCaptureImpl_PipeWire::CreateReader() const
+{
+    return std::unique_ptr<AudioBroadcastRing::Reader>(new AudioBroadcastRing::Reader(_sampleQueue.CreateReader()));
+}
+
+uint64_t AudioCaptureImpl_PipeWire::BufferUnderruns() const
+{
+    return _sampleQueue.Underruns();
+}
+
+uint64_t AudioCaptureImpl_PipeWire::BufferOverruns() const
+{
+    return _sampleQueue.Overruns();
+}
+
+uint64_t AudioCaptureImpl_PipeWire::MissedDeadlines() const
+{
+    return _sampleQueue.MissedDeadlines();
+}
+
+bool AudioCaptureImpl_PipeWire::Connect()
+{
+    if (_core)
+    {
+        return true;
+    }
+
+    if (!_loop)
+    {
+        _loop = pw_thread_loop_new("projectM-pipewire", nullptr);
+        if (!_loop || pw_thread_loop_start(_loop) < 0)
+        {
+            poco_error(_logger, "Could not start the PipeWire thread loop.");
+            Disconnect();
+            return false;
+        }
+    }
+
+    pw_thread_loop_lock(_loop);
+
+    _context = pw_context_new(pw_thread_loop_get_loop(_loop), nullptr, 0);
+    if (_context)
+    {
+        _core = pw_context_connect(_context, nullptr, 0);
+    }
+
+    if (!_core)
+    {
+        pw_thread_loop_unlock(_loop);
+        poco_error_f1(_logger, "Could not connect to the PipeWire daemon: %s", std::string(std::strerror(errno)));
+        Disconnect();
+        return false;
+    }
+
+    pw_core_add_listener(_core, &_coreListener, &_coreEvents, this);
+
+    _registry = pw_core_get_registry(_core, PW_VERSION_REGISTRY, 0);
+    pw_registry_add_listener(_registry, &_registryListener, &_registryEvents, this);
+
+    // Wait for the initial list of globals, so the device list is complete on first use.
+    _synced = false;
+    _syncSequence = pw_core_sync(_core, PW_ID_CORE, 0);
+    while (!_synced)
+    {
+        if (pw_thread_loop_timed_wait(_loop, static_cast<int>(ConnectTimeout)) != 0)
+        {
+            poco_warning(_logger, "Timed out waiting for the PipeWire registry, device list may be incomplete.");
+            break;
+        }
+    }
+
+    pw_thread_loop_unlock(_loop);
+
+    return true;
+}
+
+void AudioCaptureImpl_PipeWire::Disconnect()
+{
+    if (_loop)
+    {
+        pw_thread_loop_lock(_loop);
+    }
+
+    if (_registry)
+    {
+        spa_hook_remove(&_registryListener);
+        pw_proxy_destroy(reinterpret_cast<pw_proxy*>(_registry));
+        _registry = nullptr;
+    }
+
+    if (_core)
+    {
+        spa_hook_remove(&_coreListener);
+        pw_core_disconnect(_core);
+        _core = nullptr;
+    }
+
+    if (_context)
+    {
+        pw_context_destroy(_context);
+        _context = nullptr;
+    }
+
+    if (_loop)
+    {
+        pw_thread_loop_unlock(_loop);
+        pw_thread_loop_stop(_loop);
+        pw_thread_loop_destroy(_loop);
+        _loop = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_nodesMutex);
+    _nodes.clear();
+}
+
+std::vector<AudioCaptureImpl_PipeWire::Node> AudioCaptureImpl_PipeWire::Nodes() const
+{
+    std::lock_guard<std::mutex> lock(_nodesMutex);
+    return _nodes;
+}
+
+void AudioCaptureImpl_PipeWire::OnRegistryGlobal(void* data, uint32_t id, uint32_t, const char* type, uint32_t,
+                                                 const struct spa_dict* props)
+{
+    auto* instance = static_cast<AudioCaptureImpl_PipeWire*>(data);
+
+    if (props == nullptr || std::strcmp(type, PW_TYPE_INTERFACE_Node) != 0)
+    {
+        return;
+    }
+
+    const char* mediaClass = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
+    const char* name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+    if (mediaClass == nullptr || name == nullptr)
+    {
+        return;
+    }
+
+    Node node;
+    node.id = id;
+    node.name = name;
+
+    if (std::strcmp(mediaClass, "Audio/Sink") == 0)
+    {
+        node.isSink = true;
+    }
+    else if (std::strcmp(mediaClass, "Audio/Source") != 0)
+    {
+        return;
+    }
+
+    const char* description = spa_dict_lookup(props, PW_KEY_NODE_DESCRIPTION);
+    node.description = description != nullptr ? description : name;
+
+    poco_trace_f3(instance->_logger, R"(PipeWire node %?u added: "%s" (sink: %b))", id, node.description, node.isSink);
+
+    std::lock_guard<std::mutex> lock(instance->_nodesMutex);
+    instance->_nodes.push_back(std::move(node));
+}
+
+void AudioCaptureImpl_PipeWire::OnRegistryGlobalRemove(void* data, uint32_t id)
+{
+    auto* instance = static_cast<AudioCaptureImpl_PipeWire*>(data);
+
+    std::lock_guard<std::mutex> lock(instance->_nodesMutex);
+    for (auto node = instance->_nodes.begin(); node != instance->_nodes.end(); ++node)
+    {
+        if (node->id == id)
+        {
+            poco_trace_f1(instance->_logger, "PipeWire node %?u removed.", id);
+            instance->_nodes.erase(node);
+            break;
+        }
+    }
+}
+
+void AudioCaptureImpl_PipeWire::OnCoreDone(void* data, uint32_t id, int seq)
+{
+    auto* instance = static_cast<AudioCaptureImpl_PipeWire*>(data);
+
+    if (id == PW_ID_CORE && seq == instance->_syncSequence)
+    {
+        instance->_synced = true;
+        pw_thread_loop_signal(instance->_loop, false);
+    }
+}
+
+void AudioCaptureImpl_PipeWire::OnStreamStateChanged(void* data, enum pw_stream_state, enum pw_stream_state state, const char* error)
+{
+    auto* instance = static_cast<AudioCaptureImpl_PipeWire*>(data);
+
+    if (state == PW_STREAM_STATE_ERROR)
+    {
+        poco_error_f1(instance->_logger, "PipeWire stream error: %s", std::string(error != nullptr ? error : "unknown"));
+    }
+    else
+    {
+        poco_debug_f1(instance->_logger, "PipeWire stream state changed to %s.", std::string(pw_stream_state_as_string(state)));
+    }
+
+    instance->_streamState = state;
+    pw_thread_loop_signal(instance->_loop, false);
+}
+
+void AudioCaptureImpl_PipeWire::OnStreamProcess(void* data)
+{
+    auto* instance = static_cast<AudioCaptureImpl_PipeWire*>(data);
+
+    auto* buffer = pw_stream_dequeue_buffer(instance->_stream);
+    if (buffer == nullptr)
+    {
+        return;
+    }
+
+    const auto& bufferData = buffer->buffer->datas[0];
+    if (bufferData.data != nullptr && bufferData.chunk != nullptr)
+    {
+        uint32_t offset = std::min(bufferData.chunk->offset, bufferData.maxsize);
+        uint32_t size = std::min(bufferData.chunk->size, bufferData.maxsize - offset);
+
+        const auto* samples = reinterpret_cast<const float*>(static_cast<const uint8_t*>(bufferData.data) + offset);
+        size_t frames = size / (sizeof(float) * 2);
+
+        while (frames > 0)
+        {
+            auto chunkFrames = std::min(frames, static_cast<size_t>(MaxQuantum));
+            instance->_sampleQueue.Write(samples, chunkFrames);
+            samples += chunkFrames * 2;
+            frames -= chunkFrames;
+        }
+    }
+
+    pw_stream_queue_buffer(instance->_stream, buffer);
+}
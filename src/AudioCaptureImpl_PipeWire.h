@@ -0,0 +1,177 @@
+#pragma once
+
+#include "AudioCaptureImpl.h"
+#include "AudioSampleQueue.h"
+
+#include <pipewire/pipewire.h>
+
+#include <Poco/Logger.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Native PipeWire capture backend.
+ *
+ * Captures audio with a PipeWire stream instead of going through SDL's PulseAudio emulation layer. This
+ * allows requesting a small processing quantum (audio.quantum, 256 frames by default) for low latency.
+ * The stream requests 44.1 kHz stereo float data, so PipeWire's adapter handles any format conversion.
+ *
+ * Input devices and sink monitors are enumerated directly from the PipeWire registry, which is kept up
+ * to date in the background. The stream's process callback runs on PipeWire's real-time data thread and
+ * only writes into the lock-free sample queue.
+ */
+class AudioCaptureImpl_PipeWire : public AudioCaptureImpl
+{
+public:
+    AudioCaptureImpl_PipeWire();
+
+    ~AudioCaptureImpl_PipeWire() override;
+
+    /**
+     * @brief Returns a map of available recording devices and sink monitors.
+     * @return A vector of available audio device IDs and names.
+     */
+    std::map<int, std::string> AudioDeviceList() override;
+
+    /**
+     * @brief Connects to PipeWire and starts capturing from the given device.
+     * @param projectMHandle projectM instance handle that will receive the captured data.
+     * @param audioDeviceIndex The audio device index to capture from. Use -1 for the default input device.
+     * @return true if the stream started, false if PipeWire is not available or the stream failed.
+     */
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
+
+    /**
+     * @brief Disconnects and destroys the capture stream.
+     */
+    void StopRecording() override;
+
+    /**
+     * @brief Returns the currently used Audio device index.
+     * @return The index of the current audio device, as listed by @a AudioDeviceList()
+     */
+    int AudioDeviceIndex() const override;
+
+    /**
+     * @brief Retrieves the current audio device name.
+     * @return The name of the currently selected audio recording device.
+     */
+    std::string AudioDeviceName() const override;
+
+    /**
+     * @brief Passes the captured samples for the next frame to projectM.
+     */
+    void FillBuffer() override;
+
+    /**
+     * @brief Delays the captured samples or lowers the buffering, depending on the offset's sign.
+     * @param offset The offset in seconds.
+     */
+    void SyncOffset(double offset) override;
+
+    /**
+     * @brief Returns the estimated capture latency.
+     * @return The device buffer duration, paced backlog and sync delay in seconds.
+     */
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the captured audio.
+     * @return The sample queue's level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Attaches an additional consumer to the sample queue.
+     * @return A new reader of the processed stream.
+     */
+    std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     * @return The underrun count since the stream was started.
+     */
+    uint64_t BufferUnderruns() const override;
+
+    /**
+     * @brief Returns the number of times captured samples had to be dropped.
+     * @return The overrun count since the stream was started.
+     */
+    uint64_t BufferOverruns() const override;
+
+    /**
+     * @brief Returns the number of times the capture thread didn't run in time.
+     * @return The missed deadline count since the stream was started.
+     */
+    uint64_t MissedDeadlines() const override;
+
+protected:
+    /**
+     * @brief A capture node announced by the PipeWire registry.
+     */
+    struct Node
+    {
+        uint32_t id{0}; //!< Registry object ID.
+        std::string name; //!< Unique node name, used as the stream target.
+        std::string description; //!< Human-readable description.
+        bool isSink{false}; //!< If true, the node is an output device and its monitor is captured.
+    };
+
+    /**
+     * @brief Connects to the PipeWire daemon and starts listening to the registry.
+     * @return true if the connection was established.
+     */
+    bool Connect();
+
+    /**
+     * @brief Disconnects from the PipeWire daemon.
+     */
+    void Disconnect();
+
+    /**
+     * @brief Returns a copy of the currently known capture nodes.
+     * @return The list of nodes, in the order they were announced.
+     */
+    std::vector<Node> Nodes() const;
+
+    static void OnRegistryGlobal(void* data, uint32_t id, uint32_t permissions, const char* type, uint32_t version,
+                                 const struct spa_dict* props);
+    static void OnRegistryGlobalRemove(void* data, uint32_t id);
+    static void OnCoreDone(void* data, uint32_t id, int seq);
+    static void OnStreamStateChanged(void* data, enum pw_stream_state old, enum pw_stream_state state, const char* error);
+    static void OnStreamProcess(void* data);
+
+    static constexpr double ConnectTimeout{2.0}; //!< Max. time in seconds to wait for the daemon or stream to respond.
+    static constexpr uint32_t MaxQuantum{8192}; //!< Largest quantum PipeWire may deliver in a single buffer.
+
+    projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
+    int _currentAudioDeviceIndex{-1}; //!< Currently selected audio device index.
+    std::string _currentAudioDeviceName; //!< Display name of the currently captured device.
+    uint32_t _quantum{256}; //!< Requested processing quantum in frames.
+
+    pw_thread_loop* _loop{nullptr}; //!< PipeWire thread loop running all callbacks.
+    pw_context* _context{nullptr}; //!< PipeWire context.
+    pw_core* _core{nullptr}; //!< Connection to the PipeWire daemon.
+    pw_registry* _registry{nullptr}; //!< Registry proxy used to enumerate nodes.
+    pw_stream* _stream{nullptr}; //!< The capture stream, if recording.
+
+    spa_hook _coreListener{}; //!< Listener for core events.
+    spa_hook _registryListener{}; //!< Listener for registry events.
+    spa_hook _streamListener{}; //!< Listener for stream events.
+    pw_core_events _coreEvents{}; //!< Core event callbacks.
+    pw_registry_events _registryEvents{}; //!< Registry event callbacks.
+    pw_stream_events _streamEvents{}; //!< Stream event callbacks.
+
+    int _syncSequence{0}; //!< Sequence number of the pending core roundtrip.
+    bool _synced{false}; //!< True after the initial registry roundtrip completed.
+    pw_stream_state _streamState{PW_STREAM_STATE_UNCONNECTED}; //!< Last known stream state.
+
+    mutable std::mutex _nodesMutex; //!< Protects _nodes, which is modified on the PipeWire thread.
+    std::vector<Node> _nodes; //!< Known capture nodes.
+
+    AudioSampleQueue _sampleQueue; //!< Buffers the captured samples until FillBuffer() is called.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioCapture.PipeWire")}; //!< The class logger.
+};
@@ -0,0 +1,163 @@
+#include "AudioCaptureImpl_Pulse.h"
+
+#include "ThreadScheduling.h"
+
+#include <pulse/error.h>
+#include <pulse/simple.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+
+namespace {
+
+constexpr char DefaultSourceName[] = "Default capturing device";
+constexpr char DefaultMonitorName[] = "Monitor of default output device";
+
+} // namespace
+
+constexpr uint32_t AudioCaptureImpl_Pulse::MaxQuantum;
+
+AudioCaptureImpl_Pulse::AudioCaptureImpl_Pulse()
+    : _captureThread(this, &AudioCaptureImpl_Pulse::CaptureThread)
+    , _sampleQueue(MaxQuantum * 4)
+{
+    _quantum = Poco::Util::Application::instance().config().getUInt("audio.quantum", 256);
+    _quantum = std::max(32U, std::min(_quantum, MaxQuantum));
+    _readBuffer.resize(_quantum * 2);
+}
+
+AudioCaptureImpl_Pulse::~AudioCaptureImpl_Pulse()
+{
+    StopRecording();
+}
+
+std::map<int, std::string> AudioCaptureImpl_Pulse::AudioDeviceList()
+{
+    return {
+        {-1, DefaultSourceName},
+        {0, DefaultMonitorName}};
+}
+
+bool AudioCaptureImpl_Pulse::StartRecording(projectm* projectMHandle, int audioDeviceIndex)
+{
+    _projectMHandle = projectMHandle;
+    _currentAudioDeviceIndex = audioDeviceIndex == 0 ? 0 : -1;
+
+    pa_sample_spec sampleSpec{};
+    sampleSpec.format = PA_SAMPLE_FLOAT32LE;
+    sampleSpec.rate = AudioSampleQueue::OutputSampleFrequency;
+    sampleSpec.channels = 2;
+
+    // Ask the server to deliver data in blocks of one quantum instead of its default of ~2 seconds.
+    pa_buffer_attr bufferAttributes{};
+    bufferAttributes.maxlength = static_cast<uint32_t>(-1);
+    bufferAttributes.fragsize = _quantum * 2 * sizeof(float);
+
+    int error{0};
+    _connection = pa_simple_new(nullptr, "projectM", PA_STREAM_RECORD,
+                                _currentAudioDeviceIndex == 0 ? "@DEFAULT_MONITOR@" : nullptr,
+                                "Visualizer input", &sampleSpec, nullptr, &bufferAttributes, &error);
+    if (!_connection)
+    {
+        poco_error_f1(_logger, "Failed to open PulseAudio record stream: %s", std::string(pa_strerror(error)));
+        return false;
+    }
+
+    _sampleQueue.Configure(AudioSampleQueue::OutputSampleFrequency, 2, _quantum, _quantum);
+
+    _isCapturing = true;
+    _captureThreadResult = _captureThread();
+
+    poco_information_f2(_logger, R"(Capturing audio from "%s" in blocks of %?u frames.)", AudioDeviceName(), _quantum);
+
+    return true;
+}
+
+void AudioCaptureImpl_Pulse::StopRecording()
+{
+    _isCapturing = false;
+
+    if (_connection)
+    {
+        // The capture thread was started with the connection, but may already have exited on a read error.
+        _captureThreadResult.wait();
+        pa_simple_free(_connection);
+        _connection = nullptr;
+
+        poco_debug(_logger, "Stopped audio recording and closed record stream.");
+    }
+}
+
+int AudioCaptureImpl_Pulse::AudioDeviceIndex() const
+{
+    return _currentAudioDeviceIndex;
+}
+
+std::string AudioCaptureImpl_Pulse::AudioDeviceName() const
+{
+    return _currentAudioDeviceIndex == 0 ? DefaultMonitorName : DefaultSourceName;
+}
+
+void AudioCaptureImpl_Pulse::FillBuffer()
+{
+    if (!_isCapturing || !_projectMHandle)
+    {
+        return;
+    }
+
+    _sampleQueue.Drain(_projectMHandle);
+}
+
+void AudioCaptureImpl_Pulse::SyncOffset(double offset)
+{
+    _sampleQueue.SyncOffset(offset);
+}
+
+double AudioCaptureImpl_Pulse::Latency() const
+{
+    return _sampleQueue.Latency();
+}
+
+AudioLevelMeter& AudioCaptureImpl_Pulse::LevelMeter()
+{
+    return _sampleQueue.LevelMeter();
+}
+
+std::unique_ptr<AudioBroadcastRing::Reader> AudioCaptureImpl_Pulse::CreateReader() const
+{
+    return std::unique_ptr<AudioBroadcastRing::Reader>(new AudioBroadcastRing::Reader(_sampleQueue.CreateReader()));
+}
+
+uint64_t AudioCaptureImpl_Pulse::BufferUnderruns() const
+{
+    return _sampleQueue.Underruns();
+}
+
+uint64_t AudioCaptureImpl_Pulse::BufferOverruns() const
+{
+    return _sampleQueue.Overruns();
+}
+
+uint64_t AudioCaptureImpl_Pulse::MissedDeadlines() const
+{
+    return _sampleQueue.MissedDeadlines();
+}
+
+void AudioCaptureImpl_Pulse::CaptureThread()
+{
+    ThreadScheduling::ForCapture().ApplyToCurrentThread();
+
+    while (_isCapturing)
+    {
+        int error{0};
+        if (pa_simple_read(_connection, _readBuffer.data(), _readBuffer.size() * sizeof(float), &error) < 0)
+        {
+            poco_error_f1(_logger, "Reading from PulseAudio failed, capturing stopped: %s", std::string(pa_strerror(error)));
+            _isCapturing = false;
+            break;
+        }
+
+        _sampleQueue.Write(_readBuffer.data(), _quantum);
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "AudioCaptureImpl.h"
+#include "AudioSampleQueue.h"
+
+#include <Poco/ActiveMethod.h>
+#include <Poco/Logger.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+struct pa_simple;
+
+/**
+ * @brief PulseAudio capture backend using the "simple" client API.
+ *
+ * Used on systems running a PulseAudio daemon without PipeWire, or if projectMSDL was built without
+ * PipeWire support. Reads blocks of audio.quantum frames on a separate capture thread, which keeps the
+ * latency well below SDL's default buffer sizes.
+ *
+ * The simple API can't enumerate devices, so only the default source and the monitor of the default
+ * sink are offered.
+ */
+class AudioCaptureImpl_Pulse : public AudioCaptureImpl
+{
+public:
+    AudioCaptureImpl_Pulse();
+
+    ~AudioCaptureImpl_Pulse() override;
+
+    /**
+     * @brief Returns the default source and the monitor of the default sink.
+     * @return A vector of available audio device IDs and names.
+     */
+    std::map<int, std::string> AudioDeviceList() override;
+
+    /**
+     * @brief Connects to PulseAudio and starts the capture thread.
+     * @param projectMHandle projectM instance handle that will receive the captured data.
+     * @param audioDeviceIndex -1 for the default source, 0 for the default sink monitor.
+     * @return true if the record stream was created, false if the daemon isn't reachable.
+     */
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
+
+    /**
+     * @brief Stops the capture thread and closes the record stream.
+     */
+    void StopRecording() override;
+
+    /**
+     * @brief Returns the currently used Audio device index.
+     * @return The index of the current audio device, as listed by @a AudioDeviceList()
+     */
+    int AudioDeviceIndex() const override;
+
+    /**
+     * @brief Retrieves the current audio device name.
+     * @return The name of the currently selected audio recording device.
+     */
+    std::string AudioDeviceName() const override;
+
+    /**
+     * @brief Passes the captured samples for the next frame to projectM.
+     */
+    void FillBuffer() override;
+
+    /**
+     * @brief Delays the captured samples or lowers the buffering, depending on the offset's sign.
+     * @param offset The offset in seconds.
+     */
+    void SyncOffset(double offset) override;
+
+    /**
+     * @brief Returns the estimated capture latency.
+     * @return The device buffer duration, paced backlog and sync delay in seconds.
+     */
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the captured audio.
+     * @return The sample queue's level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Attaches an additional consumer to the sample queue.
+     * @return A new reader of the processed stream.
+     */
+    std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     * @return The underrun count since the stream was started.
+     */
+    uint64_t BufferUnderruns() const override;
+
+    /**
+     * @brief Returns the number of times captured samples had to be dropped.
+     * @return The overrun count since the stream was started.
+     */
+    uint64_t BufferOverruns() const override;
+
+    /**
+     * @brief Returns the number of times the capture thread didn't run in time.
+     * @return The missed deadline count since the stream was started.
+     */
+    uint64_t MissedDeadlines() const override;
+
+protected:
+    /**
+     * @brief Reads blocks from the record stream and writes them into the sample queue until stopped.
+     */
+    void CaptureThread();
+
+    static constexpr uint32_t MaxQuantum{8192}; //!< Largest read block size in frames.
+
+    projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
+    int _currentAudioDeviceIndex{-1}; //!< Currently selected audio device index.
+    uint32_t _quantum{256}; //!< Number of frames read at once.
+
+    pa_simple* _connection{nullptr}; //!< The record stream connection.
+    std::vector<float> _readBuffer; //!< Buffer receiving one block of samples.
+
+    Poco::ActiveMethod<void, void, AudioCaptureImpl_Pulse> _captureThread; //!< Active method running the capture thread.
+    Poco::ActiveResult<void> _captureThreadResult{new Poco::ActiveResultHolder<void>()}; //!< Result of the capture thread.
+    std::atomic_bool _isCapturing{false}; //!< If true, capturing is running. Capture thread will exit if set to false.
+
+    AudioSampleQueue _sampleQueue; //!< Buffers the captured samples until FillBuffer() is called.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioCapture.Pulse")}; //!< The class logger.
+};
@@ -4,30 +4,52 @@
 
 #include <projectM-4/projectM.h>
 
-AudioCaptureImpl::AudioCaptureImpl()
-    : _requestedSampleCount(projectm_pcm_get_max_samples())
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Returns the initial SDL buffer size in samples, based on the configured FPS.
+ * @param sampleFrequency The sample frequency the device is opened with.
+ * @return The number of samples SDL should deliver per callback.
+ */
+uint32_t RequestedSampleCount(uint32_t sampleFrequency)
 {
+    uint32_t requestedSampleCount = projectm_pcm_get_max_samples();
+
     auto targetFps = Poco::Util::Application::instance().config().getUInt("projectM.fps", 60);
     if (targetFps > 0)
     {
-        _requestedSampleCount = std::min(_requestedSampleFrequency / targetFps, _requestedSampleCount);
+        requestedSampleCount = std::min(sampleFrequency / targetFps, requestedSampleCount);
         // Don't let the buffer get too small to prevent excessive updates calls.
         // 300 samples is enough for 144 FPS.
-        _requestedSampleCount = std::max(_requestedSampleCount, 300U);
+        requestedSampleCount = std::max(requestedSampleCount, 300U);
     }
 
+    return requestedSampleCount;
+}
+
+} // namespace
+
+AudioCaptureImpl_SDL::AudioCaptureImpl_SDL()
+    : _requestedSampleCount(RequestedSampleCount(AudioSampleQueue::OutputSampleFrequency))
+    , _threadScheduling(ThreadScheduling::ForCapture())
+    , _sampleQueue(_requestedSampleCount * _bufferedCallbackCount)
+{
+    _useNativeSampleFrequency = Poco::Util::Application::instance().config().getBool("audio.nativeSampleRate", true);
+
 #ifdef SDL_HINT_AUDIO_INCLUDE_MONITORS
     SDL_SetHint(SDL_HINT_AUDIO_INCLUDE_MONITORS, "1");
 #endif
     SDL_InitSubSystem(SDL_INIT_AUDIO);
 }
 
-AudioCaptureImpl::~AudioCaptureImpl()
+AudioCaptureImpl_SDL::~AudioCaptureImpl_SDL()
 {
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 }
 
-std::map<int, std::string> AudioCaptureImpl::AudioDeviceList()
+std::map<int, std::string> AudioCaptureImpl_SDL::AudioDeviceList()
 {
     std::map<int, std::string> deviceList{
         {-1, "Default capturing device"}};
@@ -50,22 +72,26 @@ std::map<int, std::string> AudioCaptureImpl::AudioDeviceList()
     return deviceList;
 }
 
-void AudioCaptureImpl::StartRecording(projectm* projectMHandle, int audioDeviceIndex)
+bool AudioCaptureImpl_SDL::StartRecording(projectm* projectMHandle, int audioDeviceIndex)
 {
     _projectMHandle = projectMHandle;
     _currentAudioDeviceIndex = audioDeviceIndex;
 
     poco_debug_f1(_logger, "Using SDL audio driver \"%s\".", std::string(SDL_GetCurrentAudioDriver()));
 
-    if (OpenAudioDevice())
+    if (!OpenAudioDevice())
     {
-        SDL_PauseAudioDevice(_currentAudioDeviceID, false);
-
-        poco_debug(_logger, "Started audio recording.");
+        return false;
     }
+
+    SDL_PauseAudioDevice(_currentAudioDeviceID, false);
+
+    poco_debug(_logger, "Started audio recording.");
+
+    return true;
 }
 
-void AudioCaptureImpl::StopRecording()
+void AudioCaptureImpl_SDL::StopRecording()
 {
     if (_currentAudioDeviceID)
     {
@@ -77,32 +103,62 @@ void AudioCaptureImpl::StopRecording()
     }
 }
 
-void AudioCaptureImpl::NextAudioDevice()
+void AudioCaptureImpl_SDL::FillBuffer()
 {
-    StopRecording();
+    if (!_currentAudioDeviceID || !_projectMHandle)
+    {
+        return;
+    }
 
-    // Will wrap around to default capture device (-1).
-    int nextAudioDeviceId = ((_currentAudioDeviceIndex + 2) % (SDL_GetNumAudioDevices(true) + 1)) - 1;
+    if (!_audioThreadScheduled && _audioThreadIdPublished.load(std::memory_order_acquire))
+    {
+        ApplyThreadScheduling();
+    }
 
-    StartRecording(_projectMHandle, nextAudioDeviceId);
+    _sampleQueue.Drain(_projectMHandle);
 }
 
-void AudioCaptureImpl::AudioDeviceIndex(int index)
+void AudioCaptureImpl_SDL::SyncOffset(double offset)
 {
-    if (index >= -1 && index < SDL_GetNumAudioDevices(true))
-    {
-        StopRecording();
-        _currentAudioDeviceIndex = index;
-        StartRecording(_projectMHandle, index);
-    }
+    _sampleQueue.SyncOffset(offset);
+}
+
+double AudioCaptureImpl_SDL::Latency() const
+{
+    return _sampleQueue.Latency();
 }
 
-int AudioCaptureImpl::AudioDeviceIndex() const
+AudioLevelMeter& AudioCaptureImpl_SDL::LevelMeter()
+{
+    return _sampleQueue.LevelMeter();
+}
+
+std::unique_ptr<AudioBroadcastRing::Reader> AudioCaptureImpl_SDL::CreateReader() const
+{
+    return std::unique_ptr<AudioBroadcastRing::Reader>(new AudioBroadcastRing::Reader(_sampleQueue.CreateReader()));
+}
+
+uint64_t AudioCaptureImpl_SDL::BufferUnderruns() const
+{
+    return _sampleQueue.Underruns();
+}
+
+uint64_t AudioCaptureImpl_SDL::BufferOverruns() const
+{
+    return _sampleQueue.Overruns();
+}
+
+uint64_t AudioCaptureImpl_SDL::MissedDeadlines() const
+{
+    return _sampleQueue.MissedDeadlines();
+}
+
+int AudioCaptureImpl_SDL::AudioDeviceIndex() const
 {
     return _currentAudioDeviceIndex;
 }
 
-std::string AudioCaptureImpl::AudioDeviceName() const
+std::string AudioCaptureImpl_SDL::AudioDeviceName() const
 {
     if (_currentAudioDeviceIndex >= 0)
     {
@@ -114,21 +170,28 @@ std::string AudioCaptureImpl::AudioDeviceName() const
     }
 }
 
-bool AudioCaptureImpl::OpenAudioDevice()
+bool AudioCaptureImpl_SDL::OpenAudioDevice()
 {
     SDL_AudioSpec requestedSpecs{};
     SDL_AudioSpec actualSpecs{};
 
-    requestedSpecs.freq = _requestedSampleFrequency;
+    requestedSpecs.freq = AudioSampleQueue::OutputSampleFrequency;
     requestedSpecs.format = AUDIO_F32;
     requestedSpecs.channels = 2;
     requestedSpecs.samples = _requestedSampleCount;
-    requestedSpecs.callback = AudioCaptureImpl::AudioInputCallback;
+    requestedSpecs.callback = AudioCaptureImpl_SDL::AudioInputCallback;
     requestedSpecs.userdata = this;
 
     // Will be NULL on error, which happens if the requested index is -1. This automatically selects the default device.
     auto deviceName = SDL_GetAudioDeviceName(_currentAudioDeviceIndex, true);
-    _currentAudioDeviceID = SDL_OpenAudioDevice(deviceName, true, &requestedSpecs, &actualSpecs, SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
+    int allowedChanges = SDL_AUDIO_ALLOW_CHANNELS_CHANGE;
+    if (_useNativeSampleFrequency)
+    {
+        // Let the device run at its native rate and convert it with our own resampler instead of SDL's.
+        allowedChanges |= SDL_AUDIO_ALLOW_FREQUENCY_CHANGE;
+    }
+
+    _currentAudioDeviceID = SDL_OpenAudioDevice(deviceName, true, &requestedSpecs, &actualSpecs, allowedChanges);
 
     if (_currentAudioDeviceID == 0)
     {
@@ -139,7 +202,11 @@ bool AudioCaptureImpl::OpenAudioDevice()
         return false;
     }
 
-    _channels = actualSpecs.channels;
+    // No callback is running before the device is unpaused, so it's safe to reconfigure the queue.
+    _audioThreadIdPublished = false;
+    _audioThreadScheduled = false;
+    _deviceChannels = actualSpecs.channels;
+    _sampleQueue.Configure(actualSpecs.freq, _deviceChannels, actualSpecs.samples, actualSpecs.samples);
 
     poco_information_f4(_logger, R"(Opened audio recording device "%s" (ID %?d) with %?d channels at %?d Hz.)",
                         std::string(deviceName != nullptr ? deviceName : "System default capturing device"),
@@ -150,13 +217,29 @@ bool AudioCaptureImpl::OpenAudioDevice()
     return true;
 }
 
-void AudioCaptureImpl::AudioInputCallback(void* userData, unsigned char* stream, int len)
+void AudioCaptureImpl_SDL::AudioInputCallback(void* userData, unsigned char* stream, int len)
 {
     poco_assert_dbg(userData);
-    auto instance = reinterpret_cast<AudioCaptureImpl*>(userData);
+    auto instance = reinterpret_cast<AudioCaptureImpl_SDL*>(userData);
+
+    // SDL creates a new thread for each opened device. Only publish its ID here, the settings are applied by
+    // ApplyThreadScheduling() outside of the real-time thread.
+    if (!instance->_audioThreadIdPublished.load(std::memory_order_relaxed))
+    {
+        instance->_audioThreadId = ThreadScheduling::CurrentThreadId();
+        instance->_audioThreadIdPublished = true;
+    }
+
+    instance->_sampleQueue.Write(reinterpret_cast<const float*>(stream),
+                                 static_cast<size_t>(len) / sizeof(float) / instance->_deviceChannels);
+}
 
-    unsigned int samples = len / sizeof(float) / instance->_channels;
+void AudioCaptureImpl_SDL::ApplyThreadScheduling()
+{
+    _audioThreadScheduled = true;
 
-    projectm_pcm_add_float(instance->_projectMHandle, reinterpret_cast<float*>(stream), samples,
-                           static_cast<projectm_channels>(instance->_channels));
+    if (_threadScheduling.Enabled())
+    {
+        _threadScheduling.ApplyToThread(_audioThreadId);
+    }
 }
@@ -1,76 +1,116 @@
 #pragma once
 
+#include "AudioCaptureImpl.h"
+#include "AudioSampleQueue.h"
+#include "ThreadScheduling.h"
+
 #include <SDL2/SDL.h>
 
 #include <Poco/Logger.h>
 
+#include <atomic>
 #include <string>
-#include <vector>
-
-class projectm;
 
 /**
  * @brief SDL-based audio capturing thread.
  *
  * Uses SDL's audio API to capture PCM data from any supported drivers.
  */
-class AudioCaptureImpl
+class AudioCaptureImpl_SDL : public AudioCaptureImpl
 {
 public:
-    AudioCaptureImpl();
+    AudioCaptureImpl_SDL();
 
-    ~AudioCaptureImpl();
+    ~AudioCaptureImpl_SDL() override;
 
     /**
      * @brief Returns a map of available recording devices.
      * @return A vector of available audio device IDs and names.
      */
-    std::map<int, std::string> AudioDeviceList();
+    std::map<int, std::string> AudioDeviceList() override;
 
     /**
      * @brief Starts audio capturing with the first available device.
      * @param projectMHandle projectM instance handle that will receive the captured data.
      * @param audioDeviceIndex The initial audio device ID to capture from. Use -1 to select the implementation's
      *                      default device.
+     * @return true if the device was opened successfully.
      */
-    void StartRecording(projectm* projectMHandle, int audioDeviceIndex);
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
 
     /**
      * @brief Stops audio recording.
      */
-    void StopRecording();
+    void StopRecording() override;
 
     /**
-     * @brief Switches to the next available audio recording device.
+     * @brief Returns the currently used Audio device index.
+     * @return The index of the current audio device, as listed by @a AudioDeviceList()
      */
-    void NextAudioDevice();
+    int AudioDeviceIndex() const override;
 
     /**
-     * @brief Activates the audio device with the given idnex for recording.
-     * @param index The index, as listed by @a AudioDeviceList()
+     * @brief Retrieves the current audio device name.
+     * @return The name of the currently selected audio recording device.
      */
-    void AudioDeviceIndex(int index);
+    std::string AudioDeviceName() const override;
 
     /**
-     * @brief Returns the currently used Audio device index.
-     * @return The index of the current audio device, as listed by @a AudioDeviceList()
+     * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
+     *
+     * SDL's audio callback only copies the captured samples into a lock-free ring buffer. This method
+     * is called on the render thread and drains that buffer into projectM, so projectM's PCM data is
+     * never modified while a frame is being rendered.
+     *
+     * Only the number of samples matching the time since the last call are passed to projectM, the
+     * remainder is kept as a backlog to compensate for the callback jitter.
      */
-    int AudioDeviceIndex() const;
+    void FillBuffer() override;
 
     /**
-     * @brief Retrieves the current audio device name.
-     * @return The name of the currently selected audio recording device.
+     * @brief Delays the captured samples or lowers the buffering, depending on the offset's sign.
+     * @param offset The offset in seconds.
      */
-    std::string AudioDeviceName() const;
+    void SyncOffset(double offset) override;
 
     /**
-     * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
+     * @brief Returns the estimated capture latency.
+     * @return The device buffer duration, paced backlog and sync delay in seconds.
+     */
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the captured audio.
+     * @return The sample queue's level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Attaches an additional consumer to the sample queue.
+     * @return A new reader of the processed stream.
+     */
+    std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     * @return The underrun count since the device was opened.
+     */
+    uint64_t BufferUnderruns() const override;
+
+    /**
+     * @brief Returns the number of times captured samples had to be dropped.
      *
-     * As of now, SDL uses async callbacks to directly fill projectM's audio buffer.
+     * This happens if the backlog grows too large or the capture buffer is full.
      *
-     * @todo Store audio samples internally and push them to projectM when requested.
+     * @return The overrun count since the device was opened.
+     */
+    uint64_t BufferOverruns() const override;
+
+    /**
+     * @brief Returns the number of times the capture thread didn't run in time.
+     * @return The missed deadline count since the stream was started.
      */
-    void FillBuffer(){};
+    uint64_t MissedDeadlines() const override;
 
 protected:
     /**
@@ -90,13 +130,34 @@ protected:
      */
     static void AudioInputCallback(void* userData, unsigned char* stream, int len);
 
+    /**
+     * @brief Applies the scheduling settings to SDL's audio thread, whose ID the callback has published.
+     *
+     * Called once per opened device by FillBuffer() on the render thread, after the first callback ran. This
+     * keeps system calls, D-Bus requests and logging out of the real-time thread, and nothing has to wait
+     * for the first callback.
+     */
+    void ApplyThreadScheduling();
+
+    /**
+     * @brief Number of SDL callback buffers the sample queue can hold before samples are dropped.
+     */
+    static constexpr uint32_t _bufferedCallbackCount{8};
+
     projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
     int32_t _currentAudioDeviceIndex{-1}; //!< Currently selected audio device index.
     SDL_AudioDeviceID _currentAudioDeviceID{0}; //!< Device ID of the currently opened audio device.
-    uint32_t _channels{2};
 
-    constexpr static uint32_t _requestedSampleFrequency{44100}; //!< Requested sample frequency. Currently hardcoded as 44100 Hz, as this is what the spectrum analyzer expects.
+    bool _useNativeSampleFrequency{true}; //!< If true, the device is opened with its native sample frequency and converted by the sample queue.
     uint32_t _requestedSampleCount{44100U / 60U}; //!< Requested audio buffer size. Determines how often SDL will call AudioInputCallback() with new data, and how much data is delivered on each call.
+    uint32_t _deviceChannels{2}; //!< Number of channels delivered by the audio device.
+
+    ThreadScheduling _threadScheduling; //!< Priority and affinity settings applied to SDL's audio thread.
+    std::atomic<ThreadScheduling::ThreadId> _audioThreadId{0}; //!< ID of the current device's audio thread, written by the first callback.
+    std::atomic_bool _audioThreadIdPublished{false}; //!< Set by the first callback after storing _audioThreadId.
+    bool _audioThreadScheduled{false}; //!< True once the settings were applied to the current device's audio thread.
+
+    AudioSampleQueue _sampleQueue; //!< Downmixes, resamples and buffers the captured samples until FillBuffer() is called.
 
     Poco::Logger& _logger{Poco::Logger::get("AudioCapture.SDL")}; //!< The class logger.
 };
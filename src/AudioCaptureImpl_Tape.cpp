@@ -0,0 +1,256 @@
+#include "AudioCaptureImpl_Tape.h"
+
+#include "AudioDownmixer.h"
+#include "AudioTapeRecorder.h"
+#include "ThreadScheduling.h"
+
+#include <Poco/File.h>
+
+#include <Poco/Util/Application.h>
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr char TapePrefix[] = "tape:";
+constexpr size_t TapePrefixLength = sizeof(TapePrefix) - 1;
+
+} // namespace
+
+AudioCaptureImpl_Tape::AudioCaptureImpl_Tape()
+    : _playerThread(this, &AudioCaptureImpl_Tape::PlayerThread)
+    , _sampleQueue(AudioSampleQueue::OutputSampleFrequency / 2)
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    auto deviceName = config.getString("audio.device", "");
+    _fileName = IsTapeDevice(deviceName) ? deviceName.substr(TapePrefixLength) : config.getString("audio.tape.path", "");
+}
+
+AudioCaptureImpl_Tape::~AudioCaptureImpl_Tape()
+{
+    StopRecording();
+}
+
+bool AudioCaptureImpl_Tape::IsTapeDevice(const std::string& deviceName)
+{
+    return deviceName.compare(0, TapePrefixLength, TapePrefix) == 0;
+}
+
+std::map<int, std::string> AudioCaptureImpl_Tape::AudioDeviceList()
+{
+    return {{-1, AudioDeviceName()}};
+}
+
+bool AudioCaptureImpl_Tape::StartRecording(projectm* projectMHandle, int)
+{
+    StopRecording();
+
+    _projectMHandle = projectMHandle;
+
+    if (_fileName.empty())
+    {
+        poco_error(_logger, "No audio tape specified. Set audio.device to \"tape:<path>\" or audio.tape.path to a file name.");
+        return false;
+    }
+
+    try
+    {
+        _mapping.reset(new Poco::SharedMemory(Poco::File(_fileName), Poco::SharedMemory::AM_READ));
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not open audio tape "%s": %s)", _fileName, ex.displayText());
+        return false;
+    }
+
+    if (!IndexBlocks())
+    {
+        _mapping.reset();
+        return false;
+    }
+
+    _sampleQueue.Configure(_sampleRate, _channels, _maxBlockFrames, _blocks.front().frames);
+
+    _isPlaying = true;
+    _playerThreadResult = _playerThread();
+
+    poco_information_f4(_logger, R"(Replaying audio tape "%s" with %?u blocks of %?u channel audio at %?u Hz.)",
+                        _fileName, _blocks.size(), _channels, _sampleRate);
+
+    return true;
+}
+
+void AudioCaptureImpl_Tape::StopRecording()
+{
+    if (_isPlaying)
+    {
+        _isPlaying = false;
+        _playerThreadResult.wait();
+    }
+
+    if (_mapping)
+    {
+        _mapping.reset();
+        _blocks.clear();
+    }
+}
+
+int AudioCaptureImpl_Tape::AudioDeviceIndex() const
+{
+    return -1;
+}
+
+std::string AudioCaptureImpl_Tape::AudioDeviceName() const
+{
+    return TapePrefix + _fileName;
+}
+
+void AudioCaptureImpl_Tape::FillBuffer()
+{
+    if (!_projectMHandle)
+    {
+        return;
+    }
+
+    _sampleQueue.Drain(_projectMHandle);
+}
+
+void AudioCaptureImpl_Tape::SyncOffset(double offset)
+{
+    _sampleQueue.SyncOffset(offset);
+}
+
+double AudioCaptureImpl_Tape::Latency() const
+{
+    return _sampleQueue.Latency();
+}
+
+AudioLevelMeter& AudioCaptureImpl_Tape::LevelMeter()
+{
+    return _sampleQueue.LevelMeter();
+}
+
+std::unique_ptr<AudioBroadcastRing::Reader> AudioCaptureImpl_Tape::CreateReader() const
+{
+    return std::unique_ptr<AudioBroadcastRing::Reader>(new AudioBroadcastRing::Reader(_sampleQueue.CreateReader()));
+}
+
+uint64_t AudioCaptureImpl_Tape::BufferUnderruns() const
+{
+    return _sampleQueue.Underruns();
+}
+
+uint64_t AudioCaptureImpl_Tape::BufferOverruns() const
+{
+    return _sampleQueue.Overruns();
+}
+
+uint64_t AudioCaptureImpl_Tape::MissedDeadlines() const
+{
+    return _sampleQueue.MissedDeadlines();
+}
+
+bool AudioCaptureImpl_Tape::IndexBlocks()
+{
+    const auto* fileStart = reinterpret_cast<const unsigned char*>(_mapping->begin());
+    const auto fileSize = static_cast<size_t>(_mapping->end() - _mapping->begin());
+
+    AudioTapeRecorder::FileHeader fileHeader;
+    if (fileSize < sizeof(fileHeader))
+    {
+        poco_error_f1(_logger, R"(Audio tape "%s" is too short.)", _fileName);
+        return false;
+    }
+
+    std::memcpy(&fileHeader, fileStart, sizeof(fileHeader));
+    if (std::memcmp(fileHeader.magic, AudioTapeRecorder::Magic, sizeof(AudioTapeRecorder::Magic)) != 0 ||
+        fileHeader.version != AudioTapeRecorder::Version)
+    {
+        poco_error_f1(_logger, R"(File "%s" is not an audio tape or was written by an incompatible version.)", _fileName);
+        return false;
+    }
+
+    _blocks.clear();
+    _maxBlockFrames = 0;
+
+    double firstTime{0.0};
+    size_t offset = sizeof(fileHeader);
+    while (offset + sizeof(AudioTapeRecorder::BlockHeader) <= fileSize)
+    {
+        AudioTapeRecorder::BlockHeader header;
+        std::memcpy(&header, fileStart + offset, sizeof(header));
+        offset += sizeof(header);
+
+        auto blockBytes = static_cast<size_t>(header.frames) * header.channels * sizeof(float);
+        if (header.frames == 0 || header.sampleRate == 0 || header.channels == 0 ||
+            header.channels > AudioDownmixer::MaxChannels || blockBytes > fileSize - offset)
+        {
+            poco_warning_f1(_logger, "Audio tape is truncated or damaged after %.1f seconds, replaying only the part before.",
+                            header.time - firstTime);
+            break;
+        }
+
+        if (_blocks.empty())
+        {
+            firstTime = header.time;
+            _sampleRate = header.sampleRate;
+            _channels = header.channels;
+        }
+        else if (header.sampleRate != _sampleRate || header.channels != _channels)
+        {
+            poco_warning_f1(_logger, "Audio tape changes the device format after %.1f seconds, replaying only the part before.",
+                            header.time - firstTime);
+            break;
+        }
+
+        Block block;
+        block.time = header.time - firstTime;
+        block.frames = header.frames;
+        // All headers and blocks are multiples of four bytes, so the samples are properly aligned.
+        block.samples = reinterpret_cast<const float*>(fileStart + offset);
+        _blocks.push_back(block);
+
+        _maxBlockFrames = std::max(_maxBlockFrames, header.frames);
+        offset += blockBytes;
+    }
+
+    if (_blocks.empty())
+    {
+        poco_error_f1(_logger, R"(Audio tape "%s" contains no audio.)", _fileName);
+        return false;
+    }
+
+    return true;
+}
+
+void AudioCaptureImpl_Tape::PlayerThread()
+{
+    ThreadScheduling::ForCapture().ApplyToCurrentThread();
+
+    auto ticksPerSecond = static_cast<double>(SDL_GetPerformanceFrequency());
+    auto startTicks = SDL_GetPerformanceCounter();
+
+    for (const auto& block : _blocks)
+    {
+        if (!_isPlaying)
+        {
+            return;
+        }
+
+        auto waitTime = block.time - static_cast<double>(SDL_GetPerformanceCounter() - startTicks) / ticksPerSecond;
+        if (waitTime > 0.0)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<double>(waitTime));
+        }
+
+        _sampleQueue.Write(block.samples, block.frames);
+    }
+
+    poco_information_f1(_logger, "Reached the end of the audio tape after %.1f seconds.", _blocks.back().time);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "AudioCaptureImpl.h"
+#include "AudioSampleQueue.h"
+
+#include <Poco/ActiveMethod.h>
+#include <Poco/Logger.h>
+#include <Poco/SharedMemory.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Replays an audio tape written by the AudioTapeRecorder.
+ *
+ * Selected by setting audio.device to "tape:<path>", or with audio.backend set to "tape" and the path in
+ * audio.tape.path. The file is memory-mapped and indexed once on start. A player thread then writes each
+ * recorded block into the sample queue unchanged, with its original size and at its original time
+ * relative to the first block. This way, the whole capture path from the device callback on behaves as
+ * it did while recording, including downmixing, resampling and frame pacing.
+ *
+ * Only the part of the tape before the first change of the sample rate or channel count is replayed, as
+ * the sample queue can't be reconfigured while the render thread reads from it.
+ */
+class AudioCaptureImpl_Tape : public AudioCaptureImpl
+{
+public:
+    /**
+     * @brief Creates a new tape source.
+     *
+     * The path is taken from audio.device if it has the "tape:" prefix, otherwise from audio.tape.path.
+     */
+    AudioCaptureImpl_Tape();
+
+    ~AudioCaptureImpl_Tape() override;
+
+    /**
+     * @brief Checks whether a configured device name refers to a tape.
+     * @param deviceName The audio.device value.
+     * @return true if the name starts with the "tape:" prefix.
+     */
+    static bool IsTapeDevice(const std::string& deviceName);
+
+    /**
+     * @brief Returns a list with the tape as the only device.
+     * @return A map with a single entry.
+     */
+    std::map<int, std::string> AudioDeviceList() override;
+
+    /**
+     * @brief Opens and indexes the tape and starts the player thread.
+     * @param projectMHandle projectM instance handle that will receive the audio data.
+     * @param audioDeviceIndex Ignored, as there is only one device.
+     * @return true if the tape could be opened and contains at least one valid block.
+     */
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
+
+    /**
+     * @brief Stops the player thread and closes the tape.
+     */
+    void StopRecording() override;
+
+    /**
+     * @brief Returns the device index of the tape.
+     * @return Always -1, the tape is the backend's default and only device.
+     */
+    int AudioDeviceIndex() const override;
+
+    /**
+     * @brief Returns the tape's device name.
+     * @return The "tape:" prefix followed by the file name.
+     */
+    std::string AudioDeviceName() const override;
+
+    /**
+     * @brief Passes the replayed samples for the next frame to projectM.
+     */
+    void FillBuffer() override;
+
+    /**
+     * @brief Delays the replayed samples or lowers the buffering, depending on the offset's sign.
+     * @param offset The offset in seconds.
+     */
+    void SyncOffset(double offset) override;
+
+    /**
+     * @brief Returns the estimated capture latency.
+     * @return The recorded block duration, paced backlog and sync delay in seconds.
+     */
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the replayed audio.
+     * @return The sample queue's level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Attaches an additional consumer to the sample queue.
+     * @return A new reader of the processed stream.
+     */
+    std::unique_ptr<AudioBroadcastRing::Reader> CreateReader() const override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     * @return The underrun count since the replay was started.
+     */
+    uint64_t BufferUnderruns() const override;
+
+    /**
+     * @brief Returns the number of times replayed samples had to be skipped.
+     * @return The overrun count since the replay was started.
+     */
+    uint64_t BufferOverruns() const override;
+
+    /**
+     * @brief Returns the number of times the player thread didn't run in time.
+     * @return The missed deadline count since the replay was started.
+     */
+    uint64_t MissedDeadlines() const override;
+
+protected:
+    /**
+     * @brief A recorded block inside the mapped tape.
+     */
+    struct Block
+    {
+        double time{0.0}; //!< Capture time of the block relative to the first one in seconds.
+        uint32_t frames{0}; //!< Number of sample frames.
+        const float* samples{nullptr}; //!< Interleaved samples in the mapped file.
+    };
+
+    /**
+     * @brief Validates the tape header and builds the block index.
+     * @return true if the tape contains at least one valid block.
+     */
+    bool IndexBlocks();
+
+    /**
+     * @brief Writes the blocks into the sample queue at their recorded times until stopped or done.
+     */
+    void PlayerThread();
+
+    std::string _fileName; //!< Path of the tape file.
+    std::unique_ptr<Poco::SharedMemory> _mapping; //!< Read-only memory mapping of the whole file.
+    std::vector<Block> _blocks; //!< Index of all replayed blocks.
+    uint32_t _sampleRate{0}; //!< Sample rate of the replayed blocks.
+    uint32_t _channels{0}; //!< Channel count of the replayed blocks.
+    uint32_t _maxBlockFrames{0}; //!< Size of the largest replayed block.
+
+    projectm* _projectMHandle{nullptr}; //!< Handle if the projectM instance that will receive the audio data.
+
+    Poco::ActiveMethod<void, void, AudioCaptureImpl_Tape> _playerThread; //!< Active method running the player thread.
+    Poco::ActiveResult<void> _playerThreadResult{new Poco::ActiveResultHolder<void>()}; //!< Result of the player thread.
+    std::atomic_bool _isPlaying{false}; //!< If true, the player thread is running. It exits if set to false.
+
+    AudioSampleQueue _sampleQueue; //!< Ring receiving the replayed samples, drained in FillBuffer().
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioCapture.Tape")}; //!< The class logger.
+};
@@ -1,25 +1,29 @@
 #include "AudioCaptureImpl_WASAPI.h"
 
+#include "ThreadScheduling.h"
+
 #include <projectM-4/projectM.h>
 
 #include <Poco/UnicodeConverter.h>
+#include <Poco/Util/Application.h>
 
 #include <functiondiscoverykeys_devpkey.h>
 #include <mmdeviceapi.h>
 #include <objbase.h>
 
-AudioCaptureImpl::AudioCaptureImpl()
-    : _captureThread(this, &AudioCaptureImpl::CaptureThread)
+AudioCaptureImpl_WASAPI::AudioCaptureImpl_WASAPI()
+    : _captureThread(this, &AudioCaptureImpl_WASAPI::CaptureThread)
+    , _tapeRecorder(Poco::Util::Application::instance().getSubsystem<AudioTapeRecorder>())
 {
     CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 }
 
-AudioCaptureImpl::~AudioCaptureImpl()
+AudioCaptureImpl_WASAPI::~AudioCaptureImpl_WASAPI()
 {
     CoUninitialize();
 }
 
-std::map<int, std::string> AudioCaptureImpl::AudioDeviceList()
+std::map<int, std::string> AudioCaptureImpl_WASAPI::AudioDeviceList()
 {
     std::map<int, std::string> deviceList{
         {-1, _defaultDeviceName}};
@@ -42,16 +46,18 @@ std::map<int, std::string> AudioCaptureImpl::AudioDeviceList()
     return deviceList;
 }
 
-void AudioCaptureImpl::StartRecording(projectm* projectMHandle, int audioDeviceIndex)
+bool AudioCaptureImpl_WASAPI::StartRecording(projectm* projectMHandle, int audioDeviceIndex)
 {
     _projectMHandle = projectMHandle;
     _currentAudioDeviceIndex = audioDeviceIndex;
 
     _isCapturing = true;
     _captureThreadResult = _captureThread();
+
+    return true;
 }
 
-void AudioCaptureImpl::StopRecording()
+void AudioCaptureImpl_WASAPI::StopRecording()
 {
     if (_isCapturing)
     {
@@ -63,40 +69,12 @@ void AudioCaptureImpl::StopRecording()
     }
 }
 
-void AudioCaptureImpl::NextAudioDevice()
-{
-    StopRecording();
-
-    IMMDeviceEnumerator* enumerator{GetDeviceEnumerator()};
-    auto captureDevices{GetAudioDeviceList(enumerator)};
-    enumerator->Release();
-
-    // Will wrap around to loopback capture device (-1).
-    int nextAudioDeviceId = ((_currentAudioDeviceIndex + 2) % (static_cast<int>(captureDevices.size()) + 1)) - 1;
-
-    StartRecording(_projectMHandle, nextAudioDeviceId);
-}
-
-void AudioCaptureImpl::AudioDeviceIndex(int index)
-{
-    IMMDeviceEnumerator* enumerator{GetDeviceEnumerator()};
-    auto captureDevices{GetAudioDeviceList(enumerator)};
-    enumerator->Release();
-
-    if (index >= -1 && index < static_cast<int>(captureDevices.size()))
-    {
-        _currentAudioDeviceIndex = index;
-        StopRecording();
-        StartRecording(_projectMHandle, index);
-    }
-}
-
-int AudioCaptureImpl::AudioDeviceIndex() const
+int AudioCaptureImpl_WASAPI::AudioDeviceIndex() const
 {
     return _currentAudioDeviceIndex;
 }
 
-std::string AudioCaptureImpl::AudioDeviceName() const
+std::string AudioCaptureImpl_WASAPI::AudioDeviceName() const
 {
     if (_currentAudioDeviceIndex < 0)
     {
@@ -115,7 +93,7 @@ std::string AudioCaptureImpl::AudioDeviceName() const
     return captureDevices.at(_currentAudioDeviceIndex).FriendlyName();
 }
 
-void AudioCaptureImpl::FillBuffer()
+void AudioCaptureImpl_WASAPI::FillBuffer()
 {
     if (_isCapturing)
     {
@@ -132,7 +110,22 @@ void AudioCaptureImpl::FillBuffer()
     }
 }
 
-HRESULT AudioCaptureImpl::QueryInterface(const IID& riid, void** ppvObject)
+void AudioCaptureImpl_WASAPI::SyncOffset(double offset)
+{
+    _delayLine.Delay(offset);
+}
+
+double AudioCaptureImpl_WASAPI::Latency() const
+{
+    return _periodTime + _delayLine.Delay();
+}
+
+AudioLevelMeter& AudioCaptureImpl_WASAPI::LevelMeter()
+{
+    return _levelMeter;
+}
+
+HRESULT AudioCaptureImpl_WASAPI::QueryInterface(const IID& riid, void** ppvObject)
 {
     if (ppvObject == nullptr)
     {
@@ -153,24 +146,24 @@ HRESULT AudioCaptureImpl::QueryInterface(const IID& riid, void** ppvObject)
     return E_NOINTERFACE;
 }
 
-ULONG AudioCaptureImpl::AddRef()
+ULONG AudioCaptureImpl_WASAPI::AddRef()
 {
     return InterlockedIncrement(&_referenceCount);
 }
 
-ULONG AudioCaptureImpl::Release()
+ULONG AudioCaptureImpl_WASAPI::Release()
 {
     return InterlockedDecrement(&_referenceCount);
 }
 
-std::string AudioCaptureImpl::UnicodeToString(LPCWSTR unicodeString)
+std::string AudioCaptureImpl_WASAPI::UnicodeToString(LPCWSTR unicodeString)
 {
     std::string utf8String;
     Poco::UnicodeConverter::convert(std::wstring(unicodeString), utf8String);
     return utf8String;
 }
 
-std::vector<AudioCaptureImpl::AudioDevice> AudioCaptureImpl::GetAudioDeviceList(IMMDeviceEnumerator* enumerator) const
+std::vector<AudioCaptureImpl_WASAPI::AudioDevice> AudioCaptureImpl_WASAPI::GetAudioDeviceList(IMMDeviceEnumerator* enumerator) const
 {
     auto addEndpoints = [this, enumerator](std::vector<AudioDevice>& deviceList, EDataFlow dataFlow) {
         HRESULT result{S_OK};
@@ -210,7 +203,7 @@ std::vector<AudioCaptureImpl::AudioDevice> AudioCaptureImpl::GetAudioDeviceList(
     return deviceList;
 }
 
-bool AudioCaptureImpl::OpenAudioDevice(IMMDevice* device, bool useLoopback)
+bool AudioCaptureImpl_WASAPI::OpenAudioDevice(IMMDevice* device, bool useLoopback)
 {
     // activate an IAudioClient
     HRESULT result = device->Activate(__uuidof(IAudioClient),
@@ -261,6 +254,8 @@ bool AudioCaptureImpl::OpenAudioDevice(IMMDevice* device, bool useLoopback)
     }
 
     _channels = pwfx->nChannels;
+    auto sampleRate = static_cast<uint32_t>(pwfx->nSamplesPerSec);
+    _sampleRate = sampleRate;
 
     // Can't use event-driven processing in loopback mode, but as we
     // get a "fill buffer" request before rendering each frame, this isn't
@@ -281,6 +276,30 @@ bool AudioCaptureImpl::OpenAudioDevice(IMMDevice* device, bool useLoopback)
         return false;
     }
 
+    // Packets never exceed the endpoint buffer size, so the downmix and delay buffers can be allocated once here.
+    UINT32 bufferFrames{0};
+    result = _audioClient->GetBufferSize(&bufferFrames);
+    if (FAILED(result))
+    {
+        poco_error_f1(_logger, "IAudioClient->GetBufferSize failed: result = 0x%08?x", result);
+        return false;
+    }
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> audioConfig = Poco::Util::Application::instance().config().createView("audio");
+
+    _downmixer.Configure(_channels, *audioConfig);
+    if (_downmixer.Active())
+    {
+        _downmixBuffer.resize(static_cast<size_t>(bufferFrames) * _downmixer.OutputChannels());
+
+        poco_debug_f1(_logger, "Downmixing %hu audio channels to stereo.", _channels);
+    }
+
+    _delayLine.Configure(sampleRate, _downmixer.OutputChannels());
+    _delayBuffer.resize(static_cast<size_t>(bufferFrames) * _downmixer.OutputChannels());
+    _periodTime = static_cast<double>(hnsDefaultDevicePeriod) / 10000000.0;
+    _levelMeter.Configure(sampleRate, _downmixer.OutputChannels(), audioConfig->getDouble("silenceThreshold", -60.0));
+
     // activate an IAudioCaptureClient
     result = _audioClient->GetService(
         __uuidof(IAudioCaptureClient),
@@ -302,7 +321,7 @@ bool AudioCaptureImpl::OpenAudioDevice(IMMDevice* device, bool useLoopback)
     return true;
 }
 
-void AudioCaptureImpl::CloseAudioDevice(IMMDevice* device)
+void AudioCaptureImpl_WASAPI::CloseAudioDevice(IMMDevice* device)
 {
     poco_trace(_logger, "Stopping audio client.");
     _audioClient->Stop();
@@ -328,10 +347,12 @@ void AudioCaptureImpl::CloseAudioDevice(IMMDevice* device)
     }
 }
 
-void AudioCaptureImpl::CaptureThread()
+void AudioCaptureImpl_WASAPI::CaptureThread()
 {
     poco_debug(_logger, "Audio capture thread starting.");
 
+    ThreadScheduling::ForCapture().ApplyToCurrentThread();
+
     HRESULT result = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 
     if (FAILED(result))
@@ -447,7 +468,18 @@ void AudioCaptureImpl::CaptureThread()
 
                 if (framesAvailable > 0 && data != nullptr)
                 {
-                    projectm_pcm_add_float(_projectMHandle, reinterpret_cast<float*>(data), framesAvailable, static_cast<projectm_channels>(_channels));
+                    auto* samples = reinterpret_cast<const float*>(data);
+                    _tapeRecorder.Record(samples, framesAvailable, _sampleRate, _channels);
+                    if (_downmixer.Active())
+                    {
+                        _downmixer.Process(samples, framesAvailable, _downmixBuffer.data());
+                        samples = _downmixBuffer.data();
+                    }
+
+                    _levelMeter.Process(samples, framesAvailable);
+                    _delayLine.Process(samples, framesAvailable, _delayBuffer.data());
+                    projectm_pcm_add_float(_projectMHandle, _delayBuffer.data(), framesAvailable,
+                                           static_cast<projectm_channels>(_downmixer.OutputChannels()));
                 }
 
                 _audioCaptureClient->ReleaseBuffer(framesAvailable);
@@ -474,7 +506,7 @@ void AudioCaptureImpl::CaptureThread()
     poco_debug(_logger, "Audio capture thread exiting.");
 }
 
-IMMDeviceEnumerator* AudioCaptureImpl::GetDeviceEnumerator() const
+IMMDeviceEnumerator* AudioCaptureImpl_WASAPI::GetDeviceEnumerator() const
 {
     IMMDeviceEnumerator* enumerator{nullptr};
 
@@ -493,7 +525,7 @@ IMMDeviceEnumerator* AudioCaptureImpl::GetDeviceEnumerator() const
     return enumerator;
 }
 
-HRESULT AudioCaptureImpl::OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState)
+HRESULT AudioCaptureImpl_WASAPI::OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState)
 {
     auto deviceId{UnicodeToString(pwstrDeviceId)};
 
@@ -525,7 +557,7 @@ HRESULT AudioCaptureImpl::OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNe
     return S_OK;
 }
 
-HRESULT AudioCaptureImpl::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDefaultDeviceId)
+HRESULT AudioCaptureImpl_WASAPI::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDefaultDeviceId)
 {
     poco_trace_f1(_logger, "Default audio device changed to ID %s", UnicodeToString(pwstrDefaultDeviceId));
 
@@ -542,28 +574,28 @@ HRESULT AudioCaptureImpl::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPC
     return S_OK;
 }
 
-HRESULT AudioCaptureImpl::OnDeviceAdded(LPCWSTR pwstrDeviceId)
+HRESULT AudioCaptureImpl_WASAPI::OnDeviceAdded(LPCWSTR pwstrDeviceId)
 {
     poco_trace_f1(_logger, "Audio device added: %s", UnicodeToString(pwstrDeviceId));
 
     return S_OK;
 }
 
-HRESULT AudioCaptureImpl::OnDeviceRemoved(LPCWSTR pwstrDeviceId)
+HRESULT AudioCaptureImpl_WASAPI::OnDeviceRemoved(LPCWSTR pwstrDeviceId)
 {
     poco_trace_f1(_logger, "Audio device removed: %s", UnicodeToString(pwstrDeviceId));
 
     return S_OK;
 }
 
-HRESULT AudioCaptureImpl::OnPropertyValueChanged(LPCWSTR pwstrDeviceId, const PROPERTYKEY key)
+HRESULT AudioCaptureImpl_WASAPI::OnPropertyValueChanged(LPCWSTR pwstrDeviceId, const PROPERTYKEY key)
 {
     poco_trace_f1(_logger, "Audio device property changed for device ID %s", UnicodeToString(pwstrDeviceId));
 
     return S_OK;
 }
 
-AudioCaptureImpl::AudioDevice::AudioDevice(IMMDevice* device, bool isRenderDevice)
+AudioCaptureImpl_WASAPI::AudioDevice::AudioDevice(IMMDevice* device, bool isRenderDevice)
     : _friendlyName(GetAudioEndpointFriendlyName(device))
     , _isRenderDevice(isRenderDevice)
 {
@@ -577,11 +609,11 @@ AudioCaptureImpl::AudioDevice::AudioDevice(IMMDevice* device, bool isRenderDevic
         }
 
         poco_trace_f3(_logger, R"(Added WASAPI audio device "%s" with ID %s (Render device: %b))",
-                      _friendlyName, AudioCaptureImpl::UnicodeToString(_deviceId), _isRenderDevice);
+                      _friendlyName, AudioCaptureImpl_WASAPI::UnicodeToString(_deviceId), _isRenderDevice);
     }
 }
 
-AudioCaptureImpl::AudioDevice::AudioDevice(AudioCaptureImpl::AudioDevice&& other) noexcept
+AudioCaptureImpl_WASAPI::AudioDevice::AudioDevice(AudioCaptureImpl_WASAPI::AudioDevice&& other) noexcept
 {
     _deviceId = other._deviceId;
     other._deviceId = nullptr;
@@ -589,7 +621,7 @@ AudioCaptureImpl::AudioDevice::AudioDevice(AudioCaptureImpl::AudioDevice&& other
     _isRenderDevice = other._isRenderDevice;
 }
 
-AudioCaptureImpl::AudioDevice::~AudioDevice()
+AudioCaptureImpl_WASAPI::AudioDevice::~AudioDevice()
 {
     if (_deviceId)
     {
@@ -598,13 +630,13 @@ AudioCaptureImpl::AudioDevice::~AudioDevice()
     }
 }
 
-std::string AudioCaptureImpl::AudioDevice::GetAudioEndpointFriendlyName(IMMDevice* pMMDevice)
+std::string AudioCaptureImpl_WASAPI::AudioDevice::GetAudioEndpointFriendlyName(IMMDevice* pMMDevice)
 {
     HRESULT result{S_OK};
 
     if (pMMDevice == nullptr)
     {
-        return AudioCaptureImpl::_defaultDeviceName;
+        return AudioCaptureImpl_WASAPI::_defaultDeviceName;
     }
 
     IPropertyStore* deviceProps{nullptr};
@@ -626,7 +658,7 @@ std::string AudioCaptureImpl::AudioDevice::GetAudioEndpointFriendlyName(IMMDevic
         return {};
     }
 
-    std::string deviceFriendlyName = AudioCaptureImpl::UnicodeToString(variantName.pwszVal);
+    std::string deviceFriendlyName = AudioCaptureImpl_WASAPI::UnicodeToString(variantName.pwszVal);
 
     PropVariantClear(&variantName);
     deviceProps->Release();
@@ -634,17 +666,17 @@ std::string AudioCaptureImpl::AudioDevice::GetAudioEndpointFriendlyName(IMMDevic
     return deviceFriendlyName;
 }
 
-LPWSTR AudioCaptureImpl::AudioDevice::DeviceId() const
+LPWSTR AudioCaptureImpl_WASAPI::AudioDevice::DeviceId() const
 {
     return _deviceId;
 }
 
-std::string AudioCaptureImpl::AudioDevice::FriendlyName() const
+std::string AudioCaptureImpl_WASAPI::AudioDevice::FriendlyName() const
 {
     return _friendlyName;
 }
 
-bool AudioCaptureImpl::AudioDevice::IsRenderDevice() const
+bool AudioCaptureImpl_WASAPI::AudioDevice::IsRenderDevice() const
 {
     return _isRenderDevice;
 }
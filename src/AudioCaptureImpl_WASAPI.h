@@ -1,5 +1,11 @@
 #pragma once
 
+#include "AudioCaptureImpl.h"
+#include "AudioDelayLine.h"
+#include "AudioDownmixer.h"
+#include "AudioLevelMeter.h"
+#include "AudioTapeRecorder.h"
+
 #include <Poco/Logger.h>
 
 #include <Audioclient.h>
@@ -9,8 +15,7 @@
 
 #include <mmdeviceapi.h>
 #include <string>
-
-struct projectm;
+#include <vector>
 
 /**
  * @brief WASAPI-based audio capturing implementation.
@@ -24,65 +29,104 @@ struct projectm;
  *
  * It supports hot-plug device changes with fallback to other devices.
  */
-class AudioCaptureImpl : public IMMNotificationClient
+class AudioCaptureImpl_WASAPI : public AudioCaptureImpl, public IMMNotificationClient
 {
 public:
     /**
      * Constructor.
      */
-    AudioCaptureImpl();
+    AudioCaptureImpl_WASAPI();
 
     /**
      * Destructor.
      */
-    ~AudioCaptureImpl();
+    ~AudioCaptureImpl_WASAPI() override;
 
     /**
      * @brief Returns a map of available recording devices.
      * @return A vector of available audio device IDs and names.
      */
-    std::map<int, std::string> AudioDeviceList();
+    std::map<int, std::string> AudioDeviceList() override;
 
     /**
      * @brief Starts audio capturing with the first available device.
      * @param projectMHandle projectM instance handle that will receive the captured data.
      * @param audioDeviceIndex The initial audio device ID to capture from. Use -1 to select the implementation's
      *                      default device.
+     * @return Always true, as the device is opened asynchronously by the capture thread.
      */
-    void StartRecording(projectm* projectMHandle, int audioDeviceIndex);
+    bool StartRecording(projectm* projectMHandle, int audioDeviceIndex) override;
 
     /**
      * @brief Stops audio recording.
      */
-    void StopRecording();
+    void StopRecording() override;
 
     /**
-     * @brief Switches to the next available audio recording device.
+     * @brief Returns the currently used Audio device index.
+     * @return The index of the current audio device, as listed by @a AudioDeviceList()
      */
-    void NextAudioDevice();
+    int AudioDeviceIndex() const override;
 
     /**
-     * @brief Activates the audio device with the given idnex for recording.
-     * @param index The index, as listed by @a AudioDeviceList()
+     * @brief Retrieves the current audio device name.
+     * @return The name of the currently selected audio recording device.
      */
-    void AudioDeviceIndex(int index);
+    std::string AudioDeviceName() const override;
 
     /**
-     * @brief Returns the currently used Audio device index.
-     * @return The index of the current audio device, as listed by @a AudioDeviceList()
+     * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
      */
-    int AudioDeviceIndex() const;
+    void FillBuffer() override;
 
     /**
-     * @brief Retrieves the current audio device name.
-     * @return The name of the currently selected audio recording device.
+     * @brief Delays the captured samples by positive offsets.
+     *
+     * Negative offsets have no effect, as packets are already read synchronously with each frame.
+     *
+     * @param offset The offset in seconds.
      */
-    std::string AudioDeviceName() const;
+    void SyncOffset(double offset) override;
 
     /**
-     * @brief Asks the capture client to fill projectM's audio buffer for the next frame.
+     * @brief Returns the estimated capture latency.
+     * @return The device period and sync delay in seconds.
      */
-    void FillBuffer();
+    double Latency() const override;
+
+    /**
+     * @brief Returns the meter analyzing the captured audio.
+     *
+     * Packets flagged as silent by the audio engine are not analyzed, so they count as silence.
+     *
+     * @return The level meter.
+     */
+    AudioLevelMeter& LevelMeter() override;
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     *
+     * The WASAPI capture thread passes all pending packets to projectM synchronously with FillBuffer(),
+     * so there is no backlog which could run empty.
+     *
+     * @return Always 0.
+     */
+    uint64_t BufferUnderruns() const override
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Returns the number of times captured samples had to be dropped.
+     *
+     * WASAPI keeps unread packets in its own buffer, so no samples are dropped by this implementation.
+     *
+     * @return Always 0.
+     */
+    uint64_t BufferOverruns() const override
+    {
+        return 0;
+    }
 
     /**
      * @brief Converts a widechar/unicode string to a UTF-8-encoded string
@@ -287,10 +331,18 @@ protected:
 
     LONG _referenceCount{0}; //!< COM IUnknown object reference counter
 
-    Poco::ActiveMethod<void, void, AudioCaptureImpl> _captureThread; //!< Active method running the capture thread.
+    Poco::ActiveMethod<void, void, AudioCaptureImpl_WASAPI> _captureThread; //!< Active method running the capture thread.
     Poco::ActiveResult<void> _captureThreadResult{new Poco::ActiveResultHolder<void>()};
     std::string _currentCaptureDeviceId; //!< Current capture device ID. USed for checking if capturing needs restarting.
     WORD _channels{0}; //!< Number of channels on the current capture device.
+    uint32_t _sampleRate{0}; //!< Sample rate of the current capture device.
+    AudioDownmixer _downmixer; //!< Folds surround input down to stereo.
+    std::vector<float> _downmixBuffer; //!< Preallocated stereo output buffer for the downmixer.
+    AudioDelayLine _delayLine; //!< Delays the samples passed to projectM by the A/V sync offset.
+    std::vector<float> _delayBuffer; //!< Preallocated output buffer for the delay line.
+    std::atomic<double> _periodTime{0.0}; //!< Device period in seconds, set by the capture thread.
+    AudioLevelMeter _levelMeter; //!< Analyzes each captured packet.
+    AudioTapeRecorder& _tapeRecorder; //!< Records the captured packets if enabled.
 
     std::atomic_bool _isCapturing{false}; //!< If true, capturing is running. Capture thread will exit if set to false.
     std::atomic_bool _restartCapturing{false}; //!< If true, the capture thread will stop and restart capturing without exiting.
@@ -0,0 +1,93 @@
+#include "AudioCaptureRegistry.h"
+
+#include "AudioCaptureImpl_File.h"
+#include "AudioCaptureImpl_Impulse.h"
+#include "AudioCaptureImpl_SDL.h"
+#include "AudioCaptureImpl_Tape.h"
+
+#ifdef _WIN32
+#include "AudioCaptureImpl_WASAPI.h"
+#else
+#include "AudioCaptureImpl_Pipe.h"
+#endif
+
+#ifdef USE_PIPEWIRE
+#include "AudioCaptureImpl_PipeWire.h"
+#endif
+
+#ifdef USE_PULSEAUDIO
+#include "AudioCaptureImpl_Pulse.h"
+#endif
+
+#include <Poco/String.h>
+
+namespace {
+
+template<class BackendClass>
+AudioCaptureImpl* CreateBackend()
+{
+    return new BackendClass;
+}
+
+} // namespace
+
+const std::vector<AudioCaptureRegistry::Backend>& AudioCaptureRegistry::Backends()
+{
+    static const std::vector<Backend> backends{
+#ifdef _WIN32
+        {"wasapi", "Windows Audio Session API, supports loopback recording", true, &CreateBackend<AudioCaptureImpl_WASAPI>},
+#endif
+#ifdef USE_PIPEWIRE
+        {"pipewire", "Native PipeWire stream with a configurable low-latency quantum", true, &CreateBackend<AudioCaptureImpl_PipeWire>},
+#endif
+#ifdef USE_PULSEAUDIO
+        {"pulse", "PulseAudio simple API, default source or default sink monitor", true, &CreateBackend<AudioCaptureImpl_Pulse>},
+#endif
+        {"sdl", "SDL2 audio recording", true, &CreateBackend<AudioCaptureImpl_SDL>},
+        {"file", "WAV or raw PCM file playback", false, &CreateBackend<AudioCaptureImpl_File>},
+        {"impulse", "Periodic test impulses for latency measurements", false, &CreateBackend<AudioCaptureImpl_Impulse>},
+        {"tape", "Replay of an audio tape recorded with audio.record.path", false, &CreateBackend<AudioCaptureImpl_Tape>},
+#ifndef _WIN32
+        {"pipe", "Raw PCM data from stdin or a named pipe", false, &CreateBackend<AudioCaptureImpl_Pipe>},
+#endif
+    };
+
+    return backends;
+}
+
+const AudioCaptureRegistry::Backend* AudioCaptureRegistry::Find(const std::string& name)
+{
+    for (const auto& backend : Backends())
+    {
+        if (Poco::icompare(name, backend.name) == 0)
+        {
+            return &backend;
+        }
+    }
+
+    return nullptr;
+}
+
+std::vector<const AudioCaptureRegistry::Backend*> AudioCaptureRegistry::Candidates(const std::string& requestedBackend, bool fallback)
+{
+    std::vector<const Backend*> candidates;
+
+    const auto* requested = Find(requestedBackend);
+    if (requested)
+    {
+        candidates.push_back(requested);
+    }
+
+    if (!requested || fallback)
+    {
+        for (const auto& backend : Backends())
+        {
+            if (backend.automatic && &backend != requested)
+            {
+                candidates.push_back(&backend);
+            }
+        }
+    }
+
+    return candidates;
+}
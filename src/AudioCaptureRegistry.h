@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class AudioCaptureImpl;
+
+/**
+ * @brief List of audio capture backends compiled into the application.
+ *
+ * Backends are listed in the order of preference. If audio.backend is set to "auto", the first automatic
+ * backend that starts successfully is used. Backends which need explicit configuration, like the file
+ * source, are only used if requested by name.
+ */
+class AudioCaptureRegistry
+{
+public:
+    /**
+     * @brief Function creating a new, not yet started backend instance.
+     */
+    using Factory = AudioCaptureImpl* (*)();
+
+    /**
+     * @brief Registry entry for a single backend.
+     */
+    struct Backend
+    {
+        const char* name; //!< Name used in the audio.backend setting.
+        const char* description; //!< Human-readable description.
+        bool automatic; //!< If true, the backend is tried if no backend or a failing backend was requested.
+        Factory create; //!< Creates a new backend instance.
+    };
+
+    /**
+     * @brief Returns all available backends in the order of preference.
+     * @return A list of all backends.
+     */
+    static const std::vector<Backend>& Backends();
+
+    /**
+     * @brief Searches a backend by name.
+     * @param name The backend name, case-insensitive.
+     * @return A pointer to the backend entry, or nullptr if no backend with the given name exists.
+     */
+    static const Backend* Find(const std::string& name);
+
+    /**
+     * @brief Returns the backends to try, in order, for the given setting.
+     * @param requestedBackend The requested backend name, or "auto".
+     * @param fallback If true, the automatic backends are appended after the requested one.
+     * @return A list of backends to try until one starts successfully.
+     */
+    static std::vector<const Backend*> Candidates(const std::string& requestedBackend, bool fallback);
+};
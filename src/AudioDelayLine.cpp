@@ -0,0 +1,73 @@
+#include "AudioDelayLine.h"
+
+#include <algorithm>
+#include <cstring>
+
+constexpr double AudioDelayLine::MaxDelay;
+
+void AudioDelayLine::Configure(uint32_t sampleRate, uint32_t channels)
+{
+    _sampleRate = sampleRate;
+    _channels = channels;
+
+    // One extra frame, so the output of a zero-length delay is the frame which was just stored.
+    _historyFrames = static_cast<size_t>(MaxDelay * sampleRate) + 1;
+    _history.assign(_historyFrames * _channels, 0.0f);
+    _writePosition = 0;
+}
+
+void AudioDelayLine::Delay(double seconds)
+{
+    _delay = std::min(std::max(seconds, 0.0), MaxDelay);
+}
+
+double AudioDelayLine::Delay() const
+{
+    return _delay;
+}
+
+void AudioDelayLine::Process(const float* input, size_t frames, float* output)
+{
+    if (_historyFrames == 0)
+    {
+        if (output != input)
+        {
+            std::memcpy(output, input, frames * _channels * sizeof(float));
+        }
+        return;
+    }
+
+    auto delayFrames = std::min(static_cast<size_t>(_delay.load(std::memory_order_relaxed) * _sampleRate), _historyFrames - 1);
+
+    // Limit the chunk size so storing a chunk never overwrites history which is still to be output.
+    auto maxChunkFrames = _historyFrames - delayFrames;
+    while (frames > 0)
+    {
+        auto chunkFrames = std::min(frames, maxChunkFrames);
+
+        Store(input, chunkFrames);
+        Load(output, chunkFrames, delayFrames + chunkFrames);
+
+        input += chunkFrames * _channels;
+        output += chunkFrames * _channels;
+        frames -= chunkFrames;
+    }
+}
+
+void AudioDelayLine::Store(const float* input, size_t frames)
+{
+    auto firstFrames = std::min(frames, _historyFrames - _writePosition);
+    std::memcpy(&_history[_writePosition * _channels], input, firstFrames * _channels * sizeof(float));
+    std::memcpy(_history.data(), input + firstFrames * _channels, (frames - firstFrames) * _channels * sizeof(float));
+
+    _writePosition = (_writePosition + frames) % _historyFrames;
+}
+
+void AudioDelayLine::Load(float* output, size_t frames, size_t framesBack) const
+{
+    auto readPosition = (_writePosition + _historyFrames - framesBack) % _historyFrames;
+
+    auto firstFrames = std::min(frames, _historyFrames - readPosition);
+    std::memcpy(output, &_history[readPosition * _channels], firstFrames * _channels * sizeof(float));
+    std::memcpy(output + firstFrames * _channels, _history.data(), (frames - firstFrames) * _channels * sizeof(float));
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Delays interleaved audio by a configurable time to align the visuals with the sound system.
+ *
+ * If the display shows the visuals earlier than the speakers play the sound, delaying the samples passed
+ * to projectM compensates for the difference. The delay line keeps a history of MaxDelay seconds of
+ * audio and outputs the samples from the configured time ago.
+ *
+ * Memory is only allocated in Configure(). The delay can be changed at any time from another thread,
+ * which just moves the read position within the history.
+ */
+class AudioDelayLine
+{
+public:
+    static constexpr double MaxDelay{0.5}; //!< Maximum supported delay in seconds.
+
+    /**
+     * @brief Allocates the history for the given format and clears it. Keeps the current delay.
+     *
+     * Must not be called while Process() is running.
+     *
+     * @param sampleRate The sample rate of the processed audio.
+     * @param channels The number of interleaved channels, 1 or 2.
+     */
+    void Configure(uint32_t sampleRate, uint32_t channels);
+
+    /**
+     * @brief Sets the delay. Can be called from any thread.
+     * @param seconds The delay in seconds. Clamped to the range from 0 to MaxDelay.
+     */
+    void Delay(double seconds);
+
+    /**
+     * @brief Returns the current delay.
+     * @return The delay in seconds.
+     */
+    double Delay() const;
+
+    /**
+     * @brief Stores a block of samples in the history and outputs the delayed samples.
+     * @param input The interleaved input samples.
+     * @param frames The number of sample frames to process.
+     * @param output Destination memory for the delayed samples. May be the same as input.
+     */
+    void Process(const float* input, size_t frames, float* output);
+
+protected:
+    /**
+     * @brief Copies samples into the history at the write position and advances it.
+     * @param input The samples to store.
+     * @param frames The number of sample frames. Must not exceed the history size.
+     */
+    void Store(const float* input, size_t frames);
+
+    /**
+     * @brief Copies samples from the history, starting the given number of frames before the write position.
+     * @param output Destination memory for the samples.
+     * @param frames The number of sample frames to copy.
+     * @param framesBack Distance of the first frame from the write position. Must be at least @a frames.
+     */
+    void Load(float* output, size_t frames, size_t framesBack) const;
+
+    uint32_t _sampleRate{44100}; //!< Sample rate of the processed audio.
+    uint32_t _channels{2}; //!< Number of interleaved channels.
+    size_t _historyFrames{0}; //!< Size of the history in sample frames.
+    size_t _writePosition{0}; //!< Frame index in the history the next input frame is stored at.
+    std::vector<float> _history; //!< The most recent input samples, used as a circular buffer.
+
+    std::atomic<double> _delay{0.0}; //!< Current delay in seconds.
+};
@@ -0,0 +1,258 @@
+#include "AudioDownmixer.h"
+
+#include "AudioSIMD.h"
+
+#include <Poco/Logger.h>
+#include <Poco/NumberParser.h>
+#include <Poco/StringTokenizer.h>
+
+#include <algorithm>
+#include <string>
+
+namespace {
+
+constexpr float FullLevel{1.0f};
+constexpr float Minus3dB{0.7071f};
+constexpr float Minus6dB{0.5f};
+
+/**
+ * @brief Parses a comma-separated coefficient list.
+ * @param value The configuration value.
+ * @param channels Number of expected coefficients.
+ * @param coefficients Receives the parsed values. Only modified if the list is valid.
+ * @return true if the list contained exactly one valid number per channel.
+ */
+bool ParseCoefficients(const std::string& value, uint32_t channels, float* coefficients)
+{
+    Poco::StringTokenizer tokens(value, ",", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    if (tokens.count() != channels)
+    {
+        return false;
+    }
+
+    float parsedCoefficients[AudioDownmixer::MaxChannels]{};
+    for (uint32_t channel = 0; channel < channels; channel++)
+    {
+        double coefficient{0.0};
+        if (!Poco::NumberParser::tryParseFloat(tokens[channel], coefficient))
+        {
+            return false;
+        }
+        parsedCoefficients[channel] = static_cast<float>(coefficient);
+    }
+
+    std::copy(parsedCoefficients, parsedCoefficients + channels, coefficients);
+
+    return true;
+}
+
+} // namespace
+
+constexpr uint32_t AudioDownmixer::MaxVectorChannels;
+constexpr uint32_t AudioDownmixer::MaxChannels;
+
+void AudioDownmixer::Configure(uint32_t inputChannels, const Poco::Util::AbstractConfiguration& config)
+{
+    float leftCoefficients[MaxChannels]{};
+    float rightCoefficients[MaxChannels]{};
+
+    inputChannels = std::min(inputChannels, MaxChannels);
+    DefaultCoefficients(inputChannels, leftCoefficients, rightCoefficients);
+
+    if (inputChannels > 2)
+    {
+        auto& logger = Poco::Logger::get("AudioCapture.Downmix");
+        auto baseKey = "downmix." + std::to_string(inputChannels);
+
+        auto leftValue = config.getString(baseKey + ".left", "");
+        if (!leftValue.empty() && !ParseCoefficients(leftValue, inputChannels, leftCoefficients))
+        {
+            poco_warning_f2(logger, "Ignoring audio.%s.left, expected %?u comma-separated numbers.", baseKey, inputChannels);
+        }
+
+        auto rightValue = config.getString(baseKey + ".right", "");
+        if (!rightValue.empty() && !ParseCoefficients(rightValue, inputChannels, rightCoefficients))
+        {
+            poco_warning_f2(logger, "Ignoring audio.%s.right, expected %?u comma-separated numbers.", baseKey, inputChannels);
+        }
+    }
+
+    Configure(inputChannels, leftCoefficients, rightCoefficients);
+}
+
+void AudioDownmixer::Configure(uint32_t inputChannels, const float* leftCoefficients, const float* rightCoefficients)
+{
+    _inputChannels = std::min(inputChannels, MaxChannels);
+
+    std::fill(std::begin(_leftCoefficients), std::end(_leftCoefficients), 0.0f);
+    std::fill(std::begin(_rightCoefficients), std::end(_rightCoefficients), 0.0f);
+    std::copy(leftCoefficients, leftCoefficients + _inputChannels, _leftCoefficients);
+    std::copy(rightCoefficients, rightCoefficients + _inputChannels, _rightCoefficients);
+}
+
+bool AudioDownmixer::Active() const
+{
+    return _inputChannels > 2;
+}
+
+uint32_t AudioDownmixer::OutputChannels() const
+{
+    return std::min(_inputChannels, 2U);
+}
+
+void AudioDownmixer::Process(const float* input, size_t frames, float* output) const
+{
+    size_t vectorFrames{0};
+
+#if defined(AUDIO_SIMD_SSE2) || defined(AUDIO_SIMD_NEON)
+    // Each frame is loaded as two full vectors, which may read into the following frame. Those
+    // samples are multiplied by the zero padding. Stop early enough to not read past the input.
+    const size_t inputSamples = frames * _inputChannels;
+    if (_inputChannels <= MaxVectorChannels && inputSamples >= MaxVectorChannels)
+    {
+        vectorFrames = (inputSamples - MaxVectorChannels) / _inputChannels + 1;
+    }
+#endif
+
+#if defined(AUDIO_SIMD_SSE2)
+    const __m128 left0 = _mm_loadu_ps(_leftCoefficients);
+    const __m128 left1 = _mm_loadu_ps(_leftCoefficients + 4);
+    const __m128 right0 = _mm_loadu_ps(_rightCoefficients);
+    const __m128 right1 = _mm_loadu_ps(_rightCoefficients + 4);
+
+    for (size_t frame = 0; frame < vectorFrames; frame++)
+    {
+        const float* samples = input + frame * _inputChannels;
+        const __m128 samples0 = _mm_loadu_ps(samples);
+        const __m128 samples1 = _mm_loadu_ps(samples + 4);
+
+        __m128 left = _mm_add_ps(_mm_mul_ps(samples0, left0), _mm_mul_ps(samples1, left1));
+        __m128 right = _mm_add_ps(_mm_mul_ps(samples0, right0), _mm_mul_ps(samples1, right1));
+
+        // Interleave both partial sums (L0 R0 L1 R1 + L2 R2 L3 R3), then fold the upper half onto the lower.
+        __m128 sum = _mm_add_ps(_mm_unpacklo_ps(left, right), _mm_unpackhi_ps(left, right));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(output + frame * 2), sum);
+    }
+#elif defined(AUDIO_SIMD_NEON)
+    const float32x4_t left0 = vld1q_f32(_leftCoefficients);
+    const float32x4_t left1 = vld1q_f32(_leftCoefficients + 4);
+    const float32x4_t right0 = vld1q_f32(_rightCoefficients);
+    const float32x4_t right1 = vld1q_f32(_rightCoefficients + 4);
+
+    for (size_t frame = 0; frame < vectorFrames; frame++)
+    {
+        const float* samples = input + frame * _inputChannels;
+        const float32x4_t samples0 = vld1q_f32(samples);
+        const float32x4_t samples1 = vld1q_f32(samples + 4);
+
+        float32x4_t left = vmlaq_f32(vmulq_f32(samples0, left0), samples1, left1);
+        float32x4_t right = vmlaq_f32(vmulq_f32(samples0, right0), samples1, right1);
+
+        // Pairwise adds: (L0+L1, L2+L3) and (R0+R1, R2+R3), then once more across both.
+        float32x2_t leftHalf = vpadd_f32(vget_low_f32(left), vget_high_f32(left));
+        float32x2_t rightHalf = vpadd_f32(vget_low_f32(right), vget_high_f32(right));
+
+        vst1_f32(output + frame * 2, vpadd_f32(leftHalf, rightHalf));
+    }
+#endif
+
+    ProcessScalar(input + vectorFrames * _inputChannels, frames - vectorFrames, output + vectorFrames * 2);
+}
+
+void AudioDownmixer::DefaultCoefficients(uint32_t inputChannels, float* leftCoefficients, float* rightCoefficients)
+{
+    std::fill(leftCoefficients, leftCoefficients + inputChannels, 0.0f);
+    std::fill(rightCoefficients, rightCoefficients + inputChannels, 0.0f);
+
+    auto set = [leftCoefficients, rightCoefficients](uint32_t channel, float left, float right) {
+        leftCoefficients[channel] = left;
+        rightCoefficients[channel] = right;
+    };
+
+    switch (inputChannels)
+    {
+        case 0:
+            break;
+
+        case 1:
+            set(0, FullLevel, FullLevel);
+            break;
+
+        case 3: // FL FR LFE
+            set(0, FullLevel, 0.0f);
+            set(1, 0.0f, FullLevel);
+            set(2, Minus6dB, Minus6dB);
+            break;
+
+        case 4: // FL FR BL BR
+            set(0, FullLevel, 0.0f);
+            set(1, 0.0f, FullLevel);
+            set(2, Minus3dB, 0.0f);
+            set(3, 0.0f, Minus3dB);
+            break;
+
+        case 5: // FL FR LFE BL BR
+            set(0, FullLevel, 0.0f);
+            set(1, 0.0f, FullLevel);
+            set(2, Minus6dB, Minus6dB);
+            set(3, Minus3dB, 0.0f);
+            set(4, 0.0f, Minus3dB);
+            break;
+
+        case 6: // FL FR FC LFE SL SR
+            set(0, FullLevel, 0.0f);
+            set(1, 0.0f, FullLevel);
+            set(2, Minus3dB, Minus3dB);
+            set(3, Minus6dB, Minus6dB);
+            set(4, Minus3dB, 0.0f);
+            set(5, 0.0f, Minus3dB);
+            break;
+
+        case 7: // FL FR FC LFE BC SL SR
+            set(0, FullLevel, 0.0f);
+            set(1, 0.0f, FullLevel);
+            set(2, Minus3dB, Minus3dB);
+            set(3, Minus6dB, Minus6dB);
+            set(4, Minus6dB, Minus6dB);
+            set(5, Minus3dB, 0.0f);
+            set(6, 0.0f, Minus3dB);
+            break;
+
+        case 8: // FL FR FC LFE BL BR SL SR
+            set(0, FullLevel, 0.0f);
+            set(1, 0.0f, FullLevel);
+            set(2, Minus3dB, Minus3dB);
+            set(3, Minus6dB, Minus6dB);
+            set(4, Minus3dB, 0.0f);
+            set(5, 0.0f, Minus3dB);
+            set(6, Minus3dB, 0.0f);
+            set(7, 0.0f, Minus3dB);
+            break;
+
+        default: // Stereo and unknown layouts: use the first two channels as front left/right.
+            set(0, FullLevel, 0.0f);
+            set(1, 0.0f, FullLevel);
+            break;
+    }
+}
+
+void AudioDownmixer::ProcessScalar(const float* input, size_t frames, float* output) const
+{
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        const float* samples = input + frame * _inputChannels;
+
+        float left{0.0f};
+        float right{0.0f};
+        for (uint32_t channel = 0; channel < _inputChannels; channel++)
+        {
+            left += samples[channel] * _leftCoefficients[channel];
+            right += samples[channel] * _rightCoefficients[channel];
+        }
+
+        output[frame * 2] = left;
+        output[frame * 2 + 1] = right;
+    }
+}
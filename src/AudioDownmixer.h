@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Folds interleaved multichannel audio down to stereo.
+ *
+ * projectM only accepts mono and stereo PCM data. Audio devices with more channels, e.g. 5.1 or 7.1
+ * surround monitors, are mixed down to stereo using a configurable coefficient matrix. Mono and stereo
+ * data is passed through untouched.
+ *
+ * The default coefficients follow SDL's channel layouts (which match the WASAPI default order):
+ *
+ * - 3 channels: FL FR LFE
+ * - 4 channels: FL FR BL BR
+ * - 5 channels: FL FR LFE BL BR
+ * - 6 channels: FL FR FC LFE SL SR
+ * - 7 channels: FL FR FC LFE BC SL SR
+ * - 8 channels: FL FR FC LFE BL BR SL SR
+ *
+ * Each output frame is computed with two vector multiplications and a shuffle-based horizontal sum
+ * for up to eight channels. Devices with more channels use a scalar loop.
+ */
+class AudioDownmixer
+{
+public:
+    static constexpr uint32_t MaxVectorChannels{8}; //!< Maximum number of input channels handled by the SIMD kernel.
+    static constexpr uint32_t MaxChannels{32}; //!< Maximum number of supported input channels.
+
+    /**
+     * @brief Sets up the downmixer for the given input channel count.
+     *
+     * Coefficients can be overridden in the configuration with the keys "downmix.<channels>.left" and
+     * "downmix.<channels>.right", each containing a comma-separated list with one value per input channel.
+     *
+     * @param inputChannels The number of interleaved input channels.
+     * @param config The "audio" configuration view to read user-defined coefficients from.
+     */
+    void Configure(uint32_t inputChannels, const Poco::Util::AbstractConfiguration& config);
+
+    /**
+     * @brief Sets up the downmixer for the given input channel count with explicit coefficients.
+     * @param inputChannels The number of interleaved input channels.
+     * @param leftCoefficients Weight of each input channel in the left output channel.
+     * @param rightCoefficients Weight of each input channel in the right output channel.
+     */
+    void Configure(uint32_t inputChannels, const float* leftCoefficients, const float* rightCoefficients);
+
+    /**
+     * @brief Returns whether the input needs to be downmixed.
+     * @return true if the input has more than two channels.
+     */
+    bool Active() const;
+
+    /**
+     * @brief Returns the number of channels in the output data.
+     * @return Either the input channel count for mono and stereo, or 2.
+     */
+    uint32_t OutputChannels() const;
+
+    /**
+     * @brief Downmixes a block of interleaved audio to stereo.
+     * @param input The interleaved input samples.
+     * @param frames The number of sample frames to process.
+     * @param output Destination memory for 2 * frames samples. May be the same as input.
+     */
+    void Process(const float* input, size_t frames, float* output) const;
+
+    /**
+     * @brief Fills the given arrays with the default downmix coefficients for the channel count.
+     * @param inputChannels The number of interleaved input channels.
+     * @param leftCoefficients Receives inputChannels weights for the left output channel.
+     * @param rightCoefficients Receives inputChannels weights for the right output channel.
+     */
+    static void DefaultCoefficients(uint32_t inputChannels, float* leftCoefficients, float* rightCoefficients);
+
+protected:
+    /**
+     * @brief Portable version of the downmix kernel, used for the last frames of each block and wide layouts.
+     * @param input The interleaved input samples.
+     * @param frames The number of sample frames to process.
+     * @param output Destination memory for 2 * frames samples.
+     */
+    void ProcessScalar(const float* input, size_t frames, float* output) const;
+
+    uint32_t _inputChannels{2}; //!< Number of interleaved input channels.
+
+    // Zero-padded to MaxVectorChannels so the SIMD kernel can always load two full vectors.
+    float _leftCoefficients[MaxChannels]{}; //!< Weight of each input channel in the left output channel.
+    float _rightCoefficients[MaxChannels]{}; //!< Weight of each input channel in the right output channel.
+};
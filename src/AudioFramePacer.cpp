@@ -0,0 +1,134 @@
+#include "AudioFramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr double AudioFramePacer::MaxElapsedTime;
+
+void AudioFramePacer::Reset(uint32_t sampleRate, uint32_t deviceBufferFrames)
+{
+    _sampleRate = sampleRate;
+    _deviceBufferFrames = deviceBufferFrames;
+    _backlogStep = std::max<size_t>(1, deviceBufferFrames / 4);
+    _minimumBacklog = _lowLatency ? _backlogStep : deviceBufferFrames;
+    _maximumBacklog = static_cast<size_t>(deviceBufferFrames) * 4;
+    _targetBacklog = _minimumBacklog;
+
+    _fractionalFrames = 0.0;
+    _pendingCorrection = 0;
+    _started = false;
+
+    _underruns = 0;
+    _overruns = 0;
+}
+
+void AudioFramePacer::LowLatency(bool enabled)
+{
+    if (enabled == _lowLatency)
+    {
+        return;
+    }
+
+    _lowLatency = enabled;
+    _minimumBacklog = _lowLatency ? _backlogStep : _deviceBufferFrames;
+
+    // Start again from the lowest backlog, it grows back on underruns if needed.
+    _targetBacklog = _minimumBacklog;
+}
+
+AudioFramePacer::Step AudioFramePacer::Advance(double now, size_t availableFrames)
+{
+    Step step;
+
+    if (!_started)
+    {
+        // Start with exactly the targeted backlog in the buffer.
+        _started = true;
+        _lastTime = now;
+        _lastBacklogChangeTime = now;
+        _lowWaterMarkStartTime = now;
+        _lowWaterMark = availableFrames;
+
+        if (availableFrames > _targetBacklog)
+        {
+            step.framesToSkip = availableFrames - _targetBacklog;
+        }
+
+        return step;
+    }
+
+    double elapsedTime = std::min(std::max(now - _lastTime, 0.0), MaxElapsedTime);
+    _lastTime = now;
+
+    double wantedFrames = elapsedTime * static_cast<double>(_sampleRate) + _fractionalFrames;
+    auto framesToDeliver = static_cast<size_t>(std::floor(wantedFrames));
+    _fractionalFrames = wantedFrames - static_cast<double>(framesToDeliver);
+
+    if (_pendingCorrection > 0)
+    {
+        auto correction = std::min(_pendingCorrection, std::max<size_t>(1, framesToDeliver / MaxCorrectionDivisor));
+        framesToDeliver += correction;
+        _pendingCorrection -= correction;
+    }
+
+    if (framesToDeliver > availableFrames)
+    {
+        _underruns++;
+        framesToDeliver = availableFrames;
+        _fractionalFrames = 0.0;
+        _pendingCorrection = 0;
+
+        _targetBacklog = std::min(_targetBacklog + _backlogStep, _maximumBacklog);
+        _lastBacklogChangeTime = now;
+    }
+
+    auto remainingFrames = availableFrames - framesToDeliver;
+
+    // Allow one device buffer on top of the maximum backlog, as the driver delivers data in bursts.
+    if (remainingFrames > _maximumBacklog + _minimumBacklog)
+    {
+        _overruns++;
+        step.framesToSkip = remainingFrames - _targetBacklog;
+        remainingFrames = _targetBacklog;
+        _pendingCorrection = 0;
+    }
+
+    step.framesToDeliver = framesToDeliver;
+
+    // Anything that permanently stays in the buffer above the target is caused by clock drift.
+    _lowWaterMark = std::min(_lowWaterMark, remainingFrames);
+    if (now - _lowWaterMarkStartTime >= LowWaterMarkInterval)
+    {
+        if (_lowWaterMark > _targetBacklog)
+        {
+            // Only correct half of the excess to avoid overshooting into an underrun.
+            _pendingCorrection = (_lowWaterMark - _targetBacklog) / 2;
+        }
+
+        _lowWaterMark = remainingFrames;
+        _lowWaterMarkStartTime = now;
+    }
+
+    if (_targetBacklog > _minimumBacklog && now - _lastBacklogChangeTime >= BacklogShrinkInterval)
+    {
+        _targetBacklog = std::max(_targetBacklog - std::min(_backlogStep, _targetBacklog), _minimumBacklog);
+        _lastBacklogChangeTime = now;
+    }
+
+    return step;
+}
+
+uint64_t AudioFramePacer::Underruns() const
+{
+    return _underruns;
+}
+
+uint64_t AudioFramePacer::Overruns() const
+{
+    return _overruns;
+}
+
+size_t AudioFramePacer::TargetBacklog() const
+{
+    return _targetBacklog;
+}
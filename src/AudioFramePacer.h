@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Calculates how many captured sample frames should be passed to projectM each rendered frame.
+ *
+ * Audio drivers deliver samples in bursts of one device buffer, which rarely matches the render frame
+ * rate. Passing everything that arrived since the last frame makes projectM alternate between a full
+ * buffer and no new data at all. The pacer instead hands out exactly the number of sample frames that
+ * corresponds to the wall-clock time passed since the previous frame, and keeps a small backlog in the
+ * capture buffer to bridge the gaps between two driver callbacks.
+ *
+ * The backlog adapts itself: it grows by a fraction of a device buffer after each underrun and slowly
+ * shrinks back if no underruns happened for a while. If the audio clock runs slightly faster than the
+ * system clock, the backlog's low-water mark rises above the target and the excess is delivered in
+ * small extra portions. Backlog exceeding the allowed maximum, e.g. after the render loop was stalled,
+ * is skipped and counted as an overrun, which keeps latency bounded.
+ */
+class AudioFramePacer
+{
+public:
+    /**
+     * @brief Result of a single pacing step.
+     */
+    struct Step
+    {
+        size_t framesToSkip{0}; //!< Number of oldest sample frames to drop from the buffer.
+        size_t framesToDeliver{0}; //!< Number of sample frames to pass to projectM after skipping.
+    };
+
+    /**
+     * @brief Resets the pacer, e.g. after a new audio device was opened.
+     * @param sampleRate The sample rate of the captured audio in Hz.
+     * @param deviceBufferFrames The number of sample frames delivered by each driver callback.
+     */
+    void Reset(uint32_t sampleRate, uint32_t deviceBufferFrames);
+
+    /**
+     * @brief Enables or disables the low-latency mode.
+     *
+     * By default, the backlog never drops below one device buffer. In low-latency mode, the lowest backlog
+     * is a quarter of a device buffer instead. This minimizes the capture latency, at the cost of more
+     * underruns until the backlog has grown to the lowest value the driver's timing allows. The setting is
+     * kept across resets.
+     *
+     * @param enabled true to enable the low-latency mode.
+     */
+    void LowLatency(bool enabled);
+
+    /**
+     * @brief Calculates the number of sample frames to skip and deliver for the current render frame.
+     * @param now The current time in seconds, from a monotonic clock.
+     * @param availableFrames The number of sample frames currently in the capture buffer.
+     * @return The number of sample frames to skip and to deliver.
+     */
+    Step Advance(double now, size_t availableFrames);
+
+    /**
+     * @brief Returns the number of frames for which fewer samples were available than required.
+     * @return The underrun count since the last reset.
+     */
+    uint64_t Underruns() const;
+
+    /**
+     * @brief Returns the number of times excess backlog had to be dropped.
+     * @return The overrun count since the last reset.
+     */
+    uint64_t Overruns() const;
+
+    /**
+     * @brief Returns the currently targeted backlog.
+     * @return The number of sample frames the pacer tries to keep in the capture buffer.
+     */
+    size_t TargetBacklog() const;
+
+protected:
+    static constexpr double MaxElapsedTime{0.25}; //!< Longer gaps between two frames, e.g. while dragging the window, are clamped to this time in seconds.
+    static constexpr double BacklogShrinkInterval{5.0}; //!< Time in seconds without underruns before the target backlog is lowered by one step.
+    static constexpr double LowWaterMarkInterval{1.0}; //!< Time in seconds over which the lowest backlog is tracked for drift correction.
+    static constexpr size_t MaxCorrectionDivisor{16}; //!< Limits drift correction to 1/16th of the regularly delivered frames.
+
+    uint32_t _sampleRate{44100}; //!< Sample rate of the captured audio.
+    size_t _deviceBufferFrames{0}; //!< Number of sample frames delivered by each driver callback.
+    bool _lowLatency{false}; //!< If true, the backlog may drop below one device buffer.
+    size_t _backlogStep{0}; //!< Amount the target backlog changes on underruns or after a period without underruns.
+    size_t _minimumBacklog{0}; //!< Lowest possible target backlog, one device buffer or one step in low-latency mode.
+    size_t _maximumBacklog{0}; //!< Highest possible target backlog.
+    size_t _targetBacklog{0}; //!< Currently targeted backlog.
+
+    double _lastTime{0.0}; //!< Time of the previous Advance() call.
+    double _lastBacklogChangeTime{0.0}; //!< Time of the last underrun or target backlog change.
+    double _lowWaterMarkStartTime{0.0}; //!< Start time of the current low-water mark interval.
+    double _fractionalFrames{0.0}; //!< Sub-frame remainder carried over to the next step.
+    size_t _lowWaterMark{0}; //!< Lowest backlog after delivering in the current interval.
+    size_t _pendingCorrection{0}; //!< Excess backlog frames still to be delivered for drift correction.
+    bool _started{false}; //!< False until the first Advance() call after a reset.
+
+    uint64_t _underruns{0}; //!< Number of underruns since the last reset.
+    uint64_t _overruns{0}; //!< Number of overruns since the last reset.
+};
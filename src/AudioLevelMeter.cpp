@@ -0,0 +1,296 @@
+#include "AudioLevelMeter.h"
+
+#include "AudioSIMD.h"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using BlockStatistics = AudioLevelMeter::BlockStatistics;
+
+BlockStatistics AnalyzeScalar(const float* samples, size_t count)
+{
+    BlockStatistics statistics;
+    for (size_t index = 0; index < count; index++)
+    {
+        auto value = samples[index];
+        auto magnitude = std::fabs(value);
+
+        statistics.sum += value;
+        statistics.sumOfSquares += value * value;
+        statistics.peak = std::max(statistics.peak, magnitude);
+        if (magnitude >= AudioLevelMeter::ClipLevel)
+        {
+            statistics.clippedSamples += 1.0f;
+        }
+    }
+
+    return statistics;
+}
+
+/*
+ * The SIMD kernels process a multiple of 8 samples. The remainder of a block is passed to AnalyzeScalar().
+ */
+
+#ifdef AUDIO_SIMD_SSE2
+float HorizontalSumSSE2(__m128 value)
+{
+    value = _mm_add_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_add_ss(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtss_f32(value);
+}
+
+float HorizontalMaxSSE2(__m128 value)
+{
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_max_ss(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtss_f32(value);
+}
+
+BlockStatistics AnalyzeSSE2(const float* samples, size_t count)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 clipLevel = _mm_set1_ps(AudioLevelMeter::ClipLevel);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    __m128 sum = _mm_setzero_ps();
+    __m128 sumOfSquares = _mm_setzero_ps();
+    __m128 peak = _mm_setzero_ps();
+    __m128 clippedSamples = _mm_setzero_ps();
+    for (size_t index = 0; index < count; index += 4)
+    {
+        __m128 value = _mm_loadu_ps(samples + index);
+        __m128 magnitude = _mm_andnot_ps(signMask, value);
+
+        sum = _mm_add_ps(sum, value);
+        sumOfSquares = _mm_add_ps(sumOfSquares, _mm_mul_ps(value, value));
+        peak = _mm_max_ps(peak, magnitude);
+        clippedSamples = _mm_add_ps(clippedSamples, _mm_and_ps(_mm_cmpge_ps(magnitude, clipLevel), one));
+    }
+
+    BlockStatistics statistics;
+    statistics.sum = HorizontalSumSSE2(sum);
+    statistics.sumOfSquares = HorizontalSumSSE2(sumOfSquares);
+    statistics.peak = HorizontalMaxSSE2(peak);
+    statistics.clippedSamples = HorizontalSumSSE2(clippedSamples);
+
+    return statistics;
+}
+#endif
+
+#ifdef AUDIO_SIMD_AVX2
+AUDIO_SIMD_TARGET_AVX2 BlockStatistics AnalyzeAVX2(const float* samples, size_t count)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 clipLevel = _mm256_set1_ps(AudioLevelMeter::ClipLevel);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 sum = _mm256_setzero_ps();
+    __m256 sumOfSquares = _mm256_setzero_ps();
+    __m256 peak = _mm256_setzero_ps();
+    __m256 clippedSamples = _mm256_setzero_ps();
+    for (size_t index = 0; index < count; index += 8)
+    {
+        __m256 value = _mm256_loadu_ps(samples + index);
+        __m256 magnitude = _mm256_andnot_ps(signMask, value);
+
+        sum = _mm256_add_ps(sum, value);
+        sumOfSquares = _mm256_add_ps(sumOfSquares, _mm256_mul_ps(value, value));
+        peak = _mm256_max_ps(peak, magnitude);
+        clippedSamples = _mm256_add_ps(clippedSamples, _mm256_and_ps(_mm256_cmp_ps(magnitude, clipLevel, _CMP_GE_OQ), one));
+    }
+
+    BlockStatistics statistics;
+    statistics.sum = HorizontalSumSSE2(_mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+    statistics.sumOfSquares = HorizontalSumSSE2(_mm_add_ps(_mm256_castps256_ps128(sumOfSquares), _mm256_extractf128_ps(sumOfSquares, 1)));
+    statistics.peak = HorizontalMaxSSE2(_mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1)));
+    statistics.clippedSamples = HorizontalSumSSE2(_mm_add_ps(_mm256_castps256_ps128(clippedSamples), _mm256_extractf128_ps(clippedSamples, 1)));
+
+    return statistics;
+}
+#endif
+
+#ifdef AUDIO_SIMD_NEON
+float HorizontalSumNEON(float32x4_t value)
+{
+    float32x2_t halfSum = vadd_f32(vget_low_f32(value), vget_high_f32(value));
+
+    return vget_lane_f32(vpadd_f32(halfSum, halfSum), 0);
+}
+
+float HorizontalMaxNEON(float32x4_t value)
+{
+    float32x2_t halfMax = vpmax_f32(vget_low_f32(value), vget_high_f32(value));
+
+    return vget_lane_f32(vpmax_f32(halfMax, halfMax), 0);
+}
+
+BlockStatistics AnalyzeNEON(const float* samples, size_t count)
+{
+    const float32x4_t clipLevel = vdupq_n_f32(AudioLevelMeter::ClipLevel);
+    const uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.0f));
+
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    float32x4_t sumOfSquares = vdupq_n_f32(0.0f);
+    float32x4_t peak = vdupq_n_f32(0.0f);
+    float32x4_t clippedSamples = vdupq_n_f32(0.0f);
+    for (size_t index = 0; index < count; index += 4)
+    {
+        float32x4_t value = vld1q_f32(samples + index);
+        float32x4_t magnitude = vabsq_f32(value);
+
+        sum = vaddq_f32(sum, value);
+        sumOfSquares = vmlaq_f32(sumOfSquares, value, value);
+        peak = vmaxq_f32(peak, magnitude);
+        clippedSamples = vaddq_f32(clippedSamples, vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(magnitude, clipLevel), one)));
+    }
+
+    BlockStatistics statistics;
+    statistics.sum = HorizontalSumNEON(sum);
+    statistics.sumOfSquares = HorizontalSumNEON(sumOfSquares);
+    statistics.peak = HorizontalMaxNEON(peak);
+    statistics.clippedSamples = HorizontalSumNEON(clippedSamples);
+
+    return statistics;
+}
+#endif
+
+} // namespace
+
+constexpr float AudioLevelMeter::ClipLevel;
+constexpr double AudioLevelMeter::PeakFallRate;
+constexpr double AudioLevelMeter::RMSTime;
+constexpr double AudioLevelMeter::DCTime;
+
+AudioLevelMeter::AudioLevelMeter()
+    : _ticksPerSecond(static_cast<double>(SDL_GetPerformanceFrequency()))
+{
+    _analyze = &AnalyzeScalar;
+    _kernelName = "scalar";
+#ifdef AUDIO_SIMD_SSE2
+    _analyze = &AnalyzeSSE2;
+    _kernelName = "SSE2";
+#endif
+#ifdef AUDIO_SIMD_AVX2
+    if (SDL_HasAVX2())
+    {
+        _analyze = &AnalyzeAVX2;
+        _kernelName = "AVX2";
+    }
+#endif
+#ifdef AUDIO_SIMD_NEON
+    _analyze = &AnalyzeNEON;
+    _kernelName = "NEON";
+#endif
+}
+
+void AudioLevelMeter::Configure(uint32_t sampleRate, uint32_t channels, double silenceThresholdDb)
+{
+    _sampleRate = sampleRate;
+    _channels = channels;
+
+    auto threshold = std::pow(10.0, silenceThresholdDb / 20.0);
+    _silenceThresholdSquared = static_cast<float>(threshold * threshold);
+    _ticksPerSecond = static_cast<double>(SDL_GetPerformanceFrequency());
+
+    _peak = 0.0f;
+    _meanSquare = 0.0f;
+    _dcOffset = 0.0f;
+    _clippedSamples = 0;
+    _lastAudibleTicks = SDL_GetPerformanceCounter();
+
+    TakeInterval();
+}
+
+void AudioLevelMeter::Process(const float* samples, size_t frames)
+{
+    auto count = frames * _channels;
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto startTicks = SDL_GetPerformanceCounter();
+
+    auto kernelCount = count & ~static_cast<size_t>(7);
+    auto statistics = _analyze(samples, kernelCount);
+    auto remainder = AnalyzeScalar(samples + kernelCount, count - kernelCount);
+    statistics.sum += remainder.sum;
+    statistics.sumOfSquares += remainder.sumOfSquares;
+    statistics.peak = std::max(statistics.peak, remainder.peak);
+    statistics.clippedSamples += remainder.clippedSamples;
+
+    auto meanSquare = statistics.sumOfSquares / static_cast<float>(count);
+    auto mean = statistics.sum / static_cast<float>(count);
+
+    if (meanSquare >= _silenceThresholdSquared)
+    {
+        _lastAudibleTicks.store(startTicks, std::memory_order_relaxed);
+    }
+
+    // Only this thread writes the readings, so they don't need to be updated atomically as a whole.
+    auto blockTime = static_cast<double>(frames) / _sampleRate;
+    auto peakFall = static_cast<float>(std::pow(10.0, -PeakFallRate * blockTime / 20.0));
+    auto rmsWeight = static_cast<float>(1.0 - std::exp(-blockTime / RMSTime));
+    auto dcWeight = static_cast<float>(1.0 - std::exp(-blockTime / DCTime));
+
+    auto lastMeanSquare = _meanSquare.load(std::memory_order_relaxed);
+    auto lastDCOffset = _dcOffset.load(std::memory_order_relaxed);
+    _peak.store(std::max(statistics.peak, _peak.load(std::memory_order_relaxed) * peakFall), std::memory_order_relaxed);
+    _meanSquare.store(lastMeanSquare + (meanSquare - lastMeanSquare) * rmsWeight, std::memory_order_relaxed);
+    _dcOffset.store(lastDCOffset + (mean - lastDCOffset) * dcWeight, std::memory_order_relaxed);
+
+    auto clippedSamples = static_cast<uint64_t>(statistics.clippedSamples);
+    _clippedSamples.fetch_add(clippedSamples, std::memory_order_relaxed);
+
+    AtomicMax(_intervalPeak, statistics.peak);
+    _intervalClippedSamples.fetch_add(clippedSamples, std::memory_order_relaxed);
+    _intervalFrames.fetch_add(frames, std::memory_order_relaxed);
+    _intervalTicks.fetch_add(SDL_GetPerformanceCounter() - startTicks, std::memory_order_relaxed);
+}
+
+AudioLevelMeter::Levels AudioLevelMeter::CurrentLevels() const
+{
+    Levels levels;
+    levels.peak = _peak.load(std::memory_order_relaxed);
+    levels.rms = std::sqrt(_meanSquare.load(std::memory_order_relaxed));
+    levels.dcOffset = _dcOffset.load(std::memory_order_relaxed);
+    levels.clippedSamples = _clippedSamples.load(std::memory_order_relaxed);
+
+    return levels;
+}
+
+AudioLevelMeter::Interval AudioLevelMeter::TakeInterval()
+{
+    Interval interval;
+    interval.maxPeak = _intervalPeak.exchange(0.0f, std::memory_order_relaxed);
+    interval.clippedSamples = _intervalClippedSamples.exchange(0, std::memory_order_relaxed);
+    interval.frames = _intervalFrames.exchange(0, std::memory_order_relaxed);
+    interval.processingTime = static_cast<double>(_intervalTicks.exchange(0, std::memory_order_relaxed)) / _ticksPerSecond;
+
+    return interval;
+}
+
+double AudioLevelMeter::SilenceDuration() const
+{
+    auto silentTicks = SDL_GetPerformanceCounter() - _lastAudibleTicks.load(std::memory_order_relaxed);
+    return static_cast<double>(silentTicks) / _ticksPerSecond;
+}
+
+const char* AudioLevelMeter::KernelName() const
+{
+    return _kernelName;
+}
+
+void AudioLevelMeter::AtomicMax(std::atomic<float>& target, float value)
+{
+    auto current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Measures the level of the captured audio and tracks for how long it has been silent.
+ *
+ * Each captured block is analyzed in a single pass, which calculates the peak and RMS level, the DC
+ * offset and the number of clipped samples. The pass uses SSE2, AVX2 or NEON if available, so metering
+ * adds very little work to the audio thread. The results are published as atomics, which can be read
+ * from any thread without locking:
+ *
+ * - Levels() returns meter readings with the usual ballistics, i.e. a peak falling by PeakFallRate and an
+ *   RMS and DC offset averaged over RMSTime and DCTime.
+ * - TakeInterval() returns the maximum peak, the clipped samples, the processed frames and the time spent
+ *   metering since its last call, for periodic log output. Only one thread should call it.
+ * - SilenceDuration() returns the time since the last block with an RMS level above the silence threshold.
+ *   Measuring the time instead of counting silent samples also covers sources which stop delivering data
+ *   while nothing is played, like WASAPI loopback capture or an idle pipe.
+ *
+ * Process() is called by a single thread, either the one delivering the audio or the render thread reading it
+ * from the sample queue.
+ */
+class AudioLevelMeter
+{
+public:
+    static constexpr float ClipLevel{0.999f}; //!< Absolute sample value from which a sample counts as clipped.
+    static constexpr double PeakFallRate{20.0}; //!< Fall rate of the peak reading in dB per second.
+    static constexpr double RMSTime{0.3}; //!< Time constant of the RMS averaging in seconds.
+    static constexpr double DCTime{1.0}; //!< Time constant of the DC offset averaging in seconds.
+
+    /**
+     * @brief Current meter readings.
+     */
+    struct Levels
+    {
+        float peak{0.0f}; //!< Linear peak level, falling by PeakFallRate.
+        float rms{0.0f}; //!< Linear RMS level.
+        float dcOffset{0.0f}; //!< Average sample value.
+        uint64_t clippedSamples{0}; //!< Number of clipped samples since the meter was configured.
+    };
+
+    /**
+     * @brief Meter statistics accumulated since the last call to TakeInterval().
+     */
+    struct Interval
+    {
+        float maxPeak{0.0f}; //!< Highest absolute sample value.
+        uint64_t clippedSamples{0}; //!< Number of clipped samples.
+        uint64_t frames{0}; //!< Number of processed sample frames.
+        double processingTime{0.0}; //!< Time spent in Process() in seconds.
+    };
+
+    /**
+     * @brief Statistics of a single block, as calculated by the analysis kernels.
+     */
+    struct BlockStatistics
+    {
+        float sum{0.0f}; //!< Sum of all samples.
+        float sumOfSquares{0.0f}; //!< Sum of all squared samples.
+        float peak{0.0f}; //!< Highest absolute sample value.
+        float clippedSamples{0.0f}; //!< Number of samples at or above ClipLevel.
+    };
+
+    AudioLevelMeter();
+
+    /**
+     * @brief Sets the format and silence threshold and resets all readings.
+     * @param sampleRate The sample rate of the processed audio.
+     * @param channels The number of interleaved channels.
+     * @param silenceThresholdDb RMS level in dBFS below which a block counts as silent.
+     */
+    void Configure(uint32_t sampleRate, uint32_t channels, double silenceThresholdDb);
+
+    /**
+     * @brief Analyzes a block of captured samples and updates the readings.
+     * @param samples The interleaved samples.
+     * @param frames The number of sample frames.
+     */
+    void Process(const float* samples, size_t frames);
+
+    /**
+     * @brief Returns the current meter readings.
+     * @return The peak, RMS and DC offset readings and the total clip count.
+     */
+    Levels CurrentLevels() const;
+
+    /**
+     * @brief Returns the statistics accumulated since the last call and starts a new interval.
+     * @return The interval statistics.
+     */
+    Interval TakeInterval();
+
+    /**
+     * @brief Returns for how long the input has been silent.
+     * @return The time since the last block above the threshold or the call to Configure() in seconds.
+     */
+    double SilenceDuration() const;
+
+    /**
+     * @brief Returns the name of the SIMD kernel used to analyze the blocks.
+     * @return A short name like "SSE2", for log output.
+     */
+    const char* KernelName() const;
+
+protected:
+    using AnalyzeFunction = BlockStatistics (*)(const float* samples, size_t count);
+
+    /**
+     * @brief Raises an atomic float to the given value if it is higher.
+     * @param target The atomic to update.
+     * @param value The new candidate value.
+     */
+    static void AtomicMax(std::atomic<float>& target, float value);
+
+    AnalyzeFunction _analyze{nullptr}; //!< The selected analysis kernel.
+    const char* _kernelName{"scalar"}; //!< Name of the selected kernel.
+
+    uint32_t _sampleRate{44100}; //!< Sample rate of the processed audio.
+    uint32_t _channels{2}; //!< Number of interleaved channels.
+    float _silenceThresholdSquared{1e-6f}; //!< Squared linear RMS threshold for silence.
+    double _ticksPerSecond{1.0}; //!< Performance counter frequency.
+
+    std::atomic<float> _peak{0.0f}; //!< Falling peak reading.
+    std::atomic<float> _meanSquare{0.0f}; //!< Averaged mean square, the square of the RMS reading.
+    std::atomic<float> _dcOffset{0.0f}; //!< Averaged sample value.
+    std::atomic<uint64_t> _clippedSamples{0}; //!< Clipped samples since Configure().
+    std::atomic<uint64_t> _lastAudibleTicks{0}; //!< Performance counter value of the last block above the silence threshold.
+
+    std::atomic<float> _intervalPeak{0.0f}; //!< Highest absolute sample value in the current interval.
+    std::atomic<uint64_t> _intervalClippedSamples{0}; //!< Clipped samples in the current interval.
+    std::atomic<uint64_t> _intervalFrames{0}; //!< Processed frames in the current interval.
+    std::atomic<uint64_t> _intervalTicks{0}; //!< Performance counter ticks spent in Process() in the current interval.
+};
@@ -0,0 +1,315 @@
+#include "AudioResampler.h"
+
+#include "AudioSIMD.h"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr double Pi{3.14159265358979323846};
+
+float DotProductScalar(const float* coefficients, const float* samples, size_t count)
+{
+    float sum[4]{};
+    for (size_t index = 0; index < count; index += 4)
+    {
+        sum[0] += coefficients[index] * samples[index];
+        sum[1] += coefficients[index + 1] * samples[index + 1];
+        sum[2] += coefficients[index + 2] * samples[index + 2];
+        sum[3] += coefficients[index + 3] * samples[index + 3];
+    }
+
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+#ifdef AUDIO_SIMD_SSE2
+float DotProductSSE2(const float* coefficients, const float* samples, size_t count)
+{
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    for (size_t index = 0; index < count; index += 8)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(coefficients + index), _mm_loadu_ps(samples + index)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(coefficients + index + 4), _mm_loadu_ps(samples + index + 4)));
+    }
+
+    __m128 sum = _mm_add_ps(sum0, sum1);
+    sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtss_f32(sum);
+}
+#endif
+
+#ifdef AUDIO_SIMD_AVX2
+AUDIO_SIMD_TARGET_AVX2 float DotProductAVX2(const float* coefficients, const float* samples, size_t count)
+{
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t index = 0; index < count; index += 8)
+    {
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(coefficients + index), _mm256_loadu_ps(samples + index)));
+    }
+
+    __m128 halfSum = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    halfSum = _mm_add_ps(halfSum, _mm_movehl_ps(halfSum, halfSum));
+    halfSum = _mm_add_ss(halfSum, _mm_shuffle_ps(halfSum, halfSum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtss_f32(halfSum);
+}
+#endif
+
+#ifdef AUDIO_SIMD_NEON
+float DotProductNEON(const float* coefficients, const float* samples, size_t count)
+{
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    for (size_t index = 0; index < count; index += 8)
+    {
+        sum0 = vmlaq_f32(sum0, vld1q_f32(coefficients + index), vld1q_f32(samples + index));
+        sum1 = vmlaq_f32(sum1, vld1q_f32(coefficients + index + 4), vld1q_f32(samples + index + 4));
+    }
+
+    float32x4_t sum = vaddq_f32(sum0, sum1);
+    float32x2_t halfSum = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+
+    return vget_lane_f32(vpadd_f32(halfSum, halfSum), 0);
+}
+#endif
+
+uint32_t GreatestCommonDivisor(uint32_t a, uint32_t b)
+{
+    while (b != 0)
+    {
+        auto remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+
+    return a;
+}
+
+} // namespace
+
+bool AudioResampler::KernelAvailable(Kernel kernel)
+{
+    switch (kernel)
+    {
+        case Kernel::Automatic:
+        case Kernel::Scalar:
+            return true;
+
+        case Kernel::SSE2:
+#ifdef AUDIO_SIMD_SSE2
+            return true;
+#else
+            return false;
+#endif
+
+        case Kernel::AVX2:
+#ifdef AUDIO_SIMD_AVX2
+            return SDL_HasAVX2() == SDL_TRUE;
+#else
+            return false;
+#endif
+
+        case Kernel::NEON:
+#ifdef AUDIO_SIMD_NEON
+            return true;
+#else
+            return false;
+#endif
+    }
+
+    return false;
+}
+
+void AudioResampler::Configure(uint32_t inputRate, uint32_t outputRate, uint32_t channels, size_t maxInputFrames,
+                               Kernel kernel)
+{
+    _inputRate = inputRate;
+    _outputRate = outputRate;
+    _channels = channels;
+
+    auto divisor = GreatestCommonDivisor(inputRate, outputRate);
+    _interpolation = outputRate / divisor;
+    _decimation = inputRate / divisor;
+
+    if (_interpolation > MaxPhases)
+    {
+        _decimation = static_cast<uint32_t>(std::lround(static_cast<double>(inputRate) * MaxPhases / outputRate));
+        _interpolation = MaxPhases;
+    }
+
+    SelectKernel(kernel);
+    CreateFilter();
+
+    _history.assign(_channels, std::vector<float>(TapsPerPhase * 2 + maxInputFrames));
+    // Start with a zeroed filter window so the first output sample aligns with the first input sample.
+    _historyLength = TapsPerPhase - 1;
+    _inputIndex = 0;
+    _phase = 0;
+}
+
+bool AudioResampler::Active() const
+{
+    return _inputRate != _outputRate;
+}
+
+size_t AudioResampler::MaxOutputFrames(size_t inputFrames) const
+{
+    return (inputFrames + TapsPerPhase) * _interpolation / _decimation + 2;
+}
+
+size_t AudioResampler::Process(const float* input, size_t inputFrames, float* output)
+{
+    const size_t maxChunkFrames = _history.empty() ? 0 : _history.front().size() - TapsPerPhase * 2;
+    size_t outputFrames{0};
+
+    while (inputFrames > 0 && maxChunkFrames > 0)
+    {
+        auto chunkFrames = std::min(inputFrames, maxChunkFrames);
+
+        // Deinterleave the new input into the per-channel history.
+        for (uint32_t channel = 0; channel < _channels; channel++)
+        {
+            auto* history = _history[channel].data() + _historyLength;
+            for (size_t frame = 0; frame < chunkFrames; frame++)
+            {
+                history[frame] = input[frame * _channels + channel];
+            }
+        }
+        _historyLength += chunkFrames;
+        input += chunkFrames * _channels;
+        inputFrames -= chunkFrames;
+
+        auto inputIndex = _inputIndex;
+        auto phase = _phase;
+        while (inputIndex + TapsPerPhase <= _historyLength)
+        {
+            const auto* coefficients = _coefficients.data() + phase * TapsPerPhase;
+            for (uint32_t channel = 0; channel < _channels; channel++)
+            {
+                output[outputFrames * _channels + channel] = _dotProduct(coefficients, _history[channel].data() + inputIndex, TapsPerPhase);
+            }
+            outputFrames++;
+
+            phase += _decimation;
+            inputIndex += phase / _interpolation;
+            phase %= _interpolation;
+        }
+
+        // Discard consumed input. With large decimation factors, the window might even skip samples not received yet.
+        auto consumedFrames = std::min(inputIndex, _historyLength);
+        for (auto& history : _history)
+        {
+            std::memmove(history.data(), history.data() + consumedFrames, (_historyLength - consumedFrames) * sizeof(float));
+        }
+        _historyLength -= consumedFrames;
+        _inputIndex = inputIndex - consumedFrames;
+        _phase = phase;
+    }
+
+    return outputFrames;
+}
+
+const char* AudioResampler::KernelName() const
+{
+    return _kernelName;
+}
+
+void AudioResampler::SelectKernel(Kernel kernel)
+{
+    if (!KernelAvailable(kernel))
+    {
+        kernel = Kernel::Automatic;
+    }
+
+    if (kernel == Kernel::Automatic)
+    {
+        kernel = Kernel::Scalar;
+#ifdef AUDIO_SIMD_SSE2
+        kernel = Kernel::SSE2;
+#endif
+        if (KernelAvailable(Kernel::AVX2))
+        {
+            kernel = Kernel::AVX2;
+        }
+#ifdef AUDIO_SIMD_NEON
+        kernel = Kernel::NEON;
+#endif
+    }
+
+    _dotProduct = &DotProductScalar;
+    _kernelName = "scalar";
+
+    switch (kernel)
+    {
+#ifdef AUDIO_SIMD_SSE2
+        case Kernel::SSE2:
+            _dotProduct = &DotProductSSE2;
+            _kernelName = "SSE2";
+            break;
+#endif
+
+#ifdef AUDIO_SIMD_AVX2
+        case Kernel::AVX2:
+            _dotProduct = &DotProductAVX2;
+            _kernelName = "AVX2";
+            break;
+#endif
+
+#ifdef AUDIO_SIMD_NEON
+        case Kernel::NEON:
+            _dotProduct = &DotProductNEON;
+            _kernelName = "NEON";
+            break;
+#endif
+
+        default:
+            break;
+    }
+}
+
+void AudioResampler::CreateFilter()
+{
+    const size_t filterLength = TapsPerPhase * _interpolation;
+    const double center = static_cast<double>(filterLength - 1) / 2.0;
+
+    // Cutoff at 90% of the lower Nyquist frequency, relative to the upsampled rate.
+    const double cutoff = 0.45 / static_cast<double>(std::max(_interpolation, _decimation));
+
+    std::vector<double> prototype(filterLength);
+    for (size_t index = 0; index < filterLength; index++)
+    {
+        double x = static_cast<double>(index) - center;
+        double sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * Pi * cutoff * x) / (Pi * x);
+
+        // Blackman window
+        double windowPosition = static_cast<double>(index) / static_cast<double>(filterLength - 1);
+        double window = 0.42 - 0.5 * std::cos(2.0 * Pi * windowPosition) + 0.08 * std::cos(4.0 * Pi * windowPosition);
+
+        prototype[index] = sinc * window;
+    }
+
+    // Split into phases with reversed tap order, so each phase is a plain dot product with the input history.
+    // Each phase is normalized to unity gain to avoid amplitude ripple between phases.
+    _coefficients.resize(filterLength);
+    for (uint32_t phase = 0; phase < _interpolation; phase++)
+    {
+        double phaseSum{0.0};
+        for (size_t tap = 0; tap < TapsPerPhase; tap++)
+        {
+            phaseSum += prototype[phase + tap * _interpolation];
+        }
+
+        for (size_t tap = 0; tap < TapsPerPhase; tap++)
+        {
+            _coefficients[phase * TapsPerPhase + (TapsPerPhase - 1 - tap)] =
+                static_cast<float>(prototype[phase + tap * _interpolation] / phaseSum);
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Polyphase FIR sample rate converter for interleaved float audio.
+ *
+ * Converts captured audio from the device's native sample rate into the rate projectM expects. The
+ * conversion ratio is reduced to a fraction of two integers, each output sample is then calculated by a
+ * single dot product of one filter phase and the input history. The dot product uses AVX2, SSE2 or NEON
+ * instructions if available, with a scalar fallback.
+ *
+ * Ratios which would require too many filter phases are approximated with a slightly different ratio.
+ * The resulting tiny rate mismatch is compensated for by the frame pacer like any other clock drift.
+ *
+ * All buffers are allocated in Configure(), so Process() is safe to call from the audio callback.
+ */
+class AudioResampler
+{
+public:
+    /**
+     * @brief Dot product kernels.
+     */
+    enum class Kernel
+    {
+        Automatic, //!< The fastest kernel supported by the CPU.
+        Scalar, //!< Plain C++.
+        SSE2, //!< x86 SSE2.
+        AVX2, //!< x86 AVX2, if supported by the CPU.
+        NEON //!< ARM NEON.
+    };
+
+    /**
+     * @brief Returns whether a kernel was compiled in and is supported by the CPU.
+     * @param kernel The kernel to check.
+     * @return true if the kernel can be used.
+     */
+    static bool KernelAvailable(Kernel kernel);
+
+    /**
+     * @brief Sets up the resampler and allocates all required memory.
+     * @param inputRate The sample rate of the input data in Hz.
+     * @param outputRate The desired output sample rate in Hz.
+     * @param channels The number of interleaved channels.
+     * @param maxInputFrames The maximum number of sample frames passed to a single Process() call.
+     * @param kernel The dot product kernel to use. Falls back to Kernel::Automatic if not available.
+     */
+    void Configure(uint32_t inputRate, uint32_t outputRate, uint32_t channels, size_t maxInputFrames,
+                   Kernel kernel = Kernel::Automatic);
+
+    /**
+     * @brief Returns whether the input and output rates differ and data needs to be resampled.
+     * @return true if Process() needs to be called, false if input can be used as-is.
+     */
+    bool Active() const;
+
+    /**
+     * @brief Returns the maximum number of output sample frames a Process() call can produce.
+     * @param inputFrames The number of input sample frames.
+     * @return The maximum number of output sample frames.
+     */
+    size_t MaxOutputFrames(size_t inputFrames) const;
+
+    /**
+     * @brief Resamples a block of interleaved audio.
+     * @param input The input samples.
+     * @param inputFrames The number of input sample frames. Must not exceed the maximum passed to Configure().
+     * @param output Destination memory, large enough for MaxOutputFrames(inputFrames) sample frames.
+     * @return The number of sample frames written to the output.
+     */
+    size_t Process(const float* input, size_t inputFrames, float* output);
+
+    /**
+     * @brief Returns the name of the SIMD instruction set used by the filter kernel.
+     * @return A short, human-readable instruction set name.
+     */
+    const char* KernelName() const;
+
+protected:
+    /**
+     * @brief Selects the dot product kernel.
+     * @param kernel The requested kernel.
+     */
+    void SelectKernel(Kernel kernel);
+
+    /**
+     * @brief Calculates the windowed-sinc prototype filter and splits it into phases.
+     */
+    void CreateFilter();
+
+    using DotProductFunction = float (*)(const float* coefficients, const float* samples, size_t count);
+
+    static constexpr size_t TapsPerPhase{32}; //!< Filter length per phase. Must be a multiple of 8 for the SIMD kernels.
+    static constexpr uint32_t MaxPhases{1024}; //!< Maximum number of polyphase filter phases.
+
+    uint32_t _inputRate{0}; //!< Input sample rate.
+    uint32_t _outputRate{0}; //!< Output sample rate.
+    uint32_t _channels{0}; //!< Number of interleaved channels.
+
+    uint32_t _interpolation{1}; //!< Upsampling factor L, which is also the number of filter phases.
+    uint32_t _decimation{1}; //!< Downsampling factor M.
+
+    std::vector<float> _coefficients; //!< Filter coefficients, TapsPerPhase per phase, each phase in reverse order.
+    std::vector<std::vector<float>> _history; //!< Per-channel, deinterleaved input history.
+    size_t _historyLength{0}; //!< Number of valid samples in each history buffer.
+    size_t _inputIndex{0}; //!< Start of the filter window in the history buffers.
+    uint32_t _phase{0}; //!< Current filter phase.
+
+    DotProductFunction _dotProduct{nullptr}; //!< The selected dot product kernel.
+    const char* _kernelName{"scalar"}; //!< Name of the selected kernel.
+};
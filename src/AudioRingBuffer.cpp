@@ -0,0 +1,98 @@
+#include "AudioRingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+AudioRingBuffer::AudioRingBuffer(size_t minimumCapacity)
+{
+    size_t capacity{1};
+    while (capacity < minimumCapacity)
+    {
+        capacity <<= 1;
+    }
+
+    _buffer.resize(capacity);
+    _mask = capacity - 1;
+}
+
+size_t AudioRingBuffer::Write(const float* samples, size_t count)
+{
+    const auto writePosition = _writePosition.load(std::memory_order_relaxed);
+    const auto readPosition = _readPosition.load(std::memory_order_acquire);
+
+    count = std::min(count, _buffer.size() - (writePosition - readPosition));
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const auto offset = writePosition & _mask;
+    const auto firstPart = std::min(count, _buffer.size() - offset);
+
+    std::memcpy(_buffer.data() + offset, samples, firstPart * sizeof(float));
+    if (count > firstPart)
+    {
+        std::memcpy(_buffer.data(), samples + firstPart, (count - firstPart) * sizeof(float));
+    }
+
+    _writePosition.store(writePosition + count, std::memory_order_release);
+
+    return count;
+}
+
+size_t AudioRingBuffer::Read(float* samples, size_t count)
+{
+    const auto readPosition = _readPosition.load(std::memory_order_relaxed);
+    const auto writePosition = _writePosition.load(std::memory_order_acquire);
+
+    count = std::min(count, writePosition - readPosition);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const auto offset = readPosition & _mask;
+    const auto firstPart = std::min(count, _buffer.size() - offset);
+
+    std::memcpy(samples, _buffer.data() + offset, firstPart * sizeof(float));
+    if (count > firstPart)
+    {
+        std::memcpy(samples + firstPart, _buffer.data(), (count - firstPart) * sizeof(float));
+    }
+
+    _readPosition.store(readPosition + count, std::memory_order_release);
+
+    return count;
+}
+
+size_t AudioRingBuffer::Discard(size_t count)
+{
+    const auto readPosition = _readPosition.load(std::memory_order_relaxed);
+    const auto writePosition = _writePosition.load(std::memory_order_acquire);
+
+    count = std::min(count, writePosition - readPosition);
+
+    _readPosition.store(readPosition + count, std::memory_order_release);
+
+    return count;
+}
+
+size_t AudioRingBuffer::ReadAvailable() const
+{
+    return _writePosition.load(std::memory_order_acquire) - _readPosition.load(std::memory_order_acquire);
+}
+
+size_t AudioRingBuffer::WriteAvailable() const
+{
+    return _buffer.size() - ReadAvailable();
+}
+
+size_t AudioRingBuffer::Capacity() const
+{
+    return _buffer.size();
+}
+
+void AudioRingBuffer::Clear()
+{
+    _readPosition.store(_writePosition.load(std::memory_order_acquire), std::memory_order_release);
+}
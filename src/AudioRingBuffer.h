@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CacheLineAligned.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer for interleaved float samples.
+ *
+ * All memory is allocated once in the constructor. Afterwards, exactly one thread may call Write()
+ * while exactly one other thread calls Read() or Discard(), without any locking or allocations.
+ *
+ * Read and write positions are free-running counters, each aligned to its own cache line so the
+ * audio callback and the render thread don't invalidate each other's cache lines on every access, and
+ * neither shares a line with the members preceding the ring in an owning object. Heap instances are
+ * aligned by CacheLineAligned.
+ */
+class AudioRingBuffer : public CacheLineAligned
+{
+public:
+    AudioRingBuffer() = delete;
+    AudioRingBuffer(const AudioRingBuffer& other) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer& other) = delete;
+
+    /**
+     * @brief Constructor.
+     * @param minimumCapacity The minimum number of floats the buffer should hold. Will be rounded up
+     *                        to the next power of two.
+     */
+    explicit AudioRingBuffer(size_t minimumCapacity);
+
+    /**
+     * @brief Appends samples to the buffer. Producer side only.
+     *
+     * If there's not enough space left, only the samples which fit are written. The caller is
+     * responsible for keeping the count a multiple of the channel count.
+     *
+     * @param samples Pointer to the samples to copy.
+     * @param count Number of floats to write.
+     * @return The number of floats actually written.
+     */
+    size_t Write(const float* samples, size_t count);
+
+    /**
+     * @brief Removes samples from the buffer and copies them into the given memory. Consumer side only.
+     * @param samples Destination memory with space for at least @a count floats.
+     * @param count Maximum number of floats to read.
+     * @return The number of floats actually read.
+     */
+    size_t Read(float* samples, size_t count);
+
+    /**
+     * @brief Drops up to the given number of samples without copying them. Consumer side only.
+     * @param count Maximum number of floats to discard.
+     * @return The number of floats actually discarded.
+     */
+    size_t Discard(size_t count);
+
+    /**
+     * @brief Returns the number of floats currently available for reading.
+     * @return The number of readable floats.
+     */
+    size_t ReadAvailable() const;
+
+    /**
+     * @brief Returns the number of floats which can currently be written.
+     * @return The number of free slots in the buffer.
+     */
+    size_t WriteAvailable() const;
+
+    /**
+     * @brief Returns the total capacity of the buffer.
+     * @return The capacity in floats.
+     */
+    size_t Capacity() const;
+
+    /**
+     * @brief Empties the buffer.
+     *
+     * Must only be called while no producer is active, e.g. after the audio device was closed.
+     */
+    void Clear();
+
+protected:
+    alignas(CacheLineSize) std::atomic<size_t> _writePosition{0}; //!< Total number of floats written. Only modified by the producer.
+    alignas(CacheLineSize) std::atomic<size_t> _readPosition{0}; //!< Total number of floats read. Only modified by the consumer.
+
+    alignas(CacheLineSize) size_t _mask{0}; //!< Capacity minus one, used to wrap positions into the buffer. Read by both sides, so kept off the positions' lines.
+    std::vector<float> _buffer; //!< The sample storage.
+};
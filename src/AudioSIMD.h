@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * @file AudioSIMD.h
+ * @brief Detects which SIMD instruction sets can be used by the audio processing kernels.
+ *
+ * SSE2 and NEON are part of the respective baseline architectures and are used unconditionally if the
+ * compiler targets them. AVX2 code is compiled separately using a function target attribute and must only
+ * be called after checking for CPU support at runtime, e.g. via SDL_HasAVX2().
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(AUDIO_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define AUDIO_SIMD_AVX2 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define AUDIO_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define AUDIO_SIMD_TARGET_AVX2
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define AUDIO_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
@@ -0,0 +1,207 @@
+#include "AudioSampleQueue.h"
+
+#include <projectM-4/projectM.h>
+
+#include <SDL2/SDL.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+
+constexpr uint32_t AudioSampleQueue::OutputSampleFrequency;
+constexpr uint32_t AudioSampleQueue::OutputChannels;
+constexpr double AudioSampleQueue::MissedDeadlineFactor;
+
+AudioSampleQueue::AudioSampleQueue(size_t capacityFrames)
+    : _sampleBuffer(new AudioBroadcastRing(capacityFrames * OutputChannels))
+    , _drainReader(_sampleBuffer->CreateReader())
+    , _meterReader(_sampleBuffer->CreateReader())
+    , _drainBuffer(_sampleBuffer->Capacity())
+{
+}
+
+void AudioSampleQueue::Configure(uint32_t sampleRate, uint32_t channels, size_t maxWriteFrames, uint32_t periodFrames)
+{
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> audioConfig = Poco::Util::Application::instance().config().createView("audio");
+
+    _deviceChannels = channels;
+    _downmixer.Configure(_deviceChannels, *audioConfig);
+    _channels = _downmixer.OutputChannels();
+    if (_downmixer.Active())
+    {
+        _downmixBuffer.resize(maxWriteFrames * _channels);
+
+        poco_debug_f1(_logger, "Downmixing %?u audio channels to stereo.", _deviceChannels);
+    }
+
+    _resampler.Configure(sampleRate, OutputSampleFrequency, _channels, maxWriteFrames);
+    auto maxOutputFrames = _resampler.Active() ? _resampler.MaxOutputFrames(maxWriteFrames) : maxWriteFrames;
+    if (_resampler.Active())
+    {
+        _resampleBuffer.resize(maxOutputFrames * _channels);
+
+        poco_debug_f3(_logger, "Resampling audio from %?u Hz to %?u Hz using the %s filter kernel.",
+                      sampleRate, OutputSampleFrequency, std::string(_resampler.KernelName()));
+    }
+
+    // The pacer works on the resampled data, so scale the period size accordingly.
+    _pacer.Reset(OutputSampleFrequency,
+                 static_cast<uint32_t>(static_cast<uint64_t>(periodFrames) * OutputSampleFrequency / sampleRate));
+    if (_channels < OutputChannels)
+    {
+        _stereoBuffer.resize(maxOutputFrames * OutputChannels);
+    }
+
+    _laggedReads = 0;
+    _drainReader.SkipToLatest();
+    _drainPosition.store(_drainReader.Position(), std::memory_order_release);
+    _meterReader.SkipToLatest();
+    _delayLine.Configure(OutputSampleFrequency, OutputChannels);
+    auto silenceThreshold = audioConfig->getDouble("silenceThreshold", -60.0);
+    _levelMeter.Configure(OutputSampleFrequency, OutputChannels, silenceThreshold);
+    poco_debug_f2(_logger, "Metering audio with a silence threshold of %.0f dBFS using the %s kernel.",
+                  silenceThreshold, std::string(_levelMeter.KernelName()));
+    _periodTime = static_cast<double>(periodFrames) / static_cast<double>(sampleRate);
+
+    _ticksPerDeviceFrame = static_cast<double>(SDL_GetPerformanceFrequency()) / static_cast<double>(sampleRate);
+    _lastWriteTicks = 0;
+    _lastWriteFrames = 0;
+    _missedDeadlines = 0;
+}
+
+void AudioSampleQueue::Write(const float* samples, size_t frames)
+{
+    auto now = SDL_GetPerformanceCounter();
+    if (_lastWriteTicks != 0 &&
+        static_cast<double>(now - _lastWriteTicks) > MissedDeadlineFactor * _ticksPerDeviceFrame * static_cast<double>(_lastWriteFrames))
+    {
+        _missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    }
+    _lastWriteTicks = now;
+    _lastWriteFrames = frames;
+
+    if (_downmixer.Active())
+    {
+        _downmixer.Process(samples, frames, _downmixBuffer.data());
+        samples = _downmixBuffer.data();
+    }
+
+    if (_resampler.Active())
+    {
+        frames = _resampler.Process(samples, frames, _resampleBuffer.data());
+        samples = _resampleBuffer.data();
+    }
+
+    if (_channels < OutputChannels)
+    {
+        for (size_t frame = 0; frame < frames; frame++)
+        {
+            _stereoBuffer[frame * 2] = samples[frame];
+            _stereoBuffer[frame * 2 + 1] = samples[frame];
+        }
+        samples = _stereoBuffer.data();
+    }
+
+    _sampleBuffer->Write(samples, frames * OutputChannels);
+}
+
+size_t AudioSampleQueue::WriteAvailable() const
+{
+    auto backlog = _sampleBuffer->WritePosition() - _drainPosition.load(std::memory_order_acquire);
+
+    return (_sampleBuffer->Capacity() - std::min(backlog, _sampleBuffer->Capacity())) / OutputChannels;
+}
+
+size_t AudioSampleQueue::Drain(projectm* projectMHandle)
+{
+    auto now = static_cast<double>(SDL_GetPerformanceCounter()) / static_cast<double>(SDL_GetPerformanceFrequency());
+    MeterNewSamples();
+
+    auto step = _pacer.Advance(now, _drainReader.Available() / OutputChannels);
+
+    _drainReader.Discard(step.framesToSkip * OutputChannels);
+
+    size_t framesConsumed = step.framesToSkip;
+    size_t samplesToDeliver = step.framesToDeliver * OutputChannels;
+    while (samplesToDeliver > 0)
+    {
+        auto chunkSize = std::min(samplesToDeliver, _drainBuffer.size());
+        size_t samplesRead{0};
+        if (_drainReader.Read(_drainBuffer.data(), chunkSize, samplesRead) == AudioBroadcastRing::ReadStatus::Lagged)
+        {
+            _laggedReads.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        if (samplesRead == 0)
+        {
+            break;
+        }
+
+        _delayLine.Process(_drainBuffer.data(), samplesRead / OutputChannels, _drainBuffer.data());
+        projectm_pcm_add_float(projectMHandle, _drainBuffer.data(), static_cast<unsigned int>(samplesRead / OutputChannels),
+                               PROJECTM_STEREO);
+
+        samplesToDeliver -= samplesRead;
+        framesConsumed += samplesRead / OutputChannels;
+    }
+
+    _drainPosition.store(_drainReader.Position(), std::memory_order_release);
+
+    return framesConsumed;
+}
+
+void AudioSampleQueue::MeterNewSamples()
+{
+    // At low frame rates, e.g. while idle, the meter may fall behind by more than the ring holds. Skipping
+    // to the newer half keeps it from lagging on every frame, so silence detection still sees the audio.
+    auto available = _meterReader.Available();
+    if (available > _sampleBuffer->Capacity() / 2)
+    {
+        _meterReader.Discard(available - _sampleBuffer->Capacity() / 2);
+    }
+
+    size_t samplesRead{0};
+    while (_meterReader.Read(_drainBuffer.data(), _drainBuffer.size(), samplesRead) == AudioBroadcastRing::ReadStatus::Ok &&
+           samplesRead > 0)
+    {
+        _levelMeter.Process(_drainBuffer.data(), samplesRead / OutputChannels);
+    }
+}
+
+AudioBroadcastRing::Reader AudioSampleQueue::CreateReader() const
+{
+    return _sampleBuffer->CreateReader();
+}
+
+void AudioSampleQueue::SyncOffset(double offset)
+{
+    _delayLine.Delay(offset);
+    _pacer.LowLatency(offset < 0.0);
+}
+
+double AudioSampleQueue::Latency() const
+{
+    return _periodTime +
+           static_cast<double>(_pacer.TargetBacklog()) / OutputSampleFrequency +
+           _delayLine.Delay();
+}
+
+AudioLevelMeter& AudioSampleQueue::LevelMeter()
+{
+    return _levelMeter;
+}
+
+uint64_t AudioSampleQueue::Underruns() const
+{
+    return _pacer.Underruns();
+}
+
+uint64_t AudioSampleQueue::Overruns() const
+{
+    return _pacer.Overruns() + _laggedReads.load(std::memory_order_relaxed);
+}
+
+uint64_t AudioSampleQueue::MissedDeadlines() const
+{
+    return _missedDeadlines.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "AudioBroadcastRing.h"
+#include "AudioDelayLine.h"
+#include "AudioDownmixer.h"
+#include "AudioFramePacer.h"
+#include "AudioResampler.h"
+#include "AudioLevelMeter.h"
+
+#include <Poco/Logger.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct projectm;
+
+/**
+ * @brief Transports captured audio from a backend's audio thread to projectM on the render thread.
+ *
+ * Bundles the processing chain shared by all callback- or thread-based capture backends: the audio thread
+ * calls Write() with the device data, which is downmixed to stereo, resampled to 44.1 kHz and stored in a
+ * lock-free broadcast ring. Mono input is stored as stereo as well, so the ring's format never changes.
+ *
+ * The audio thread only does this conversion. All consumers read the ring with their own reader at their
+ * own pace: Drain(), called on the render thread once per frame, passes the paced amount of samples through
+ * the A/V sync delay line to projectM and meters the new samples with a second reader. Further consumers,
+ * like the audio tape recorder, attach with CreateReader(), without copying the data per consumer or
+ * slowing down the audio thread.
+ *
+ * Write() never allocates or locks, so it can be called from real-time audio threads.
+ */
+class AudioSampleQueue
+{
+public:
+    static constexpr uint32_t OutputSampleFrequency{44100}; //!< Sample frequency passed to projectM, as expected by its spectrum analyzer.
+    static constexpr uint32_t OutputChannels{2}; //!< Number of interleaved channels stored in the ring and passed to projectM.
+
+    /**
+     * @brief Constructor.
+     * @param capacityFrames Minimum number of output sample frames the ring can hold.
+     */
+    explicit AudioSampleQueue(size_t capacityFrames);
+
+    /**
+     * @brief Sets up the processing chain for a new device format.
+     *
+     * Must only be called while no audio thread is writing to the queue. Drops all samples not yet passed
+     * to projectM. Readers created with CreateReader() stay valid, as the output format never changes.
+     *
+     * @param sampleRate The device sample rate.
+     * @param channels The device channel count.
+     * @param maxWriteFrames The maximum number of frames passed to a single Write() call.
+     * @param periodFrames The number of frames the device usually delivers at once.
+     */
+    void Configure(uint32_t sampleRate, uint32_t channels, size_t maxWriteFrames, uint32_t periodFrames);
+
+    /**
+     * @brief Processes and stores captured samples. Audio thread only.
+     *
+     * If the ring is full, the oldest samples are overwritten. Readers which didn't read them in time lag.
+     *
+     * @param samples Interleaved samples in the format passed to Configure().
+     * @param frames Number of sample frames. Must not exceed the maximum passed to Configure().
+     */
+    void Write(const float* samples, size_t frames);
+
+    /**
+     * @brief Returns the number of frames which can be written without overwriting unread samples. Audio thread only.
+     *
+     * Sources which are not driven by a device clock, e.g. a pipe, use this to throttle themselves to the
+     * rate projectM consumes the data at, instead of overwriting samples Drain() hasn't read yet. Only
+     * meaningful if the configured format needs no conversion, i.e. mono or stereo data at
+     * OutputSampleFrequency.
+     *
+     * @return The number of sample frames Write() can store without Drain() losing any.
+     */
+    size_t WriteAvailable() const;
+
+    /**
+     * @brief Passes the samples for the current render frame to projectM and meters all new samples. Render thread only.
+     * @param projectMHandle The projectM instance receiving the samples.
+     * @return The number of sample frames taken from the ring, including skipped ones.
+     */
+    size_t Drain(projectm* projectMHandle);
+
+    /**
+     * @brief Attaches an additional consumer to the processed stream.
+     *
+     * The reader starts at the newest sample and receives the data in the output format, i.e. OutputChannels
+     * interleaved channels at OutputSampleFrequency. It must not be used after the queue is destroyed.
+     *
+     * @return A new reader of the queue's ring.
+     */
+    AudioBroadcastRing::Reader CreateReader() const;
+
+    /**
+     * @brief Applies the A/V sync offset. Render thread only.
+     *
+     * A positive offset delays the samples passed to projectM. A negative offset can't be compensated
+     * directly, so it switches the pacer to its low-latency mode instead, which keeps as few samples
+     * buffered as the driver's timing allows.
+     *
+     * @param offset The offset in seconds.
+     */
+    void SyncOffset(double offset);
+
+    /**
+     * @brief Returns the estimated time from capturing a sample until it is passed to projectM. Render thread only.
+     * @return The sum of the device buffer duration, the paced backlog and the sync delay in seconds.
+     */
+    double Latency() const;
+
+    /**
+     * @brief Returns the meter analyzing the stream in Drain(). Its readings can be accessed from any thread.
+     * @return The level meter.
+     */
+    AudioLevelMeter& LevelMeter();
+
+    /**
+     * @brief Returns the number of frames which received fewer samples than required.
+     * @return The underrun count since the last call to Configure().
+     */
+    uint64_t Underruns() const;
+
+    /**
+     * @brief Returns the number of times samples had to be dropped before Drain() passed them to projectM.
+     * @return The overrun count since the last call to Configure().
+     */
+    uint64_t Overruns() const;
+
+    /**
+     * @brief Returns the number of times the audio thread called Write() late.
+     *
+     * A write is late if the time since the previous one is more than MissedDeadlineFactor times the duration
+     * of the previously written block, which means the audio thread was descheduled for a while.
+     *
+     * @return The missed deadline count since the last call to Configure().
+     */
+    uint64_t MissedDeadlines() const;
+
+protected:
+    /**
+     * @brief Passes all samples written since the last call to the level meter.
+     */
+    void MeterNewSamples();
+
+    static constexpr double MissedDeadlineFactor{2.0}; //!< Multiple of the expected write interval after which a write counts as late.
+
+    uint32_t _deviceChannels{2}; //!< Number of channels delivered by the device.
+    uint32_t _channels{2}; //!< Number of channels after downmixing, 1 for mono devices.
+
+    std::unique_ptr<AudioBroadcastRing> _sampleBuffer; //!< Processed samples, written by the audio thread. Held by pointer to keep it cache line aligned.
+    AudioBroadcastRing::Reader _drainReader; //!< The ring reader used by Drain().
+    std::atomic<size_t> _drainPosition{0}; //!< Position of _drainReader, limits WriteAvailable().
+    AudioBroadcastRing::Reader _meterReader; //!< The ring reader feeding _levelMeter.
+    std::vector<float> _drainBuffer; //!< Preallocated buffer used to pass samples from the ring to projectM and the level meter.
+    AudioDownmixer _downmixer; //!< Folds surround input down to stereo before resampling.
+    std::vector<float> _downmixBuffer; //!< Preallocated output buffer for the downmixer.
+    AudioResampler _resampler; //!< Converts the device's sample frequency to OutputSampleFrequency.
+    std::vector<float> _resampleBuffer; //!< Preallocated output buffer for the resampler.
+    std::vector<float> _stereoBuffer; //!< Preallocated buffer for mono samples duplicated to stereo.
+    AudioFramePacer _pacer; //!< Calculates the number of samples passed to projectM each frame.
+    AudioDelayLine _delayLine; //!< Delays the samples passed to projectM by the A/V sync offset.
+    double _periodTime{0.0}; //!< Duration of a device buffer in seconds.
+    AudioLevelMeter _levelMeter; //!< Analyzes the samples read by _meterReader.
+    std::atomic<uint64_t> _laggedReads{0}; //!< Number of times Drain() lost samples which were overwritten.
+
+    double _ticksPerDeviceFrame{0.0}; //!< Performance counter ticks per device sample frame.
+    uint64_t _lastWriteTicks{0}; //!< Performance counter value of the last Write() call.
+    size_t _lastWriteFrames{0}; //!< Number of device frames passed to the last Write() call.
+    std::atomic<uint64_t> _missedDeadlines{0}; //!< Number of late Write() calls.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioCapture.Queue")}; //!< The class logger.
+};
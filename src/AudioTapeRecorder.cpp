@@ -0,0 +1,203 @@
+#include "AudioTapeRecorder.h"
+
+#include "AudioCapture.h"
+#include "AudioSampleQueue.h"
+
+#include <Poco/Thread.h>
+
+#include <Poco/Util/Application.h>
+
+#include <SDL2/SDL.h>
+
+#include <cstring>
+#include <vector>
+
+static_assert(sizeof(AudioTapeRecorder::BlockHeader) % sizeof(float) == 0, "Block header must fit into whole ring slots.");
+
+constexpr char AudioTapeRecorder::Magic[8];
+constexpr uint32_t AudioTapeRecorder::Version;
+constexpr size_t AudioTapeRecorder::HeaderFloats;
+constexpr size_t AudioTapeRecorder::RingCapacity;
+constexpr size_t AudioTapeRecorder::ReadBlockFrames;
+constexpr long AudioTapeRecorder::PollInterval;
+
+const char* AudioTapeRecorder::name() const
+{
+    return "Audio Tape Recorder";
+}
+
+void AudioTapeRecorder::initialize(Poco::Util::Application& app)
+{
+    _path = app.config().getString("audio.record.path", "");
+    if (_path.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        _file.reset(new Poco::FileOutputStream(_path));
+
+        FileHeader header;
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        _file->write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not create audio tape "%s": %s)", _path, ex.displayText());
+        _file.reset();
+        return;
+    }
+
+    _reader = app.getSubsystem<AudioCapture>().CreateReader();
+    if (!_reader)
+    {
+        _ring.reset(new AudioRingBuffer(RingCapacity));
+    }
+    _ticksPerSecond = static_cast<double>(SDL_GetPerformanceFrequency());
+    _startTicks = SDL_GetPerformanceCounter();
+    _droppedBlocks = 0;
+    _writtenBlocks = 0;
+    _recordedTime = 0.0;
+
+    _recording = true;
+    _writerThreadResult = _writerThread();
+
+    poco_information_f1(_logger, R"(Recording captured audio to "%s".)", _path);
+}
+
+void AudioTapeRecorder::uninitialize()
+{
+    if (!_recording)
+    {
+        return;
+    }
+
+    _recording = false;
+    _writerThreadResult.wait();
+    _file.reset();
+    _reader.reset();
+    _ring.reset();
+
+    poco_information_f4(_logger, R"(Recorded %?u audio blocks (%.1f seconds) to "%s", %?u blocks were dropped.)",
+                        _writtenBlocks, _recordedTime, _path, _droppedBlocks.load());
+}
+
+bool AudioTapeRecorder::Recording() const
+{
+    return _recording;
+}
+
+void AudioTapeRecorder::Record(const float* samples, size_t frames, uint32_t sampleRate, uint32_t channels)
+{
+    if (!_recording.load(std::memory_order_acquire) || !_ring || frames == 0)
+    {
+        return;
+    }
+
+    // Only queue whole blocks, so the writer never sees a header without its samples.
+    auto sampleCount = frames * channels;
+    if (_ring->WriteAvailable() < HeaderFloats + sampleCount)
+    {
+        _droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    BlockHeader header;
+    header.time = static_cast<double>(SDL_GetPerformanceCounter() - _startTicks) / _ticksPerSecond;
+    header.frames = static_cast<uint32_t>(frames);
+    header.sampleRate = sampleRate;
+    header.channels = channels;
+
+    float headerFloats[HeaderFloats];
+    std::memcpy(headerFloats, &header, sizeof(header));
+
+    _ring->Write(headerFloats, HeaderFloats);
+    _ring->Write(samples, sampleCount);
+}
+
+void AudioTapeRecorder::WriterThread()
+{
+    if (_reader)
+    {
+        WriteReaderBlocks();
+    }
+    else
+    {
+        WriteQueuedBlocks();
+    }
+
+    _file->flush();
+    if (!_file->good())
+    {
+        poco_error_f1(_logger, R"(Writing the audio tape "%s" failed. The recording is incomplete.)", _path);
+    }
+}
+
+void AudioTapeRecorder::WriteReaderBlocks()
+{
+    std::vector<float> samples(ReadBlockFrames * AudioSampleQueue::OutputChannels);
+
+    while (_recording)
+    {
+        size_t samplesRead{0};
+        if (_reader->Read(samples.data(), samples.size(), samplesRead) == AudioBroadcastRing::ReadStatus::Lagged)
+        {
+            _droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (samplesRead == 0)
+        {
+            Poco::Thread::sleep(PollInterval);
+            continue;
+        }
+
+        BlockHeader header;
+        header.time = static_cast<double>(SDL_GetPerformanceCounter() - _startTicks) / _ticksPerSecond;
+        header.frames = static_cast<uint32_t>(samplesRead / AudioSampleQueue::OutputChannels);
+        header.sampleRate = AudioSampleQueue::OutputSampleFrequency;
+        header.channels = AudioSampleQueue::OutputChannels;
+
+        WriteBlock(header, samples.data());
+    }
+}
+
+void AudioTapeRecorder::WriteQueuedBlocks()
+{
+    std::vector<float> samples;
+    float headerFloats[HeaderFloats];
+
+    while (_recording || _ring->ReadAvailable() > 0)
+    {
+        if (_ring->ReadAvailable() < HeaderFloats)
+        {
+            Poco::Thread::sleep(PollInterval);
+            continue;
+        }
+
+        BlockHeader header;
+        _ring->Read(headerFloats, HeaderFloats);
+        std::memcpy(&header, headerFloats, sizeof(header));
+
+        // The samples are queued right after the header, so this only waits if the header was just published.
+        samples.resize(static_cast<size_t>(header.frames) * header.channels);
+        size_t samplesRead{0};
+        while (samplesRead < samples.size())
+        {
+            samplesRead += _ring->Read(samples.data() + samplesRead, samples.size() - samplesRead);
+        }
+
+        WriteBlock(header, samples.data());
+    }
+}
+
+void AudioTapeRecorder::WriteBlock(const BlockHeader& header, const float* samples)
+{
+    _file->write(reinterpret_cast<const char*>(&header), sizeof(header));
+    _file->write(reinterpret_cast<const char*>(samples),
+                 static_cast<std::streamsize>(static_cast<size_t>(header.frames) * header.channels * sizeof(float)));
+
+    _writtenBlocks++;
+    _recordedTime = header.time;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "AudioBroadcastRing.h"
+#include "AudioRingBuffer.h"
+
+#include <Poco/ActiveMethod.h>
+#include <Poco/FileStream.h>
+#include <Poco/Logger.h>
+#include <Poco/Util/Subsystem.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Records the captured audio for later replay with the "tape" backend.
+ *
+ * If audio.record.path is set, the captured audio is written to the file in blocks, each with its sample
+ * rate, channel count and the time since recording started. A background thread writes the file, so the
+ * audio thread never waits for disk I/O.
+ *
+ * Backends using a sample queue provide a reader of their processed stream, which the background thread
+ * reads on its own, so recording adds no work to the audio thread. These tapes contain stereo audio at
+ * AudioSampleQueue::OutputSampleFrequency, in blocks timed when the thread read them. Backends without a
+ * reader pass each block in the device format to Record() instead, which copies it into a transfer ring.
+ * The block sizes and times are then those of the original callbacks, so the tape replay drives the
+ * capture path with the same timing. If the writer falls behind, the data is dropped and counted.
+ *
+ * Tape files consist of a FileHeader followed by blocks of a BlockHeader and the block's interleaved float
+ * samples, all in native byte order.
+ *
+ * Must be initialized after AudioCapture, so it is uninitialized before the capture backend is destroyed.
+ * Record() must only be called by one thread at a time, which is the case as only one backend is active.
+ */
+class AudioTapeRecorder : public Poco::Util::Subsystem
+{
+public:
+    static constexpr char Magic[8]{'P', 'M', 'A', 'U', 'T', 'A', 'P', 'E'}; //!< Identifies a tape file.
+    static constexpr uint32_t Version{1}; //!< Current tape file format version.
+
+    /**
+     * @brief Header at the start of a tape file.
+     */
+    struct FileHeader
+    {
+        char magic[8]; //!< Always Magic.
+        uint32_t version{Version}; //!< File format version.
+        uint32_t reserved{0}; //!< Unused, zero.
+    };
+
+    /**
+     * @brief Header preceding the samples of each recorded block.
+     */
+    struct BlockHeader
+    {
+        double time{0.0}; //!< Time the block was captured in seconds since recording started.
+        uint32_t frames{0}; //!< Number of sample frames in the block.
+        uint32_t sampleRate{0}; //!< Sample rate of the block.
+        uint32_t channels{0}; //!< Number of interleaved channels.
+        uint32_t reserved{0}; //!< Unused, zero.
+    };
+
+    const char* name() const override;
+
+    void initialize(Poco::Util::Application& app) override;
+
+    void uninitialize() override;
+
+    /**
+     * @brief Returns whether captured audio is being recorded.
+     * @return true if audio.record.path is set and the file could be created.
+     */
+    bool Recording() const;
+
+    /**
+     * @brief Queues a captured block for writing. Audio thread only, never blocks.
+     *
+     * Only used by backends which don't provide a reader, blocks passed by other backends are ignored.
+     * @param samples The interleaved samples as delivered by the device.
+     * @param frames The number of sample frames.
+     * @param sampleRate The device sample rate.
+     * @param channels The device channel count.
+     */
+    void Record(const float* samples, size_t frames, uint32_t sampleRate, uint32_t channels);
+
+protected:
+    static constexpr size_t HeaderFloats{sizeof(BlockHeader) / sizeof(float)}; //!< Ring space taken by a block header.
+    static constexpr size_t RingCapacity{1u << 20}; //!< Size of the transfer ring in floats, about 2.7 seconds of 48 kHz 8 channel audio.
+    static constexpr size_t ReadBlockFrames{4096}; //!< Maximum number of sample frames per block read from the capture reader.
+    static constexpr long PollInterval{10}; //!< Time in milliseconds the writer thread waits if no data is available.
+
+    /**
+     * @brief Writes the captured audio to the file until recording is stopped.
+     */
+    void WriterThread();
+
+    /**
+     * @brief Writes the stream read from _reader until recording is stopped.
+     */
+    void WriteReaderBlocks();
+
+    /**
+     * @brief Writes blocks queued by Record() until recording is stopped and the ring is empty.
+     */
+    void WriteQueuedBlocks();
+
+    /**
+     * @brief Appends a block to the file.
+     * @param header The block header.
+     * @param samples The block's interleaved samples.
+     */
+    void WriteBlock(const BlockHeader& header, const float* samples);
+
+    std::string _path; //!< Path of the tape file.
+    std::unique_ptr<Poco::FileOutputStream> _file; //!< The tape file, written by the writer thread.
+    std::unique_ptr<AudioBroadcastRing::Reader> _reader; //!< Reader of the capture backend's stream, if it provides one.
+    std::unique_ptr<AudioRingBuffer> _ring; //!< Transfers headers and samples from Record() to the writer, if there's no reader.
+    uint64_t _startTicks{0}; //!< Performance counter value when recording started.
+    double _ticksPerSecond{1.0}; //!< Performance counter frequency.
+
+    std::atomic_bool _recording{false}; //!< If true, Record() queues blocks and the writer thread runs.
+    std::atomic<uint64_t> _droppedBlocks{0}; //!< Blocks which didn't fit into the ring, or reads which lagged.
+    uint64_t _writtenBlocks{0}; //!< Blocks written by the writer thread.
+    double _recordedTime{0.0}; //!< Time of the last written block.
+
+    Poco::ActiveMethod<void, void, AudioTapeRecorder> _writerThread{this, &AudioTapeRecorder::WriterThread}; //!< Active method running the writer thread.
+    Poco::ActiveResult<void> _writerThreadResult{new Poco::ActiveResultHolder<void>()}; //!< Result of the writer thread.
+
+    Poco::Logger& _logger{Poco::Logger::get("AudioTapeRecorder")}; //!< The class logger.
+};
@@ -0,0 +1,66 @@
+#include "CacheLineAligned.h"
+
+#include <cstdint>
+
+constexpr size_t CacheLineAligned::CacheLineSize;
+
+void* CacheLineAligned::operator new(size_t size)
+{
+    return Align(::operator new(size + CacheLineSize + sizeof(void*)));
+}
+
+void* CacheLineAligned::operator new[](size_t size)
+{
+    return Align(::operator new[](size + CacheLineSize + sizeof(void*)));
+}
+
+void* CacheLineAligned::operator new(size_t size, const std::nothrow_t& tag) noexcept
+{
+    return Align(::operator new(size + CacheLineSize + sizeof(void*), tag));
+}
+
+void* CacheLineAligned::operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+    return Align(::operator new[](size + CacheLineSize + sizeof(void*), tag));
+}
+
+void CacheLineAligned::operator delete(void* pointer) noexcept
+{
+    ::operator delete(Block(pointer));
+}
+
+void CacheLineAligned::operator delete[](void* pointer) noexcept
+{
+    ::operator delete[](Block(pointer));
+}
+
+void CacheLineAligned::operator delete(void* pointer, const std::nothrow_t& tag) noexcept
+{
+    ::operator delete(Block(pointer), tag);
+}
+
+void CacheLineAligned::operator delete[](void* pointer, const std::nothrow_t& tag) noexcept
+{
+    ::operator delete[](Block(pointer), tag);
+}
+
+void* CacheLineAligned::Align(void* block)
+{
+    if (!block)
+    {
+        return nullptr;
+    }
+
+    auto address = reinterpret_cast<uintptr_t>(static_cast<char*>(block) + sizeof(void*));
+    address = (address + CacheLineSize - 1) & ~static_cast<uintptr_t>(CacheLineSize - 1);
+
+    auto* instance = reinterpret_cast<void**>(address);
+    instance[-1] = block;
+
+    return instance;
+}
+
+void* CacheLineAligned::Block(void* pointer)
+{
+    return pointer ? static_cast<void**>(pointer)[-1] : nullptr;
+}
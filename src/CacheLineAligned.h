@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+/**
+ * @brief Base class which allocates instances of derived classes on a cache line boundary.
+ *
+ * Classes separating members shared between threads with alignas(CacheLineSize) only get that alignment
+ * on the stack and in static storage. Before C++17, operator new only guarantees the alignment of
+ * std::max_align_t, so heap instances would leave it to chance. Deriving from this class provides the
+ * single object, array and nothrow forms of operator new and delete, all returning aligned memory.
+ *
+ * Instances embedded in another object are only aligned if the enclosing object is, so classes relying
+ * on the alignment should be held by pointer.
+ */
+class CacheLineAligned
+{
+public:
+    static constexpr size_t CacheLineSize{64}; //!< Assumed size of a CPU cache line in bytes.
+
+    static void* operator new(size_t size);
+    static void* operator new[](size_t size);
+    static void* operator new(size_t size, const std::nothrow_t& tag) noexcept;
+    static void* operator new[](size_t size, const std::nothrow_t& tag) noexcept;
+
+    static void operator delete(void* pointer) noexcept;
+    static void operator delete[](void* pointer) noexcept;
+    static void operator delete(void* pointer, const std::nothrow_t& tag) noexcept;
+    static void operator delete[](void* pointer, const std::nothrow_t& tag) noexcept;
+
+protected:
+    /**
+     * @brief Aligns an over-allocated memory block, keeping the original block pointer right before the result.
+     * @param block Memory of the requested size plus CacheLineSize + sizeof(void*) bytes, or nullptr.
+     * @return Pointer to the aligned memory, or nullptr if @a block is nullptr.
+     */
+    static void* Align(void* block);
+
+    /**
+     * @brief Returns the block pointer stored by Align().
+     * @param pointer Pointer returned by Align(), or nullptr.
+     * @return The original block, or nullptr.
+     */
+    static void* Block(void* pointer);
+};
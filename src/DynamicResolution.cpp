@@ -0,0 +1,290 @@
+#include "DynamicResolution.h"
+
+#include <Poco/Format.h>
+
+#include <Poco/Util/Application.h>
+
+#ifdef USE_GLEW
+#include <GL/glew.h>
+#else
+// Declares the framebuffer object and timer query functions.
+#define GL_GLEXT_PROTOTYPES
+#endif
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include <algorithm>
+#include <cmath>
+
+constexpr int DynamicResolution::ScaleLevels;
+constexpr float DynamicResolution::ScaleStep;
+constexpr double DynamicResolution::TargetLoad;
+constexpr double DynamicResolution::DecreaseDelay;
+constexpr double DynamicResolution::IncreaseDelay;
+constexpr double DynamicResolution::Smoothing;
+constexpr size_t DynamicResolution::QueryCount;
+
+DynamicResolution::DynamicResolution()
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    if (!config.getBool("render.dynamicResolution.enabled", false))
+    {
+        return;
+    }
+
+#if USE_GLES
+    poco_warning(_logger, "Dynamic resolution scaling requires OpenGL 3.3 and isn't available with OpenGL ES.");
+#else
+    auto minScale = config.getDouble("render.dynamicResolution.minScale", 0.5);
+    _minLevel = std::min(std::max(static_cast<int>(std::lround(minScale * ScaleLevels)), 1), ScaleLevels);
+    _configuredBudget = std::max(config.getDouble("render.dynamicResolution.budget", 0.0), 0.0);
+    _budget = _configuredBudget;
+    _enabled = true;
+
+    poco_information_f1(_logger, "Dynamic resolution scaling enabled, minimum scale %.2f.", static_cast<double>(_minLevel) / ScaleLevels);
+#endif
+}
+
+bool DynamicResolution::Enabled() const
+{
+    return _enabled;
+}
+
+void DynamicResolution::Disable()
+{
+    _enabled = false;
+    _level = ScaleLevels;
+}
+
+void DynamicResolution::TargetFPS(int fps)
+{
+    if (_configuredBudget > 0.0)
+    {
+        return;
+    }
+
+    _budget = fps > 0 ? 1000.0 / fps : 0.0;
+}
+
+void DynamicResolution::Resize(int width, int height)
+{
+    _width = width;
+    _height = height;
+
+    if (!_enabled)
+    {
+        return;
+    }
+
+    DestroyFramebuffer();
+    CreateFramebuffer();
+}
+
+int DynamicResolution::RenderWidth() const
+{
+    return std::max(static_cast<int>(std::lround(_width * Scale())), 1);
+}
+
+int DynamicResolution::RenderHeight() const
+{
+    return std::max(static_cast<int>(std::lround(_height * Scale())), 1);
+}
+
+float DynamicResolution::Scale() const
+{
+    return static_cast<float>(_level) / ScaleLevels;
+}
+
+double DynamicResolution::Budget() const
+{
+    return _budget;
+}
+
+uint32_t DynamicResolution::BeginFrame(uint32_t outputFramebuffer)
+{
+    if (!_enabled)
+    {
+        return outputFramebuffer;
+    }
+
+#if !USE_GLES
+    ReadRenderTime();
+    glBeginQuery(GL_TIME_ELAPSED, _queries[_queryIndex]);
+#endif
+
+    // At full scale, projectM renders directly into the output and the blit is skipped.
+    return _level < ScaleLevels ? _framebuffer : outputFramebuffer;
+}
+
+bool DynamicResolution::EndFrame(POCO_UNUSED uint32_t outputFramebuffer)
+{
+    if (!_enabled)
+    {
+        return false;
+    }
+
+#if !USE_GLES
+    glEndQuery(GL_TIME_ELAPSED);
+    _queryIssued[_queryIndex] = true;
+    _queryLevels[_queryIndex] = _level;
+    _queryIndex = (_queryIndex + 1) % QueryCount;
+
+    if (_level < ScaleLevels)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+        glBlitFramebuffer(0, 0, RenderWidth(), RenderHeight(), 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glViewport(0, 0, _width, _height);
+#endif
+
+    return AdjustScale();
+}
+
+void DynamicResolution::Destroy()
+{
+    DestroyFramebuffer();
+
+#if !USE_GLES
+    if (_queries[0])
+    {
+        glDeleteQueries(static_cast<GLsizei>(QueryCount), _queries.data());
+        _queries.fill(0);
+        _queryIssued.fill(false);
+    }
+#endif
+}
+
+void DynamicResolution::ReadRenderTime()
+{
+#if !USE_GLES
+    if (!_queryIssued[_queryIndex])
+    {
+        return;
+    }
+    _queryIssued[_queryIndex] = false;
+
+    // The query is reused now, so a result that isn't available yet is lost rather than waited for.
+    GLint available{0};
+    glGetQueryObjectiv(_queries[_queryIndex], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available || _queryLevels[_queryIndex] != _level)
+    {
+        return;
+    }
+
+    GLuint64 nanoseconds{0};
+    glGetQueryObjectui64v(_queries[_queryIndex], GL_QUERY_RESULT, &nanoseconds);
+
+    auto renderTime = static_cast<double>(nanoseconds) / 1000000.0;
+    _renderTime = _renderTime > 0.0 ? _renderTime + Smoothing * (renderTime - _renderTime) : renderTime;
+#endif
+}
+
+bool DynamicResolution::AdjustScale()
+{
+    if (_budget <= 0.0 || _renderTime <= 0.0)
+    {
+        return false;
+    }
+
+    auto now = SDL_GetPerformanceCounter();
+    auto sinceChange = static_cast<double>(now - _lastChangeTicks) / static_cast<double>(SDL_GetPerformanceFrequency());
+    auto scale = static_cast<double>(Scale());
+
+    // The render time is roughly proportional to the pixel count, which is the square of the scale.
+    int level = _level;
+    if (_renderTime > _budget && sinceChange >= DecreaseDelay)
+    {
+        auto targetScale = scale * std::sqrt(TargetLoad * _budget / _renderTime);
+        level = std::max(std::min(static_cast<int>(std::floor(targetScale * ScaleLevels)), _level - 1), _minLevel);
+    }
+    else if (_level < ScaleLevels && sinceChange >= IncreaseDelay)
+    {
+        auto nextScale = static_cast<double>(_level + 1) / ScaleLevels;
+        if (_renderTime * (nextScale * nextScale) / (scale * scale) < TargetLoad * _budget)
+        {
+            level = _level + 1;
+        }
+    }
+
+    if (level == _level)
+    {
+        return false;
+    }
+
+    auto newScale = static_cast<double>(level) / ScaleLevels;
+    _renderTime *= (newScale * newScale) / (scale * scale);
+    _level = level;
+    _lastChangeTicks = now;
+
+    poco_debug_f4(_logger, "Render time %.2f ms of %.2f ms budget, changed resolution scale to %.2f (%s).",
+                  _renderTime, _budget, newScale, Poco::format("%?dx%?d", RenderWidth(), RenderHeight()));
+
+    return true;
+}
+
+void DynamicResolution::CreateFramebuffer()
+{
+#if !USE_GLES
+    if (!_queries[0])
+    {
+        glGenQueries(static_cast<GLsizei>(QueryCount), _queries.data());
+    }
+
+    // Allocated at output size, so scale changes don't need a new framebuffer. RGBA8 matches the output.
+    glGenRenderbuffers(1, &_colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, _width, _height);
+
+    glGenRenderbuffers(1, &_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, _width, _height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint previousFramebuffer{0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    glGenFramebuffers(1, &_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+
+    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        poco_error_f1(_logger, "Could not create the scaled framebuffer, status 0x%04x. Disabling dynamic resolution scaling.",
+                      static_cast<unsigned int>(status));
+        DestroyFramebuffer();
+        Disable();
+    }
+#endif
+}
+
+void DynamicResolution::DestroyFramebuffer()
+{
+#if !USE_GLES
+    if (_framebuffer)
+    {
+        glDeleteFramebuffers(1, &_framebuffer);
+        _framebuffer = 0;
+    }
+
+    if (_colorBuffer)
+    {
+        glDeleteRenderbuffers(1, &_colorBuffer);
+        _colorBuffer = 0;
+    }
+
+    if (_depthBuffer)
+    {
+        glDeleteRenderbuffers(1, &_depthBuffer);
+        _depthBuffer = 0;
+    }
+#endif
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Lowers projectM's render resolution while the render pass exceeds its time budget.
+ *
+ * Enabled with render.dynamicResolution.enabled. projectM renders into an offscreen framebuffer at a
+ * fraction of the output size, which is then upscaled with a bilinear blit into the window (or headless)
+ * framebuffer, before the GUI is drawn at native resolution.
+ *
+ * The GPU time of each projectM render pass is measured with timer queries, which are read a few frames
+ * later, so measuring never stalls the pipeline. Frame times alone can't be used, as with vertical sync,
+ * they always match the refresh interval, no matter how much headroom is left.
+ *
+ * The scale moves in steps of ScaleStep between render.dynamicResolution.minScale and 1.0, with hysteresis:
+ * - If the smoothed render time exceeds the budget, the scale is lowered to the step expected to bring it
+ *   down to TargetLoad times the budget, at most every DecreaseDelay seconds.
+ * - It is raised by a single step only if the render time at the new scale is expected to stay below
+ *   TargetLoad times the budget, at most every IncreaseDelay seconds.
+ *
+ * The budget is render.dynamicResolution.budget milliseconds, or the frame time at the target frame rate.
+ * Requires OpenGL 3.3, so it isn't available with OpenGL ES.
+ *
+ * All methods must be called on the render thread with the OpenGL context current.
+ */
+class DynamicResolution
+{
+public:
+    static constexpr int ScaleLevels{20}; //!< Number of scale steps from 0 to 1.
+    static constexpr float ScaleStep{1.0f / ScaleLevels}; //!< Smallest scale change, 5%.
+    static constexpr double TargetLoad{0.85}; //!< Fraction of the budget the scale is adjusted for.
+    static constexpr double DecreaseDelay{0.5}; //!< Minimum seconds between a change and the next decrease.
+    static constexpr double IncreaseDelay{2.0}; //!< Minimum seconds between a change and the next increase.
+    static constexpr double Smoothing{0.1}; //!< Weight of a new render time measurement in the moving average.
+
+    DynamicResolution();
+
+    /**
+     * @brief Returns whether dynamic resolution scaling is active.
+     * @return true if enabled in the configuration and supported.
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Turns dynamic resolution scaling off, e.g. when rendering offline, where quality matters more than time.
+     */
+    void Disable();
+
+    /**
+     * @brief Sets the frame rate the budget is derived from, if not configured explicitly.
+     * @param fps The target frames per second. 0 keeps the resolution at full scale.
+     */
+    void TargetFPS(int fps);
+
+    /**
+     * @brief Sets the size of the output and recreates the offscreen framebuffer.
+     * @param width Output width in pixels.
+     * @param height Output height in pixels.
+     */
+    void Resize(int width, int height);
+
+    /**
+     * @brief Returns the width projectM has to render at.
+     * @return The scaled render width in pixels.
+     */
+    int RenderWidth() const;
+
+    /**
+     * @brief Returns the height projectM has to render at.
+     * @return The scaled render height in pixels.
+     */
+    int RenderHeight() const;
+
+    /**
+     * @brief Returns the current scale.
+     * @return The fraction of the output size projectM renders at, 1.0 if disabled.
+     */
+    float Scale() const;
+
+    /**
+     * @brief Returns the render time budget the scale is adjusted for.
+     * @return The budget in milliseconds, 0 if there is none.
+     */
+    double Budget() const;
+
+    /**
+     * @brief Starts timing a projectM render pass.
+     * @param outputFramebuffer The framebuffer the frame is finally displayed from.
+     * @return The framebuffer projectM must render into.
+     */
+    uint32_t BeginFrame(uint32_t outputFramebuffer);
+
+    /**
+     * @brief Stops timing, upscales the frame into the output framebuffer and adjusts the scale.
+     *
+     * Leaves the output framebuffer bound, with the viewport covering all of it.
+     *
+     * @param outputFramebuffer The framebuffer the frame is finally displayed from.
+     * @return true if the render size changed, so projectM has to be resized.
+     */
+    bool EndFrame(uint32_t outputFramebuffer);
+
+    /**
+     * @brief Deletes the offscreen framebuffer and timer queries.
+     */
+    void Destroy();
+
+protected:
+    static constexpr size_t QueryCount{4}; //!< Number of timer queries in flight.
+
+    /**
+     * @brief Reads the oldest timer query if its result is available and updates the render time average.
+     */
+    void ReadRenderTime();
+
+    /**
+     * @brief Chooses a new scale level based on the smoothed render time.
+     * @return true if the level changed.
+     */
+    bool AdjustScale();
+
+    /**
+     * @brief Creates the offscreen framebuffer for the current output size.
+     */
+    void CreateFramebuffer();
+
+    /**
+     * @brief Deletes the offscreen framebuffer.
+     */
+    void DestroyFramebuffer();
+
+    bool _enabled{false}; //!< True if scaling is active.
+    int _minLevel{ScaleLevels / 2}; //!< Lowest scale level, from render.dynamicResolution.minScale.
+    int _level{ScaleLevels}; //!< Current scale level, the scale is _level / ScaleLevels.
+    double _configuredBudget{0.0}; //!< Budget from render.dynamicResolution.budget in milliseconds, 0 if derived from the frame rate.
+    double _budget{0.0}; //!< Effective budget in milliseconds, 0 if there is none.
+
+    int _width{0}; //!< Output width in pixels.
+    int _height{0}; //!< Output height in pixels.
+
+    uint32_t _framebuffer{0}; //!< Offscreen framebuffer object at output size, projectM uses the lower left part.
+    uint32_t _colorBuffer{0}; //!< Color renderbuffer of the offscreen framebuffer.
+    uint32_t _depthBuffer{0}; //!< Depth renderbuffer of the offscreen framebuffer.
+
+    std::array<uint32_t, QueryCount> _queries{}; //!< Ring of GPU timer queries.
+    std::array<bool, QueryCount> _queryIssued{}; //!< True if the query at the same index has a pending result.
+    std::array<int, QueryCount> _queryLevels{}; //!< Scale level each query was issued at, results from other levels are ignored.
+    size_t _queryIndex{0}; //!< Index of the query used for the next frame.
+
+    double _renderTime{0.0}; //!< Moving average of the render pass GPU time in milliseconds, 0 before the first measurement.
+    uint64_t _lastChangeTicks{0}; //!< Performance counter value at the last scale change.
+
+    Poco::Logger& _logger{Poco::Logger::get("DynamicResolution")}; //!< The class logger.
+};
@@ -2,21 +2,34 @@
 
 #include <SDL2/SDL.h>
 
+FPSLimiter::FPSLimiter()
+    : _ticksPerSecond(SDL_GetPerformanceFrequency())
+{
+    SpinBudget(0.001);
+}
+
 void FPSLimiter::TargetFPS(int fps)
 {
-    if (fps)
+    if (fps < 0)
     {
-        _targetFrameTime = 1000 / fps;
+        fps = 0;
     }
-    else
+
+    if (fps != _targetFPS)
     {
-        _targetFrameTime = 0;
+        _targetFPS = fps;
+        _scheduledFrames = 0;
     }
 }
 
+void FPSLimiter::SpinBudget(double seconds)
+{
+    _spinTicks = seconds > 0.0 ? static_cast<uint64_t>(seconds * static_cast<double>(_ticksPerSecond)) : 0;
+}
+
 float FPSLimiter::FPS() const
 {
-    uint32_t frameTimeSum{ 0 };
+    uint64_t frameTimeSum{ 0 };
     uint32_t frameTimeCount{ 0 };
 
     for (auto _lastFrameTime : _lastFrameTimes)
@@ -33,24 +46,65 @@ float FPSLimiter::FPS() const
         return 0.0f;
     }
 
-   return 1000.0f / (static_cast<float>(frameTimeSum) / static_cast<float>(frameTimeCount));
+   return static_cast<float>(static_cast<double>(_ticksPerSecond) * frameTimeCount / static_cast<double>(frameTimeSum));
 }
 
 void FPSLimiter::StartFrame()
 {
-    _lastTickCount = SDL_GetTicks();
+    _frameStartTicks = SDL_GetPerformanceCounter();
 }
 
 void FPSLimiter::EndFrame()
 {
-    uint32_t frameTime = SDL_GetTicks() - _lastTickCount;
+    auto now = SDL_GetPerformanceCounter();
+
+    if (_targetFPS > 0)
+    {
+        if (_scheduledFrames == 0)
+        {
+            _scheduleStartTicks = _frameStartTicks;
+        }
+
+        // Calculated from the schedule start each time, so truncating the division doesn't add up.
+        auto deadline = _scheduleStartTicks + (_scheduledFrames + 1) * _ticksPerSecond / static_cast<uint64_t>(_targetFPS);
+        auto frameTicks = _ticksPerSecond / static_cast<uint64_t>(_targetFPS);
+
+        if (now < deadline)
+        {
+            WaitUntil(deadline);
+            now = SDL_GetPerformanceCounter();
+        }
 
-    if (_targetFrameTime && frameTime < _targetFrameTime)
+        _scheduledFrames++;
+        if (now > deadline && now - deadline >= frameTicks)
+        {
+            // Missed at least one whole frame, e.g. while loading a preset. Skip the missed deadlines instead of
+            // rushing through them, but keep the remaining ones aligned to the schedule.
+            _scheduledFrames = (now - _scheduleStartTicks) * static_cast<uint64_t>(_targetFPS) / _ticksPerSecond;
+        }
+    }
+    else
     {
-        SDL_Delay(_targetFrameTime - frameTime);
-        frameTime = SDL_GetTicks() - _lastTickCount;
+        _scheduledFrames = 0;
     }
 
-    _lastFrameTimes[_nextFrameTimesOffset] = frameTime;
+    _lastFrameTimes[_nextFrameTimesOffset] = now - _frameStartTicks;
     _nextFrameTimesOffset = (_nextFrameTimesOffset + 1) % 10;
 }
+
+void FPSLimiter::WaitUntil(uint64_t deadline) const
+{
+    auto now = SDL_GetPerformanceCounter();
+    if (deadline > now + _spinTicks)
+    {
+        auto sleepMilliseconds = (deadline - now - _spinTicks) * 1000 / _ticksPerSecond;
+        if (sleepMilliseconds > 0)
+        {
+            SDL_Delay(static_cast<Uint32>(sleepMilliseconds));
+        }
+    }
+
+    while (SDL_GetPerformanceCounter() < deadline)
+    {
+    }
+}
@@ -4,16 +4,34 @@
 
 /**
  * @brief Limits FPS by adding a delay if necessary. Also keeps track of actual FPS.
+ *
+ * Frame deadlines are calculated from the start of the schedule with performance counter precision, so
+ * rounding errors and late wakeups don't accumulate. The limiter sleeps until shortly before each deadline,
+ * then busy-waits for the remaining spin budget, as the OS scheduler may wake a sleeping thread a lot later.
  */
 class FPSLimiter
 {
 public:
+    FPSLimiter();
+
     /**
      * @brief Sets the target frames per second value.
+     *
+     * Restarts the deadline schedule if the value changed.
+     *
      * @param fps The targeted frames per second. Set to 0 for unlimited FPS.
      */
     void TargetFPS(int fps);
 
+    /**
+     * @brief Sets the time spent busy-waiting before each deadline instead of sleeping.
+     *
+     * Larger values compensate for more sleep overshoot at the cost of CPU time.
+     *
+     * @param seconds The spin budget in seconds. 0 only sleeps.
+     */
+    void SpinBudget(double seconds);
+
     /**
      * @brief Calculates the current real FPS.
      *
@@ -38,12 +56,21 @@ public:
     void EndFrame();
 
 protected:
+    /**
+     * @brief Sleeps, then spins until the given performance counter value is reached.
+     * @param deadline The performance counter value to wait for.
+     */
+    void WaitUntil(uint64_t deadline) const;
 
-    uint32_t _lastTickCount{ 0 }; //!< Last SDL tick count, when a new frame was started.
-    uint32_t _targetFrameTime{ 0 }; //!< Targeted time per frame in milliseconds.
-    uint32_t _lastFrameTimes[10]{}; //!< Actual tick time of the last ten frames, including limiting delay.
-    int _nextFrameTimesOffset{ 0 }; //!< Next offset to overwrite the _lastFrameTimes ring buffer.
+    uint64_t _ticksPerSecond{1}; //!< Performance counter frequency.
+    int _targetFPS{0}; //!< Targeted frames per second, 0 if unlimited.
+    uint64_t _spinTicks{0}; //!< Performance counter ticks to busy-wait before a deadline.
 
-};
+    uint64_t _frameStartTicks{0}; //!< Performance counter value when the current frame was started.
+    uint64_t _scheduleStartTicks{0}; //!< Performance counter value the frame deadlines are calculated from.
+    uint64_t _scheduledFrames{0}; //!< Number of frames since the schedule start. 0 restarts the schedule.
 
+    uint64_t _lastFrameTimes[10]{}; //!< Actual time of the last ten frames in performance counter ticks, including limiting delay.
+    int _nextFrameTimesOffset{ 0 }; //!< Next offset to overwrite the _lastFrameTimes ring buffer.
 
+};
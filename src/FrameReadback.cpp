@@ -0,0 +1,153 @@
+#include "FrameReadback.h"
+
+#ifdef USE_GLEW
+#include <GL/glew.h>
+#else
+// Declares the buffer object functions used for the readback.
+#define GL_GLEXT_PROTOTYPES
+#endif
+
+#include <SDL2/SDL_opengl.h>
+
+void FrameReadback::Create(int width, int height, size_t bufferCount)
+{
+    Destroy();
+
+    _width = width;
+    _height = height;
+    _buffers.resize(bufferCount > 0 ? bufferCount : 1);
+
+    for (auto& buffer : _buffers)
+    {
+#if USE_GLES
+        buffer.pixels.resize(FrameBytes());
+#else
+        glGenBuffers(1, &buffer.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(FrameBytes()), nullptr, GL_STREAM_READ);
+#endif
+    }
+
+#if !USE_GLES
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+}
+
+void FrameReadback::Destroy()
+{
+    if (_mapped)
+    {
+        ReleaseOldest();
+    }
+
+#if !USE_GLES
+    for (auto& buffer : _buffers)
+    {
+        glDeleteBuffers(1, &buffer.buffer);
+    }
+#endif
+
+    _buffers.clear();
+    _oldest = 0;
+    _pending = 0;
+    _width = 0;
+    _height = 0;
+}
+
+bool FrameReadback::Created() const
+{
+    return !_buffers.empty();
+}
+
+int FrameReadback::Width() const
+{
+    return _width;
+}
+
+int FrameReadback::Height() const
+{
+    return _height;
+}
+
+size_t FrameReadback::FrameBytes() const
+{
+    return static_cast<size_t>(_width) * static_cast<size_t>(_height) * 4;
+}
+
+bool FrameReadback::Full() const
+{
+    return _pending == _buffers.size();
+}
+
+bool FrameReadback::Pending() const
+{
+    return _pending > 0;
+}
+
+void FrameReadback::Queue(uint32_t framebuffer, uint64_t tag)
+{
+    if (_buffers.empty() || Full())
+    {
+        return;
+    }
+
+    auto& buffer = _buffers[(_oldest + _pending) % _buffers.size()];
+    buffer.tag = tag;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+#if USE_GLES
+    glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, buffer.pixels.data());
+#else
+    // With a pack buffer bound, the pointer is an offset into it and the call returns without waiting.
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.buffer);
+    glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+
+    _pending++;
+}
+
+const uint8_t* FrameReadback::MapOldest(uint64_t& tag)
+{
+    if (!Pending())
+    {
+        return nullptr;
+    }
+
+    auto& buffer = _buffers[_oldest];
+    tag = buffer.tag;
+
+#if USE_GLES
+    _mapped = true;
+    return buffer.pixels.data();
+#else
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.buffer);
+    const auto* pixels = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(FrameBytes()), GL_MAP_READ_BIT));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    _mapped = pixels != nullptr;
+    return pixels;
+#endif
+}
+
+void FrameReadback::ReleaseOldest()
+{
+    if (!Pending())
+    {
+        return;
+    }
+
+#if !USE_GLES
+    if (_mapped)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, _buffers[_oldest].buffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+#endif
+
+    _mapped = false;
+    _oldest = (_oldest + 1) % _buffers.size();
+    _pending--;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Reads rendered frames back from the GPU through a ring of pixel buffer objects.
+ *
+ * Queue() starts an asynchronous glReadPixels() into the next buffer object and returns immediately. The
+ * frame is mapped with MapOldest() only after more frames have been queued, when the copy has usually
+ * finished, so neither the GPU nor the CPU waits for the other. Frames are consumed in the order they were
+ * queued, and each buffer must be consumed before it's reused, see Full().
+ *
+ * OpenGL ES 2.0 has no pixel buffer objects. There, Queue() reads the frame synchronously into memory.
+ *
+ * Pixels are RGBA, bottom row first, without row padding. All methods must be called on the render thread
+ * with the OpenGL context current.
+ */
+class FrameReadback
+{
+public:
+    FrameReadback() = default;
+
+    FrameReadback(const FrameReadback&) = delete;
+
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    /**
+     * @brief Creates the readback buffers, replacing any existing ones and dropping their frames.
+     * @param width Width of the frames in pixels.
+     * @param height Height of the frames in pixels.
+     * @param bufferCount Number of buffers, which is the number of frames that can be in flight.
+     */
+    void Create(int width, int height, size_t bufferCount);
+
+    /**
+     * @brief Deletes all buffers and drops pending frames.
+     */
+    void Destroy();
+
+    /**
+     * @brief Returns whether the buffers have been created.
+     * @return true if frames can be queued.
+     */
+    bool Created() const;
+
+    /**
+     * @brief Returns the frame width the buffers were created for.
+     * @return The width in pixels.
+     */
+    int Width() const;
+
+    /**
+     * @brief Returns the frame height the buffers were created for.
+     * @return The height in pixels.
+     */
+    int Height() const;
+
+    /**
+     * @brief Returns the size of a single frame.
+     * @return The frame size in bytes.
+     */
+    size_t FrameBytes() const;
+
+    /**
+     * @brief Returns whether all buffers hold unconsumed frames.
+     * @return true if the oldest frame must be consumed before the next one can be queued.
+     */
+    bool Full() const;
+
+    /**
+     * @brief Returns whether any queued frame hasn't been consumed yet.
+     * @return true if MapOldest() can be called.
+     */
+    bool Pending() const;
+
+    /**
+     * @brief Starts reading the given framebuffer into the next buffer.
+     * @param framebuffer The framebuffer object to read, 0 for the default framebuffer.
+     * @param tag A value returned together with the frame, e.g. a timestamp.
+     */
+    void Queue(uint32_t framebuffer, uint64_t tag);
+
+    /**
+     * @brief Maps the oldest queued frame into memory, waiting for its copy to finish if necessary.
+     * @param tag Receives the value passed to Queue().
+     * @return The pixels of the frame, or nullptr if it couldn't be mapped. Valid until ReleaseOldest().
+     */
+    const uint8_t* MapOldest(uint64_t& tag);
+
+    /**
+     * @brief Unmaps the oldest frame and makes its buffer available again.
+     */
+    void ReleaseOldest();
+
+protected:
+    /**
+     * @brief A single slot in the readback ring.
+     */
+    struct Buffer
+    {
+        uint32_t buffer{0}; //!< OpenGL buffer object name, 0 without pixel buffer objects.
+        std::vector<uint8_t> pixels; //!< Frame memory for synchronous readback without pixel buffer objects.
+        uint64_t tag{0}; //!< The value passed to Queue().
+    };
+
+    int _width{0}; //!< Frame width in pixels.
+    int _height{0}; //!< Frame height in pixels.
+
+    std::vector<Buffer> _buffers; //!< The ring of buffers.
+    size_t _oldest{0}; //!< Index of the oldest pending frame.
+    size_t _pending{0}; //!< Number of queued frames which haven't been released yet.
+    bool _mapped{false}; //!< True while the oldest buffer is mapped.
+};
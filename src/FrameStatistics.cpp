@@ -0,0 +1,263 @@
+#include "FrameStatistics.h"
+
+#include <Poco/Exception.h>
+#include <Poco/Format.h>
+#include <Poco/Path.h>
+#include <Poco/String.h>
+
+#include <Poco/Util/Application.h>
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <iomanip>
+
+constexpr double FrameStatistics::DroppedFrameFactor;
+constexpr size_t FrameStatistics::HistogramCount;
+constexpr size_t FrameStatistics::FrameTimeIndex;
+
+namespace {
+
+//! Names of the histograms in the output file and log, in the order of FrameStatistics::Phase, plus the frame time.
+const char* const HistogramNames[]{"pollEvents", "fillBuffer", "renderFrame", "guiDraw", "swap", "frame"};
+
+} // namespace
+
+FrameStatistics::FrameStatistics()
+    : _ticksPerSecond(SDL_GetPerformanceFrequency())
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    auto interval = std::max(config.getDouble("render.stats.interval", 10.0), 1.0);
+    _intervalTicks = static_cast<uint64_t>(interval * static_cast<double>(_ticksPerSecond));
+
+    _path = config.getString("render.stats.path", "");
+    if (_path.empty())
+    {
+        return;
+    }
+
+    _csv = Poco::icompare(Poco::Path(_path).getExtension(), "csv") == 0;
+
+    try
+    {
+        _file.reset(new Poco::FileOutputStream(_path));
+        *_file << std::fixed << std::setprecision(3);
+        WriteHeader();
+
+        poco_information_f2(_logger, R"(Writing frame statistics every %.0f seconds to "%s".)", interval, _path);
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not open frame statistics file "%s": %s)", _path, ex.displayText());
+        _file.reset();
+    }
+}
+
+void FrameStatistics::TargetFPS(int fps)
+{
+    _targetFrameTicks = fps > 0 ? _ticksPerSecond / static_cast<uint64_t>(fps) : 0;
+}
+
+void FrameStatistics::StartFrame()
+{
+    auto now = SDL_GetPerformanceCounter();
+
+    if (_frameStartTicks == 0)
+    {
+        _runStartTicks = now;
+        _intervalStartTicks = now;
+    }
+    else if (!_frameDiscarded)
+    {
+        auto frameTicks = now - _frameStartTicks;
+        _interval.histograms[FrameTimeIndex].Record(Microseconds(frameTicks));
+        if (_targetFrameTicks > 0 &&
+            static_cast<double>(frameTicks) > DroppedFrameFactor * static_cast<double>(_targetFrameTicks))
+        {
+            _interval.droppedFrames++;
+        }
+    }
+
+    if (now - _intervalStartTicks >= _intervalTicks)
+    {
+        FinishInterval(now);
+    }
+
+    _frameStartTicks = now;
+    _phaseStartTicks = now;
+    _frameDiscarded = false;
+}
+
+void FrameStatistics::EndPhase(Phase phase)
+{
+    auto now = SDL_GetPerformanceCounter();
+
+    _interval.histograms[static_cast<size_t>(phase)].Record(Microseconds(now - _phaseStartTicks));
+    _phaseStartTicks = now;
+}
+
+void FrameStatistics::DiscardFrame()
+{
+    _frameDiscarded = true;
+}
+
+void FrameStatistics::ResolutionScale(float scale, double budget)
+{
+    _interval.scaleSum += scale;
+    _interval.scaleFrames++;
+    _interval.minScale = std::min(_interval.minScale, scale);
+    _interval.budget = budget;
+}
+
+void FrameStatistics::LogSummary()
+{
+    if (_frameStartTicks == 0)
+    {
+        return;
+    }
+
+    auto now = SDL_GetPerformanceCounter();
+    FinishInterval(now);
+
+    const auto& frameTimes = _total.histograms[FrameTimeIndex];
+    auto duration = static_cast<double>(now - _runStartTicks) / static_cast<double>(_ticksPerSecond);
+    poco_information_f3(_logger, "Frame statistics: %?u frames in %.1f seconds, %?u dropped.",
+                        frameTimes.Count(), duration, _total.droppedFrames);
+
+    for (size_t index = 0; index < HistogramCount; index++)
+    {
+        const auto& histogram = _total.histograms[index];
+        if (histogram.Count() == 0)
+        {
+            continue;
+        }
+
+        poco_information(_logger, Poco::format("%-11s p50 %6.2f ms, p95 %6.2f ms, p99 %6.2f ms, max %6.2f ms",
+                                               std::string(HistogramNames[index]),
+                                               histogram.Percentile(50.0) / 1000.0, histogram.Percentile(95.0) / 1000.0,
+                                               histogram.Percentile(99.0) / 1000.0, histogram.Max() / 1000.0));
+    }
+
+    if (_total.scaleFrames > 0)
+    {
+        poco_information_f3(_logger, "Resolution scale: mean %.2f, min %.2f, budget %.2f ms.",
+                            _total.MeanScale(), static_cast<double>(_total.minScale), _total.budget);
+    }
+}
+
+void FrameStatistics::Period::Add(const Period& other)
+{
+    for (size_t index = 0; index < HistogramCount; index++)
+    {
+        histograms[index].Add(other.histograms[index]);
+    }
+
+    droppedFrames += other.droppedFrames;
+    scaleSum += other.scaleSum;
+    scaleFrames += other.scaleFrames;
+    minScale = std::min(minScale, other.minScale);
+    if (other.scaleFrames > 0)
+    {
+        budget = other.budget;
+    }
+}
+
+void FrameStatistics::Period::Reset()
+{
+    for (auto& histogram : histograms)
+    {
+        histogram.Reset();
+    }
+
+    droppedFrames = 0;
+    scaleSum = 0.0;
+    scaleFrames = 0;
+    minScale = 1.0f;
+    budget = 0.0;
+}
+
+double FrameStatistics::Period::MeanScale() const
+{
+    return scaleFrames > 0 ? scaleSum / static_cast<double>(scaleFrames) : 1.0;
+}
+
+uint32_t FrameStatistics::Microseconds(uint64_t ticks) const
+{
+    auto microseconds = static_cast<double>(ticks) * 1000000.0 / static_cast<double>(_ticksPerSecond);
+
+    return static_cast<uint32_t>(std::min(microseconds, static_cast<double>(FrameTimeHistogram::MaxValue)));
+}
+
+void FrameStatistics::FinishInterval(uint64_t now)
+{
+    if (_file && _interval.histograms[FrameTimeIndex].Count() > 0)
+    {
+        WritePeriod(_interval,
+                    static_cast<double>(now - _runStartTicks) / static_cast<double>(_ticksPerSecond),
+                    static_cast<double>(now - _intervalStartTicks) / static_cast<double>(_ticksPerSecond));
+    }
+
+    _total.Add(_interval);
+    _interval.Reset();
+    _intervalStartTicks = now;
+}
+
+void FrameStatistics::WriteHeader()
+{
+    if (!_csv)
+    {
+        return;
+    }
+
+    *_file << "time,duration,frames,dropped,fps,scale_mean,scale_min,budget_ms";
+    for (const auto* name : HistogramNames)
+    {
+        *_file << "," << name << "_p50_ms," << name << "_p95_ms," << name << "_p99_ms," << name << "_max_ms";
+    }
+    *_file << "\n";
+}
+
+void FrameStatistics::WritePeriod(const Period& period, double time, double duration)
+{
+    auto frames = period.histograms[FrameTimeIndex].Count();
+    auto fps = static_cast<double>(frames) / duration;
+
+    if (_csv)
+    {
+        *_file << time << "," << duration << "," << frames << "," << period.droppedFrames << "," << fps
+               << "," << period.MeanScale() << "," << period.minScale << "," << period.budget;
+        for (const auto& histogram : period.histograms)
+        {
+            *_file << "," << histogram.Percentile(50.0) / 1000.0
+                   << "," << histogram.Percentile(95.0) / 1000.0
+                   << "," << histogram.Percentile(99.0) / 1000.0
+                   << "," << histogram.Max() / 1000.0;
+        }
+        *_file << "\n";
+    }
+    else
+    {
+        *_file << R"({"time":)" << time << R"(,"duration":)" << duration << R"(,"frames":)" << frames
+               << R"(,"dropped":)" << period.droppedFrames << R"(,"fps":)" << fps
+               << R"(,"scale":{"mean":)" << period.MeanScale() << R"(,"min":)" << period.minScale
+               << R"(},"budget":)" << period.budget;
+        for (size_t index = 0; index < HistogramCount; index++)
+        {
+            const auto& histogram = period.histograms[index];
+            *_file << R"(,")" << HistogramNames[index]
+                   << R"(":{"p50":)" << histogram.Percentile(50.0) / 1000.0
+                   << R"(,"p95":)" << histogram.Percentile(95.0) / 1000.0
+                   << R"(,"p99":)" << histogram.Percentile(99.0) / 1000.0
+                   << R"(,"max":)" << histogram.Max() / 1000.0 << "}";
+        }
+        *_file << "}\n";
+    }
+
+    _file->flush();
+    if (!_file->good())
+    {
+        poco_error_f1(_logger, R"(Could not write frame statistics to "%s". Stopping output.)", _path);
+        _file.reset();
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "FrameTimeHistogram.h"
+
+#include <Poco/FileStream.h>
+#include <Poco/Logger.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Records frame time percentiles and the duration of each render loop phase.
+ *
+ * The render loop calls StartFrame() at the beginning of each frame and EndPhase() after each of its
+ * phases. The frame time is measured from one frame start to the next, so it includes the frame limiter's
+ * delay and is what the viewer actually sees. A frame counts as dropped if it took more than
+ * DroppedFrameFactor times the target frame time.
+ *
+ * All values are kept in fixed-size histograms, so recording doesn't allocate. If render.stats.path is
+ * set, the statistics of each render.stats.interval are appended to that file, as CSV if the file name
+ * ends with ".csv" and as JSON lines otherwise. A summary of the whole run is logged on exit. If dynamic
+ * resolution scaling is active, the mean and lowest scale and the render time budget are included.
+ *
+ * All methods must be called on the render thread.
+ */
+class FrameStatistics
+{
+public:
+    /**
+     * @brief Phases of a render loop iteration, in the order they are executed.
+     */
+    enum class Phase
+    {
+        PollEvents, //!< Event handling, including viewport size checks.
+        FillBuffer, //!< Passing the captured audio to projectM.
+        RenderFrame, //!< Rendering the projectM frame.
+        GuiDraw, //!< Drawing the ImGui overlay.
+        Swap, //!< Swapping the window buffers, which usually waits for vertical sync.
+        Count //!< Number of phases.
+    };
+
+    static constexpr double DroppedFrameFactor{1.5}; //!< Multiple of the target frame time above which a frame counts as dropped.
+
+    FrameStatistics();
+
+    /**
+     * @brief Sets the frame rate used to detect dropped frames.
+     * @param fps The target frames per second. 0 disables dropped frame detection.
+     */
+    void TargetFPS(int fps);
+
+    /**
+     * @brief Marks the start of a new frame, completing the previous one.
+     *
+     * Writes the interval statistics if render.stats.interval has passed.
+     */
+    void StartFrame();
+
+    /**
+     * @brief Records the time since the frame start or previous phase as the duration of the given phase.
+     * @param phase The phase which just ended.
+     */
+    void EndPhase(Phase phase);
+
+    /**
+     * @brief Excludes the current frame from the frame time statistics, e.g. if nothing was rendered.
+     *
+     * Durations of phases which already ended are still recorded.
+     */
+    void DiscardFrame();
+
+    /**
+     * @brief Records the dynamic resolution scale of the current frame and the budget it's adjusted for.
+     * @param scale The fraction of the output size projectM rendered at.
+     * @param budget The render time budget in milliseconds, 0 if there is none.
+     */
+    void ResolutionScale(float scale, double budget);
+
+    /**
+     * @brief Writes the last interval and logs the percentiles of the whole run.
+     */
+    void LogSummary();
+
+protected:
+    static constexpr size_t HistogramCount{static_cast<size_t>(Phase::Count) + 1}; //!< One histogram per phase, plus the frame time.
+    static constexpr size_t FrameTimeIndex{static_cast<size_t>(Phase::Count)}; //!< Index of the frame time histogram.
+
+    /**
+     * @brief Statistics over a period of time.
+     */
+    struct Period
+    {
+        /**
+         * @brief Adds another period's values.
+         * @param other The period to merge into this one.
+         */
+        void Add(const Period& other);
+
+        /**
+         * @brief Removes all recorded values.
+         */
+        void Reset();
+
+        /**
+         * @brief Returns the mean resolution scale.
+         * @return The mean scale, 1.0 if none was recorded.
+         */
+        double MeanScale() const;
+
+        std::array<FrameTimeHistogram, HistogramCount> histograms; //!< Phase durations and frame times.
+        uint64_t droppedFrames{0}; //!< Number of frames exceeding the dropped frame threshold.
+        double scaleSum{0.0}; //!< Sum of the recorded resolution scales.
+        uint64_t scaleFrames{0}; //!< Number of frames with a recorded resolution scale.
+        float minScale{1.0f}; //!< Lowest recorded resolution scale.
+        double budget{0.0}; //!< Last recorded render time budget in milliseconds.
+    };
+
+    /**
+     * @brief Converts a performance counter interval to microseconds.
+     * @param ticks The interval in performance counter ticks.
+     * @return The interval in microseconds, clamped to the histogram range.
+     */
+    uint32_t Microseconds(uint64_t ticks) const;
+
+    /**
+     * @brief Appends the current interval's statistics to the output file and adds them to the run's total.
+     * @param now The current performance counter value.
+     */
+    void FinishInterval(uint64_t now);
+
+    /**
+     * @brief Writes the header line if the output file is a CSV file.
+     */
+    void WriteHeader();
+
+    /**
+     * @brief Appends one period's statistics as a line to the output file.
+     * @param period The statistics to write.
+     * @param time Time since the start of the run in seconds.
+     * @param duration Length of the period in seconds.
+     */
+    void WritePeriod(const Period& period, double time, double duration);
+
+    uint64_t _ticksPerSecond{1}; //!< Performance counter frequency.
+    uint64_t _targetFrameTicks{0}; //!< Target frame time in performance counter ticks, 0 if unlimited.
+
+    uint64_t _frameStartTicks{0}; //!< Performance counter value at the start of the current frame, 0 before the first frame.
+    uint64_t _phaseStartTicks{0}; //!< Performance counter value at the start of the current phase.
+    bool _frameDiscarded{false}; //!< If true, the current frame isn't recorded.
+
+    Period _interval; //!< Statistics of the current output interval.
+    Period _total; //!< Statistics of the whole run, excluding the current interval.
+
+    uint64_t _runStartTicks{0}; //!< Performance counter value of the first frame start.
+    uint64_t _intervalStartTicks{0}; //!< Performance counter value at the start of the current interval.
+    uint64_t _intervalTicks{0}; //!< Length of an output interval in performance counter ticks.
+
+    std::string _path; //!< Output file path, empty if disabled.
+    bool _csv{false}; //!< If true, the output is CSV, otherwise JSON lines.
+    std::unique_ptr<Poco::FileOutputStream> _file; //!< The output file, if open.
+
+    Poco::Logger& _logger{Poco::Logger::get("FrameStatistics")}; //!< The class logger.
+};
@@ -0,0 +1,108 @@
+#include "FrameTimeHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr uint32_t FrameTimeHistogram::SubBucketBits;
+constexpr uint32_t FrameTimeHistogram::SubBuckets;
+constexpr uint32_t FrameTimeHistogram::MaxValue;
+constexpr uint32_t FrameTimeHistogram::BucketCount;
+
+void FrameTimeHistogram::Record(uint32_t microseconds)
+{
+    microseconds = std::min(microseconds, MaxValue);
+
+    _buckets[BucketIndex(microseconds)]++;
+    _count++;
+    _sum += microseconds;
+    _max = std::max(_max, microseconds);
+}
+
+void FrameTimeHistogram::Add(const FrameTimeHistogram& other)
+{
+    for (uint32_t index = 0; index < BucketCount; index++)
+    {
+        _buckets[index] += other._buckets[index];
+    }
+
+    _count += other._count;
+    _sum += other._sum;
+    _max = std::max(_max, other._max);
+}
+
+void FrameTimeHistogram::Reset()
+{
+    _buckets.fill(0);
+    _count = 0;
+    _sum = 0;
+    _max = 0;
+}
+
+uint64_t FrameTimeHistogram::Count() const
+{
+    return _count;
+}
+
+double FrameTimeHistogram::Mean() const
+{
+    if (_count == 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(_sum) / static_cast<double>(_count);
+}
+
+uint32_t FrameTimeHistogram::Max() const
+{
+    return _max;
+}
+
+uint32_t FrameTimeHistogram::Percentile(double percentile) const
+{
+    if (_count == 0)
+    {
+        return 0;
+    }
+
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(_count)));
+    rank = std::min(std::max<uint64_t>(rank, 1), _count);
+
+    uint64_t valuesBelow{0};
+    for (uint32_t index = 0; index < BucketCount; index++)
+    {
+        valuesBelow += _buckets[index];
+        if (valuesBelow >= rank)
+        {
+            return std::min(BucketMaxValue(index), _max);
+        }
+    }
+
+    return _max;
+}
+
+uint32_t FrameTimeHistogram::BucketIndex(uint32_t value)
+{
+    uint32_t highestBit{0};
+    while (value >> (highestBit + 1))
+    {
+        highestBit++;
+    }
+
+    // Values up to 2 * SubBuckets - 1 map to their own bucket. Above, each power of two is shifted into the
+    // range [SubBuckets, 2 * SubBuckets) and offset by SubBuckets per power.
+    auto shift = highestBit > SubBucketBits ? highestBit - SubBucketBits : 0;
+    return shift * SubBuckets + (value >> shift);
+}
+
+uint32_t FrameTimeHistogram::BucketMaxValue(uint32_t index)
+{
+    if (index < 2 * SubBuckets)
+    {
+        return index;
+    }
+
+    auto shift = index / SubBuckets - 1;
+    return ((index - shift * SubBuckets) << shift) + (1u << shift) - 1;
+}
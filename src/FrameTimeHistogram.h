@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Fixed-size histogram of durations in microseconds with a bounded relative error.
+ *
+ * Uses the bucket layout of HDR histograms: values below 2 * SubBuckets are counted exactly, and each
+ * following power of two is split into SubBuckets linear buckets. Percentiles are therefore accurate to
+ * about 1/SubBuckets of the value, from microseconds up to MaxValue, with a few kilobytes of memory.
+ *
+ * Recording is a bucket index calculation and an increment, without any allocations, so it can be done
+ * for every phase of every frame.
+ */
+class FrameTimeHistogram
+{
+public:
+    static constexpr uint32_t SubBucketBits{5}; //!< Log2 of the linear buckets per power of two.
+    static constexpr uint32_t SubBuckets{1u << SubBucketBits}; //!< Linear buckets per power of two, about 3% resolution.
+    static constexpr uint32_t MaxValue{(1u << 26) - 1}; //!< Largest distinguishable value, about 67 seconds. Larger values are clamped.
+
+    /**
+     * @brief Adds a duration to the histogram.
+     * @param microseconds The duration in microseconds.
+     */
+    void Record(uint32_t microseconds);
+
+    /**
+     * @brief Adds all values of another histogram.
+     * @param other The histogram to merge into this one.
+     */
+    void Add(const FrameTimeHistogram& other);
+
+    /**
+     * @brief Removes all recorded values.
+     */
+    void Reset();
+
+    /**
+     * @brief Returns the number of recorded values.
+     * @return The value count.
+     */
+    uint64_t Count() const;
+
+    /**
+     * @brief Returns the arithmetic mean of all recorded values.
+     * @return The mean in microseconds, or 0 if nothing was recorded.
+     */
+    double Mean() const;
+
+    /**
+     * @brief Returns the largest recorded value, exactly.
+     * @return The maximum in microseconds, or 0 if nothing was recorded.
+     */
+    uint32_t Max() const;
+
+    /**
+     * @brief Returns the value below or at which the given percentage of all recorded values lie.
+     * @param percentile The percentile, from 0 to 100. Values outside are clamped.
+     * @return The highest value of the matching bucket in microseconds, at most Max(). 0 if nothing was recorded.
+     */
+    uint32_t Percentile(double percentile) const;
+
+protected:
+    static constexpr uint32_t BucketCount{(26 - SubBucketBits + 1) * SubBuckets}; //!< Number of buckets up to MaxValue.
+
+    /**
+     * @brief Calculates the bucket a value is counted in.
+     * @param value The value, at most MaxValue.
+     * @return The bucket index.
+     */
+    static uint32_t BucketIndex(uint32_t value);
+
+    /**
+     * @brief Calculates the highest value counted in a bucket.
+     * @param index The bucket index.
+     * @return The highest value of the bucket.
+     */
+    static uint32_t BucketMaxValue(uint32_t index);
+
+    std::array<uint32_t, BucketCount> _buckets{}; //!< Value count per bucket.
+    uint64_t _count{0}; //!< Total number of recorded values.
+    uint64_t _sum{0}; //!< Sum of all recorded values, for the mean.
+    uint32_t _max{0}; //!< Largest recorded value.
+};
@@ -0,0 +1,285 @@
+#include "LatencyProbe.h"
+
+#include "notifications/QuitNotification.h"
+
+#include <Poco/FileStream.h>
+#include <Poco/Format.h>
+#include <Poco/NotificationCenter.h>
+
+#include <Poco/Util/Application.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+
+// Draws a full-screen white outer border while the bass is well above its average, black otherwise.
+// No decay, warp, zoom or waveform, so each frame only shows the current audio level.
+constexpr char CalibrationPreset[] = R"([preset00]
+fDecay=0.000000
+fGammaAdj=1.000000
+fVideoEchoAlpha=0.000000
+fWaveAlpha=0.000000
+fWaveScale=0.010000
+bAdditiveWaves=0
+bWaveDots=0
+bModWaveAlphaByVolume=0
+bMaximizeWaveColor=0
+bTexWrap=0
+bDarkenCenter=0
+zoom=1.000000
+rot=0.000000
+warp=0.000000
+ob_size=0.500000
+ob_r=1.000000
+ob_g=1.000000
+ob_b=1.000000
+ob_a=0.000000
+ib_size=0.000000
+ib_a=0.000000
+per_frame_1=ob_a=above(bass,1.5);
+)";
+
+} // namespace
+
+constexpr int LatencyProbe::ProbeSize;
+constexpr double LatencyProbe::BaselineSmoothing;
+
+const char* LatencyProbe::name() const
+{
+    return "Latency Probe";
+}
+
+void LatencyProbe::initialize(Poco::Util::Application& app)
+{
+    _config = app.config().createView("latency");
+
+    _enabled = _config->getBool("enabled", false);
+    _impulseCount = std::max(1u, _config->getUInt("impulses", 20));
+    _threshold = _config->getDouble("threshold", 0.25);
+    _timeout = _config->getDouble("timeout", 0.5);
+    _reportFile = _config->getString("report", "");
+
+    _samples.reserve(_impulseCount);
+    _pixels.resize(ProbeSize * ProbeSize * 4);
+}
+
+void LatencyProbe::uninitialize()
+{
+}
+
+bool LatencyProbe::Enabled() const
+{
+    return _enabled;
+}
+
+void LatencyProbe::Start(projectm_handle projectMHandle)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    auto presetFile = _config->getString("preset", "");
+    if (presetFile.empty())
+    {
+        projectm_load_preset_data(projectMHandle, CalibrationPreset, false);
+    }
+    else
+    {
+        projectm_load_preset_file(projectMHandle, presetFile.c_str(), false);
+    }
+    projectm_set_preset_locked(projectMHandle, true);
+
+    poco_information_f1(_logger, "Measuring audio-to-photon latency over %?u impulses.", _impulseCount);
+}
+
+void LatencyProbe::ImpulseDelivered(double emitTime, double queueTime, double deliveryTime)
+{
+    if (!_enabled || _finished)
+    {
+        return;
+    }
+
+    if (_pending)
+    {
+        _missed++;
+        poco_debug(_logger, "Impulse delivered before the previous one was detected.");
+    }
+
+    _pending = true;
+    _emitTime = emitTime;
+    _queueTime = queueTime;
+    _deliveryTime = deliveryTime;
+}
+
+void LatencyProbe::FrameRendered(int width, int height)
+{
+    if (!_enabled || _finished)
+    {
+        return;
+    }
+
+    glFinish();
+    _renderTime = Now();
+
+    int size = std::min(ProbeSize, std::min(width, height));
+    if (size <= 0)
+    {
+        _luminance = 0.0;
+        return;
+    }
+
+    glReadPixels((width - size) / 2, (height - size) / 2, size, size, GL_RGBA, GL_UNSIGNED_BYTE, _pixels.data());
+
+    double sum{0.0};
+    auto pixelCount = static_cast<size_t>(size * size);
+    for (size_t pixel = 0; pixel < pixelCount; pixel++)
+    {
+        const auto* rgba = &_pixels[pixel * 4];
+        sum += 0.2126 * rgba[0] + 0.7152 * rgba[1] + 0.0722 * rgba[2];
+    }
+
+    _luminance = sum / (255.0 * static_cast<double>(pixelCount));
+}
+
+void LatencyProbe::FrameSwapped()
+{
+    if (!_enabled || _finished)
+    {
+        return;
+    }
+
+    // Most drivers only block in glFinish() until the swap has actually been performed.
+    glFinish();
+    auto swapTime = Now();
+
+    if (_baseline < 0.0)
+    {
+        _baseline = _luminance;
+    }
+
+    if (!_pending)
+    {
+        _baseline += BaselineSmoothing * (_luminance - _baseline);
+        return;
+    }
+
+    if (_luminance - _baseline > _threshold)
+    {
+        Sample sample;
+        sample.capture = _queueTime - _emitTime;
+        sample.backlog = _deliveryTime - _queueTime;
+        sample.render = _renderTime - _deliveryTime;
+        sample.swap = swapTime - _renderTime;
+        sample.total = swapTime - _emitTime;
+        _samples.push_back(sample);
+        _pending = false;
+
+        poco_debug_f2(_logger, "Impulse %?u detected, total latency %.1f ms.", _samples.size(), sample.total * 1000.0);
+    }
+    else if (swapTime - _deliveryTime > _timeout)
+    {
+        _missed++;
+        _pending = false;
+
+        poco_warning_f1(_logger, "No luminance spike detected within %.1f ms after the impulse was delivered.", _timeout * 1000.0);
+    }
+
+    if (_samples.size() + _missed >= _impulseCount)
+    {
+        _finished = true;
+        Report();
+        Poco::NotificationCenter::defaultCenter().postNotification(new QuitNotification);
+    }
+}
+
+double LatencyProbe::Now()
+{
+    return static_cast<double>(SDL_GetPerformanceCounter()) / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+void LatencyProbe::Report() const
+{
+    poco_information_f2(_logger, "Latency measurement finished: %?u impulses detected, %?u missed.", _samples.size(), _missed);
+
+    if (_samples.empty())
+    {
+        poco_error(_logger, "No impulse was detected. Check that the calibration preset reacts to the impulse source.");
+        return;
+    }
+
+    struct Stage
+    {
+        const char* name;
+        double Sample::*value;
+    };
+
+    static const Stage stages[]{
+        {"capture", &Sample::capture},
+        {"backlog", &Sample::backlog},
+        {"render", &Sample::render},
+        {"swap", &Sample::swap},
+        {"total", &Sample::total}};
+
+    for (const auto& stage : stages)
+    {
+        std::vector<double> values;
+        values.reserve(_samples.size());
+        for (const auto& sample : _samples)
+        {
+            values.push_back(sample.*stage.value * 1000.0);
+        }
+
+        poco_information(_logger, Poco::format("%-8s p50 %6.1f ms, p95 %6.1f ms, p99 %6.1f ms, max %6.1f ms",
+                                               std::string(stage.name),
+                                               Percentile(values, 50.0), Percentile(values, 95.0),
+                                               Percentile(values, 99.0), Percentile(values, 100.0)));
+    }
+
+    if (_reportFile.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        Poco::FileOutputStream report(_reportFile);
+        report << "impulse,capture_ms,backlog_ms,render_ms,swap_ms,total_ms\n"
+               << std::fixed << std::setprecision(3);
+
+        for (size_t index = 0; index < _samples.size(); index++)
+        {
+            const auto& sample = _samples[index];
+            report << index + 1 << ","
+                   << sample.capture * 1000.0 << ","
+                   << sample.backlog * 1000.0 << ","
+                   << sample.render * 1000.0 << ","
+                   << sample.swap * 1000.0 << ","
+                   << sample.total * 1000.0 << "\n";
+        }
+
+        poco_information_f1(_logger, R"(Wrote latency report to "%s".)", _reportFile);
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not write latency report to "%s": %s)", _reportFile, ex.displayText());
+    }
+}
+
+double LatencyProbe::Percentile(std::vector<double>& values, double percentile)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(values.size())));
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+}
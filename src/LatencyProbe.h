@@ -0,0 +1,131 @@
+#pragma once
+
+#include <projectM-4/projectM.h>
+
+#include <Poco/Logger.h>
+#include <Poco/Util/AbstractConfiguration.h>
+#include <Poco/Util/Subsystem.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Measures the audio-to-photon latency using the "impulse" audio source.
+ *
+ * If latency.enabled is true, a calibration preset which turns the whole screen white on strong bass is
+ * loaded and locked. The impulse source reports when each burst was recorded, queued and passed to
+ * projectM. After rendering, the probe reads back a small block of pixels from the center of the frame
+ * and detects the luminance spike caused by the burst. Each detected burst yields one sample with these
+ * stages:
+ *
+ * - capture: time from recording the first burst sample until its block was queued.
+ * - backlog: time the block waited in the sample ring until FillBuffer() passed it to projectM.
+ * - render: time from delivery until a frame showing the spike finished rendering.
+ * - swap: time until the buffer swap of that frame completed.
+ *
+ * After latency.impulses bursts, the percentiles of each stage are logged, optionally written to the
+ * latency.report file, and the application quits. All methods must be called on the render thread.
+ */
+class LatencyProbe : public Poco::Util::Subsystem
+{
+public:
+    const char* name() const override;
+
+    void initialize(Poco::Util::Application& app) override;
+
+    void uninitialize() override;
+
+    /**
+     * @brief Returns whether the latency measurement is active.
+     * @return true if latency.enabled is set.
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Loads and locks the calibration preset.
+     * @param projectMHandle The projectM instance used for rendering.
+     */
+    void Start(projectm_handle projectMHandle);
+
+    /**
+     * @brief Registers a burst which was just passed to projectM.
+     * @param emitTime Time the first burst sample was recorded.
+     * @param queueTime Time the sample block was written to the ring.
+     * @param deliveryTime Time the sample was passed to projectM.
+     */
+    void ImpulseDelivered(double emitTime, double queueTime, double deliveryTime);
+
+    /**
+     * @brief Waits for the rendered frame to finish and samples its luminance.
+     *
+     * Must be called after projectM has rendered the frame, but before any UI is drawn over it.
+     *
+     * @param width The drawable width.
+     * @param height The drawable height.
+     */
+    void FrameRendered(int width, int height);
+
+    /**
+     * @brief Waits for the buffer swap to finish and checks the frame for the burst's luminance spike.
+     */
+    void FrameSwapped();
+
+    /**
+     * @brief Returns the current time in seconds, as used by all timestamps passed to the probe.
+     * @return The SDL performance counter value in seconds.
+     */
+    static double Now();
+
+protected:
+    /**
+     * @brief Latency of a single detected burst, split into stages. All values in seconds.
+     */
+    struct Sample
+    {
+        double capture{0.0}; //!< Recording until queued.
+        double backlog{0.0}; //!< Queued until passed to projectM.
+        double render{0.0}; //!< Passed to projectM until the frame finished rendering.
+        double swap{0.0}; //!< Rendering finished until the swap completed.
+        double total{0.0}; //!< Recording until the swap completed.
+    };
+
+    /**
+     * @brief Logs the stage percentiles and writes the report file, if configured.
+     */
+    void Report() const;
+
+    /**
+     * @brief Returns the given percentile of a list of values using the nearest-rank method.
+     * @param values The values. Will be sorted.
+     * @param percentile The percentile, from 0 to 100.
+     * @return The percentile value, or 0 if the list is empty.
+     */
+    static double Percentile(std::vector<double>& values, double percentile);
+
+    static constexpr int ProbeSize{32}; //!< Edge length of the pixel block read back from the frame center.
+    static constexpr double BaselineSmoothing{0.1}; //!< Weight of the current frame in the luminance baseline.
+
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> _config; //!< View of the "latency" configuration subkey.
+
+    bool _enabled{false}; //!< True if latency.enabled is set.
+    unsigned int _impulseCount{20}; //!< Number of bursts to measure before quitting.
+    double _threshold{0.25}; //!< Luminance increase over the baseline which counts as a detection.
+    double _timeout{0.5}; //!< Max. time in seconds to wait for the spike after a burst was delivered.
+    std::string _reportFile; //!< Path of the CSV report file, empty to only log the results.
+
+    bool _pending{false}; //!< True if a delivered burst hasn't been detected yet.
+    double _emitTime{0.0}; //!< Recording time of the pending burst.
+    double _queueTime{0.0}; //!< Queue time of the pending burst.
+    double _deliveryTime{0.0}; //!< Delivery time of the pending burst.
+
+    double _renderTime{0.0}; //!< Time the last frame finished rendering.
+    double _luminance{0.0}; //!< Mean luminance of the last frame's center block, from 0 to 1.
+    double _baseline{-1.0}; //!< Smoothed luminance of frames without a burst, negative until the first frame.
+    bool _finished{false}; //!< True after all bursts have been measured.
+
+    std::vector<unsigned char> _pixels; //!< Preallocated readback buffer.
+    std::vector<Sample> _samples; //!< Measurements of all detected bursts.
+    unsigned int _missed{0}; //!< Number of bursts which didn't produce a spike in time.
+
+    Poco::Logger& _logger{Poco::Logger::get("LatencyProbe")}; //!< The class logger.
+};
@@ -0,0 +1,210 @@
+#include "MeshGovernor.h"
+
+#include <Poco/Format.h>
+#include <Poco/NumberParser.h>
+#include <Poco/StringTokenizer.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <algorithm>
+
+constexpr double MeshGovernor::SettleTime;
+constexpr double MeshGovernor::DecreaseDelay;
+constexpr double MeshGovernor::IncreaseDelay;
+constexpr double MeshGovernor::IncreaseLoad;
+constexpr double MeshGovernor::Smoothing;
+
+MeshGovernor::MeshGovernor(const Poco::Util::AbstractConfiguration& config, double now)
+    : _levelStartTime(now)
+{
+    _enabled = config.getBool("meshGovernor.enabled", false);
+    _configuredBudget = std::max(config.getDouble("meshGovernor.budget", 0.0), 0.0);
+    ParseLadder(config.getString("meshGovernor.ladder", "64x36,48x27,32x18"));
+    TargetFPS(config.getInt("fps", 60));
+
+    if (_enabled)
+    {
+        poco_information_f2(_logger, "Mesh governor enabled with a budget of %.1f ms and %?u smaller mesh sizes.",
+                            _budget, _ladderSizes.size());
+    }
+}
+
+double MeshGovernor::ThreadCpuTime()
+{
+#ifdef _WIN32
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return 0.0;
+    }
+
+    // Both are counted in 100 ns units.
+    auto ticks = (static_cast<uint64_t>(kernelTime.dwHighDateTime) << 32 | kernelTime.dwLowDateTime) +
+                 (static_cast<uint64_t>(userTime.dwHighDateTime) << 32 | userTime.dwLowDateTime);
+    return static_cast<double>(ticks) / 10000.0;
+#else
+    timespec time{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_nsec) / 1000000.0;
+#endif
+}
+
+bool MeshGovernor::Enabled() const
+{
+    return _enabled;
+}
+
+void MeshGovernor::Disable()
+{
+    _enabled = false;
+    _level = 0;
+    _presetLevels.clear();
+}
+
+void MeshGovernor::TargetFPS(int fps)
+{
+    if (_configuredBudget > 0.0)
+    {
+        _budget = _configuredBudget;
+        return;
+    }
+
+    // Leave the other half of the frame for the GPU work and everything else.
+    _budget = 500.0 / (fps > 0 ? fps : 60);
+}
+
+void MeshGovernor::ConfiguredMeshSize(size_t width, size_t height)
+{
+    if (!_levels.empty() && _levels.front() == MeshSize(width, height))
+    {
+        return;
+    }
+
+    _levels.clear();
+    _levels.emplace_back(width, height);
+    for (const auto& size : _ladderSizes)
+    {
+        if (size.first * size.second < width * height)
+        {
+            _levels.push_back(size);
+        }
+    }
+
+    _level = std::min(_level, _levels.size() - 1);
+}
+
+size_t MeshGovernor::MeshWidth() const
+{
+    return _levels.empty() ? 0 : _levels[_level].first;
+}
+
+size_t MeshGovernor::MeshHeight() const
+{
+    return _levels.empty() ? 0 : _levels[_level].second;
+}
+
+void MeshGovernor::PresetSwitched(const std::string& presetFile, double now)
+{
+    if (!_presetFile.empty())
+    {
+        _presetLevels[_presetFile] = _level;
+    }
+
+    _presetFile = presetFile;
+
+    auto storedLevel = _presetLevels.find(presetFile);
+    _level = storedLevel != _presetLevels.end() ? storedLevel->second : 0;
+    if (!_levels.empty())
+    {
+        _level = std::min(_level, _levels.size() - 1);
+    }
+
+    _renderTime = 0.0;
+    _levelStartTime = now;
+}
+
+void MeshGovernor::FrameRendered(double milliseconds, double now)
+{
+    if (!_enabled || _levels.size() < 2)
+    {
+        return;
+    }
+
+    auto elapsed = now - _levelStartTime;
+    if (elapsed < SettleTime)
+    {
+        return;
+    }
+
+    _renderTime = _renderTime > 0.0 ? _renderTime + Smoothing * (milliseconds - _renderTime) : milliseconds;
+    elapsed -= SettleTime;
+
+    if (_renderTime > _budget && elapsed >= DecreaseDelay && _level + 1 < _levels.size())
+    {
+        ChangeLevel(_level + 1, now);
+    }
+    else if (_level > 0 && elapsed >= IncreaseDelay &&
+             _renderTime * Vertices(_level - 1) / Vertices(_level) < IncreaseLoad * _budget)
+    {
+        ChangeLevel(_level - 1, now);
+    }
+}
+
+void MeshGovernor::ParseLadder(const std::string& ladder)
+{
+    Poco::StringTokenizer sizes(ladder, ",", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    for (const auto& size : sizes)
+    {
+        auto separator = size.find('x');
+
+        unsigned int width{0};
+        unsigned int height{0};
+        if (separator == std::string::npos ||
+            !Poco::NumberParser::tryParseUnsigned(size.substr(0, separator), width) ||
+            !Poco::NumberParser::tryParseUnsigned(size.substr(separator + 1), height) ||
+            width == 0 || height == 0)
+        {
+            poco_warning_f1(_logger, R"(Ignoring invalid mesh size "%s" in projectM.meshGovernor.ladder.)", size);
+            continue;
+        }
+
+        _ladderSizes.emplace_back(width, height);
+    }
+
+    std::sort(_ladderSizes.begin(), _ladderSizes.end(), [](const MeshSize& left, const MeshSize& right) {
+        return left.first * left.second > right.first * right.second;
+    });
+}
+
+void MeshGovernor::ChangeLevel(size_t level, double now)
+{
+    poco_information(_logger, Poco::format(R"(Preset "%s" took %.2f ms of %.2f ms, changing the mesh size from %?ux%?u to %?ux%?u.)",
+                                           _presetFile, _renderTime, _budget,
+                                           _levels[_level].first, _levels[_level].second,
+                                           _levels[level].first, _levels[level].second));
+
+    _level = level;
+    _renderTime = 0.0;
+    _levelStartTime = now;
+
+    if (!_presetFile.empty())
+    {
+        _presetLevels[_presetFile] = _level;
+    }
+}
+
+double MeshGovernor::Vertices(size_t level) const
+{
+    return static_cast<double>(_levels[level].first + 1) * static_cast<double>(_levels[level].second + 1);
+}
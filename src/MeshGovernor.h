@@ -0,0 +1,148 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <Poco/Util/AbstractConfiguration.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Lowers the warp mesh size of presets whose per-vertex code takes too much CPU time.
+ *
+ * Enabled with projectM.meshGovernor.enabled. The ladder starts with the configured projectM.meshX/meshY
+ * size, followed by all sizes from projectM.meshGovernor.ladder with fewer vertices, largest first.
+ *
+ * The CPU time the render thread spends in projectM's frame rendering is averaged per preset. CPU time
+ * instead of wall time is measured, so preemption by other threads and waiting for the GPU driver don't
+ * count against the preset, as only the per-vertex code scales with the mesh size. Work the driver does
+ * on the render thread is still included. Measuring starts SettleTime seconds after a preset switch or
+ * mesh change, so shader compilation and the mesh rebuild are ignored. Then, with hysteresis:
+ * - If the average exceeds the budget after DecreaseDelay seconds, the mesh is stepped down one level.
+ * - After IncreaseDelay seconds, it's stepped up one level if the time at the larger mesh, estimated
+ *   proportionally to the vertex count, stays below IncreaseLoad times the budget.
+ *
+ * The level chosen for each preset file is remembered for the rest of the session, so the next time the
+ * preset is displayed, it starts at that level. The budget is projectM.meshGovernor.budget milliseconds,
+ * or half the frame time at the frame rate the render loop passes to TargetFPS() each frame.
+ *
+ * All methods must be called on the render thread.
+ */
+class MeshGovernor
+{
+public:
+    static constexpr double SettleTime{1.0}; //!< Seconds after a preset switch or mesh change which aren't measured.
+    static constexpr double DecreaseDelay{1.0}; //!< Seconds of measurements before the mesh is stepped down.
+    static constexpr double IncreaseDelay{5.0}; //!< Seconds of measurements before the mesh is stepped up.
+    static constexpr double IncreaseLoad{0.7}; //!< Fraction of the budget the estimated time must stay below to step up.
+    static constexpr double Smoothing{0.05}; //!< Weight of a new measurement in the moving average.
+
+    /**
+     * @brief Reads the governor settings.
+     * @param config View of the "projectM" configuration subkey.
+     * @param now The current time in seconds, on the same clock as the times passed to the other methods.
+     */
+    MeshGovernor(const Poco::Util::AbstractConfiguration& config, double now);
+
+    /**
+     * @brief Returns the CPU time consumed by the calling thread.
+     *
+     * Uses CLOCK_THREAD_CPUTIME_ID, or GetThreadTimes() on Windows. The latter is only updated on each
+     * scheduler tick, so single measurements are coarse, but their moving average is not biased.
+     *
+     * @return The thread's CPU time in milliseconds, or 0 if it can't be determined.
+     */
+    static double ThreadCpuTime();
+
+    /**
+     * @brief Returns whether the governor is active.
+     * @return true if enabled in the configuration.
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Turns the governor off and returns to the configured mesh size.
+     */
+    void Disable();
+
+    /**
+     * @brief Sets the frame rate the budget is derived from, if not configured explicitly.
+     * @param fps The target frames per second, 0 or less for the default of 60.
+     */
+    void TargetFPS(int fps);
+
+    /**
+     * @brief Sets the configured mesh size, which is the top of the ladder.
+     * @param width Configured mesh width.
+     * @param height Configured mesh height.
+     */
+    void ConfiguredMeshSize(size_t width, size_t height);
+
+    /**
+     * @brief Returns the mesh width of the current level.
+     * @return The mesh width projectM should use.
+     */
+    size_t MeshWidth() const;
+
+    /**
+     * @brief Returns the mesh height of the current level.
+     * @return The mesh height projectM should use.
+     */
+    size_t MeshHeight() const;
+
+    /**
+     * @brief Remembers the current preset's level and continues with the level of the new preset.
+     * @param presetFile The file name of the new preset.
+     * @param now The current time in seconds.
+     */
+    void PresetSwitched(const std::string& presetFile, double now);
+
+    /**
+     * @brief Records the time it took to render a frame and adjusts the level if required.
+     * @param milliseconds The CPU time spent in projectM's frame rendering.
+     * @param now The current time in seconds.
+     */
+    void FrameRendered(double milliseconds, double now);
+
+protected:
+    using MeshSize = std::pair<size_t, size_t>; //!< Mesh width and height.
+
+    /**
+     * @brief Parses projectM.meshGovernor.ladder.
+     * @param ladder Comma-separated list of sizes like "64x36".
+     */
+    void ParseLadder(const std::string& ladder);
+
+    /**
+     * @brief Changes the current preset's level and restarts measuring.
+     * @param level The new level.
+     * @param now The current time in seconds.
+     */
+    void ChangeLevel(size_t level, double now);
+
+    /**
+     * @brief Returns the number of vertices of a level's mesh.
+     * @param level The ladder level.
+     * @return The vertex count.
+     */
+    double Vertices(size_t level) const;
+
+    bool _enabled{false}; //!< True if the governor is active.
+    double _configuredBudget{0.0}; //!< Budget from projectM.meshGovernor.budget in milliseconds, 0 if derived from the frame rate.
+    double _budget{0.0}; //!< Effective budget in milliseconds.
+
+    std::vector<MeshSize> _ladderSizes; //!< Sizes from projectM.meshGovernor.ladder, largest first.
+    std::vector<MeshSize> _levels; //!< The configured size followed by all smaller ladder sizes.
+    size_t _level{0}; //!< Current index into _levels.
+
+    std::string _presetFile; //!< File name of the current preset.
+    std::map<std::string, size_t> _presetLevels; //!< Level chosen for each preset file displayed in this session.
+
+    double _renderTime{0.0}; //!< Moving average of the render CPU time in milliseconds, 0 before the first measurement.
+    double _levelStartTime{0.0}; //!< Time of the last preset switch or level change in seconds.
+
+    Poco::Logger& _logger{Poco::Logger::get("MeshGovernor")}; //!< The class logger.
+};
@@ -0,0 +1,168 @@
+#include "OfflineRenderer.h"
+
+#include <Poco/Exception.h>
+#include <Poco/Format.h>
+
+#include <Poco/Util/Application.h>
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+
+constexpr double OfflineRenderer::ProgressInterval;
+
+namespace {
+
+constexpr int MaxReadbackBuffers{8}; //!< Upper limit of render.offline.readbackBuffers.
+
+} // namespace
+
+OfflineRenderer::OfflineRenderer()
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    _output = config.getString("render.offline.output", "");
+
+    // Same fallback as the file audio source, so both agree on the audio slice per frame.
+    _fps = config.getInt("projectM.fps", 60);
+    if (_fps <= 0)
+    {
+        _fps = 60;
+    }
+
+    _bufferCount = static_cast<size_t>(std::min(std::max(config.getInt("render.offline.readbackBuffers", 3), 1), MaxReadbackBuffers));
+
+    auto formatName = config.getString("render.offline.format", "y4m");
+    if (!VideoFrameWriter::ParseFormat(formatName, _format))
+    {
+        poco_warning_f1(_logger, R"(Unknown video format "%s", using "y4m".)", formatName);
+        _format = VideoFrameWriter::Format::Y4M;
+    }
+}
+
+bool OfflineRenderer::Enabled() const
+{
+    return !_output.empty();
+}
+
+int OfflineRenderer::FPS() const
+{
+    return _fps;
+}
+
+double OfflineRenderer::FrameTime() const
+{
+    return static_cast<double>(_framesRendered) / static_cast<double>(_fps);
+}
+
+bool OfflineRenderer::Start(int width, int height)
+{
+    try
+    {
+        _writer.reset(new VideoFrameWriter(_output, _format, width, height, _fps));
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not open video output "%s": %s)", _output, ex.displayText());
+        _writer.reset();
+        return false;
+    }
+
+    _readback.Create(width, height, _bufferCount);
+
+    _startTicks = SDL_GetPerformanceCounter();
+    _lastProgressTicks = _startTicks;
+
+    poco_information_f4(_logger, R"(Rendering a %?dx%?d video at %?d FPS to "%s".)", width, height, _fps, _output);
+
+    return true;
+}
+
+bool OfflineRenderer::FrameRendered(uint32_t framebuffer)
+{
+    if (!_writer)
+    {
+        return false;
+    }
+
+    if (_readback.Full() && !WriteOldestFrame())
+    {
+        return false;
+    }
+
+    _readback.Queue(framebuffer, _framesRendered);
+    _framesRendered++;
+
+    auto now = SDL_GetPerformanceCounter();
+    if (static_cast<double>(now - _lastProgressTicks) >= ProgressInterval * static_cast<double>(SDL_GetPerformanceFrequency()))
+    {
+        LogProgress(false);
+        _lastProgressTicks = now;
+    }
+
+    return true;
+}
+
+void OfflineRenderer::Finish()
+{
+    if (!_writer)
+    {
+        return;
+    }
+
+    while (_readback.Pending() && WriteOldestFrame())
+    {
+    }
+
+    _readback.Destroy();
+
+    if (!_writer->Close())
+    {
+        poco_error_f1(_logger, R"(The video written to "%s" is incomplete.)", _output);
+    }
+    _writer.reset();
+
+    LogProgress(true);
+}
+
+bool OfflineRenderer::WriteOldestFrame()
+{
+    uint64_t frameIndex{0};
+    const auto* pixels = _readback.MapOldest(frameIndex);
+    if (!pixels)
+    {
+        poco_error_f1(_logger, "Could not map the readback buffer of frame %?u.", frameIndex);
+        _readback.ReleaseOldest();
+        return false;
+    }
+
+    bool written = _writer->WriteFrame(pixels);
+    _readback.ReleaseOldest();
+
+    if (written)
+    {
+        _framesWritten++;
+    }
+
+    return written;
+}
+
+void OfflineRenderer::LogProgress(bool final)
+{
+    auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - _startTicks) /
+                   static_cast<double>(SDL_GetPerformanceFrequency());
+    auto videoTime = static_cast<double>(_framesWritten) / static_cast<double>(_fps);
+    auto renderFPS = elapsed > 0.0 ? static_cast<double>(_framesWritten) / elapsed : 0.0;
+    auto speed = elapsed > 0.0 ? videoTime / elapsed : 0.0;
+
+    if (final)
+    {
+        poco_information(_logger, Poco::format("Rendered %?u frames (%.1f seconds of video) in %.1f seconds: %.1f FPS, %.2fx real time.",
+                                               _framesWritten, videoTime, elapsed, renderFPS, speed));
+    }
+    else
+    {
+        poco_information_f3(_logger, "Rendered %.1f seconds of video, %.1f FPS, %.2fx real time.",
+                            videoTime, renderFPS, speed);
+    }
+}
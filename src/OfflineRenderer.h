@@ -0,0 +1,98 @@
+#pragma once
+
+#include "FrameReadback.h"
+#include "VideoFrameWriter.h"
+
+#include <Poco/Logger.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Renders an audio file into a video as fast as possible, instead of showing it in real time.
+ *
+ * Enabled by setting render.offline.output to a file name or an encoder command, see VideoFrameWriter.
+ * Together with the non-realtime file audio source, which passes exactly sampleRate / fps samples to projectM
+ * per frame, every frame shows a fixed slice of the audio, independent of how long rendering takes.
+ *
+ * Each frame is read back asynchronously through a FrameReadback ring of render.offline.readbackBuffers
+ * pixel buffer objects, so the GPU keeps rendering while earlier frames are converted and written.
+ *
+ * The progress and the achieved frame rate relative to real time are logged periodically and at the end.
+ *
+ * All methods must be called on the render thread with the OpenGL context current.
+ */
+class OfflineRenderer
+{
+public:
+    static constexpr double ProgressInterval{5.0}; //!< Seconds between two progress log messages.
+
+    OfflineRenderer();
+
+    /**
+     * @brief Returns whether offline rendering is configured.
+     * @return true if render.offline.output is set.
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Returns the frame rate of the rendered video.
+     * @return The video frame rate, taken from projectM.fps.
+     */
+    int FPS() const;
+
+    /**
+     * @brief Returns the position of the next frame in the video.
+     * @return The time of the next frame in seconds since the start of the video.
+     */
+    double FrameTime() const;
+
+    /**
+     * @brief Opens the video output and creates the readback buffers.
+     * @param width Width of the rendered frames.
+     * @param height Height of the rendered frames.
+     * @return true if the output was opened successfully.
+     */
+    bool Start(int width, int height);
+
+    /**
+     * @brief Queues the readback of a rendered frame and writes the oldest finished frame.
+     * @param framebuffer The framebuffer object the frame was rendered into, 0 for the default framebuffer.
+     * @return true if rendering can continue, false if the video output failed.
+     */
+    bool FrameRendered(uint32_t framebuffer);
+
+    /**
+     * @brief Writes all frames still in the readback ring, closes the output and logs the achieved speed.
+     */
+    void Finish();
+
+protected:
+    /**
+     * @brief Writes the oldest frame in the readback ring to the output.
+     * @return true if the frame was written.
+     */
+    bool WriteOldestFrame();
+
+    /**
+     * @brief Logs the number of frames written and the frame rate achieved since the start.
+     * @param final If true, the message is the final summary.
+     */
+    void LogProgress(bool final);
+
+    std::string _output; //!< Output file name or encoder command, empty if disabled.
+    VideoFrameWriter::Format _format{VideoFrameWriter::Format::Y4M}; //!< Video stream format.
+    int _fps{60}; //!< Frame rate of the video.
+    size_t _bufferCount{3}; //!< Number of frames in flight between rendering and writing.
+
+    std::unique_ptr<VideoFrameWriter> _writer; //!< The video output.
+    FrameReadback _readback; //!< Asynchronous readback of the rendered frames.
+
+    uint64_t _framesRendered{0}; //!< Number of frames queued for readback.
+    uint64_t _framesWritten{0}; //!< Number of frames written to the output.
+    uint64_t _startTicks{0}; //!< Performance counter value when rendering started.
+    uint64_t _lastProgressTicks{0}; //!< Performance counter value of the last progress message.
+
+    Poco::Logger& _logger{Poco::Logger::get("OfflineRenderer")}; //!< The class logger.
+};
@@ -5,6 +5,8 @@
 #include "ProjectMSDLApplication.h"
 
 #include "AudioCapture.h"
+#include "AudioTapeRecorder.h"
+#include "LatencyProbe.h"
 #include "ProjectMWrapper.h"
 #include "RenderLoop.h"
 #include "SDLRenderingWindow.h"
@@ -24,7 +26,9 @@ ProjectMSDLApplication::ProjectMSDLApplication()
     // Note: order here is important, as subsystems are initialized in the same order.
     addSubsystem(new SDLRenderingWindow);
     addSubsystem(new ProjectMWrapper);
+    addSubsystem(new LatencyProbe);
     addSubsystem(new AudioCapture);
+    addSubsystem(new AudioTapeRecorder);
     addSubsystem(new ProjectMGUI);
 }
 
@@ -130,10 +134,69 @@ void ProjectMSDLApplication::defineOptions(Poco::Util::OptionSet& options)
 
     options.addOption(Option("audioDevice", "d",
                              "Select an audio device to record from initially. Can be the numerical ID or the full device name. "
-                             "If the device is not found, the default device will be used instead.",
+                             "If the device is not found, the default device will be used instead. "
+                             "Use \"file:<path>\" to play a WAV or raw PCM file instead of recording, \"tape:<path>\" to replay "
+                             "an audio tape, or \"pipe:<path>\" to read raw PCM data from a named pipe. \"pipe:-\" reads from stdin.",
                              false, "<id or name>", true)
                           .binding("audio.device", _commandLineOverrides));
 
+    options.addOption(Option("audioBackend", "",
+                             "Select the audio capture backend, e.g. \"sdl\", \"wasapi\", \"pipewire\", \"pulse\", \"file\", \"tape\" or \"impulse\". "
+                             "Default is \"auto\", which uses the first backend that starts successfully.",
+                             false, "<name>", true)
+                          .binding("audio.backend", _commandLineOverrides));
+
+    options.addOption(Option("pcmFormat", "",
+                             "Sample format of PCM data read from a pipe, either \"f32\" (default) or \"s16\".",
+                             false, "<format>", true)
+                          .binding("audio.pipe.format", _commandLineOverrides));
+
+    options.addOption(Option("pcmChannels", "",
+                             "Number of interleaved channels in PCM data read from a pipe, 1 or 2. Default is 2.",
+                             false, "<count>", true)
+                          .binding("audio.pipe.channels", _commandLineOverrides));
+
+    options.addOption(Option("recordAudio", "",
+                             "Record the captured audio with its original callback sizes and timing to the given file. "
+                             "Replay it with the audio device \"tape:<path>\" to reproduce capture-related issues.",
+                             false, "<path>", true)
+                          .binding("audio.record.path", _commandLineOverrides));
+
+    options.addOption(Option("measureLatency", "",
+                             "Measure the audio-to-photon latency with the given number of test impulses, log the results and exit. "
+                             "Uses the \"impulse\" audio backend and a built-in calibration preset.",
+                             false, "<count>", true)
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::MeasureLatency)));
+
+    options.addOption(Option("latencyReport", "",
+                             "Write the individual latency measurements to the given CSV file.",
+                             false, "<path>", true)
+                          .binding("latency.report", _commandLineOverrides));
+
+    options.addOption(Option("renderVideo", "",
+                             "Render the audio file given with --audioDevice file:<path> into a video as fast as possible and exit. "
+                             "Writes a Y4M stream to the given file, or to the standard input of a command if it starts with \"|\".",
+                             false, "<output>", true)
+                          .callback(
+                              OptionCallback<ProjectMSDLApplication>(this, &ProjectMSDLApplication::RenderVideo)));
+
+    options.addOption(Option("videoFormat", "",
+                             "Video stream format for --renderVideo, \"y4m\" or \"raw\" RGBA frames. Default is y4m.",
+                             false, "<format>", true)
+                          .binding("render.offline.format", _commandLineOverrides));
+
+    options.addOption(Option("sharedMemoryOutput", "",
+                             "Publish each rendered frame to a shared memory ring with the given name, for other local processes.",
+                             false, "<name>", true)
+                          .binding("render.sharedMemory.name", _commandLineOverrides));
+
+    options.addOption(Option("frameStats", "",
+                             "Write frame time percentiles and render phase durations periodically to the given file, "
+                             "as CSV if it ends with \".csv\", otherwise as JSON lines.",
+                             false, "<path>", true)
+                          .binding("render.stats.path", _commandLineOverrides));
+
     options.addOption(Option("presetPath", "p", "Base directory to search for presets.",
                              false, "<path>", true)
                           .binding("projectM.presetPath", _commandLineOverrides));
@@ -150,6 +213,11 @@ void ProjectMSDLApplication::defineOptions(Poco::Util::OptionSet& options)
                              false, "<0/1>", true)
                           .binding("window.fullscreen", _commandLineOverrides));
 
+    options.addOption(Option("headless", "",
+                             "Render into an offscreen framebuffer of the configured window size, without a visible window or vertical sync.",
+                             false, "<0/1>", true)
+                          .binding("window.headless", _commandLineOverrides));
+
     options.addOption(Option("exclusive", "e",
                              "Use exclusive fullscreen mode. If true, this will change display resolution on most platforms to best match the window resolution.",
                              false, "<0/1>", true)
@@ -281,3 +349,21 @@ void ProjectMSDLApplication::ListAudioDevices(POCO_UNUSED const std::string& nam
 {
     _commandLineOverrides->setBool("audio.listDevices", true);
 }
+
+void ProjectMSDLApplication::MeasureLatency(POCO_UNUSED const std::string& name, const std::string& value)
+{
+    _commandLineOverrides->setBool("latency.enabled", true);
+    _commandLineOverrides->setString("latency.impulses", value);
+    _commandLineOverrides->setString("audio.backend", "impulse");
+    _commandLineOverrides->setBool("audio.backendFallback", false);
+}
+
+void ProjectMSDLApplication::RenderVideo(POCO_UNUSED const std::string& name, const std::string& value)
+{
+    _commandLineOverrides->setString("render.offline.output", value);
+    _commandLineOverrides->setBool("window.headless", true);
+    _commandLineOverrides->setString("audio.backend", "file");
+    _commandLineOverrides->setBool("audio.backendFallback", false);
+    _commandLineOverrides->setBool("audio.file.realtime", false);
+    _commandLineOverrides->setBool("audio.file.loop", false);
+}
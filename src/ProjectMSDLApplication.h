@@ -47,6 +47,20 @@ protected:
 
     void ListAudioDevices(const std::string& name, const std::string& value);
 
+    /**
+     * @brief Enables the latency measurement mode with the impulse audio source.
+     * @param name Unused.
+     * @param value The number of impulses to measure.
+     */
+    void MeasureLatency(const std::string& name, const std::string& value);
+
+    /**
+     * @brief Enables offline rendering of the audio file into a video, in a headless window.
+     * @param name Unused.
+     * @param value The output file name, or "|" followed by an encoder command.
+     */
+    void RenderVideo(const std::string& name, const std::string& value);
+
     Poco::AutoPtr<Poco::Util::PropertyFileConfiguration> _userConfiguration{
         new Poco::Util::PropertyFileConfiguration()}; //!< The current user's configuration, used to store/reset changes made in the UI's settings dialog.
     Poco::AutoPtr<Poco::Util::MapConfiguration> _commandLineOverrides{
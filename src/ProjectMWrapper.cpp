@@ -9,6 +9,13 @@
 #include <Poco/File.h>
 #include <Poco/NotificationCenter.h>
 
+#ifdef USE_GLEW
+#include <GL/glew.h>
+#else
+// Declares glBindFramebuffer().
+#define GL_GLEXT_PROTOTYPES
+#endif
+
 #include <SDL2/SDL_opengl.h>
 
 #include <cmath>
@@ -25,6 +32,14 @@ void ProjectMWrapper::initialize(Poco::Util::Application& app)
     _userConfig = projectMSDLApp.UserConfiguration();
     poco_information_f1(_logger, "Events enabled: %?d", _projectMConfigView->eventsEnabled());
 
+    _meshGovernor.reset(new MeshGovernor(*_projectMConfigView, Now()));
+    if (_meshGovernor->Enabled() && !app.config().getString("render.offline.output", "").empty())
+    {
+        // Render time doesn't matter in a video, so always use the configured mesh size.
+        poco_information(_logger, "The mesh governor is disabled while rendering a video.");
+        _meshGovernor->Disable();
+    }
+
     if (!_projectM)
     {
         auto& sdlWindow = app.getSubsystem<SDLRenderingWindow>();
@@ -53,7 +68,8 @@ void ProjectMWrapper::initialize(Poco::Util::Application& app)
 
         projectm_set_window_size(_projectM, canvasWidth, canvasHeight);
         projectm_set_fps(_projectM, fps);
-        projectm_set_mesh_size(_projectM, _projectMConfigView->getInt("meshX", 48), _projectMConfigView->getInt("meshY", 32));
+        _meshGovernor->ConfiguredMeshSize(_projectMConfigView->getUInt64("meshX", 48), _projectMConfigView->getUInt64("meshY", 32));
+        projectm_set_mesh_size(_projectM, _meshGovernor->MeshWidth(), _meshGovernor->MeshHeight());
         projectm_set_aspect_correction(_projectM, _projectMConfigView->getBool("aspectCorrectionEnabled", true));
         projectm_set_preset_locked(_projectM, _projectMConfigView->getBool("presetLocked", false));
 
@@ -148,26 +164,49 @@ int ProjectMWrapper::TargetFPS()
     return _projectMConfigView->getInt("fps", 60);
 }
 
+void ProjectMWrapper::MeshGovernorTargetFPS(int fps)
+{
+    _meshGovernor->TargetFPS(fps);
+}
+
 void ProjectMWrapper::UpdateRealFPS(float fps)
 {
     projectm_set_fps(_projectM, static_cast<uint32_t>(std::round(fps)));
 }
 
-void ProjectMWrapper::RenderFrame() const
+void ProjectMWrapper::FrameTime(POCO_UNUSED double seconds)
 {
+#if PROJECTM_VERSION_MAJOR > 4 || (PROJECTM_VERSION_MAJOR == 4 && PROJECTM_VERSION_MINOR >= 1)
+    projectm_set_frame_time(_projectM, seconds);
+#endif
+}
+
+void ProjectMWrapper::RenderFrame(uint32_t framebuffer)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
     glClearColor(0.0, 0.0, 0.0, 0.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     size_t currentMeshX{0};
     size_t currentMeshY{0};
     projectm_get_mesh_size(_projectM, &currentMeshX, &currentMeshY);
-    if (currentMeshX != _projectMConfigView->getInt("meshX", 220) ||
-        currentMeshY != _projectMConfigView->getInt("meshY", 125))
+    if (currentMeshX != _meshGovernor->MeshWidth() ||
+        currentMeshY != _meshGovernor->MeshHeight())
     {
-        projectm_set_mesh_size(_projectM, _projectMConfigView->getInt("meshX", 220), _projectMConfigView->getInt("meshY", 125));
+        projectm_set_mesh_size(_projectM, _meshGovernor->MeshWidth(), _meshGovernor->MeshHeight());
     }
 
+    auto renderStartTime = MeshGovernor::ThreadCpuTime();
+
+#if PROJECTM_VERSION_MAJOR > 4 || (PROJECTM_VERSION_MAJOR == 4 && PROJECTM_VERSION_MINOR >= 1)
+    projectm_opengl_render_frame_fbo(_projectM, framebuffer);
+#else
+    // Renders into the framebuffer bound above.
     projectm_opengl_render_frame(_projectM);
+#endif
+
+    // The per-vertex code runs on the CPU, so the CPU time spent in the call grows with the mesh size.
+    _meshGovernor->FrameRendered(MeshGovernor::ThreadCpuTime() - renderStartTime, Now());
 }
 
 void ProjectMWrapper::DisplayInitialPreset()
@@ -218,6 +257,7 @@ void ProjectMWrapper::PresetSwitchedEvent(bool isHardCut, unsigned int index, vo
     auto that = reinterpret_cast<ProjectMWrapper*>(context);
     auto presetName = projectm_playlist_item(that->_playlist, index);
     poco_information_f1(that->_logger, "Displaying preset: %s", std::string(presetName));
+    that->_meshGovernor->PresetSwitched(presetName, Now());
     projectm_playlist_free_string(presetName);
 
     Poco::NotificationCenter::defaultCenter().postNotification(new UpdateWindowTitleNotification);
@@ -263,6 +303,11 @@ void ProjectMWrapper::PlaybackControlNotificationHandler(const Poco::AutoPtr<Pla
     }
 }
 
+double ProjectMWrapper::Now()
+{
+    return static_cast<double>(SDL_GetPerformanceCounter()) / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
 std::vector<std::string> ProjectMWrapper::GetPathListWithDefault(const std::string& baseKey, const std::string& defaultPath)
 {
     using Poco::Util::AbstractConfiguration;
@@ -341,6 +386,8 @@ void ProjectMWrapper::OnConfigurationPropertyRemoved(const std::string& key)
 
     if (key == "projectM.meshX" || key == "projectM.meshY")
     {
-        projectm_set_mesh_size(_projectM, _projectMConfigView->getUInt64("meshX", 48), _projectMConfigView->getUInt64("meshY", 32));
+        // The configured size is the top of the governor's ladder, so it decides which size is actually used.
+        _meshGovernor->ConfiguredMeshSize(_projectMConfigView->getUInt64("meshX", 48), _projectMConfigView->getUInt64("meshY", 32));
+        projectm_set_mesh_size(_projectM, _meshGovernor->MeshWidth(), _meshGovernor->MeshHeight());
     }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "MeshGovernor.h"
+
 #include "notifications/PlaybackControlNotification.h"
 
 #include <projectM-4/projectM.h>
@@ -11,6 +13,7 @@
 #include <Poco/Util/AbstractConfiguration.h>
 #include <Poco/Util/Subsystem.h>
 
+#include <cstdint>
 #include <memory>
 
 class ProjectMWrapper : public Poco::Util::Subsystem
@@ -36,8 +39,12 @@ public:
 
     /**
      * Renders a single projectM frame.
+     *
+     * The mesh size is chosen by the mesh governor, which is fed the time projectM took to render.
+     *
+     * @param framebuffer The framebuffer object to render into, 0 for the window's default framebuffer.
      */
-    void RenderFrame() const;
+    void RenderFrame(uint32_t framebuffer);
 
     /**
      * @brief Returns the targeted FPS value.
@@ -45,12 +52,28 @@ public:
      */
     int TargetFPS();
 
+    /**
+     * @brief Sets the frame rate the mesh governor derives its render time budget from.
+     * @param fps The frame rate the render loop currently paces to, 0 if unlimited.
+     */
+    void MeshGovernorTargetFPS(int fps);
+
     /**
      * @brief Updates projectM with the current, actual FPS value.
      * @param fps The current FPS value.
      */
     void UpdateRealFPS(float fps);
 
+    /**
+     * @brief Sets the time of the next frame, so presets and transitions follow it instead of the wall clock.
+     *
+     * Used when rendering faster or slower than real time. Requires libprojectM 4.1 or higher, on older
+     * versions, projectM always uses the wall clock.
+     *
+     * @param seconds The time of the next frame in seconds since the first frame.
+     */
+    void FrameTime(double seconds);
+
     /**
      * @brief If splash is disabled, shows the initial preset.
      * If shuffle is on, a random preset will be picked. Otherwise, the first playlist item is displayed.
@@ -91,6 +114,12 @@ private:
 
     void PlaybackControlNotificationHandler(const Poco::AutoPtr<PlaybackControlNotification>& notification);
 
+    /**
+     * @brief Returns the current time in seconds, as passed to the mesh governor.
+     * @return The SDL performance counter value in seconds.
+     */
+    static double Now();
+
     std::vector<std::string> GetPathListWithDefault(const std::string& baseKey, const std::string& defaultPath);
 
     /**
@@ -110,6 +139,7 @@ private:
 
     projectm_handle _projectM{nullptr}; //!< Pointer to the projectM instance used by the application.
     projectm_playlist_handle _playlist{nullptr}; //!< Pointer to the projectM playlist manager instance.
+    std::unique_ptr<MeshGovernor> _meshGovernor; //!< Adapts the mesh size to each preset's render time.
 
     Poco::NObserver<ProjectMWrapper, PlaybackControlNotification> _playbackControlNotificationObserver{*this, &ProjectMWrapper::PlaybackControlNotificationHandler};
 
@@ -1,6 +1,7 @@
 #include "RenderLoop.h"
 
 #include "FPSLimiter.h"
+#include "ThreadScheduling.h"
 
 #include "gui/ProjectMGUI.h"
 
@@ -10,53 +11,188 @@
 
 #include <SDL2/SDL.h>
 
+#include <algorithm>
+#include <cstdlib>
+
 #include "ProjectMSDLApplication.h"
 
 RenderLoop::RenderLoop()
     : _audioCapture(Poco::Util::Application::instance().getSubsystem<AudioCapture>())
     , _projectMWrapper(Poco::Util::Application::instance().getSubsystem<ProjectMWrapper>())
     , _sdlRenderingWindow(Poco::Util::Application::instance().getSubsystem<SDLRenderingWindow>())
+    , _latencyProbe(Poco::Util::Application::instance().getSubsystem<LatencyProbe>())
     , _projectMHandle(_projectMWrapper.ProjectM())
     , _playlistHandle(_projectMWrapper.Playlist())
     , _projectMGui(Poco::Util::Application::instance().getSubsystem<ProjectMGUI>())
     , _userConfig(ProjectMSDLApplication::instance().UserConfiguration())
 {
+    auto& config = Poco::Util::Application::instance().config();
+
+    _idleTimeout = std::max(config.getDouble("render.idle.timeout", 0.0), 0.0);
+    _idleFPS = std::max(config.getInt("render.idle.fps", 5), 1);
+    _idleFreeze = config.getBool("render.idle.freeze", false);
+    _spinBudget = std::max(config.getDouble("render.spinBudget", 1.0), 0.0) / 1000.0;
+    _refreshRatePacing = config.getBool("window.refreshRatePacing", true);
+    _headless = _sdlRenderingWindow.Headless();
+
+    if (_latencyProbe.Enabled() || _offlineRenderer.Enabled())
+    {
+        // The gaps between test impulses must not throttle the measurement, and silence in a video must be rendered.
+        _idleTimeout = 0.0;
+    }
+
+    if (_offlineRenderer.Enabled() && _dynamicResolution.Enabled())
+    {
+        // Render time doesn't matter in a video, so always use the full resolution.
+        poco_information(_logger, "Dynamic resolution scaling is disabled while rendering a video.");
+        _dynamicResolution.Disable();
+    }
 }
 
 void RenderLoop::Run()
 {
+    ThreadScheduling::ForRender().ApplyToCurrentThread();
+
     FPSLimiter limiter;
+    limiter.SpinBudget(_spinBudget);
 
     auto& notificationCenter{Poco::NotificationCenter::defaultCenter()};
 
     notificationCenter.addObserver(_quitNotificationObserver);
 
     _projectMWrapper.DisplayInitialPreset();
+    _latencyProbe.Start(_projectMHandle);
+
+    if (_offlineRenderer.Enabled() && !StartOfflineRendering())
+    {
+        _wantsToQuit = true;
+    }
 
     while (!_wantsToQuit)
     {
-        limiter.TargetFPS(_projectMWrapper.TargetFPS());
+        UpdateIdleState();
+        UpdateFramePacing();
+
+        limiter.TargetFPS(_idle ? _idleFPS : _limiterFPS);
         limiter.StartFrame();
+        _frameStatistics.TargetFPS(_idle ? _idleFPS : _pacedFPS);
+        _dynamicResolution.TargetFPS(_idle ? _idleFPS : _pacedFPS);
+        _projectMWrapper.MeshGovernorTargetFPS(_idle ? _idleFPS : _pacedFPS);
+        _frameStatistics.StartFrame();
 
         PollEvents();
         CheckViewportSize();
+        _frameStatistics.EndPhase(FrameStatistics::Phase::PollEvents);
+
         _audioCapture.FillBuffer();
-        _projectMWrapper.RenderFrame();
-        _projectMGui.Draw();
+        _frameStatistics.EndPhase(FrameStatistics::Phase::FillBuffer);
+
+        if (_idle && _idleFreeze && !_redrawIdleFrame)
+        {
+            // Keep the last frame on screen. Events and audio are still processed at the idle frame rate.
+            _frameStatistics.DiscardFrame();
+            limiter.EndFrame();
+            continue;
+        }
+        _redrawIdleFrame = false;
+
+        if (_offlineRenderer.Enabled())
+        {
+            _projectMWrapper.FrameTime(_offlineRenderer.FrameTime());
+        }
+
+        // projectM renders at the scaled size, which is then upscaled into the render target.
+        auto renderTarget = _sdlRenderingWindow.RenderTarget();
+        _projectMWrapper.RenderFrame(_dynamicResolution.BeginFrame(renderTarget));
+        if (_dynamicResolution.EndFrame(renderTarget))
+        {
+            projectm_set_window_size(_projectMHandle, _dynamicResolution.RenderWidth(), _dynamicResolution.RenderHeight());
+        }
+        if (_dynamicResolution.Enabled())
+        {
+            _frameStatistics.ResolutionScale(_dynamicResolution.Scale(), _dynamicResolution.Budget());
+        }
+
+        _latencyProbe.FrameRendered(_renderWidth, _renderHeight);
+        if (_offlineRenderer.Enabled() && !_offlineRenderer.FrameRendered(renderTarget))
+        {
+            _wantsToQuit = true;
+        }
+        _sharedFrameOutput.FrameRendered(renderTarget, _renderWidth, _renderHeight);
+        _frameStatistics.EndPhase(FrameStatistics::Phase::RenderFrame);
+
+        if (!_headless)
+        {
+            _projectMGui.Draw();
+        }
+        _frameStatistics.EndPhase(FrameStatistics::Phase::GuiDraw);
 
         _sdlRenderingWindow.Swap();
+        _latencyProbe.FrameSwapped();
+        _frameStatistics.EndPhase(FrameStatistics::Phase::Swap);
 
         limiter.EndFrame();
 
-        // Pass projectM the actual FPS value of the last frame.
-        _projectMWrapper.UpdateRealFPS(limiter.FPS());
+        if (_idle)
+        {
+            _idleFramesRendered++;
+        }
+        else
+        {
+            _activeFPS = limiter.FPS();
+        }
+
+        if (_offlineRenderer.Enabled())
+        {
+            // Each frame covers exactly one frame's worth of audio, no matter how long it took to render.
+            _projectMWrapper.UpdateRealFPS(static_cast<float>(_offlineRenderer.FPS()));
+
+            if (_audioCapture.EndOfStream())
+            {
+                poco_information(_logger, "Reached the end of the audio file, finishing the video.");
+                _wantsToQuit = true;
+            }
+        }
+        else
+        {
+            // Pass projectM the actual FPS value of the last frame.
+            _projectMWrapper.UpdateRealFPS(limiter.FPS());
+        }
     }
 
     notificationCenter.removeObserver(_quitNotificationObserver);
 
+    _offlineRenderer.Finish();
+    _sharedFrameOutput.Stop();
+    _dynamicResolution.Destroy();
+    _frameStatistics.LogSummary();
+
     projectm_playlist_set_preset_switched_event_callback(_playlistHandle, nullptr, nullptr);
 }
 
+bool RenderLoop::StartOfflineRendering()
+{
+    // Only a non-looping file source ends, any other source would render forever.
+    if (_audioCapture.BackendName() != "file")
+    {
+        poco_error(_logger, R"(Rendering a video requires the "file" audio backend, set audio.device to "file:<path>".)");
+        return false;
+    }
+
+    auto& config = Poco::Util::Application::instance().config();
+    if (config.getBool("audio.file.realtime", true) || config.getBool("audio.file.loop", true))
+    {
+        poco_error(_logger, "Rendering a video requires audio.file.realtime and audio.file.loop to be disabled.");
+        return false;
+    }
+
+    int width;
+    int height;
+    _sdlRenderingWindow.GetDrawableSize(width, height);
+
+    return _offlineRenderer.Start(width, height);
+}
+
 void RenderLoop::PollEvents()
 {
     SDL_Event event;
@@ -194,6 +330,30 @@ void RenderLoop::PollEvents()
             }
 
 
+            case SDL_WINDOWEVENT:
+                if (event.window.event == SDL_WINDOWEVENT_MOVED ||
+                    event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+                    || event.window.event == SDL_WINDOWEVENT_DISPLAY_CHANGED
+#endif
+                )
+                {
+                    // The window may now be on another display, or in a fullscreen mode with a different refresh rate.
+                    _refreshRateChanged = true;
+                }
+                break;
+
+#if SDL_VERSION_ATLEAST(2, 0, 9)
+            case SDL_DISPLAYEVENT:
+                _refreshRateChanged = true;
+                break;
+#endif
+
+            case SDL_AUDIODEVICEADDED:
+            case SDL_AUDIODEVICEREMOVED:
+                _audioCapture.RefreshDeviceList();
+                break;
+
             case SDL_QUIT:
                 _wantsToQuit = true;
                 break;
@@ -209,16 +369,118 @@ void RenderLoop::CheckViewportSize()
 
     if (renderWidth != _renderWidth || renderHeight != _renderHeight)
     {
-        projectm_set_window_size(_projectMHandle, renderWidth, renderHeight);
+        _dynamicResolution.Resize(renderWidth, renderHeight);
+        projectm_set_window_size(_projectMHandle, _dynamicResolution.RenderWidth(), _dynamicResolution.RenderHeight());
         _renderWidth = renderWidth;
         _renderHeight = renderHeight;
 
         _projectMGui.UpdateFontSize();
+        _redrawIdleFrame = true;
 
         poco_debug_f2(_logger, "Resized rendering canvas to %?dx%?d.", renderWidth, renderHeight);
     }
 }
 
+void RenderLoop::UpdateFramePacing()
+{
+    if (_offlineRenderer.Enabled())
+    {
+        // Render as fast as possible. The video's frame rate only depends on the audio passed per frame.
+        _limiterFPS = 0;
+        _pacedFPS = 0;
+        return;
+    }
+
+    if (_refreshRateChanged)
+    {
+        _refreshRate = _sdlRenderingWindow.RefreshRate();
+        _refreshRateChanged = false;
+    }
+
+    auto targetFPS = _projectMWrapper.TargetFPS();
+    if (targetFPS == _pacingTargetFPS && _refreshRate == _pacingRefreshRate &&
+        _sdlRenderingWindow.SwapInterval() == _pacingSwapInterval)
+    {
+        return;
+    }
+
+    _pacingTargetFPS = targetFPS;
+    _pacingRefreshRate = _refreshRate;
+
+    if (!_refreshRatePacing || targetFPS <= 0 || _refreshRate <= 0)
+    {
+        _sdlRenderingWindow.SwapIntervalDivisor(1);
+        _pacingSwapInterval = _sdlRenderingWindow.SwapInterval();
+        _limiterFPS = targetFPS;
+        _pacedFPS = targetFPS;
+        return;
+    }
+
+    // Lock to the largest integer fraction of the refresh rate not above the target, so every frame is shown
+    // for the same number of refresh intervals and projectM.fps is never exceeded.
+    auto divisor = std::max((_refreshRate + targetFPS - 1) / targetFPS, 1);
+    _pacedFPS = _refreshRate / divisor;
+
+    _sdlRenderingWindow.SwapIntervalDivisor(divisor);
+    _pacingSwapInterval = _sdlRenderingWindow.SwapInterval();
+
+    // The driver may ignore or clamp the requested interval. Adaptive sync (-1) only counts as a single interval.
+    bool swapPaced = std::abs(_pacingSwapInterval) == divisor;
+    if (swapPaced)
+    {
+        // The swap waits for the vertical sync, so a software limiter would only add judder.
+        _limiterFPS = 0;
+    }
+    else
+    {
+        _limiterFPS = _pacedFPS;
+    }
+
+    poco_information_f4(_logger, "Pacing frames at %?d FPS, showing each for %?d refresh intervals of the %?d Hz display, using %s.",
+                        _pacedFPS, divisor, _refreshRate,
+                        std::string(swapPaced ? "vertical sync" : "the frame limiter"));
+}
+
+void RenderLoop::UpdateIdleState()
+{
+    if (_idleTimeout <= 0.0)
+    {
+        return;
+    }
+
+    bool idle = !_projectMGui.Visible() && _audioCapture.SilenceDuration() >= _idleTimeout;
+    if (idle == _idle)
+    {
+        return;
+    }
+
+    _idle = idle;
+
+    if (_idle)
+    {
+        _idleStartTicks = SDL_GetPerformanceCounter();
+        _idleFramesRendered = 0;
+
+        if (_idleFreeze)
+        {
+            poco_information_f1(_logger, "No audio signal for %.0f seconds, freezing the last frame.", _idleTimeout);
+        }
+        else
+        {
+            poco_information_f2(_logger, "No audio signal for %.0f seconds, reducing the frame rate to %?d FPS.",
+                                _idleTimeout, _idleFPS);
+        }
+        return;
+    }
+
+    auto idleTime = static_cast<double>(SDL_GetPerformanceCounter() - _idleStartTicks) /
+                    static_cast<double>(SDL_GetPerformanceFrequency());
+    auto fullRateFrames = static_cast<uint64_t>(idleTime * _activeFPS);
+
+    poco_information_f3(_logger, "Leaving idle mode after %.1f minutes. Rendered %?u frames instead of about %?u.",
+                        idleTime / 60.0, _idleFramesRendered, fullRateFrames);
+}
+
 void RenderLoop::KeyEvent(const SDL_KeyboardEvent& event, bool down)
 {
     auto keyModifier{static_cast<SDL_Keymod>(event.keysym.mod)};
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "AudioCapture.h"
+#include "DynamicResolution.h"
+#include "FrameStatistics.h"
+#include "LatencyProbe.h"
+#include "OfflineRenderer.h"
 #include "ProjectMWrapper.h"
 #include "SDLRenderingWindow.h"
+#include "SharedFrameOutput.h"
 
 #include "notifications/QuitNotification.h"
 
@@ -32,6 +37,12 @@ protected:
         bool _metaPressed{false}; //!< Logo/meta/command key
     };
 
+    /**
+     * @brief Checks the audio source and opens the video output if rendering offline.
+     * @return true if rendering can start, false if the video can't be rendered.
+     */
+    bool StartOfflineRendering();
+
     /**
      * @brief Polls all SDL events in the queue and takes action if required.
      */
@@ -39,9 +50,29 @@ protected:
 
     /**
      * @brief Checks if the GL viewport size has changed and if so, reconfigured projectM accordingly.
+     *
+     * projectM is set to the dynamic resolution's render size, which may be smaller than the viewport.
      */
     void CheckViewportSize();
 
+    /**
+     * @brief Locks the frame rate to an integer fraction of the display's refresh rate.
+     *
+     * Re-evaluated if projectM.fps, the effective swap interval or the display's refresh rate changes. The swap
+     * interval is set to the refresh rate divisor. Only if the driver actually uses that interval, the software
+     * frame limiter is disabled, so both don't work against each other. Otherwise, the limiter runs at the locked rate.
+     */
+    void UpdateFramePacing();
+
+    /**
+     * @brief Enters or leaves idle mode depending on how long the audio input has been silent.
+     *
+     * Idle mode is entered after render.idle.timeout seconds of silence and left as soon as the audio
+     * capture receives a block above the silence threshold. Both transitions are logged, together with the
+     * number of frames saved while idle.
+     */
+    void UpdateIdleState();
+
     /**
      * @brief Handles SDL key press events.
      * @param event The key event.
@@ -75,6 +106,7 @@ protected:
     AudioCapture& _audioCapture;
     ProjectMWrapper& _projectMWrapper;
     SDLRenderingWindow& _sdlRenderingWindow;
+    LatencyProbe& _latencyProbe;
 
     projectm_handle _projectMHandle{nullptr};
     projectm_playlist_handle _playlistHandle{nullptr};
@@ -92,6 +124,32 @@ protected:
 
     ModifierKeyStates _keyStates; //!< Current "pressed" states of modifier keys
 
+    FrameStatistics _frameStatistics; //!< Frame time and render phase statistics.
+    OfflineRenderer _offlineRenderer; //!< Writes the frames to a video if render.offline.output is set.
+    SharedFrameOutput _sharedFrameOutput; //!< Publishes the frames to shared memory if render.sharedMemory.name is set.
+    DynamicResolution _dynamicResolution; //!< Lowers projectM's render resolution if it exceeds the frame time budget.
+
+    bool _headless{false}; //!< If true, there's no visible window, so the GUI isn't drawn.
+    bool _refreshRatePacing{true}; //!< If true, the frame rate is locked to an integer fraction of the refresh rate.
+    bool _refreshRateChanged{true}; //!< Set if the display's refresh rate needs to be queried again.
+    int _refreshRate{0}; //!< Refresh rate of the window's display in Hz, 0 if unknown.
+    int _pacingTargetFPS{-1}; //!< projectM.fps value the current pacing was calculated for.
+    int _pacingRefreshRate{-1}; //!< Refresh rate the current pacing was calculated for.
+    int _pacingSwapInterval{-2}; //!< Effective swap interval the current pacing was calculated for.
+    int _pacedFPS{0}; //!< Effective frame rate, used to detect dropped frames. 0 if unlimited.
+    int _limiterFPS{0}; //!< Frame rate passed to the software frame limiter. 0 if vertical sync paces the frames.
+
+    double _spinBudget{0.001}; //!< Seconds the frame limiter busy-waits before each deadline.
+
+    double _idleTimeout{0.0}; //!< Seconds of silence after which idle mode is entered. 0 disables idle mode.
+    int _idleFPS{5}; //!< Frame rate while idle.
+    bool _idleFreeze{false}; //!< If true, nothing is rendered while idle and the last frame stays on screen.
+    bool _idle{false}; //!< True while in idle mode.
+    bool _redrawIdleFrame{false}; //!< Set if a frozen frame must be rendered once more, e.g. after a resize.
+    uint64_t _idleStartTicks{0}; //!< Performance counter value when idle mode was entered.
+    uint64_t _idleFramesRendered{0}; //!< Number of frames rendered since idle mode was entered.
+    float _activeFPS{0.0f}; //!< Measured frame rate outside of idle mode, used to estimate the saved frames.
+
     Poco::AutoPtr<Poco::Util::AbstractConfiguration> _userConfig; //!< View of the "projectM" configuration subkey in the "user" configuration.
 
     Poco::Logger& _logger{Poco::Logger::get("RenderLoop")}; //!< The class logger.
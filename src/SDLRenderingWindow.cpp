@@ -4,16 +4,22 @@
 #include "ProjectMWrapper.h"
 
 #include <Poco/Delegate.h>
+#include <Poco/Format.h>
 #include <Poco/NotificationCenter.h>
 
 #include <Poco/Util/Application.h>
 
 #ifdef USE_GLEW
 #include <GL/glew.h>
+#else
+// Declares the framebuffer object functions used in headless mode.
+#define GL_GLEXT_PROTOTYPES
 #endif
 
 #include <SDL2/SDL_opengl.h>
 
+#include <algorithm>
+
 const char* SDLRenderingWindow::name() const
 {
     return "SDL2 Rendering Window";
@@ -24,6 +30,7 @@ void SDLRenderingWindow::initialize(Poco::Util::Application& app)
     auto& projectMSDLApp = dynamic_cast<ProjectMSDLApplication&>(app);
     _userConfig = projectMSDLApp.UserConfiguration();
     _config = app.config().createView("window");
+    _headless = _config->getBool("headless", false);
 
     if (!_renderingWindow)
     {
@@ -52,16 +59,44 @@ void SDLRenderingWindow::uninitialize()
 
 void SDLRenderingWindow::GetDrawableSize(int& width, int& height) const
 {
+    if (_headless)
+    {
+        width = _framebufferWidth;
+        height = _framebufferHeight;
+        return;
+    }
+
     SDL_GL_GetDrawableSize(_renderingWindow, &width, &height);
 }
 
 void SDLRenderingWindow::Swap() const
 {
+    if (_headless)
+    {
+        glFlush();
+        return;
+    }
+
     SDL_GL_SwapWindow(_renderingWindow);
 }
 
+bool SDLRenderingWindow::Headless() const
+{
+    return _headless;
+}
+
+uint32_t SDLRenderingWindow::RenderTarget() const
+{
+    return _framebuffer;
+}
+
 void SDLRenderingWindow::ToggleFullscreen()
 {
+    if (_headless)
+    {
+        return;
+    }
+
     if (_fullscreen)
     {
         Windowed();
@@ -134,6 +169,11 @@ void SDLRenderingWindow::ShowCursor(bool visible)
 
 void SDLRenderingWindow::NextDisplay()
 {
+    if (_headless)
+    {
+        return;
+    }
+
     auto numDisplays = SDL_GetNumVideoDisplays();
 
     if (numDisplays < 2)
@@ -196,7 +236,22 @@ void SDLRenderingWindow::NextDisplay()
 
 void SDLRenderingWindow::CreateSDLWindow()
 {
-    SDL_InitSubSystem(SDL_INIT_VIDEO);
+    if (_headless && !SDL_getenv("SDL_VIDEODRIVER"))
+    {
+        // The offscreen driver creates an EGL pbuffer or surfaceless context, so no display server is required.
+        SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+        if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0)
+        {
+            poco_warning_f1(_logger, "Offscreen video driver not available, using a hidden window instead: %s",
+                            std::string(SDL_GetError()));
+            SDL_setenv("SDL_VIDEODRIVER", "", 1);
+        }
+    }
+
+    if (!SDL_WasInit(SDL_INIT_VIDEO))
+    {
+        SDL_InitSubSystem(SDL_INIT_VIDEO);
+    }
 
     int width{_config->getInt("width", 800)};
     int height{_config->getInt("height", 600)};
@@ -249,8 +304,9 @@ void SDLRenderingWindow::CreateSDLWindow()
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 #endif
 
-    _renderingWindow = SDL_CreateWindow("projectM", left, top, width, height,
-                                        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+    Uint32 windowFlags = _headless ? SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+                                   : SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI;
+    _renderingWindow = SDL_CreateWindow("projectM", left, top, width, height, windowFlags);
     if (!_renderingWindow)
     {
         auto errorMessage = "Could not create SDL rendering window. Error: " + std::string(SDL_GetError());
@@ -282,7 +338,14 @@ void SDLRenderingWindow::CreateSDLWindow()
     poco_debug_f1(_logger, "Initialized GLEW: %s", std::string(reinterpret_cast<const char*>(glewGetString(GLEW_VERSION))));
 #endif
 
-    if (_config->getBool("fullscreen", false))
+    if (_headless)
+    {
+        CreateRenderTarget(width, height);
+
+        poco_information_f3(_logger, "Rendering headless into a %?dx%?d framebuffer using the \"%s\" video driver.",
+                            width, height, std::string(SDL_GetCurrentVideoDriver()));
+    }
+    else if (_config->getBool("fullscreen", false))
     {
         Fullscreen();
     }
@@ -301,6 +364,8 @@ void SDLRenderingWindow::DestroySDLWindow()
 {
     poco_debug(_logger, "Closing rendering window and destroying OpenGL context.");
 
+    DestroyRenderTarget();
+
     SDL_GL_DeleteContext(_glContext);
     _glContext = nullptr;
 
@@ -310,6 +375,62 @@ void SDLRenderingWindow::DestroySDLWindow()
     SDL_QuitSubSystem(SDL_INIT_VIDEO);
 }
 
+void SDLRenderingWindow::CreateRenderTarget(int width, int height)
+{
+    _framebufferWidth = width;
+    _framebufferHeight = height;
+
+    // Plain RGBA texture and 16 bit depth, which are available in all supported OpenGL and GLES versions.
+    glGenTextures(1, &_colorTexture);
+    glBindTexture(GL_TEXTURE_2D, _colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+
+    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        auto errorMessage = Poco::format("Could not create the headless framebuffer. Status: 0x%04x", static_cast<unsigned int>(status));
+        poco_fatal(_logger, errorMessage);
+        throw Poco::Exception(errorMessage);
+    }
+
+    glViewport(0, 0, width, height);
+}
+
+void SDLRenderingWindow::DestroyRenderTarget()
+{
+    if (_framebuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &_framebuffer);
+        _framebuffer = 0;
+    }
+
+    if (_depthBuffer)
+    {
+        glDeleteRenderbuffers(1, &_depthBuffer);
+        _depthBuffer = 0;
+    }
+
+    if (_colorTexture)
+    {
+        glDeleteTextures(1, &_colorTexture);
+        _colorTexture = 0;
+    }
+}
+
 void SDLRenderingWindow::DumpOpenGLInfo()
 {
     poco_debug_f1(_logger, "- GL_VERSION: %s", std::string(reinterpret_cast<const char*>(glGetString(GL_VERSION))));
@@ -372,6 +493,46 @@ void SDLRenderingWindow::GetWindowPosition(int& left, int& top, bool relative)
     top -= bounds.y;
 }
 
+int SDLRenderingWindow::RefreshRate() const
+{
+    if (_headless)
+    {
+        return 0;
+    }
+
+    SDL_DisplayMode mode{};
+    if (SDL_GetWindowDisplayMode(_renderingWindow, &mode) == 0 && mode.refresh_rate > 0)
+    {
+        return mode.refresh_rate;
+    }
+
+    // In windowed mode, some drivers only report the refresh rate of the desktop mode.
+    auto displayIndex = SDL_GetWindowDisplayIndex(_renderingWindow);
+    if (displayIndex >= 0 && SDL_GetCurrentDisplayMode(displayIndex, &mode) == 0)
+    {
+        return mode.refresh_rate;
+    }
+
+    return 0;
+}
+
+int SDLRenderingWindow::SwapInterval() const
+{
+    return _swapInterval;
+}
+
+void SDLRenderingWindow::SwapIntervalDivisor(int divisor)
+{
+    divisor = std::max(divisor, 1);
+    if (divisor == _swapIntervalDivisor)
+    {
+        return;
+    }
+
+    _swapIntervalDivisor = divisor;
+    UpdateSwapInterval();
+}
+
 SDL_Window* SDLRenderingWindow::GetRenderingWindow() const
 {
     return _renderingWindow;
@@ -417,21 +578,31 @@ void SDLRenderingWindow::UpdateWindowTitle()
 
 void SDLRenderingWindow::UpdateSwapInterval()
 {
-    if (!_config->getBool("waitForVerticalSync", true))
+    if (_headless || !_config->getBool("waitForVerticalSync", true))
     {
         SDL_GL_SetSwapInterval(0);
+        _swapInterval = 0;
         return;
     }
 
-    if (_config->getBool("adaptiveVerticalSync", true))
+    if (_swapIntervalDivisor > 1)
+    {
+        if (SDL_GL_SetSwapInterval(_swapIntervalDivisor) == 0)
+        {
+            _swapInterval = SDL_GL_GetSwapInterval();
+            return;
+        }
+    }
+    else if (_config->getBool("adaptiveVerticalSync", true))
     {
         if (SDL_GL_SetSwapInterval(-1) == 0)
         {
+            _swapInterval = SDL_GL_GetSwapInterval();
             return;
         }
     }
 
-    SDL_GL_SetSwapInterval(1);
+    _swapInterval = SDL_GL_SetSwapInterval(1) == 0 ? SDL_GL_GetSwapInterval() : 0;
 }
 
 void SDLRenderingWindow::OnConfigurationPropertyChanged(const Poco::Util::AbstractConfiguration::KeyValue& property)
@@ -10,6 +10,8 @@
 #include <Poco/Util/Subsystem.h>
 #include <Poco/Util/AbstractConfiguration.h>
 
+#include <cstdint>
+
 struct projectm;
 
 class SDLRenderingWindow : public Poco::Util::Subsystem
@@ -33,10 +35,22 @@ public:
     void GetDrawableSize(int& width, int& height) const;
 
     /**
-     * Swaps the OpenGL front- and back buffers.
+     * Swaps the OpenGL front- and back buffers. In headless mode, only flushes the rendering commands.
      */
     void Swap() const;
 
+    /**
+     * @brief Returns whether rendering goes to an offscreen framebuffer instead of a visible window.
+     * @return true if window.headless is set.
+     */
+    bool Headless() const;
+
+    /**
+     * @brief Returns the OpenGL framebuffer object frames should be rendered to.
+     * @return The headless framebuffer, or 0 for the window's default framebuffer.
+     */
+    uint32_t RenderTarget() const;
+
     /**
      * @brief Toggles the window's fullscreen mode.
      *
@@ -92,6 +106,31 @@ public:
      */
     void GetWindowPosition(int& left, int& top, bool relative = false);
 
+    /**
+     * @brief Returns the refresh rate of the display the window is currently shown on.
+     * @return The refresh rate in Hz, or 0 if the driver doesn't report it.
+     */
+    int RefreshRate() const;
+
+    /**
+     * @brief Returns the swap interval the OpenGL context actually uses.
+     *
+     * Read back from the driver after setting it, as some drivers accept an interval without honoring it.
+     *
+     * @return The number of vertical syncs per buffer swap, -1 for adaptive vertical sync or 0 if disabled.
+     */
+    int SwapInterval() const;
+
+    /**
+     * @brief Makes buffer swaps wait for the given number of vertical syncs, if vertical sync is enabled.
+     *
+     * Used to run at an integer fraction of the refresh rate, e.g. 72 FPS on a 144 Hz display. Adaptive
+     * vertical sync only supports a single interval, so it is not used if the divisor is larger than 1.
+     *
+     * @param divisor The number of refresh intervals per frame.
+     */
+    void SwapIntervalDivisor(int divisor);
+
     SDL_Window* GetRenderingWindow() const;
 
     SDL_GLContext GetGlContext() const;
@@ -108,6 +147,18 @@ protected:
      */
     void DestroySDLWindow();
 
+    /**
+     * @brief Creates the framebuffer object used in headless mode.
+     * @param width The framebuffer width in pixels.
+     * @param height The framebuffer height in pixels.
+     */
+    void CreateRenderTarget(int width, int height);
+
+    /**
+     * @brief Deletes the headless framebuffer object and its attachments.
+     */
+    void DestroyRenderTarget();
+
     /**
      * Prints OpenGL debug information.
      */
@@ -156,6 +207,16 @@ protected:
 
     bool _fullscreen{ false };
 
+    bool _headless{ false }; //!< If true, the window is hidden and frames are rendered to _framebuffer.
+    int _framebufferWidth{ 0 }; //!< Width of the headless framebuffer.
+    int _framebufferHeight{ 0 }; //!< Height of the headless framebuffer.
+    uint32_t _framebuffer{ 0 }; //!< Headless framebuffer object.
+    uint32_t _colorTexture{ 0 }; //!< Color attachment of the headless framebuffer.
+    uint32_t _depthBuffer{ 0 }; //!< Depth attachment of the headless framebuffer.
+
+    int _swapIntervalDivisor{ 1 }; //!< Refresh intervals per frame requested by the render loop.
+    int _swapInterval{ 0 }; //!< Swap interval currently active in the OpenGL context, as reported by the driver.
+
 };
 
 
@@ -0,0 +1,166 @@
+#include "SharedFrameOutput.h"
+
+#include <Poco/Exception.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace {
+
+constexpr int MaxReadbackBuffers{8}; //!< Upper limit of render.sharedMemory.readbackBuffers.
+
+} // namespace
+
+SharedFrameOutput::SharedFrameOutput()
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    _name = config.getString("render.sharedMemory.name", "");
+    _bufferCount = static_cast<size_t>(std::min(std::max(config.getInt("render.sharedMemory.readbackBuffers", 2), 1), MaxReadbackBuffers));
+}
+
+bool SharedFrameOutput::Enabled() const
+{
+    return !_name.empty();
+}
+
+void SharedFrameOutput::FrameRendered(uint32_t framebuffer, int width, int height)
+{
+    if (!Enabled() || _failed || width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    if (width != _readback.Width() || height != _readback.Height())
+    {
+        while (_readback.Pending())
+        {
+            PublishOldestFrame();
+        }
+        _readback.Create(width, height, _bufferCount);
+    }
+
+    if (_readback.Full())
+    {
+        PublishOldestFrame();
+    }
+
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    _readback.Queue(framebuffer, static_cast<uint64_t>(timestamp));
+}
+
+void SharedFrameOutput::Stop()
+{
+    if (!_readback.Created())
+    {
+        return;
+    }
+
+    while (_readback.Pending() && !_failed)
+    {
+        PublishOldestFrame();
+    }
+    _readback.Destroy();
+
+    if (_header)
+    {
+        poco_information_f2(_logger, R"(Published %?u frames to shared memory "%s".)", _sequence, _name);
+    }
+
+    CloseSegment();
+}
+
+void SharedFrameOutput::PublishOldestFrame()
+{
+    uint64_t timestamp{0};
+    const auto* pixels = _readback.MapOldest(timestamp);
+    if (pixels)
+    {
+        Publish(pixels, _readback.Width(), _readback.Height(), timestamp);
+    }
+    else
+    {
+        poco_warning(_logger, "Could not map a readback buffer, skipping the frame.");
+    }
+    _readback.ReleaseOldest();
+}
+
+void SharedFrameOutput::Publish(const uint8_t* pixels, int width, int height, uint64_t timestamp)
+{
+    auto size = static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4;
+    if ((!_header || size > _header->slotCapacity) && !CreateSegment(size))
+    {
+        return;
+    }
+
+    _sequence++;
+    auto& slot = _header->slots[_sequence % SharedFrameRing::SlotCount];
+
+    // Invalidate the slot first, so readers still using the frame it held notice it was overwritten.
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(_segment->begin() + slot.dataOffset, pixels, size);
+    slot.timestamp = timestamp;
+    slot.size = size;
+    slot.width = static_cast<uint32_t>(width);
+    slot.height = static_cast<uint32_t>(height);
+    slot.stride = static_cast<uint32_t>(width) * 4;
+    slot.pixelFormat = static_cast<uint32_t>(SharedFrameRing::PixelFormat::RGBA8BottomUp);
+
+    slot.sequence.store(_sequence, std::memory_order_release);
+    _header->latestSequence.store(_sequence, std::memory_order_release);
+}
+
+bool SharedFrameOutput::CreateSegment(uint64_t slotCapacity)
+{
+    CloseSegment();
+
+    auto segmentSize = SharedFrameRing::SegmentSize(slotCapacity);
+    try
+    {
+        _segment.reset(new Poco::SharedMemory(_name, static_cast<std::size_t>(segmentSize), Poco::SharedMemory::AM_WRITE));
+    }
+    catch (Poco::Exception& ex)
+    {
+        poco_error_f2(_logger, R"(Could not create shared memory "%s": %s. Disabling the shared memory output.)", _name, ex.displayText());
+        _segment.reset();
+        _failed = true;
+        return false;
+    }
+
+    // Value-initialization zeroes all fields, including the atomics.
+    _header = new (_segment->begin()) SharedFrameRing::Header();
+    std::memcpy(_header->magic, SharedFrameRing::Magic, sizeof(_header->magic));
+    _header->version = SharedFrameRing::Version;
+    _header->slotCount = SharedFrameRing::SlotCount;
+    _header->slotCapacity = slotCapacity;
+
+    for (uint32_t index = 0; index < SharedFrameRing::SlotCount; index++)
+    {
+        _header->slots[index].dataOffset = SharedFrameRing::DataOffset() + index * SharedFrameRing::SlotStride(slotCapacity);
+    }
+
+    _header->state.store(static_cast<uint32_t>(SharedFrameRing::State::Active), std::memory_order_release);
+
+    poco_information_f2(_logger, R"(Publishing frames to shared memory "%s", %.1f MiB.)",
+                        _name, static_cast<double>(segmentSize) / (1024.0 * 1024.0));
+
+    return true;
+}
+
+void SharedFrameOutput::CloseSegment()
+{
+    if (_header)
+    {
+        _header->state.store(static_cast<uint32_t>(SharedFrameRing::State::Closed), std::memory_order_release);
+        _header = nullptr;
+    }
+
+    // The segment was created by this process, so destroying it also removes the name.
+    _segment.reset();
+}
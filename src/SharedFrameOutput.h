@@ -0,0 +1,88 @@
+#pragma once
+
+#include "FrameReadback.h"
+#include "SharedFrameRing.h"
+
+#include <Poco/Logger.h>
+#include <Poco/SharedMemory.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Publishes each rendered frame to a shared memory ring for other local processes, e.g. VJ software.
+ *
+ * Enabled by setting render.sharedMemory.name. The segment is created with that name, which on POSIX
+ * systems is a shm_open() object named "/<name>". See SharedFrameRing for the layout and the protocol
+ * readers have to follow.
+ *
+ * Frames are read back asynchronously through render.sharedMemory.readbackBuffers pixel buffer objects,
+ * then copied once into the next of the three slots. Readers use the pixels directly in the segment. The
+ * frames are taken before the GUI overlay is drawn, so they only show the visualization.
+ *
+ * All methods must be called on the render thread with the OpenGL context current.
+ */
+class SharedFrameOutput
+{
+public:
+    SharedFrameOutput();
+
+    /**
+     * @brief Returns whether the shared memory output is configured.
+     * @return true if render.sharedMemory.name is set.
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Queues the readback of a rendered frame and publishes the oldest finished frame.
+     * @param framebuffer The framebuffer object the frame was rendered into, 0 for the default framebuffer.
+     * @param width Width of the frame in pixels.
+     * @param height Height of the frame in pixels.
+     */
+    void FrameRendered(uint32_t framebuffer, int width, int height);
+
+    /**
+     * @brief Publishes the remaining frames, marks the segment as closed and removes it.
+     */
+    void Stop();
+
+protected:
+    /**
+     * @brief Maps the oldest frame in the readback ring and publishes it.
+     */
+    void PublishOldestFrame();
+
+    /**
+     * @brief Copies a frame into the next slot and makes it visible to readers.
+     * @param pixels RGBA pixels, bottom row first.
+     * @param width Frame width in pixels.
+     * @param height Frame height in pixels.
+     * @param timestamp Render time in nanoseconds of the monotonic clock.
+     */
+    void Publish(const uint8_t* pixels, int width, int height, uint64_t timestamp);
+
+    /**
+     * @brief Creates the segment, replacing an existing one that's too small.
+     * @param slotCapacity Required frame size in bytes.
+     * @return true if the segment is ready for writing.
+     */
+    bool CreateSegment(uint64_t slotCapacity);
+
+    /**
+     * @brief Marks the segment as closed and removes it.
+     */
+    void CloseSegment();
+
+    std::string _name; //!< Name of the shared memory segment, empty if disabled.
+    size_t _bufferCount{2}; //!< Number of frames in flight between rendering and publishing.
+    bool _failed{false}; //!< Set if the segment couldn't be created, which disables the output.
+
+    FrameReadback _readback; //!< Asynchronous readback of the rendered frames.
+
+    std::unique_ptr<Poco::SharedMemory> _segment; //!< The shared memory segment.
+    SharedFrameRing::Header* _header{nullptr}; //!< The header at the start of the segment.
+    uint64_t _sequence{0}; //!< Sequence number of the last published frame.
+
+    Poco::Logger& _logger{Poco::Logger::get("SharedFrameOutput")}; //!< The class logger.
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Memory layout of the shared memory frame ring written by SharedFrameOutput.
+ *
+ * The segment starts with a Header, followed by SlotCount frame slots. Each rendered frame is copied into
+ * the slot at index sequence % SlotCount, so while one slot is being written, readers can still use the two
+ * previous frames in place, without copying them out of the segment.
+ *
+ * Publishing a frame works like a sequence lock:
+ * 1. The writer sets the slot's sequence to 0, then copies the pixels and fills in the slot header.
+ * 2. It stores the frame's sequence number in the slot, then in Header::latestSequence.
+ *
+ * A reader loads latestSequence, checks that the slot's sequence matches, uses the pixels, and compares the
+ * slot's sequence again afterwards. If it changed, the writer has lapped the reader and the frame must be
+ * discarded. Sequence numbers start at 1 and increase by one per frame, so gaps indicate skipped frames.
+ *
+ * If the segment must grow, e.g. after a window resize, or the application exits, the writer sets the state
+ * to Closed and removes the segment. Readers should unmap it and open it again by name.
+ *
+ * All values are in native byte order. The header only uses fixed-size types and lock-free atomics, so
+ * processes written in other languages can read it as well. See tools/SharedFrameReader.cpp for a reader.
+ */
+namespace SharedFrameRing {
+
+constexpr char Magic[8]{'P', 'M', 'F', 'R', 'A', 'M', 'E', 'S'}; //!< Identifies a frame ring segment.
+constexpr uint32_t Version{1}; //!< Current layout version.
+constexpr uint32_t SlotCount{3}; //!< Number of frame slots, triple buffering.
+constexpr uint64_t Alignment{4096}; //!< Alignment of the frame data in the segment.
+
+/**
+ * @brief Pixel layouts of the frame data.
+ */
+enum class PixelFormat : uint32_t
+{
+    RGBA8BottomUp = 1 //!< 8 bit RGBA, bottom row first, as read from OpenGL.
+};
+
+/**
+ * @brief Lifecycle state of a segment.
+ */
+enum class State : uint32_t
+{
+    Active = 1, //!< The writer is publishing frames.
+    Closed = 2 //!< The segment is abandoned, readers must reopen it.
+};
+
+/**
+ * @brief Describes the frame stored in a slot.
+ */
+struct SlotHeader
+{
+    std::atomic<uint64_t> sequence; //!< Sequence number of the frame in the slot, 0 while it's being written.
+    uint64_t timestamp; //!< Time the frame was rendered, in nanoseconds of the system's monotonic clock.
+    uint64_t dataOffset; //!< Offset of the pixel data from the start of the segment.
+    uint64_t size; //!< Size of the pixel data in bytes.
+    uint32_t width; //!< Frame width in pixels.
+    uint32_t height; //!< Frame height in pixels.
+    uint32_t stride; //!< Distance between two rows in bytes.
+    uint32_t pixelFormat; //!< A PixelFormat value.
+};
+
+/**
+ * @brief Header at the start of the segment.
+ */
+struct Header
+{
+    char magic[8]; //!< Always Magic.
+    uint32_t version; //!< Layout version.
+    std::atomic<uint32_t> state; //!< A State value.
+    uint32_t slotCount; //!< Number of slots, always SlotCount in this version.
+    uint32_t reserved; //!< Unused, zero.
+    uint64_t slotCapacity; //!< Maximum size of a frame in bytes.
+    std::atomic<uint64_t> latestSequence; //!< Sequence number of the newest complete frame, 0 before the first.
+    SlotHeader slots[SlotCount]; //!< The slot headers.
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "Shared memory atomics must be lock-free.");
+
+/**
+ * @brief Calculates the offset of the first slot's data.
+ * @return The header size, rounded up to Alignment.
+ */
+constexpr uint64_t DataOffset()
+{
+    return (sizeof(Header) + Alignment - 1) / Alignment * Alignment;
+}
+
+/**
+ * @brief Calculates the distance between two slots' data.
+ * @param slotCapacity Maximum size of a frame in bytes.
+ * @return The slot capacity, rounded up to Alignment.
+ */
+constexpr uint64_t SlotStride(uint64_t slotCapacity)
+{
+    return (slotCapacity + Alignment - 1) / Alignment * Alignment;
+}
+
+/**
+ * @brief Calculates the size of a segment.
+ * @param slotCapacity Maximum size of a frame in bytes.
+ * @return The total segment size in bytes.
+ */
+constexpr uint64_t SegmentSize(uint64_t slotCapacity)
+{
+    return DataOffset() + SlotCount * SlotStride(slotCapacity);
+}
+
+} // namespace SharedFrameRing
@@ -0,0 +1,305 @@
+#include "ThreadScheduling.h"
+
+#include <Poco/NumberParser.h>
+#include <Poco/StringTokenizer.h>
+
+#include <Poco/Util/Application.h>
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include <avrt.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef USE_RTKIT
+#include <dbus/dbus.h>
+#endif
+
+namespace {
+
+constexpr unsigned int MaxCpus{1024};
+
+#ifdef USE_RTKIT
+/**
+ * @brief Asks RealtimeKit to set the given thread to SCHED_FIFO with the given priority.
+ * @param threadId The kernel thread ID.
+ * @param priority The requested priority. RealtimeKit limits this to its configured maximum.
+ * @param errorMessage Receives the error description on failure.
+ * @return true if the request was granted.
+ */
+bool MakeThreadRealtimeWithRtKit(pid_t threadId, int priority, std::string& errorMessage)
+{
+    // RealtimeKit only grants real-time scheduling to processes with a CPU time limit for real-time threads.
+    rlimit limit{};
+    limit.rlim_cur = limit.rlim_max = 200000; // 200 ms in µs
+    if (setrlimit(RLIMIT_RTTIME, &limit) != 0)
+    {
+        errorMessage = std::string("setrlimit(RLIMIT_RTTIME) failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    DBusError error;
+    dbus_error_init(&error);
+
+    auto* connection = dbus_bus_get_private(DBUS_BUS_SYSTEM, &error);
+    if (connection == nullptr)
+    {
+        errorMessage = error.message;
+        dbus_error_free(&error);
+        return false;
+    }
+    dbus_connection_set_exit_on_disconnect(connection, false);
+
+    auto* message = dbus_message_new_method_call("org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1",
+                                                 "org.freedesktop.RealtimeKit1", "MakeThreadRealtime");
+
+    dbus_uint64_t thread = static_cast<dbus_uint64_t>(threadId);
+    dbus_uint32_t threadPriority = static_cast<dbus_uint32_t>(priority);
+    dbus_message_append_args(message,
+                             DBUS_TYPE_UINT64, &thread,
+                             DBUS_TYPE_UINT32, &threadPriority,
+                             DBUS_TYPE_INVALID);
+
+    auto* reply = dbus_connection_send_with_reply_and_block(connection, message, 1000, &error);
+    bool success = reply != nullptr && !dbus_set_error_from_message(&error, reply);
+    if (!success)
+    {
+        errorMessage = error.message != nullptr ? error.message : "no reply";
+    }
+
+    if (reply != nullptr)
+    {
+        dbus_message_unref(reply);
+    }
+    dbus_message_unref(message);
+    dbus_error_free(&error);
+    dbus_connection_close(connection);
+    dbus_connection_unref(connection);
+
+    return success;
+}
+#endif
+
+} // namespace
+
+ThreadScheduling::ThreadScheduling(std::string threadName, bool realtime, int priority, std::string affinity)
+    : _threadName(std::move(threadName))
+    , _realtime(realtime)
+    , _priority(priority)
+    , _affinity(std::move(affinity))
+{
+    if (!_affinity.empty() && !ParseCpuList(_affinity, _cpus))
+    {
+        poco_warning_f2(_logger, R"(Invalid CPU list "%s" for %s thread affinity.)", _affinity, _threadName);
+        _cpus.clear();
+    }
+}
+
+ThreadScheduling ThreadScheduling::ForCapture()
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    return {"audio capture",
+            config.getBool("audio.realtime.enabled", false),
+            config.getInt("audio.realtime.priority", 10),
+            config.getString("audio.realtime.affinity", "")};
+}
+
+ThreadScheduling ThreadScheduling::ForRender()
+{
+    auto& config = Poco::Util::Application::instance().config();
+
+    return {"render", false, 0, config.getString("render.affinity", "")};
+}
+
+ThreadScheduling::ThreadId ThreadScheduling::CurrentThreadId()
+{
+#ifdef _WIN32
+    return GetCurrentThreadId();
+#elif defined(__linux__)
+    return static_cast<ThreadId>(syscall(SYS_gettid));
+#else
+    return 0;
+#endif
+}
+
+bool ThreadScheduling::Enabled() const
+{
+    return _realtime || !_cpus.empty();
+}
+
+void ThreadScheduling::ApplyToCurrentThread() const
+{
+    Apply(CurrentThreadId(), true);
+}
+
+void ThreadScheduling::ApplyToThread(ThreadId threadId) const
+{
+    Apply(threadId, false);
+}
+
+void ThreadScheduling::Apply(ThreadId threadId, bool currentThread) const
+{
+    if (_realtime && SetRealtimePriority(threadId, currentThread))
+    {
+        poco_information_f2(_logger, "Running %s thread with real-time priority %?d.", _threadName, _priority);
+    }
+
+    if (!_cpus.empty() && SetAffinity(threadId))
+    {
+        poco_information_f2(_logger, R"(Pinned %s thread to CPUs "%s".)", _threadName, _affinity);
+    }
+}
+
+bool ThreadScheduling::SetRealtimePriority(POCO_UNUSED ThreadId threadId, POCO_UNUSED bool currentThread) const
+{
+#ifdef _WIN32
+    if (currentThread)
+    {
+        DWORD taskIndex{0};
+        auto taskHandle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+        if (taskHandle == nullptr)
+        {
+            poco_warning_f2(_logger, "Could not register %s thread with MMCSS, error %?u.", _threadName, GetLastError());
+            return false;
+        }
+
+        AvSetMmThreadPriority(taskHandle, AVRT_PRIORITY_HIGH);
+        return true;
+    }
+
+    auto thread = OpenThread(THREAD_SET_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(threadId));
+    if (thread == nullptr || !SetThreadPriority(thread, THREAD_PRIORITY_TIME_CRITICAL))
+    {
+        auto error = GetLastError();
+        if (thread != nullptr)
+        {
+            CloseHandle(thread);
+        }
+
+        poco_warning_f2(_logger, "Could not raise %s thread priority, error %?u.", _threadName, error);
+        return false;
+    }
+
+    CloseHandle(thread);
+    return true;
+#elif defined(__linux__)
+    sched_param parameters{};
+    parameters.sched_priority = _priority;
+
+    // Reset on fork, so child processes don't inherit real-time scheduling.
+    if (sched_setscheduler(static_cast<pid_t>(threadId), SCHED_FIFO | SCHED_RESET_ON_FORK, &parameters) == 0)
+    {
+        return true;
+    }
+
+    std::string error = std::strerror(errno);
+
+#ifdef USE_RTKIT
+    if (MakeThreadRealtimeWithRtKit(static_cast<pid_t>(threadId), _priority, error))
+    {
+        return true;
+    }
+#endif
+
+    poco_warning_f2(_logger, "Could not set real-time priority for %s thread: %s", _threadName, error);
+    return false;
+#else
+    poco_warning(_logger, "Real-time thread priority is not supported on this platform.");
+    return false;
+#endif
+}
+
+bool ThreadScheduling::SetAffinity(POCO_UNUSED ThreadId threadId) const
+{
+#ifdef _WIN32
+    DWORD_PTR mask{0};
+    for (auto cpu : _cpus)
+    {
+        if (cpu < sizeof(DWORD_PTR) * 8)
+        {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+
+    auto thread = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, static_cast<DWORD>(threadId));
+    if (mask == 0 || thread == nullptr || SetThreadAffinityMask(thread, mask) == 0)
+    {
+        auto error = GetLastError();
+        if (thread != nullptr)
+        {
+            CloseHandle(thread);
+        }
+
+        poco_warning_f2(_logger, "Could not set %s thread affinity, error %?u.", _threadName, error);
+        return false;
+    }
+
+    CloseHandle(thread);
+    return true;
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (auto cpu : _cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    if (sched_setaffinity(static_cast<pid_t>(threadId), sizeof(cpuSet), &cpuSet) != 0)
+    {
+        poco_warning_f2(_logger, "Could not set %s thread affinity: %s", _threadName, std::string(std::strerror(errno)));
+        return false;
+    }
+
+    return true;
+#else
+    poco_warning(_logger, "Thread affinity is not supported on this platform.");
+    return false;
+#endif
+}
+
+bool ThreadScheduling::ParseCpuList(const std::string& cpuList, std::vector<unsigned int>& cpus)
+{
+    Poco::StringTokenizer ranges(cpuList, ",", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    for (const auto& range : ranges)
+    {
+        auto separator = range.find('-');
+
+        unsigned int first{0};
+        if (!Poco::NumberParser::tryParseUnsigned(range.substr(0, separator), first))
+        {
+            return false;
+        }
+
+        unsigned int last{first};
+        if (separator != std::string::npos && !Poco::NumberParser::tryParseUnsigned(range.substr(separator + 1), last))
+        {
+            return false;
+        }
+
+        if (last < first || last - first >= MaxCpus)
+        {
+            return false;
+        }
+
+        for (auto cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return !cpus.empty();
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Poco/Logger.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Applies scheduling policy and CPU affinity settings to the calling thread.
+ *
+ * Audio capture threads can be promoted to real-time priority, so they aren't descheduled while the render
+ * thread or other processes put the CPU under full load, e.g. while preset shaders are compiled. This is
+ * opt-in via audio.realtime.enabled, as it requires permissions most desktop users don't have by default.
+ *
+ * On Linux, the thread is switched to SCHED_FIFO with sched_setscheduler(). If that's not permitted and
+ * projectMSDL was built with D-Bus support, the priority is requested from RealtimeKit instead. On Windows,
+ * the thread joins the "Pro Audio" MMCSS task.
+ *
+ * Both capture and render threads can be pinned to a set of CPUs, given as a list like "2,3" or "4-7".
+ *
+ * Settings are read and the CPU list is parsed when the object is created. Threads owned by a third-party
+ * library which already run with real-time constraints, like SDL's audio callback thread, should only
+ * publish CurrentThreadId(). Another thread then calls ApplyToThread(), as the D-Bus request, system calls
+ * and log messages may block for a long time.
+ */
+class ThreadScheduling
+{
+public:
+    using ThreadId = uint64_t; //!< Kernel thread ID on Linux, thread ID on Windows. 0 is never a valid thread.
+
+    ThreadScheduling() = delete;
+
+    /**
+     * @brief Creates a scheduling configuration.
+     * @param threadName Name used in log messages.
+     * @param realtime If true, the thread is promoted to real-time priority.
+     * @param priority The real-time priority, from 1 to 99 on Linux.
+     * @param affinity CPU list the thread is pinned to. Empty to keep the default affinity.
+     */
+    ThreadScheduling(std::string threadName, bool realtime, int priority, std::string affinity);
+
+    /**
+     * @brief Creates the configuration for audio capture threads from the audio.realtime.* settings.
+     * @return The capture thread configuration.
+     */
+    static ThreadScheduling ForCapture();
+
+    /**
+     * @brief Creates the configuration for the render thread from the render.* settings.
+     * @return The render thread configuration.
+     */
+    static ThreadScheduling ForRender();
+
+    /**
+     * @brief Returns the ID of the calling thread.
+     *
+     * Doesn't allocate, lock or log, so it's safe to call from a real-time audio callback.
+     *
+     * @return The thread ID to pass to ApplyToThread(), or 0 if not supported on this platform.
+     */
+    static ThreadId CurrentThreadId();
+
+    /**
+     * @brief Returns whether there are any settings to apply.
+     * @return true if real-time priority or a valid CPU list is configured.
+     */
+    bool Enabled() const;
+
+    /**
+     * @brief Applies the priority and affinity to the calling thread.
+     *
+     * Failures are logged, but otherwise ignored, as the thread works fine with default scheduling.
+     */
+    void ApplyToCurrentThread() const;
+
+    /**
+     * @brief Applies the priority and affinity to another thread of this process.
+     *
+     * On Windows, the thread gets time-critical priority instead of joining the MMCSS task, which is only
+     * possible for the calling thread. Failures are logged, but otherwise ignored.
+     *
+     * @param threadId The ID of the thread, as returned by CurrentThreadId() on that thread.
+     */
+    void ApplyToThread(ThreadId threadId) const;
+
+protected:
+    /**
+     * @brief Promotes a thread to real-time priority.
+     * @param threadId The ID of the thread.
+     * @param currentThread True if threadId is the calling thread.
+     * @return true if successful.
+     */
+    bool SetRealtimePriority(ThreadId threadId, bool currentThread) const;
+
+    /**
+     * @brief Pins a thread to the configured CPUs.
+     * @param threadId The ID of the thread.
+     * @return true if successful.
+     */
+    bool SetAffinity(ThreadId threadId) const;
+
+    /**
+     * @brief Applies all settings and logs the results.
+     * @param threadId The ID of the thread.
+     * @param currentThread True if threadId is the calling thread.
+     */
+    void Apply(ThreadId threadId, bool currentThread) const;
+
+    /**
+     * @brief Parses a CPU list like "0,2,4-7".
+     * @param cpuList The list to parse.
+     * @param cpus Receives the CPU indices.
+     * @return true if the list is valid and not empty.
+     */
+    static bool ParseCpuList(const std::string& cpuList, std::vector<unsigned int>& cpus);
+
+    std::string _threadName; //!< Name used in log messages.
+    bool _realtime{false}; //!< If true, the thread is promoted to real-time priority.
+    int _priority{10}; //!< Real-time priority.
+    std::string _affinity; //!< CPU list to pin the thread to.
+    std::vector<unsigned int> _cpus; //!< Parsed CPU list, empty to keep the default affinity.
+
+    Poco::Logger& _logger{Poco::Logger::get("ThreadScheduling")}; //!< The class logger.
+};
@@ -0,0 +1,240 @@
+#include "VideoFrameWriter.h"
+
+#include <Poco/Exception.h>
+#include <Poco/FileStream.h>
+#include <Poco/Format.h>
+#include <Poco/PipeStream.h>
+#include <Poco/String.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <csignal>
+#endif
+
+namespace {
+
+/**
+ * @brief Calculates the BT.601 limited range luma of a pixel.
+ */
+uint8_t Luma(uint32_t red, uint32_t green, uint32_t blue)
+{
+    return static_cast<uint8_t>((66 * red + 129 * green + 25 * blue + 128 + (16 << 8)) >> 8);
+}
+
+/**
+ * @brief Calculates the BT.601 blue-difference chroma from the sums of four pixels.
+ *
+ * The offset of 128 is added before shifting, so the intermediate value is never negative.
+ */
+uint8_t ChromaBlue(int32_t red, int32_t green, int32_t blue)
+{
+    return static_cast<uint8_t>((-38 * red - 74 * green + 112 * blue + 512 + (128 << 10)) >> 10);
+}
+
+/**
+ * @brief Calculates the BT.601 red-difference chroma from the sums of four pixels.
+ */
+uint8_t ChromaRed(int32_t red, int32_t green, int32_t blue)
+{
+    return static_cast<uint8_t>((112 * red - 94 * green - 18 * blue + 512 + (128 << 10)) >> 10);
+}
+
+} // namespace
+
+VideoFrameWriter::VideoFrameWriter(const std::string& output, Format format, int width, int height, int fps)
+    : _output(output)
+    , _format(format)
+    , _width(width)
+    , _height(height)
+{
+    if (_width <= 0 || _height <= 0 || fps <= 0)
+    {
+        throw Poco::Exception(Poco::format("Invalid video format %dx%d at %d FPS.", width, height, fps));
+    }
+
+    if (_format == Format::Y4M)
+    {
+        size_t chromaSize = static_cast<size_t>((_width + 1) / 2) * static_cast<size_t>((_height + 1) / 2);
+        _frameBuffer.resize(static_cast<size_t>(_width) * static_cast<size_t>(_height) + 2 * chromaSize);
+    }
+    else
+    {
+        _frameBuffer.resize(FrameBytes());
+    }
+
+    if (!output.empty() && output[0] == '|')
+    {
+        auto command = Poco::trim(output.substr(1));
+#ifdef _WIN32
+        _encoder.reset(new Poco::ProcessHandle(Poco::Process::launch("cmd.exe", {"/C", command}, &_encoderInput, nullptr, nullptr)));
+#else
+        // If the encoder exits early, writing must fail with an error instead of terminating the application.
+        signal(SIGPIPE, SIG_IGN);
+        _encoder.reset(new Poco::ProcessHandle(Poco::Process::launch("/bin/sh", {"-c", command}, &_encoderInput, nullptr, nullptr)));
+#endif
+        _stream.reset(new Poco::PipeOutputStream(_encoderInput));
+
+        poco_information_f2(_logger, R"(Started video encoder process %?d: "%s")", _encoder->id(), command);
+    }
+    else
+    {
+        _stream.reset(new Poco::FileOutputStream(output));
+    }
+
+    if (_format == Format::Y4M)
+    {
+        // C420jpeg places the chroma samples between the luma samples, matching the 2x2 averaging.
+        *_stream << Poco::format("YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", _width, _height, fps);
+    }
+
+    if (!_stream->good())
+    {
+        throw Poco::Exception(Poco::format(R"(Could not write to video output "%s".)", output));
+    }
+}
+
+VideoFrameWriter::~VideoFrameWriter()
+{
+    Close();
+}
+
+bool VideoFrameWriter::ParseFormat(const std::string& name, Format& format)
+{
+    if (Poco::icompare(name, "y4m") == 0)
+    {
+        format = Format::Y4M;
+        return true;
+    }
+
+    if (Poco::icompare(name, "raw") == 0)
+    {
+        format = Format::Raw;
+        return true;
+    }
+
+    return false;
+}
+
+bool VideoFrameWriter::WriteFrame(const uint8_t* pixels)
+{
+    if (!_stream || _failed)
+    {
+        return false;
+    }
+
+    if (_format == Format::Y4M)
+    {
+        ConvertToYUV420(pixels);
+        *_stream << "FRAME\n";
+    }
+    else
+    {
+        CopyTopDown(pixels);
+    }
+
+    _stream->write(reinterpret_cast<const char*>(_frameBuffer.data()), static_cast<std::streamsize>(_frameBuffer.size()));
+
+    if (!_stream->good())
+    {
+        poco_error_f1(_logger, R"(Could not write to video output "%s". Stopping video output.)", _output);
+        _failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool VideoFrameWriter::Close()
+{
+    if (!_stream)
+    {
+        return !_failed;
+    }
+
+    _stream->flush();
+    bool success = !_failed && _stream->good();
+    _stream.reset();
+
+    if (_encoder)
+    {
+        // Closing the pipe signals the end of the stream to the encoder.
+        _encoderInput.close();
+
+        int exitCode = _encoder->wait();
+        _encoder.reset();
+
+        if (exitCode != 0)
+        {
+            poco_error_f1(_logger, "The video encoder exited with code %?d.", exitCode);
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+size_t VideoFrameWriter::FrameBytes() const
+{
+    return static_cast<size_t>(_width) * static_cast<size_t>(_height) * 4;
+}
+
+void VideoFrameWriter::ConvertToYUV420(const uint8_t* pixels)
+{
+    const size_t stride = static_cast<size_t>(_width) * 4;
+    const int chromaWidth = (_width + 1) / 2;
+    const int chromaHeight = (_height + 1) / 2;
+
+    uint8_t* lumaPlane = _frameBuffer.data();
+    uint8_t* blueChromaPlane = lumaPlane + static_cast<size_t>(_width) * static_cast<size_t>(_height);
+    uint8_t* redChromaPlane = blueChromaPlane + static_cast<size_t>(chromaWidth) * static_cast<size_t>(chromaHeight);
+
+    for (int row = 0; row < _height; row++)
+    {
+        const uint8_t* source = pixels + static_cast<size_t>(_height - 1 - row) * stride;
+        uint8_t* luma = lumaPlane + static_cast<size_t>(row) * static_cast<size_t>(_width);
+
+        for (int column = 0; column < _width; column++, source += 4)
+        {
+            luma[column] = Luma(source[0], source[1], source[2]);
+        }
+    }
+
+    // Each chroma sample is taken from the average of a 2x2 pixel block. Odd sizes repeat the last row or column.
+    for (int chromaRow = 0; chromaRow < chromaHeight; chromaRow++)
+    {
+        const int topRow = 2 * chromaRow;
+        const int bottomRow = std::min(topRow + 1, _height - 1);
+        const uint8_t* top = pixels + static_cast<size_t>(_height - 1 - topRow) * stride;
+        const uint8_t* bottom = pixels + static_cast<size_t>(_height - 1 - bottomRow) * stride;
+
+        uint8_t* blueChroma = blueChromaPlane + static_cast<size_t>(chromaRow) * static_cast<size_t>(chromaWidth);
+        uint8_t* redChroma = redChromaPlane + static_cast<size_t>(chromaRow) * static_cast<size_t>(chromaWidth);
+
+        for (int chromaColumn = 0; chromaColumn < chromaWidth; chromaColumn++)
+        {
+            const size_t left = static_cast<size_t>(2 * chromaColumn) * 4;
+            const size_t right = static_cast<size_t>(std::min(2 * chromaColumn + 1, _width - 1)) * 4;
+
+            int32_t red = top[left] + top[right] + bottom[left] + bottom[right];
+            int32_t green = top[left + 1] + top[right + 1] + bottom[left + 1] + bottom[right + 1];
+            int32_t blue = top[left + 2] + top[right + 2] + bottom[left + 2] + bottom[right + 2];
+
+            blueChroma[chromaColumn] = ChromaBlue(red, green, blue);
+            redChroma[chromaColumn] = ChromaRed(red, green, blue);
+        }
+    }
+}
+
+void VideoFrameWriter::CopyTopDown(const uint8_t* pixels)
+{
+    const size_t stride = static_cast<size_t>(_width) * 4;
+
+    for (int row = 0; row < _height; row++)
+    {
+        std::memcpy(_frameBuffer.data() + static_cast<size_t>(row) * stride,
+                    pixels + static_cast<size_t>(_height - 1 - row) * stride,
+                    stride);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Poco/Logger.h>
+#include <Poco/Pipe.h>
+#include <Poco/Process.h>
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Streams rendered frames as uncompressed video to a file or an encoder process.
+ *
+ * Two formats are supported:
+ * - Y4M: A YUV4MPEG2 stream with 4:2:0 chroma subsampling, which encoders like ffmpeg read without any
+ *   further parameters. The frames are converted from RGBA with the BT.601 limited range coefficients.
+ * - Raw: Plain RGBA frames without any header. The encoder must be told the size, pixel format and rate.
+ *
+ * If the output starts with "|", the remainder is run as a shell command and the stream is written to its
+ * standard input, e.g. "|ffmpeg -i - -c:v libx264 video.mp4". Otherwise, it's the name of the output file.
+ *
+ * Frames are passed bottom-up as read from OpenGL and written top-down.
+ */
+class VideoFrameWriter
+{
+public:
+    /**
+     * @brief Supported output stream formats.
+     */
+    enum class Format
+    {
+        Y4M, //!< YUV4MPEG2 with 4:2:0 chroma subsampling.
+        Raw //!< Headerless RGBA frames.
+    };
+
+    /**
+     * @brief Opens the output file or starts the encoder process and writes the stream header.
+     * @throws Poco::Exception if the output can't be opened.
+     * @param output The output file name, or a "|" followed by an encoder command.
+     * @param format The stream format.
+     * @param width Frame width in pixels.
+     * @param height Frame height in pixels.
+     * @param fps The video frame rate.
+     */
+    VideoFrameWriter(const std::string& output, Format format, int width, int height, int fps);
+
+    /**
+     * @brief Closes the output, waiting for the encoder process to finish.
+     */
+    ~VideoFrameWriter();
+
+    /**
+     * @brief Parses a format name.
+     * @param name The format name, "y4m" or "raw", case-insensitive.
+     * @param format Receives the parsed format.
+     * @return true if the name is a known format.
+     */
+    static bool ParseFormat(const std::string& name, Format& format);
+
+    /**
+     * @brief Converts and writes a single frame.
+     * @param pixels RGBA pixels of the frame, bottom row first, without any row padding.
+     * @return true if the frame was written, false if the output failed.
+     */
+    bool WriteFrame(const uint8_t* pixels);
+
+    /**
+     * @brief Flushes and closes the output and waits for the encoder process to exit.
+     * @return true if all data was written and the encoder exited successfully.
+     */
+    bool Close();
+
+    /**
+     * @brief Returns the number of bytes of a single input frame.
+     * @return The RGBA frame size in bytes.
+     */
+    size_t FrameBytes() const;
+
+protected:
+    /**
+     * @brief Converts an RGBA frame to planar YUV 4:2:0 in _frameBuffer.
+     * @param pixels RGBA pixels, bottom row first.
+     */
+    void ConvertToYUV420(const uint8_t* pixels);
+
+    /**
+     * @brief Flips an RGBA frame vertically into _frameBuffer.
+     * @param pixels RGBA pixels, bottom row first.
+     */
+    void CopyTopDown(const uint8_t* pixels);
+
+    std::string _output; //!< Output file name or encoder command, for log messages.
+    Format _format{Format::Y4M}; //!< Stream format.
+    int _width{0}; //!< Frame width in pixels.
+    int _height{0}; //!< Frame height in pixels.
+
+    std::vector<uint8_t> _frameBuffer; //!< Converted frame in the output format.
+
+    std::unique_ptr<std::ostream> _stream; //!< The output file or encoder pipe stream.
+    Poco::Pipe _encoderInput; //!< Pipe to the encoder's standard input.
+    std::unique_ptr<Poco::ProcessHandle> _encoder; //!< The encoder process, if writing to a command.
+    bool _failed{false}; //!< Set after the first write error, further frames are dropped.
+
+    Poco::Logger& _logger{Poco::Logger::get("VideoFrameWriter")}; //!< The class logger.
+};
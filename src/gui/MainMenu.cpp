@@ -93,10 +93,16 @@ void MainMenu::Draw()
 
             if (ImGui::BeginMenu("Audio Capture Device"))
             {
-                auto devices = _audioCapture.AudioDeviceList();
+                auto deviceListVersion = _audioCapture.DeviceListVersion();
+                if (_audioDevices.empty() || deviceListVersion != _audioDeviceListVersion)
+                {
+                    _audioDevices = _audioCapture.AudioDeviceList();
+                    _audioDeviceListVersion = deviceListVersion;
+                }
+
                 auto currentIndex = _audioCapture.AudioDeviceIndex();
 
-                for (const auto& device : devices)
+                for (const auto& device : _audioDevices)
                 {
                     if (ImGui::MenuItem(device.second.c_str(), "", device.first == currentIndex))
                     {
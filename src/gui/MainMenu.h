@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <string>
 
 class ProjectMGUI;
@@ -27,4 +29,7 @@ private:
     ProjectMGUI& _gui; //!< Reference to the GUI subsystem.
     ProjectMWrapper& _projectMWrapper; //!< Reference to the projectM wrapper subsystem.
     AudioCapture& _audioCapture; //!< Reference to the audio capture subsystem.
+
+    std::map<int, std::string> _audioDevices; //!< Audio device list displayed in the options menu.
+    uint64_t _audioDeviceListVersion{0}; //!< Version of the cached audio device list.
 };
@@ -1,6 +1,7 @@
 #include "SettingsWindow.h"
 
 #include "AudioCapture.h"
+#include "AudioDelayLine.h"
 #include "ProjectMSDLApplication.h"
 #include "SDLRenderingWindow.h"
 
@@ -10,10 +11,21 @@
 
 #include <imgui.h>
 
+#include <Poco/Format.h>
 #include <Poco/NotificationCenter.h>
 
 #include <Poco/Util/Application.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr float MeterRangeDb{60.0f}; //!< Level range displayed by the input level meter, in dB below full scale.
+
+} // namespace
+
 SettingsWindow::SettingsWindow(ProjectMGUI& gui)
     : _gui(gui)
     , _audioCapture(ProjectMSDLApplication::instance().getSubsystem<AudioCapture>())
@@ -278,6 +290,21 @@ void SettingsWindow::DrawAudioSettingsTab()
             LabelWithTooltip("Audio Capturing Device", "The device to capture audio from.");
             AudioDeviceSetting();
 
+            ImGui::TableNextRow();
+            LabelWithTooltip("A/V Sync Offset", "Delays the audio passed to projectM by the given number of milliseconds if the visuals appear before the sound is heard.\n"
+                                                "Any negative value minimizes the capture buffering instead, for visuals appearing after the sound.");
+            IntegerSetting("audio.syncOffset", 0, -100, static_cast<int>(AudioDelayLine::MaxDelay * 1000.0));
+
+            ImGui::TableNextRow();
+            LabelWithTooltip("Total Latency", "Estimated time from capturing audio until it is displayed.\n"
+                                              "Includes the capture buffering, the A/V sync offset and one frame each for rendering and display.");
+            AudioLatencyDisplay();
+
+            ImGui::TableNextRow();
+            LabelWithTooltip("Input Level", "RMS and peak level of the captured audio in dB relative to full scale, as analyzed right after capturing.\n"
+                                            "A constant DC offset or clipped samples usually indicate a problem with the audio source or its gain.");
+            InputLevelDisplay();
+
             ImGui::TableNextRow();
             LabelWithTooltip("Beat Sensitivity", "Beat detection multiplier.");
             DoubleSetting("projectM.beatSensitivity", 1.0, 0.0, 2.0);
@@ -552,13 +579,21 @@ void SettingsWindow::AudioDeviceSetting()
 {
     ImGui::TableSetColumnIndex(1);
 
-    auto devices = _audioCapture.AudioDeviceList();
+    // Only copy the device list if it has changed.
+    auto deviceListVersion = _audioCapture.DeviceListVersion();
+    if (_audioDevices.empty() || deviceListVersion != _audioDeviceListVersion)
+    {
+        _audioDevices = _audioCapture.AudioDeviceList();
+        _audioDeviceListVersion = deviceListVersion;
+    }
+
     auto currentIndex = _audioCapture.AudioDeviceIndex();
+    auto currentDevice = _audioDevices.find(currentIndex);
 
     ImGui::SetNextItemWidth(-1);
-    if (ImGui::BeginCombo("##audiodevice", devices.at(currentIndex).c_str(), 0))
+    if (ImGui::BeginCombo("##audiodevice", currentDevice != _audioDevices.end() ? currentDevice->second.c_str() : "", 0))
     {
-        for (const auto& device : devices)
+        for (const auto& device : _audioDevices)
         {
             bool isSelected = device.first == currentIndex;
 
@@ -593,6 +628,43 @@ void SettingsWindow::AudioDeviceSetting()
     }
 }
 
+void SettingsWindow::AudioLatencyDisplay() const
+{
+    ImGui::TableSetColumnIndex(1);
+
+    auto audioLatency = _audioCapture.Latency() * 1000.0;
+    auto framerate = ImGui::GetIO().Framerate;
+    auto displayLatency = framerate > 0.0f ? 2000.0 / static_cast<double>(framerate) : 0.0;
+
+    ImGui::Text("%.1f ms (audio %.1f ms, rendering and display %.1f ms)", audioLatency + displayLatency, audioLatency, displayLatency);
+}
+
+void SettingsWindow::InputLevelDisplay() const
+{
+    ImGui::TableSetColumnIndex(1);
+
+    auto levels = _audioCapture.InputLevels();
+    auto toDb = [](float level) {
+        return level > 0.0f ? 20.0f * std::log10(level) : -std::numeric_limits<float>::infinity();
+    };
+
+    auto rmsDb = toDb(levels.rms);
+    auto peakDb = toDb(levels.peak);
+
+    std::string overlay = Poco::format("RMS %.1f dBFS, peak %.1f dBFS", static_cast<double>(rmsDb), static_cast<double>(peakDb));
+    ImGui::ProgressBar(std::min(std::max(rmsDb / MeterRangeDb + 1.0f, 0.0f), 1.0f), ImVec2(-1.0f, 0.0f), overlay.c_str());
+
+    if (levels.clippedSamples > 0)
+    {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "DC offset %.4f, %llu clipped samples",
+                           static_cast<double>(levels.dcOffset), static_cast<unsigned long long>(levels.clippedSamples));
+    }
+    else
+    {
+        ImGui::Text("DC offset %.4f, no clipping", static_cast<double>(levels.dcOffset));
+    }
+}
+
 bool SettingsWindow::ResetButton(const std::string& property1, const std::string& property2)
 {
     if (!_userConfiguration->has(property1) && (property2.empty() || !_userConfiguration->has(property2)))
@@ -5,6 +5,8 @@
 #include <Poco/Util/MapConfiguration.h>
 #include <Poco/Util/PropertyFileConfiguration.h>
 
+#include <cstdint>
+#include <map>
 #include <string>
 
 class AudioCapture;
@@ -126,6 +128,16 @@ private:
      */
     void AudioDeviceSetting();
 
+    /**
+     * @brief Displays the estimated total latency from audio capture to the screen.
+     */
+    void AudioLatencyDisplay() const;
+
+    /**
+     * @brief Displays a level meter with the RMS and peak level, DC offset and clip count of the captured audio.
+     */
+    void InputLevelDisplay() const;
+
     /**
      * @brief Displays a reset button and removes the property from the UI map if clicked.
      * @param property1 First property to reset.
@@ -151,4 +163,7 @@ private:
     FileChooser _pathChooser{FileChooser::Mode::Directory}; //!< The file chooser dialog to select preset and texture paths.
 
     float _userScale{1.0f}; //!< Temporary value for UI scale
+
+    std::map<int, std::string> _audioDevices; //!< Audio device list displayed in the combo box.
+    uint64_t _audioDeviceListVersion{0}; //!< Version of the cached audio device list.
 };
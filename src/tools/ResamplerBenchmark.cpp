@@ -0,0 +1,288 @@
+/**
+ * @file ResamplerBenchmark.cpp
+ * @brief Compares the AudioResampler kernels with SDL's audio converters.
+ *
+ * Usage: projectMSDL-resampler-benchmark [seconds]
+ *
+ * Converts the given length of stereo audio (default 60 seconds) between common capture and projectM
+ * sample rates in blocks of BlockFrames sample frames, like the audio callback does. Each dot product
+ * kernel available on this CPU is run, followed by SDL_AudioCVT and, with SDL 2.0.7 or higher,
+ * SDL_AudioStream. Reports the time per output frame, how many times faster than realtime the conversion
+ * runs (fastest of Repetitions runs), and the largest deviation of each kernel's output from the scalar kernel.
+ */
+
+#include "AudioResampler.h"
+
+#define SDL_MAIN_HANDLED
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t Channels{2}; //!< Number of interleaved channels.
+constexpr size_t BlockFrames{480}; //!< Sample frames per block, 10 ms at 48 kHz.
+constexpr int Repetitions{3}; //!< Number of runs per converter, the fastest one is reported.
+
+/**
+ * @brief A sample rate conversion to benchmark.
+ */
+struct Conversion
+{
+    uint32_t inputRate; //!< Input sample rate in Hz.
+    uint32_t outputRate; //!< Output sample rate in Hz.
+};
+
+/**
+ * @brief A resampler kernel to benchmark.
+ */
+struct KernelInfo
+{
+    AudioResampler::Kernel kernel; //!< The kernel.
+    const char* name; //!< Display name.
+};
+
+/**
+ * @brief Measured values of a single run.
+ */
+struct Result
+{
+    double seconds{0.0}; //!< Time spent converting.
+    size_t outputFrames{0}; //!< Number of sample frames produced.
+};
+
+double Now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<float> CreateSignal(uint32_t sampleRate, double duration)
+{
+    // A logarithmic sweep over the audible range plus a little noise, so no kernel works on silence.
+    auto frames = static_cast<size_t>(duration * sampleRate);
+    std::vector<float> signal(frames * Channels);
+
+    uint32_t noise{22222};
+    double phase{0.0};
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        auto frequency = 20.0 * std::pow(1000.0, static_cast<double>(frame) / static_cast<double>(frames));
+        phase += 2.0 * 3.14159265358979323846 * frequency / sampleRate;
+
+        noise = noise * 1664525u + 1013904223u;
+        auto dither = static_cast<float>(noise >> 8) / 16777216.0f - 0.5f;
+
+        signal[frame * Channels] = 0.5f * static_cast<float>(std::sin(phase)) + 0.01f * dither;
+        signal[frame * Channels + 1] = 0.5f * static_cast<float>(std::cos(phase)) - 0.01f * dither;
+    }
+
+    return signal;
+}
+
+Result RunResampler(const Conversion& conversion, AudioResampler::Kernel kernel, const std::vector<float>& input,
+                    std::vector<float>& output)
+{
+    AudioResampler resampler;
+    resampler.Configure(conversion.inputRate, conversion.outputRate, Channels, BlockFrames, kernel);
+
+    auto inputFrames = input.size() / Channels;
+    output.resize((resampler.MaxOutputFrames(BlockFrames) * (inputFrames / BlockFrames + 1)) * Channels);
+
+    Result result;
+    auto start = Now();
+    for (size_t frame = 0; frame < inputFrames; frame += BlockFrames)
+    {
+        auto frames = std::min(BlockFrames, inputFrames - frame);
+        result.outputFrames += resampler.Process(input.data() + frame * Channels, frames,
+                                                 output.data() + result.outputFrames * Channels);
+    }
+    result.seconds = Now() - start;
+
+    output.resize(result.outputFrames * Channels);
+    return result;
+}
+
+bool RunAudioCVT(const Conversion& conversion, const std::vector<float>& input, Result& result)
+{
+    SDL_AudioCVT converter;
+    if (SDL_BuildAudioCVT(&converter, AUDIO_F32SYS, Channels, static_cast<int>(conversion.inputRate),
+                          AUDIO_F32SYS, Channels, static_cast<int>(conversion.outputRate)) < 0)
+    {
+        std::fprintf(stderr, "SDL_BuildAudioCVT failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    const auto blockBytes = static_cast<int>(BlockFrames * Channels * sizeof(float));
+    std::vector<Uint8> buffer(static_cast<size_t>(blockBytes) * static_cast<size_t>(converter.len_mult));
+    converter.buf = buffer.data();
+
+    auto inputFrames = input.size() / Channels;
+    auto start = Now();
+    for (size_t frame = 0; frame < inputFrames; frame += BlockFrames)
+    {
+        auto frames = std::min(BlockFrames, inputFrames - frame);
+        converter.len = static_cast<int>(frames * Channels * sizeof(float));
+        std::memcpy(buffer.data(), input.data() + frame * Channels, static_cast<size_t>(converter.len));
+
+        if (SDL_ConvertAudio(&converter) < 0)
+        {
+            std::fprintf(stderr, "SDL_ConvertAudio failed: %s\n", SDL_GetError());
+            return false;
+        }
+        result.outputFrames += static_cast<size_t>(converter.len_cvt) / (Channels * sizeof(float));
+    }
+    result.seconds = Now() - start;
+
+    return true;
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+bool RunAudioStream(const Conversion& conversion, const std::vector<float>& input, Result& result)
+{
+    auto* stream = SDL_NewAudioStream(AUDIO_F32SYS, Channels, static_cast<int>(conversion.inputRate),
+                                      AUDIO_F32SYS, Channels, static_cast<int>(conversion.outputRate));
+    if (!stream)
+    {
+        std::fprintf(stderr, "SDL_NewAudioStream failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    std::vector<float> output(BlockFrames * Channels * 8);
+    const auto outputBytes = static_cast<int>(output.size() * sizeof(float));
+
+    auto inputFrames = input.size() / Channels;
+    auto start = Now();
+    for (size_t frame = 0; frame < inputFrames; frame += BlockFrames)
+    {
+        auto frames = std::min(BlockFrames, inputFrames - frame);
+        SDL_AudioStreamPut(stream, input.data() + frame * Channels, static_cast<int>(frames * Channels * sizeof(float)));
+
+        int bytes;
+        while ((bytes = SDL_AudioStreamGet(stream, output.data(), outputBytes)) > 0)
+        {
+            result.outputFrames += static_cast<size_t>(bytes) / (Channels * sizeof(float));
+        }
+    }
+    result.seconds = Now() - start;
+
+    SDL_FreeAudioStream(stream);
+    return true;
+}
+#endif
+
+void PrintResult(const char* name, const Result& result, double duration, const char* deviation)
+{
+    std::printf("  %-16s %8.2f ns/frame %8.0fx realtime  %s\n", name,
+                result.outputFrames > 0 ? result.seconds * 1e9 / static_cast<double>(result.outputFrames) : 0.0,
+                result.seconds > 0.0 ? duration / result.seconds : 0.0, deviation);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    double duration = argc > 1 ? std::atof(argv[1]) : 60.0;
+    if (duration <= 0.0)
+    {
+        std::fprintf(stderr, "Usage: %s [seconds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const Conversion conversions[]{
+        {44100, 48000},
+        {48000, 44100},
+        {96000, 44100},
+        {22050, 44100},
+    };
+
+    const KernelInfo kernels[]{
+        {AudioResampler::Kernel::Scalar, "scalar"},
+        {AudioResampler::Kernel::SSE2, "SSE2"},
+        {AudioResampler::Kernel::AVX2, "AVX2"},
+        {AudioResampler::Kernel::NEON, "NEON"},
+    };
+
+    for (const auto& conversion : conversions)
+    {
+        std::printf("%u Hz -> %u Hz, %u channels, %zu frames per block, %.0f s:\n",
+                    conversion.inputRate, conversion.outputRate, Channels, BlockFrames, duration);
+
+        auto input = CreateSignal(conversion.inputRate, duration);
+
+        std::vector<float> reference;
+        for (const auto& kernel : kernels)
+        {
+            if (!AudioResampler::KernelAvailable(kernel.kernel))
+            {
+                std::printf("  %-16s not available\n", kernel.name);
+                continue;
+            }
+
+            std::vector<float> output;
+            auto result = RunResampler(conversion, kernel.kernel, input, output);
+            for (int run = 1; run < Repetitions; run++)
+            {
+                result.seconds = std::min(result.seconds, RunResampler(conversion, kernel.kernel, input, output).seconds);
+            }
+
+            char deviation[64]{};
+            if (kernel.kernel == AudioResampler::Kernel::Scalar)
+            {
+                reference.swap(output);
+            }
+            else
+            {
+                float maxDeviation{0.0f};
+                for (size_t index = 0; index < std::min(output.size(), reference.size()); index++)
+                {
+                    maxDeviation = std::max(maxDeviation, std::abs(output[index] - reference[index]));
+                }
+                std::snprintf(deviation, sizeof(deviation), "max deviation %.2g", static_cast<double>(maxDeviation));
+            }
+
+            PrintResult(kernel.name, result, duration, deviation);
+        }
+
+        Result cvtResult;
+        int cvtRuns{0};
+        for (; cvtRuns < Repetitions; cvtRuns++)
+        {
+            Result result;
+            if (!RunAudioCVT(conversion, input, result))
+            {
+                break;
+            }
+            cvtResult = cvtRuns == 0 || result.seconds < cvtResult.seconds ? result : cvtResult;
+        }
+        if (cvtRuns == Repetitions)
+        {
+            PrintResult("SDL_AudioCVT", cvtResult, duration, "");
+        }
+
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+        Result streamResult;
+        int streamRuns{0};
+        for (; streamRuns < Repetitions; streamRuns++)
+        {
+            Result result;
+            if (!RunAudioStream(conversion, input, result))
+            {
+                break;
+            }
+            streamResult = streamRuns == 0 || result.seconds < streamResult.seconds ? result : streamResult;
+        }
+        if (streamRuns == Repetitions)
+        {
+            PrintResult("SDL_AudioStream", streamResult, duration, "");
+        }
+#endif
+    }
+
+    return EXIT_SUCCESS;
+}
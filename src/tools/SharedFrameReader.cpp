@@ -0,0 +1,281 @@
+/**
+ * @file SharedFrameReader.cpp
+ * @brief Reference reader and benchmark for projectMSDL's shared memory frame output.
+ *
+ * Usage: projectMSDL-frame-reader <name> [seconds]
+ *
+ * Opens the segment published with render.sharedMemory.name, consumes the newest frame in place whenever a
+ * new one is available and reports the throughput, skipped and torn frames and the latency from rendering
+ * until the frame was available to the reader. Every byte of each frame is read, so the throughput includes
+ * the memory bandwidth a real consumer would need. Reopens the segment if projectMSDL recreates or closes it.
+ */
+
+#include "SharedFrameRing.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr auto PollInterval = std::chrono::microseconds(100); //!< Wait time between checks for a new frame.
+constexpr auto ReopenInterval = std::chrono::milliseconds(100); //!< Wait time between attempts to open the segment.
+
+/**
+ * @brief A mapped frame ring segment.
+ */
+struct Segment
+{
+    const char* base{nullptr}; //!< Start of the mapping.
+    size_t size{0}; //!< Size of the mapping.
+
+    const SharedFrameRing::Header* Header() const
+    {
+        return reinterpret_cast<const SharedFrameRing::Header*>(base);
+    }
+};
+
+/**
+ * @brief Collected benchmark values.
+ */
+struct Statistics
+{
+    uint64_t frames{0}; //!< Number of consumed frames.
+    uint64_t skipped{0}; //!< Number of frames published, but never seen by the reader.
+    uint64_t torn{0}; //!< Number of frames overwritten while they were read.
+    uint64_t bytes{0}; //!< Total size of all consumed frames.
+    uint64_t checksum{0}; //!< Sum over all frame data, so reading it can't be optimized away.
+    uint32_t width{0}; //!< Size of the last consumed frame.
+    uint32_t height{0}; //!< Size of the last consumed frame.
+    std::vector<double> latencies; //!< Latency of each consumed frame in milliseconds.
+};
+
+uint64_t Now()
+{
+    // Same clock as the writer's timestamps, std::chrono::steady_clock uses CLOCK_MONOTONIC.
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool OpenSegment(const std::string& name, Segment& segment)
+{
+    int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat status{};
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(SharedFrameRing::Header))
+    {
+        close(fd);
+        return false;
+    }
+
+    void* address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+    {
+        return false;
+    }
+
+    segment.base = static_cast<const char*>(address);
+    segment.size = static_cast<size_t>(status.st_size);
+
+    const auto* header = segment.Header();
+    if (std::memcmp(header->magic, SharedFrameRing::Magic, sizeof(header->magic)) != 0 ||
+        header->version != SharedFrameRing::Version ||
+        header->slotCount != SharedFrameRing::SlotCount ||
+        header->state.load(std::memory_order_acquire) != static_cast<uint32_t>(SharedFrameRing::State::Active) ||
+        SharedFrameRing::SegmentSize(header->slotCapacity) > segment.size)
+    {
+        munmap(address, segment.size);
+        segment = {};
+        return false;
+    }
+
+    return true;
+}
+
+void CloseSegment(Segment& segment)
+{
+    if (segment.base)
+    {
+        munmap(const_cast<char*>(segment.base), segment.size);
+    }
+    segment = {};
+}
+
+uint64_t Consume(const char* data, uint64_t size)
+{
+    uint64_t sum{0};
+    for (uint64_t offset = 0; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+    {
+        uint64_t value;
+        std::memcpy(&value, data + offset, sizeof(value));
+        sum += value;
+    }
+    return sum;
+}
+
+double Percentile(const std::vector<double>& sortedValues, double percentile)
+{
+    if (sortedValues.empty())
+    {
+        return 0.0;
+    }
+
+    auto index = static_cast<size_t>(percentile / 100.0 * static_cast<double>(sortedValues.size() - 1) + 0.5);
+    return sortedValues[std::min(index, sortedValues.size() - 1)];
+}
+
+/**
+ * @brief Consumes the newest frame if there is one.
+ * @return false if the segment was closed and must be reopened.
+ */
+bool ReadFrame(const Segment& segment, uint64_t& lastSequence, Statistics& statistics)
+{
+    const auto* header = segment.Header();
+    if (header->state.load(std::memory_order_acquire) != static_cast<uint32_t>(SharedFrameRing::State::Active))
+    {
+        return false;
+    }
+
+    auto sequence = header->latestSequence.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence == lastSequence)
+    {
+        std::this_thread::sleep_for(PollInterval);
+        return true;
+    }
+
+    auto receiveTime = Now();
+    const auto& slot = header->slots[sequence % SharedFrameRing::SlotCount];
+    if (slot.sequence.load(std::memory_order_acquire) != sequence)
+    {
+        // Already overwritten by a newer frame, which will be picked up next.
+        return true;
+    }
+
+    // The slot header is only valid if the sequence is unchanged afterwards, so bound all values first.
+    auto timestamp = slot.timestamp;
+    auto size = std::min(slot.size, header->slotCapacity);
+    auto dataOffset = std::min(slot.dataOffset, static_cast<uint64_t>(segment.size) - size);
+    auto width = slot.width;
+    auto height = slot.height;
+
+    // A real consumer would upload or composite the pixels here, directly from the segment.
+    auto checksum = Consume(segment.base + dataOffset, size);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+    {
+        statistics.torn++;
+        lastSequence = sequence;
+        return true;
+    }
+
+    if (lastSequence != 0 && sequence > lastSequence + 1)
+    {
+        statistics.skipped += sequence - lastSequence - 1;
+    }
+    lastSequence = sequence;
+
+    statistics.frames++;
+    statistics.bytes += size;
+    statistics.checksum += checksum;
+    statistics.width = width;
+    statistics.height = height;
+    statistics.latencies.push_back(static_cast<double>(receiveTime - timestamp) / 1000000.0);
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <name> [seconds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string name = argv[1];
+    double duration = argc > 2 ? std::atof(argv[2]) : 10.0;
+
+    Segment segment;
+    Statistics statistics;
+    uint64_t lastSequence{0};
+    bool waiting{false};
+
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(duration));
+    auto firstFrameTime = end;
+
+    while (std::chrono::steady_clock::now() < end)
+    {
+        if (!segment.base)
+        {
+            if (!OpenSegment(name, segment))
+            {
+                if (!waiting)
+                {
+                    std::fprintf(stderr, "Waiting for shared memory \"%s\"...\n", name.c_str());
+                    waiting = true;
+                }
+                std::this_thread::sleep_for(ReopenInterval);
+                continue;
+            }
+
+            std::fprintf(stderr, "Opened shared memory \"%s\", %zu bytes.\n", name.c_str(), segment.size);
+            waiting = false;
+            lastSequence = 0;
+        }
+
+        auto framesBefore = statistics.frames;
+        if (!ReadFrame(segment, lastSequence, statistics))
+        {
+            std::fprintf(stderr, "The segment was closed, reopening.\n");
+            CloseSegment(segment);
+            continue;
+        }
+
+        if (framesBefore == 0 && statistics.frames == 1)
+        {
+            firstFrameTime = std::chrono::steady_clock::now();
+        }
+    }
+
+    CloseSegment(segment);
+
+    if (statistics.frames == 0)
+    {
+        std::fprintf(stderr, "No frames received.\n");
+        return EXIT_FAILURE;
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - firstFrameTime).count();
+    std::sort(statistics.latencies.begin(), statistics.latencies.end());
+
+    std::printf("Frames:     %llu (%ux%u), %llu skipped, %llu torn\n",
+                static_cast<unsigned long long>(statistics.frames), statistics.width, statistics.height,
+                static_cast<unsigned long long>(statistics.skipped), static_cast<unsigned long long>(statistics.torn));
+    std::printf("Throughput: %.1f FPS, %.1f MiB/s\n",
+                static_cast<double>(statistics.frames) / elapsed,
+                static_cast<double>(statistics.bytes) / elapsed / (1024.0 * 1024.0));
+    std::printf("Latency:    p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+                Percentile(statistics.latencies, 50.0), Percentile(statistics.latencies, 95.0),
+                Percentile(statistics.latencies, 99.0), statistics.latencies.back());
+    std::printf("Checksum:   %016llx\n", static_cast<unsigned long long>(statistics.checksum));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file AudioBackendTest.cpp
+ * @brief Checks that the native PulseAudio and PipeWire backends deliver captured audio through FillBuffer().
+ *
+ * Opt-in with ENABLE_AUDIO_BACKEND_TESTS, as it requires a running sound server with a null sink as the
+ * default output device:
+ *
+ *     pactl load-module module-null-sink sink_name=projectMSDL_test sink_properties=device.description=projectMSDL-test
+ *     pactl set-default-sink projectMSDL_test
+ *
+ * A sine tone is played into the null sink with the PulseAudio simple API, which pipewire-pulse serves as
+ * well, while each backend captures the sink's monitor. projectm_pcm_add_float() is replaced by a function
+ * collecting the samples, so neither a projectM instance nor an OpenGL context is needed.
+ *
+ * Exits with SkipExitCode if the sound server or the null sink isn't available.
+ */
+
+#include "UnitTest.h"
+
+#include "AudioCaptureImpl_Pulse.h"
+
+#ifdef USE_PIPEWIRE
+#include "AudioCaptureImpl_PipeWire.h"
+#endif
+
+#include <projectM-4/projectM.h>
+
+#include <pulse/error.h>
+#include <pulse/simple.h>
+
+#include <Poco/Util/Application.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int SkipExitCode{77}; //!< Tells CTest the test was skipped.
+constexpr char SinkName[] = "projectMSDL_test"; //!< Name of the null sink the tone is played into.
+constexpr char SinkDescription[] = "projectMSDL-test"; //!< Description of the null sink, as listed by the PipeWire backend.
+constexpr uint32_t SampleRate{44100}; //!< Sample rate of the played tone.
+constexpr float ToneAmplitude{0.5f}; //!< Peak amplitude of the played tone.
+constexpr double RequiredSeconds{0.5}; //!< Captured audio required for a backend to pass.
+constexpr double MinPeak{0.25}; //!< Minimum peak amplitude of the captured audio, to tell the tone from silence.
+constexpr auto Timeout = std::chrono::seconds(5); //!< Maximum time to wait for the required audio.
+constexpr auto FrameInterval = std::chrono::milliseconds(16); //!< Time between two FillBuffer() calls, like a 60 FPS render loop.
+
+/**
+ * @brief Samples received by the projectm_pcm_add_float() replacement.
+ */
+struct CollectedSamples
+{
+    std::mutex mutex; //!< Protects all members, FillBuffer() may be called from any thread.
+    projectm_handle expectedHandle{nullptr}; //!< Handle passed to StartRecording().
+    size_t frames{0}; //!< Number of received sample frames.
+    float peak{0.0f}; //!< Largest absolute sample value.
+    bool wrongHandle{false}; //!< True if a call passed a different handle.
+    bool wrongChannels{false}; //!< True if a call passed anything other than stereo data.
+};
+
+CollectedSamples collectedSamples;
+
+/**
+ * @brief Plays a sine tone into the null sink until stopped.
+ */
+class TonePlayer
+{
+public:
+    ~TonePlayer()
+    {
+        Stop();
+    }
+
+    /**
+     * @brief Opens the playback stream.
+     * @return true if the sound server and the null sink are available.
+     */
+    bool Start()
+    {
+        pa_sample_spec sampleSpec{};
+        sampleSpec.format = PA_SAMPLE_FLOAT32LE;
+        sampleSpec.rate = SampleRate;
+        sampleSpec.channels = 2;
+
+        int error{0};
+        _connection = pa_simple_new(nullptr, "projectMSDL test", PA_STREAM_PLAYBACK, SinkName, "Test tone",
+                                    &sampleSpec, nullptr, nullptr, &error);
+        if (!_connection)
+        {
+            std::fprintf(stderr, "Could not play into the null sink \"%s\": %s\n", SinkName, pa_strerror(error));
+            return false;
+        }
+
+        _playing = true;
+        _thread = std::thread(&TonePlayer::Play, this);
+
+        return true;
+    }
+
+    /**
+     * @brief Stops playing and closes the stream.
+     */
+    void Stop()
+    {
+        _playing = false;
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+
+        if (_connection)
+        {
+            pa_simple_free(_connection);
+            _connection = nullptr;
+        }
+    }
+
+protected:
+    void Play()
+    {
+        // 10 ms blocks of a 1 kHz tone.
+        std::vector<float> block(SampleRate / 100 * 2);
+        uint64_t frame{0};
+
+        while (_playing)
+        {
+            for (size_t index = 0; index < block.size(); index += 2, frame++)
+            {
+                block[index] = ToneAmplitude * static_cast<float>(std::sin(2.0 * 3.14159265358979323846 * 1000.0 * frame / SampleRate));
+                block[index + 1] = block[index];
+            }
+
+            int error{0};
+            if (pa_simple_write(_connection, block.data(), block.size() * sizeof(float), &error) < 0)
+            {
+                std::fprintf(stderr, "Writing the test tone failed: %s\n", pa_strerror(error));
+                return;
+            }
+        }
+    }
+
+    pa_simple* _connection{nullptr}; //!< The playback stream.
+    std::thread _thread; //!< Thread writing the tone.
+    std::atomic_bool _playing{false}; //!< Playback thread exits if set to false.
+};
+
+/**
+ * @brief Captures from the null sink's monitor and checks the samples passed on by FillBuffer().
+ * @param name Backend name for the output.
+ * @param backend The capture backend.
+ * @param deviceIndex Index of the null sink's monitor in the backend's device list.
+ */
+void TestBackend(const char* name, AudioCaptureImpl& backend, int deviceIndex)
+{
+    // Any address will do, the handle is only compared.
+    int handleTarget{0};
+    auto handle = reinterpret_cast<projectm_handle>(&handleTarget);
+
+    {
+        std::lock_guard<std::mutex> lock(collectedSamples.mutex);
+        collectedSamples.expectedHandle = handle;
+        collectedSamples.frames = 0;
+        collectedSamples.peak = 0.0f;
+        collectedSamples.wrongHandle = false;
+        collectedSamples.wrongChannels = false;
+    }
+
+    if (!backend.StartRecording(handle, deviceIndex))
+    {
+        std::fprintf(stderr, "%s: StartRecording() failed.\n", name);
+        UnitTest::Fail(__FILE__, __LINE__, "backend.StartRecording(handle, deviceIndex)");
+        return;
+    }
+
+    const auto requiredFrames = static_cast<size_t>(RequiredSeconds * SampleRate);
+    const auto start = std::chrono::steady_clock::now();
+
+    size_t frames{0};
+    float peak{0.0f};
+    while (std::chrono::steady_clock::now() - start < Timeout)
+    {
+        std::this_thread::sleep_for(FrameInterval);
+        backend.FillBuffer();
+
+        std::lock_guard<std::mutex> lock(collectedSamples.mutex);
+        frames = collectedSamples.frames;
+        peak = collectedSamples.peak;
+        if (frames >= requiredFrames && peak >= MinPeak)
+        {
+            break;
+        }
+    }
+
+    backend.StopRecording();
+
+    std::printf("%s: captured %zu frames from \"%s\", peak %.3f, %llu underruns, %llu overruns\n",
+                name, frames, backend.AudioDeviceName().c_str(), static_cast<double>(peak),
+                static_cast<unsigned long long>(backend.BufferUnderruns()),
+                static_cast<unsigned long long>(backend.BufferOverruns()));
+
+    std::lock_guard<std::mutex> lock(collectedSamples.mutex);
+    UNIT_TEST_CHECK(frames >= requiredFrames);
+    UNIT_TEST_CHECK(peak >= MinPeak);
+    UNIT_TEST_CHECK(peak <= ToneAmplitude * 1.1f);
+    UNIT_TEST_CHECK(!collectedSamples.wrongHandle);
+    UNIT_TEST_CHECK(!collectedSamples.wrongChannels);
+}
+
+#ifdef USE_PIPEWIRE
+/**
+ * @brief Looks up the null sink's monitor in the PipeWire backend's device list.
+ * @param backend The PipeWire backend.
+ * @return The device index, or -2 if the sink wasn't found.
+ */
+int FindPipeWireMonitor(AudioCaptureImpl_PipeWire& backend)
+{
+    const std::string monitorName = std::string("Monitor of ") + SinkDescription;
+    for (const auto& device : backend.AudioDeviceList())
+    {
+        if (device.second == monitorName)
+        {
+            return device.first;
+        }
+    }
+
+    return -2;
+}
+#endif
+
+/**
+ * @brief Provides the application instance the backends read their configuration from.
+ */
+class AudioBackendTest : public Poco::Util::Application
+{
+protected:
+    int main(POCO_UNUSED const std::vector<std::string>& args) override
+    {
+        TonePlayer tonePlayer;
+        if (!tonePlayer.Start())
+        {
+            return SkipExitCode;
+        }
+
+        {
+            AudioCaptureImpl_Pulse backend;
+            // Index 0 is the default sink's monitor.
+            TestBackend("PulseAudio", backend, 0);
+        }
+
+#ifdef USE_PIPEWIRE
+        {
+            AudioCaptureImpl_PipeWire backend;
+            auto deviceIndex = FindPipeWireMonitor(backend);
+            if (deviceIndex == -2)
+            {
+                std::fprintf(stderr, "PipeWire: the null sink \"%s\" is not listed.\n", SinkDescription);
+                UnitTest::Fail(__FILE__, __LINE__, "FindPipeWireMonitor(backend) != -2");
+            }
+            else
+            {
+                TestBackend("PipeWire", backend, deviceIndex);
+            }
+        }
+#endif
+
+        return UnitTest::Result();
+    }
+};
+
+} // namespace
+
+// Replaces libprojectM's function, which AudioSampleQueue::Drain() calls from FillBuffer().
+void projectm_pcm_add_float(projectm_handle instance, const float* samples, unsigned int count, projectm_channels channels)
+{
+    std::lock_guard<std::mutex> lock(collectedSamples.mutex);
+
+    collectedSamples.wrongHandle |= instance != collectedSamples.expectedHandle;
+    collectedSamples.wrongChannels |= channels != PROJECTM_STEREO;
+    collectedSamples.frames += count;
+
+    for (unsigned int index = 0; index < count * static_cast<unsigned int>(channels); index++)
+    {
+        collectedSamples.peak = std::max(collectedSamples.peak, std::abs(samples[index]));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Poco::AutoPtr<AudioBackendTest> application = new AudioBackendTest;
+    application->init(argc, argv);
+
+    return application->run();
+}
@@ -0,0 +1,236 @@
+/**
+ * @file AudioBroadcastRingTest.cpp
+ * @brief Checks the reader semantics of AudioBroadcastRing, including lag and torn copy detection.
+ *
+ * Each sample written to the ring is its stream position modulo 2^24, which a float represents exactly.
+ * A reader can therefore verify every returned sample against its own position, which also catches a
+ * copy mixing old and new data that wasn't reported as lagged.
+ */
+
+#include "UnitTest.h"
+
+#include "AudioBroadcastRing.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t Capacity{256}; //!< Ring capacity in floats, small enough to lap readers quickly.
+constexpr size_t StressWrites{200000}; //!< Number of blocks written in the threaded test.
+constexpr size_t StressBlockSize{48}; //!< Floats per block in the threaded test, not a divisor of the capacity.
+
+/**
+ * @brief Exposes the write announcement, so a test can simulate a producer being preempted mid-write.
+ */
+class TestRing : public AudioBroadcastRing
+{
+public:
+    using AudioBroadcastRing::AudioBroadcastRing;
+
+    void AnnounceWrite(size_t end)
+    {
+        BeginWrite(end);
+    }
+};
+
+float SampleAt(size_t position)
+{
+    return static_cast<float>(position & 0xFFFFFF);
+}
+
+/**
+ * @brief Writes the expected samples for the given stream range.
+ * @param ring The ring to write to.
+ * @param count Number of floats to write, continuing at the ring's write position.
+ */
+void WriteSequence(AudioBroadcastRing& ring, size_t count)
+{
+    std::vector<float> samples(count);
+    auto position = ring.WritePosition();
+    for (size_t index = 0; index < count; index++)
+    {
+        samples[index] = SampleAt(position + index);
+    }
+
+    ring.Write(samples.data(), count);
+}
+
+/**
+ * @brief Checks that the given samples match the stream starting at a position.
+ * @param samples The samples returned by a read.
+ * @param count Number of floats to check.
+ * @param position Stream position of the first sample.
+ * @return true if all samples are as expected.
+ */
+bool IsSequence(const float* samples, size_t count, size_t position)
+{
+    for (size_t index = 0; index < count; index++)
+    {
+        if (samples[index] != SampleAt(position + index))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TestIndependentReaders()
+{
+    std::unique_ptr<AudioBroadcastRing> ring(new AudioBroadcastRing(Capacity - 1));
+    UNIT_TEST_CHECK(ring->Capacity() == Capacity);
+
+    auto first = ring->CreateReader();
+    WriteSequence(*ring, 100);
+    auto second = ring->CreateReader();
+    WriteSequence(*ring, 100);
+
+    // Each reader starts at the newest sample and reads at its own pace, across the wrap-around point.
+    std::vector<float> samples(Capacity);
+    size_t count{0};
+    UNIT_TEST_CHECK(first.Read(samples.data(), 150, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == 150 && IsSequence(samples.data(), count, 0));
+
+    UNIT_TEST_CHECK(second.Available() == 100);
+    UNIT_TEST_CHECK(second.Read(samples.data(), Capacity, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == 100 && IsSequence(samples.data(), count, 100));
+
+    WriteSequence(*ring, 100);
+    UNIT_TEST_CHECK(first.Discard(20) == 20);
+    UNIT_TEST_CHECK(first.Read(samples.data(), Capacity, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == 130 && IsSequence(samples.data(), count, 170));
+    UNIT_TEST_CHECK(first.Read(samples.data(), Capacity, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == 0);
+
+    UNIT_TEST_CHECK(second.Read(samples.data(), Capacity, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == 100 && IsSequence(samples.data(), count, 200));
+}
+
+void TestLagged()
+{
+    std::unique_ptr<AudioBroadcastRing> ring(new AudioBroadcastRing(Capacity));
+    auto reader = ring->CreateReader();
+    std::vector<float> samples(Capacity);
+    size_t count{0};
+
+    // Exactly one lap behind is still readable.
+    WriteSequence(*ring, Capacity);
+    UNIT_TEST_CHECK(reader.Read(samples.data(), Capacity, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == Capacity && IsSequence(samples.data(), count, 0));
+
+    // One more sample overwrites the oldest unread one.
+    WriteSequence(*ring, Capacity);
+    WriteSequence(*ring, 1);
+    UNIT_TEST_CHECK(reader.Read(samples.data(), 10, count) == AudioBroadcastRing::ReadStatus::Lagged);
+    UNIT_TEST_CHECK(count == 0);
+    UNIT_TEST_CHECK(reader.Position() == ring->WritePosition());
+
+    // The reader continues with the newest data.
+    WriteSequence(*ring, 10);
+    UNIT_TEST_CHECK(reader.Read(samples.data(), Capacity, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == 10 && IsSequence(samples.data(), count, 2 * Capacity + 1));
+
+    // Writes larger than the capacity only store the newest samples, so the positions advance by the capacity.
+    WriteSequence(*ring, 3 * Capacity);
+    UNIT_TEST_CHECK(reader.Available() == Capacity);
+    UNIT_TEST_CHECK(reader.Read(samples.data(), Capacity, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == Capacity && IsSequence(samples.data(), count, 4 * Capacity + 11));
+}
+
+void TestTornCopy()
+{
+    std::unique_ptr<TestRing> ring(new TestRing(Capacity));
+    auto reader = ring->CreateReader();
+    std::vector<float> samples(Capacity);
+    size_t count{0};
+
+    WriteSequence(*ring, 100);
+
+    // A pending write into free slots doesn't touch the unread samples.
+    ring->AnnounceWrite(Capacity);
+    UNIT_TEST_CHECK(reader.Read(samples.data(), 50, count) == AudioBroadcastRing::ReadStatus::Ok);
+    UNIT_TEST_CHECK(count == 50 && IsSequence(samples.data(), count, 0));
+
+    // A pending write reaching the reader's slots may have modified them during the copy, even though
+    // the write position still says the samples are valid.
+    ring->AnnounceWrite(Capacity + 51);
+    UNIT_TEST_CHECK(reader.Available() == 50);
+    UNIT_TEST_CHECK(reader.Read(samples.data(), 50, count) == AudioBroadcastRing::ReadStatus::Lagged);
+    UNIT_TEST_CHECK(count == 0);
+    UNIT_TEST_CHECK(reader.Position() == 100);
+}
+
+void TestConcurrentReader()
+{
+    std::unique_ptr<AudioBroadcastRing> ring(new AudioBroadcastRing(Capacity));
+    auto reader = ring->CreateReader();
+    std::atomic_bool writing{true};
+
+    std::thread writer([&ring, &writing]() {
+        for (size_t block = 0; block < StressWrites; block++)
+        {
+            WriteSequence(*ring, StressBlockSize);
+
+            // Lets the reader run in between on machines with a single core.
+            if (block % 4 == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+        writing = false;
+    });
+
+    std::vector<float> samples(Capacity);
+    size_t okReads{0};
+    size_t laggedReads{0};
+    size_t corruptReads{0};
+    size_t readSize{1};
+    while (writing)
+    {
+        auto position = reader.Position();
+        size_t count{0};
+        if (reader.Read(samples.data(), readSize, count) == AudioBroadcastRing::ReadStatus::Lagged)
+        {
+            laggedReads++;
+            continue;
+        }
+
+        if (count == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        okReads++;
+        if (!IsSequence(samples.data(), count, position))
+        {
+            corruptReads++;
+        }
+
+        // Vary the read size, so reads regularly span a block being written.
+        readSize = readSize % Capacity + 7;
+    }
+
+    writer.join();
+
+    std::printf("Concurrent reads: %zu ok, %zu lagged, %zu corrupt\n", okReads, laggedReads, corruptReads);
+
+    UNIT_TEST_CHECK(okReads > 0);
+    UNIT_TEST_CHECK(corruptReads == 0);
+}
+
+} // namespace
+
+int main()
+{
+    TestIndependentReaders();
+    TestLagged();
+    TestTornCopy();
+    TestConcurrentReader();
+
+    return UnitTest::Result();
+}
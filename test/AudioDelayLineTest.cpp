@@ -0,0 +1,169 @@
+/**
+ * @file AudioDelayLineTest.cpp
+ * @brief Checks the delay clamping and the output of AudioDelayLine for various block sizes.
+ *
+ * Each input sample is its stream position plus one, and the channel number in the fractional part, so
+ * the expected output for a delay of N frames is the input from N frames earlier, or silence before the
+ * start of the stream.
+ */
+
+#include "UnitTest.h"
+
+#include "AudioDelayLine.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t SampleRate{1000}; //!< Low sample rate, so one millisecond is one frame.
+constexpr size_t HistoryFrames{static_cast<size_t>(AudioDelayLine::MaxDelay * SampleRate)}; //!< Frames in the maximum delay.
+
+float SampleAt(size_t frame, uint32_t channel)
+{
+    return static_cast<float>(frame + 1) + static_cast<float>(channel) * 0.25f;
+}
+
+/**
+ * @brief Processes a stream in blocks of the given sizes and checks the output against the delayed input.
+ * @param delayLine The configured delay line.
+ * @param channels The number of channels the delay line was configured with.
+ * @param delayFrames The expected delay in frames.
+ * @param blockSizes The sizes of consecutive blocks in frames. The last one is repeated until @a totalFrames.
+ * @param totalFrames The total number of frames to process.
+ * @param inPlace If true, the output overwrites the input buffer.
+ * @return true if all output samples were as expected.
+ */
+bool ProcessStream(AudioDelayLine& delayLine, uint32_t channels, size_t delayFrames,
+                   std::initializer_list<size_t> blockSizes, size_t totalFrames, bool inPlace)
+{
+    std::vector<float> input;
+    std::vector<float> output;
+    auto blockSize = blockSizes.begin();
+    size_t frame{0};
+    bool matches{true};
+
+    while (frame < totalFrames)
+    {
+        auto frames = std::min(*blockSize, totalFrames - frame);
+        if (blockSize + 1 != blockSizes.end())
+        {
+            ++blockSize;
+        }
+
+        input.resize(frames * channels);
+        for (size_t index = 0; index < frames; index++)
+        {
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                input[index * channels + channel] = SampleAt(frame + index, channel);
+            }
+        }
+
+        output.resize(input.size());
+        auto* destination = inPlace ? input.data() : output.data();
+        delayLine.Process(input.data(), frames, destination);
+
+        for (size_t index = 0; index < frames; index++)
+        {
+            auto streamFrame = frame + index;
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                auto expected = streamFrame >= delayFrames ? SampleAt(streamFrame - delayFrames, channel) : 0.0f;
+                matches = matches && destination[index * channels + channel] == expected;
+            }
+        }
+
+        frame += frames;
+    }
+
+    return matches;
+}
+
+void TestClamping()
+{
+    AudioDelayLine delayLine;
+    UNIT_TEST_CHECK(delayLine.Delay() == 0.0);
+
+    delayLine.Delay(0.1);
+    UNIT_TEST_CHECK(delayLine.Delay() == 0.1);
+
+    delayLine.Delay(-1.0);
+    UNIT_TEST_CHECK(delayLine.Delay() == 0.0);
+
+    delayLine.Delay(AudioDelayLine::MaxDelay + 1.0);
+    UNIT_TEST_CHECK(delayLine.Delay() == AudioDelayLine::MaxDelay);
+
+    // The delay is kept when the format changes.
+    delayLine.Configure(SampleRate, 2);
+    UNIT_TEST_CHECK(delayLine.Delay() == AudioDelayLine::MaxDelay);
+}
+
+void TestPassThrough()
+{
+    // Before the first Configure() call, the input is copied unchanged, whatever the delay.
+    AudioDelayLine delayLine;
+    delayLine.Delay(0.1);
+    UNIT_TEST_CHECK(ProcessStream(delayLine, 2, 0, {100}, 300, false));
+
+    // A zero delay outputs each frame as soon as it was stored.
+    delayLine.Configure(SampleRate, 2);
+    delayLine.Delay(0.0);
+    UNIT_TEST_CHECK(ProcessStream(delayLine, 2, 0, {1, 7, HistoryFrames + 100}, 3000, false));
+}
+
+void TestDelay()
+{
+    AudioDelayLine delayLine;
+    delayLine.Delay(0.1);
+
+    // Blocks smaller and larger than the delay, and one larger than the whole history.
+    delayLine.Configure(SampleRate, 2);
+    UNIT_TEST_CHECK(ProcessStream(delayLine, 2, 100, {1, 99, 150, 2 * HistoryFrames, 33}, 5000, false));
+
+    delayLine.Configure(SampleRate, 1);
+    UNIT_TEST_CHECK(ProcessStream(delayLine, 1, 100, {250, 64}, 5000, true));
+
+    // The maximum delay uses the whole history.
+    delayLine.Delay(AudioDelayLine::MaxDelay);
+    delayLine.Configure(SampleRate, 2);
+    UNIT_TEST_CHECK(ProcessStream(delayLine, 2, HistoryFrames, {HistoryFrames + 1, 17, 480}, 5000, true));
+}
+
+void TestDelayChange()
+{
+    AudioDelayLine delayLine;
+    delayLine.Configure(SampleRate, 1);
+    delayLine.Delay(0.2);
+
+    std::vector<float> samples(1);
+    for (size_t frame = 0; frame < 1000; frame++)
+    {
+        samples[0] = SampleAt(frame, 0);
+        delayLine.Process(samples.data(), 1, samples.data());
+    }
+
+    // Changing the delay moves the read position within the history, no samples are lost or cleared.
+    delayLine.Delay(0.05);
+    samples[0] = SampleAt(1000, 0);
+    delayLine.Process(samples.data(), 1, samples.data());
+    UNIT_TEST_CHECK(samples[0] == SampleAt(950, 0));
+
+    delayLine.Delay(0.3);
+    samples[0] = SampleAt(1001, 0);
+    delayLine.Process(samples.data(), 1, samples.data());
+    UNIT_TEST_CHECK(samples[0] == SampleAt(701, 0));
+}
+
+} // namespace
+
+int main()
+{
+    TestClamping();
+    TestPassThrough();
+    TestDelay();
+    TestDelayChange();
+
+    return UnitTest::Result();
+}
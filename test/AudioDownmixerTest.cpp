@@ -0,0 +1,218 @@
+/**
+ * @file AudioDownmixerTest.cpp
+ * @brief Checks the default and configured downmix matrices of AudioDownmixer.
+ *
+ * The input consists of single-channel impulses with power-of-two amplitudes, so every output sample is
+ * exactly one coefficient times the amplitude, no matter in which order the SIMD kernel adds the products.
+ * Enough frames are processed to run both the vector kernel and the scalar tail.
+ */
+
+#include "UnitTest.h"
+
+#include "AudioDownmixer.h"
+
+#include <Poco/AutoPtr.h>
+
+#include <Poco/Util/MapConfiguration.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr float Minus3dB{0.7071f};
+constexpr float Minus6dB{0.5f};
+
+/**
+ * @brief Expected downmix matrix for a channel layout.
+ */
+struct Layout
+{
+    const char* name; //!< Layout name for failure messages.
+    uint32_t channels; //!< Number of input channels.
+    std::vector<float> left; //!< Expected weight of each input channel in the left output.
+    std::vector<float> right; //!< Expected weight of each input channel in the right output.
+};
+
+/**
+ * @brief Creates frames with a single non-zero channel each, cycling through all channels.
+ * @param channels Number of interleaved channels.
+ * @param frames Number of sample frames.
+ * @return The interleaved samples.
+ */
+std::vector<float> CreateImpulses(uint32_t channels, size_t frames)
+{
+    std::vector<float> samples(frames * channels, 0.0f);
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        // 1, -0.5, 0.25, ... for each pass through the channels.
+        auto pass = static_cast<int>(frame / channels);
+        samples[frame * channels + frame % channels] = std::ldexp(pass % 2 ? -1.0f : 1.0f, -pass);
+    }
+
+    return samples;
+}
+
+/**
+ * @brief Downmixes impulses and compares each output frame with the expected coefficients.
+ * @param downmixer The configured downmixer.
+ * @param layout The expected matrix.
+ * @param inPlace If true, the output overwrites the input buffer. Requires at least two channels.
+ */
+void CheckMatrix(const AudioDownmixer& downmixer, const Layout& layout, bool inPlace)
+{
+    const size_t frames = layout.channels * 3 + 5;
+    auto input = CreateImpulses(layout.channels, frames);
+
+    std::vector<float> separateOutput(frames * 2, -100.0f);
+    float* output = inPlace ? input.data() : separateOutput.data();
+    auto expectedInput = CreateImpulses(layout.channels, frames);
+
+    downmixer.Process(input.data(), frames, output);
+
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        auto channel = frame % layout.channels;
+        auto amplitude = expectedInput[frame * layout.channels + channel];
+
+        if (output[frame * 2] != layout.left[channel] * amplitude ||
+            output[frame * 2 + 1] != layout.right[channel] * amplitude)
+        {
+            std::fprintf(stderr, "%s%s, frame %zu, channel %zu: got L=%.9g R=%.9g, expected L=%.9g R=%.9g\n",
+                         layout.name, inPlace ? " (in place)" : "", frame, channel,
+                         static_cast<double>(output[frame * 2]), static_cast<double>(output[frame * 2 + 1]),
+                         static_cast<double>(layout.left[channel] * amplitude),
+                         static_cast<double>(layout.right[channel] * amplitude));
+            UnitTest::Fail(__FILE__, __LINE__, "output == coefficient * amplitude");
+        }
+    }
+}
+
+void TestDefaultLayouts()
+{
+    const Layout layouts[]{
+        {"Mono", 1, {1.0f}, {1.0f}},
+        {"Stereo", 2, {1.0f, 0.0f}, {0.0f, 1.0f}},
+        {"3.0 (FL FR LFE)", 3, {1.0f, 0.0f, Minus6dB}, {0.0f, 1.0f, Minus6dB}},
+        {"Quad (FL FR BL BR)", 4, {1.0f, 0.0f, Minus3dB, 0.0f}, {0.0f, 1.0f, 0.0f, Minus3dB}},
+        {"5.0 (FL FR LFE BL BR)", 5, {1.0f, 0.0f, Minus6dB, Minus3dB, 0.0f}, {0.0f, 1.0f, Minus6dB, 0.0f, Minus3dB}},
+        {"5.1 (FL FR FC LFE SL SR)", 6,
+         {1.0f, 0.0f, Minus3dB, Minus6dB, Minus3dB, 0.0f},
+         {0.0f, 1.0f, Minus3dB, Minus6dB, 0.0f, Minus3dB}},
+        {"6.1 (FL FR FC LFE BC SL SR)", 7,
+         {1.0f, 0.0f, Minus3dB, Minus6dB, Minus6dB, Minus3dB, 0.0f},
+         {0.0f, 1.0f, Minus3dB, Minus6dB, Minus6dB, 0.0f, Minus3dB}},
+        {"7.1 (FL FR FC LFE BL BR SL SR)", 8,
+         {1.0f, 0.0f, Minus3dB, Minus6dB, Minus3dB, 0.0f, Minus3dB, 0.0f},
+         {0.0f, 1.0f, Minus3dB, Minus6dB, 0.0f, Minus3dB, 0.0f, Minus3dB}},
+        {"10 channels, scalar only", 10,
+         {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+         {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}},
+    };
+
+    Poco::AutoPtr<Poco::Util::MapConfiguration> config(new Poco::Util::MapConfiguration);
+
+    for (const auto& layout : layouts)
+    {
+        AudioDownmixer downmixer;
+        downmixer.Configure(layout.channels, *config);
+
+        UNIT_TEST_CHECK(downmixer.Active() == (layout.channels > 2));
+        UNIT_TEST_CHECK(downmixer.OutputChannels() == (layout.channels > 2 ? 2 : layout.channels));
+
+        CheckMatrix(downmixer, layout, false);
+        if (layout.channels >= 2)
+        {
+            CheckMatrix(downmixer, layout, true);
+        }
+    }
+}
+
+void TestMixedFrame()
+{
+    // All channels at once, which exercises the horizontal sums of the vector kernel.
+    Poco::AutoPtr<Poco::Util::MapConfiguration> config(new Poco::Util::MapConfiguration);
+
+    AudioDownmixer downmixer;
+    downmixer.Configure(8, *config);
+
+    const float frame[8]{0.5f, 0.25f, 0.125f, 1.0f, -0.5f, 0.75f, 0.0625f, -0.25f};
+    std::vector<float> input;
+    for (int copy = 0; copy < 4; copy++)
+    {
+        input.insert(input.end(), std::begin(frame), std::end(frame));
+    }
+
+    std::vector<float> output(8);
+    downmixer.Process(input.data(), 4, output.data());
+
+    const double expectedLeft = 0.5 + 0.7071 * 0.125 + 0.5 * 1.0 + 0.7071 * -0.5 + 0.7071 * 0.0625;
+    const double expectedRight = 0.25 + 0.7071 * 0.125 + 0.5 * 1.0 + 0.7071 * 0.75 + 0.7071 * -0.25;
+    for (size_t index = 0; index < 4; index++)
+    {
+        UNIT_TEST_CHECK(std::abs(output[index * 2] - expectedLeft) < 1e-6);
+        UNIT_TEST_CHECK(std::abs(output[index * 2 + 1] - expectedRight) < 1e-6);
+    }
+}
+
+void TestConfiguredWeights()
+{
+    Poco::AutoPtr<Poco::Util::MapConfiguration> config(new Poco::Util::MapConfiguration);
+    config->setString("audio.downmix.6.left", "1, 0, 0.5, 0.25, 0.125, 0");
+    config->setString("audio.downmix.6.right", "0,1,0.5,0.25,0,0.125");
+    config->setString("audio.downmix.4.left", "0.5, 0.5, 0.5, 0.5");
+    config->setString("audio.downmix.4.right", "-1, 2");
+    config->setString("audio.downmix.8.left", "1, 0, 0, 0, 0, 0, 0, zero");
+    Poco::AutoPtr<Poco::Util::AbstractConfiguration> audioConfig = config->createView("audio");
+
+    {
+        AudioDownmixer downmixer;
+        downmixer.Configure(6, *audioConfig);
+        CheckMatrix(downmixer, {"Configured 5.1", 6,
+                                {1.0f, 0.0f, 0.5f, 0.25f, 0.125f, 0.0f},
+                                {0.0f, 1.0f, 0.5f, 0.25f, 0.0f, 0.125f}},
+                    false);
+    }
+
+    {
+        // The right list has the wrong length, so it falls back to the default.
+        AudioDownmixer downmixer;
+        downmixer.Configure(4, *audioConfig);
+        CheckMatrix(downmixer, {"Configured quad, invalid right list", 4,
+                                {0.5f, 0.5f, 0.5f, 0.5f},
+                                {0.0f, 1.0f, 0.0f, Minus3dB}},
+                    false);
+    }
+
+    {
+        // Invalid numbers fall back to the default as well.
+        AudioDownmixer downmixer;
+        downmixer.Configure(8, *audioConfig);
+        CheckMatrix(downmixer, {"Configured 7.1, invalid left list", 8,
+                                {1.0f, 0.0f, Minus3dB, Minus6dB, Minus3dB, 0.0f, Minus3dB, 0.0f},
+                                {0.0f, 1.0f, Minus3dB, Minus6dB, 0.0f, Minus3dB, 0.0f, Minus3dB}},
+                    false);
+    }
+
+    {
+        // Settings for other channel counts don't apply.
+        AudioDownmixer downmixer;
+        downmixer.Configure(5, *audioConfig);
+        CheckMatrix(downmixer, {"5.0 with other layouts configured", 5,
+                                {1.0f, 0.0f, Minus6dB, Minus3dB, 0.0f},
+                                {0.0f, 1.0f, Minus6dB, 0.0f, Minus3dB}},
+                    false);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    TestDefaultLayouts();
+    TestMixedFrame();
+    TestConfiguredWeights();
+
+    return UnitTest::Result();
+}
@@ -0,0 +1,205 @@
+/**
+ * @file AudioFramePacerTest.cpp
+ * @brief Checks the delivered frame counts, backlog adaptation and underrun/overrun counters of AudioFramePacer.
+ *
+ * Render frames are simulated at 64 FPS, as 1/64 s is exactly representable and the elapsed time of each
+ * step is therefore free of rounding errors.
+ */
+
+#include "UnitTest.h"
+
+#include "AudioFramePacer.h"
+
+namespace {
+
+constexpr uint32_t SampleRate{48000}; //!< Simulated capture sample rate.
+constexpr uint32_t DeviceBufferFrames{480}; //!< Simulated driver callback size.
+constexpr double FrameTime{1.0 / 64.0}; //!< Simulated render frame period in seconds.
+constexpr size_t FramesPerStep{750}; //!< Sample frames per render frame, SampleRate * FrameTime.
+constexpr size_t BacklogStep{DeviceBufferFrames / 4}; //!< Target backlog change per underrun.
+constexpr size_t MaximumBacklog{DeviceBufferFrames * 4}; //!< Highest target backlog.
+
+/**
+ * @brief Exposes the pacer's timing constants to the test.
+ */
+class TestPacer : public AudioFramePacer
+{
+public:
+    using AudioFramePacer::BacklogShrinkInterval;
+    using AudioFramePacer::MaxCorrectionDivisor;
+    using AudioFramePacer::MaxElapsedTime;
+};
+
+/**
+ * @brief Resets the pacer and performs the initial step with an exactly filled backlog.
+ * @param pacer The pacer to start.
+ * @param now The start time.
+ */
+void Start(TestPacer& pacer, double now)
+{
+    pacer.Reset(SampleRate, DeviceBufferFrames);
+    auto step = pacer.Advance(now, pacer.TargetBacklog());
+    UNIT_TEST_CHECK(step.framesToSkip == 0 && step.framesToDeliver == 0);
+}
+
+void TestStart()
+{
+    TestPacer pacer;
+    pacer.Reset(SampleRate, DeviceBufferFrames);
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == DeviceBufferFrames);
+
+    // Anything above the target backlog is skipped on the first step, nothing is delivered.
+    auto step = pacer.Advance(10.0, 2000);
+    UNIT_TEST_CHECK(step.framesToSkip == 2000 - DeviceBufferFrames);
+    UNIT_TEST_CHECK(step.framesToDeliver == 0);
+
+    // Each step delivers the frames corresponding to the elapsed time.
+    step = pacer.Advance(10.0 + FrameTime, DeviceBufferFrames + FramesPerStep);
+    UNIT_TEST_CHECK(step.framesToSkip == 0);
+    UNIT_TEST_CHECK(step.framesToDeliver == FramesPerStep);
+
+    // A stalled render loop only gets the frames of the maximum elapsed time.
+    step = pacer.Advance(12.0, static_cast<size_t>(TestPacer::MaxElapsedTime * SampleRate) + DeviceBufferFrames);
+    UNIT_TEST_CHECK(step.framesToDeliver == static_cast<size_t>(TestPacer::MaxElapsedTime * SampleRate));
+    UNIT_TEST_CHECK(pacer.Underruns() == 0 && pacer.Overruns() == 0);
+}
+
+void TestFractionalFrames()
+{
+    // At 1000 Hz, each step is 15.625 frames, and the remainders add up to whole frames.
+    TestPacer pacer;
+    pacer.Reset(1000, 16);
+    pacer.Advance(0.0, 16);
+
+    size_t delivered{0};
+    for (int frame = 1; frame <= 64; frame++)
+    {
+        auto step = pacer.Advance(frame * FrameTime, 100);
+        UNIT_TEST_CHECK(step.framesToDeliver == 15 || step.framesToDeliver == 16);
+        delivered += step.framesToDeliver;
+    }
+
+    UNIT_TEST_CHECK(delivered == 1000);
+}
+
+void TestUnderrun()
+{
+    TestPacer pacer;
+    double now{0.0};
+    Start(pacer, now);
+
+    // Only what's available is delivered, and the target backlog grows by a quarter device buffer.
+    now += FrameTime;
+    auto step = pacer.Advance(now, 100);
+    UNIT_TEST_CHECK(step.framesToSkip == 0 && step.framesToDeliver == 100);
+    UNIT_TEST_CHECK(pacer.Underruns() == 1);
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == DeviceBufferFrames + BacklogStep);
+
+    // The target backlog is limited to four device buffers.
+    for (int frame = 0; frame < 20; frame++)
+    {
+        now += FrameTime;
+        pacer.Advance(now, 0);
+    }
+
+    UNIT_TEST_CHECK(pacer.Underruns() == 21);
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == MaximumBacklog);
+
+    // Without underruns, the target backlog shrinks by one step per interval.
+    auto shrinkTime = now + TestPacer::BacklogShrinkInterval;
+    while (now + FrameTime < shrinkTime)
+    {
+        now += FrameTime;
+        pacer.Advance(now, MaximumBacklog + FramesPerStep);
+    }
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == MaximumBacklog);
+
+    now += FrameTime;
+    pacer.Advance(now, MaximumBacklog + FramesPerStep);
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == MaximumBacklog - BacklogStep);
+    UNIT_TEST_CHECK(pacer.Underruns() == 21);
+
+    // A reset clears the counters.
+    pacer.Reset(SampleRate, DeviceBufferFrames);
+    UNIT_TEST_CHECK(pacer.Underruns() == 0);
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == DeviceBufferFrames);
+}
+
+void TestOverrun()
+{
+    TestPacer pacer;
+    double now{0.0};
+    Start(pacer, now);
+
+    // One device buffer on top of the maximum backlog is tolerated.
+    now += FrameTime;
+    auto step = pacer.Advance(now, FramesPerStep + MaximumBacklog + DeviceBufferFrames);
+    UNIT_TEST_CHECK(step.framesToSkip == 0 && step.framesToDeliver == FramesPerStep);
+    UNIT_TEST_CHECK(pacer.Overruns() == 0);
+
+    // Beyond that, the backlog is cut back to the target after delivering.
+    now += FrameTime;
+    step = pacer.Advance(now, FramesPerStep + MaximumBacklog + DeviceBufferFrames + 1);
+    UNIT_TEST_CHECK(step.framesToDeliver == FramesPerStep);
+    UNIT_TEST_CHECK(step.framesToSkip == MaximumBacklog + 1);
+    UNIT_TEST_CHECK(pacer.Overruns() == 1);
+    UNIT_TEST_CHECK(pacer.Underruns() == 0);
+}
+
+void TestDriftCorrection()
+{
+    TestPacer pacer;
+    Start(pacer, 0.0);
+
+    // The buffer permanently holds 1000 frames more than the target, as if the audio clock ran faster.
+    constexpr size_t excess{1000};
+    const size_t available = DeviceBufferFrames + excess + FramesPerStep;
+    const size_t maxCorrection = FramesPerStep / TestPacer::MaxCorrectionDivisor;
+
+    // The first interval's low-water mark includes the initial step at the target backlog, so the excess
+    // is measured in the second one. Nothing is corrected until then.
+    int frame{1};
+    for (; frame <= 128; frame++)
+    {
+        auto step = pacer.Advance(frame * FrameTime, available);
+        UNIT_TEST_CHECK(step.framesToDeliver == FramesPerStep);
+    }
+
+    // During the next interval, half of the excess is delivered in small extra portions.
+    size_t corrected{0};
+    for (; frame <= 192; frame++)
+    {
+        auto step = pacer.Advance(frame * FrameTime, available);
+        UNIT_TEST_CHECK(step.framesToDeliver >= FramesPerStep);
+        UNIT_TEST_CHECK(step.framesToDeliver <= FramesPerStep + maxCorrection);
+        corrected += step.framesToDeliver - FramesPerStep;
+    }
+
+    UNIT_TEST_CHECK(corrected == excess / 2);
+    UNIT_TEST_CHECK(pacer.Underruns() == 0 && pacer.Overruns() == 0);
+}
+
+void TestLowLatency()
+{
+    TestPacer pacer;
+    pacer.LowLatency(true);
+    pacer.Reset(SampleRate, DeviceBufferFrames);
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == BacklogStep);
+
+    pacer.LowLatency(false);
+    UNIT_TEST_CHECK(pacer.TargetBacklog() == DeviceBufferFrames);
+}
+
+} // namespace
+
+int main()
+{
+    TestStart();
+    TestFractionalFrames();
+    TestUnderrun();
+    TestOverrun();
+    TestDriftCorrection();
+    TestLowLatency();
+
+    return UnitTest::Result();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file FPSLimiterTest.cpp
+ * @brief Checks that FPSLimiter keeps the mean frame period within 0.1% of the target.
+ *
+ * Each run renders RunTime seconds worth of frames with a varying amount of busy-waiting as simulated work, then
+ * compares the mean period between EndFrame() returns with the target frame time. As a missed deadline
+ * on a busy machine legitimately skips a frame, a target passes if any of Attempts runs is within bounds.
+ */
+
+#include "UnitTest.h"
+
+#include "FPSLimiter.h"
+
+#define SDL_MAIN_HANDLED
+#include <SDL2/SDL.h>
+
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr int RunTime{2}; //!< Length of each run in seconds.
+constexpr int Attempts{3}; //!< Number of runs before a target frame rate fails.
+constexpr double MaxDeviation{0.001}; //!< Allowed relative deviation of the mean frame period.
+constexpr double MaxLoad{0.5}; //!< Maximum simulated work as a fraction of the frame time.
+
+void Work(double seconds)
+{
+    auto end = SDL_GetPerformanceCounter() + static_cast<uint64_t>(seconds * static_cast<double>(SDL_GetPerformanceFrequency()));
+    while (SDL_GetPerformanceCounter() < end)
+    {
+    }
+}
+
+/**
+ * @brief Runs the limiter at a fixed frame rate.
+ * @param fps The target frame rate.
+ * @param[out] measuredFPS The limiter's own FPS value after the run.
+ * @return The mean frame period in seconds.
+ */
+double MeasurePeriod(int fps, float& measuredFPS)
+{
+    const double frameTime = 1.0 / fps;
+    const auto frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+
+    FPSLimiter limiter;
+    limiter.TargetFPS(fps);
+
+    const int frames = fps * RunTime;
+
+    uint32_t random{12345};
+    uint64_t firstFrameEnd{0};
+    uint64_t lastFrameEnd{0};
+
+    // The first frame starts the schedule and is not measured.
+    for (int frame = 0; frame <= frames; frame++)
+    {
+        limiter.StartFrame();
+
+        random = random * 1664525u + 1013904223u;
+        Work(frameTime * MaxLoad * static_cast<double>(random >> 8) / 16777216.0);
+
+        limiter.EndFrame();
+
+        lastFrameEnd = SDL_GetPerformanceCounter();
+        if (frame == 0)
+        {
+            firstFrameEnd = lastFrameEnd;
+        }
+    }
+
+    measuredFPS = limiter.FPS();
+    return static_cast<double>(lastFrameEnd - firstFrameEnd) / frequency / frames;
+}
+
+void TestTargetFPS(int fps)
+{
+    const double frameTime = 1.0 / fps;
+
+    bool withinBounds{false};
+    for (int attempt = 0; attempt < Attempts && !withinBounds; attempt++)
+    {
+        float measuredFPS{0.0f};
+        auto period = MeasurePeriod(fps, measuredFPS);
+        auto deviation = std::abs(period - frameTime) / frameTime;
+
+        std::printf("%d FPS: mean period %.4f ms, expected %.4f ms, deviation %.3f%%, FPS() %.2f\n",
+                    fps, period * 1000.0, frameTime * 1000.0, deviation * 100.0, static_cast<double>(measuredFPS));
+
+        withinBounds = deviation <= MaxDeviation;
+    }
+
+    UNIT_TEST_CHECK(withinBounds);
+}
+
+} // namespace
+
+int main()
+{
+    TestTargetFPS(30);
+    TestTargetFPS(60);
+    TestTargetFPS(144);
+
+    return UnitTest::Result();
+}
@@ -0,0 +1,146 @@
+/**
+ * @file FrameTimeHistogramTest.cpp
+ * @brief Checks the percentiles, bucket resolution and statistics of FrameTimeHistogram.
+ */
+
+#include "UnitTest.h"
+
+#include "FrameTimeHistogram.h"
+
+#include <initializer_list>
+
+namespace {
+
+/**
+ * @brief Checks that a percentile lies within the histogram's resolution above the exact value.
+ * @param value The percentile returned by the histogram.
+ * @param exact The exact percentile of the recorded values.
+ * @return true if the value is at least @a exact and at most one sub-bucket width larger.
+ */
+bool IsWithinResolution(uint32_t value, uint32_t exact)
+{
+    return value >= exact && value - exact <= exact / FrameTimeHistogram::SubBuckets;
+}
+
+void TestEmpty()
+{
+    FrameTimeHistogram histogram;
+    UNIT_TEST_CHECK(histogram.Count() == 0);
+    UNIT_TEST_CHECK(histogram.Mean() == 0.0);
+    UNIT_TEST_CHECK(histogram.Max() == 0);
+    UNIT_TEST_CHECK(histogram.Percentile(50.0) == 0);
+}
+
+void TestExactValues()
+{
+    // Values below 2 * SubBuckets have their own bucket.
+    FrameTimeHistogram histogram;
+    for (uint32_t value = 1; value <= 2 * FrameTimeHistogram::SubBuckets - 1; value++)
+    {
+        histogram.Record(value);
+    }
+
+    UNIT_TEST_CHECK(histogram.Count() == 63);
+    UNIT_TEST_CHECK(histogram.Mean() == 32.0);
+    UNIT_TEST_CHECK(histogram.Percentile(0.0) == 1);
+    UNIT_TEST_CHECK(histogram.Percentile(50.0) == 32);
+    UNIT_TEST_CHECK(histogram.Percentile(90.0) == 57);
+    UNIT_TEST_CHECK(histogram.Percentile(100.0) == 63);
+
+    // Out of range percentiles are clamped to the lowest and highest value.
+    UNIT_TEST_CHECK(histogram.Percentile(-10.0) == 1);
+    UNIT_TEST_CHECK(histogram.Percentile(200.0) == 63);
+}
+
+void TestResolution()
+{
+    // Check the values around each power of two, paired with a larger value so the result isn't clamped to Max().
+    FrameTimeHistogram histogram;
+    for (uint32_t bit = 0; bit < 26; bit++)
+    {
+        for (uint32_t offset : {0u, 1u, 2u, 3u})
+        {
+            for (auto value : {(1u << bit) - 1 + offset, (1u << bit) + (1u << bit) / 2 + offset})
+            {
+                if (value >= FrameTimeHistogram::MaxValue)
+                {
+                    continue;
+                }
+
+                histogram.Reset();
+                histogram.Record(value);
+                histogram.Record(FrameTimeHistogram::MaxValue);
+                UNIT_TEST_CHECK(IsWithinResolution(histogram.Percentile(50.0), value));
+            }
+        }
+    }
+}
+
+void TestPercentiles()
+{
+    FrameTimeHistogram histogram;
+    for (uint32_t value = 1; value <= 100000; value++)
+    {
+        histogram.Record(value);
+    }
+
+    UNIT_TEST_CHECK(histogram.Mean() == 50000.5);
+    UNIT_TEST_CHECK(IsWithinResolution(histogram.Percentile(50.0), 50000));
+    UNIT_TEST_CHECK(IsWithinResolution(histogram.Percentile(95.0), 95000));
+    UNIT_TEST_CHECK(IsWithinResolution(histogram.Percentile(99.0), 99000));
+    UNIT_TEST_CHECK(IsWithinResolution(histogram.Percentile(99.9), 99900));
+
+    // The highest bucket is limited to the exact maximum.
+    UNIT_TEST_CHECK(histogram.Percentile(100.0) == 100000);
+    UNIT_TEST_CHECK(histogram.Max() == 100000);
+
+    // A few outliers only show up in the highest percentiles.
+    histogram.Reset();
+    for (int frame = 0; frame < 990; frame++)
+    {
+        histogram.Record(16667);
+    }
+    for (int frame = 0; frame < 10; frame++)
+    {
+        histogram.Record(50000);
+    }
+
+    UNIT_TEST_CHECK(IsWithinResolution(histogram.Percentile(50.0), 16667));
+    UNIT_TEST_CHECK(IsWithinResolution(histogram.Percentile(99.0), 16667));
+    UNIT_TEST_CHECK(histogram.Percentile(99.1) == 50000);
+}
+
+void TestAddAndClamp()
+{
+    FrameTimeHistogram first;
+    FrameTimeHistogram second;
+    first.Record(100);
+    first.Record(300);
+    second.Record(FrameTimeHistogram::MaxValue + 1000);
+
+    // Values above the maximum are counted as the maximum.
+    UNIT_TEST_CHECK(second.Max() == FrameTimeHistogram::MaxValue);
+
+    first.Add(second);
+    UNIT_TEST_CHECK(first.Count() == 3);
+    UNIT_TEST_CHECK(first.Max() == FrameTimeHistogram::MaxValue);
+    UNIT_TEST_CHECK(first.Mean() == (400.0 + FrameTimeHistogram::MaxValue) / 3.0);
+    UNIT_TEST_CHECK(IsWithinResolution(first.Percentile(50.0), 300));
+    UNIT_TEST_CHECK(first.Percentile(100.0) == FrameTimeHistogram::MaxValue);
+
+    first.Reset();
+    UNIT_TEST_CHECK(first.Count() == 0 && first.Max() == 0 && first.Percentile(100.0) == 0);
+}
+
+} // namespace
+
+int main()
+{
+    TestEmpty();
+    TestExactValues();
+    TestResolution();
+    TestPercentiles();
+    TestAddAndClamp();
+
+    return UnitTest::Result();
+}
@@ -0,0 +1,212 @@
+/**
+ * @file MeshGovernorTest.cpp
+ * @brief Checks the mesh size ladder and the step down/step up hysteresis of MeshGovernor.
+ *
+ * The governor takes the current time as a parameter, so the test simulates frames at a fixed rate with a
+ * constant render time each, which makes the moving average equal to that time.
+ */
+
+#include "UnitTest.h"
+
+#include "MeshGovernor.h"
+
+#include <Poco/AutoPtr.h>
+
+#include <Poco/Util/MapConfiguration.h>
+
+namespace {
+
+constexpr double FrameTime{1.0 / 60.0}; //!< Simulated frame period in seconds.
+constexpr double Budget{10.0}; //!< Configured budget in milliseconds.
+
+/**
+ * @brief Creates a configuration with the governor enabled.
+ * @param budget The budget in milliseconds, 0 to derive it from the frame rate.
+ * @param ladder The ladder setting.
+ * @return The configuration, as the "projectM" view passed to the governor.
+ */
+Poco::AutoPtr<Poco::Util::MapConfiguration> CreateConfig(double budget, const std::string& ladder)
+{
+    Poco::AutoPtr<Poco::Util::MapConfiguration> config(new Poco::Util::MapConfiguration);
+    config->setBool("meshGovernor.enabled", true);
+    config->setDouble("meshGovernor.budget", budget);
+    config->setString("meshGovernor.ladder", ladder);
+
+    return config;
+}
+
+/**
+ * @brief Renders frames with a constant render time.
+ * @param governor The governor to feed.
+ * @param milliseconds The render time of each frame.
+ * @param now The simulated time, advanced by the number of frames.
+ * @param seconds The duration to simulate.
+ */
+void Render(MeshGovernor& governor, double milliseconds, double& now, double seconds)
+{
+    auto end = now + seconds;
+    while (now < end)
+    {
+        now += FrameTime;
+        governor.FrameRendered(milliseconds, now);
+    }
+}
+
+bool HasMeshSize(const MeshGovernor& governor, size_t width, size_t height)
+{
+    return governor.MeshWidth() == width && governor.MeshHeight() == height;
+}
+
+void TestLadder()
+{
+    // Unsorted with invalid entries, which are skipped.
+    auto config = CreateConfig(Budget, "32x18, foo, 64x36,0x10,48x27,96x54");
+    double now{0.0};
+    MeshGovernor governor(*config, now);
+    UNIT_TEST_CHECK(governor.Enabled());
+
+    // Only sizes with fewer vertices than the configured one are used, largest first.
+    governor.ConfiguredMeshSize(64, 36);
+    governor.PresetSwitched("a.milk", now);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+
+    Render(governor, 2.0 * Budget, now, 10.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 32, 18));
+
+    // The bottom of the ladder is kept, however long the preset takes.
+    Render(governor, 2.0 * Budget, now, 10.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 32, 18));
+
+    // A smaller configured size shortens the ladder, which clamps the level.
+    governor.ConfiguredMeshSize(48, 27);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 32, 18));
+
+    governor.Disable();
+    UNIT_TEST_CHECK(!governor.Enabled());
+    UNIT_TEST_CHECK(HasMeshSize(governor, 48, 27));
+}
+
+void TestStepDown()
+{
+    auto config = CreateConfig(Budget, "64x36,48x27,32x18");
+    double now{100.0};
+    MeshGovernor governor(*config, now);
+    governor.ConfiguredMeshSize(96, 54);
+    governor.PresetSwitched("a.milk", now);
+
+    // Neither the settle time nor the measuring delay trigger a change.
+    Render(governor, 2.0 * Budget, now, MeshGovernor::SettleTime + MeshGovernor::DecreaseDelay - 2.0 * FrameTime);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 96, 54));
+
+    Render(governor, 2.0 * Budget, now, 3.0 * FrameTime);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+
+    // Each step restarts the settle time.
+    Render(governor, 2.0 * Budget, now, MeshGovernor::SettleTime + MeshGovernor::DecreaseDelay - 2.0 * FrameTime);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+    Render(governor, 2.0 * Budget, now, 3.0 * FrameTime);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 48, 27));
+
+    // Render times within the budget keep the level.
+    Render(governor, Budget, now, 20.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 48, 27));
+}
+
+void TestStepUp()
+{
+    auto config = CreateConfig(Budget, "64x36");
+    double now{0.0};
+    MeshGovernor governor(*config, now);
+    governor.ConfiguredMeshSize(96, 54);
+    governor.PresetSwitched("a.milk", now);
+
+    Render(governor, 2.0 * Budget, now, 5.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+
+    // The larger mesh has 97 * 55 instead of 65 * 37 vertices, so the estimated time would be above
+    // IncreaseLoad times the budget. Neither stepping up nor down, however long it takes.
+    const double vertexRatio = 97.0 * 55.0 / (65.0 * 37.0);
+    const double threshold = MeshGovernor::IncreaseLoad * Budget / vertexRatio;
+    Render(governor, threshold * 1.05, now, 60.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+
+    // Below the threshold, the mesh is stepped up only after the increase delay.
+    governor.PresetSwitched("a.milk", now);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+    Render(governor, threshold * 0.95, now, MeshGovernor::SettleTime + MeshGovernor::IncreaseDelay - 2.0 * FrameTime);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+    Render(governor, threshold * 0.95, now, 3.0 * FrameTime);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 96, 54));
+}
+
+void TestPresetLevels()
+{
+    auto config = CreateConfig(Budget, "64x36,32x18");
+    double now{0.0};
+    MeshGovernor governor(*config, now);
+    governor.ConfiguredMeshSize(96, 54);
+
+    governor.PresetSwitched("heavy.milk", now);
+    Render(governor, 2.0 * Budget, now, 5.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 32, 18));
+
+    // Each preset starts at the level it had when it was displayed last.
+    governor.PresetSwitched("light.milk", now);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 96, 54));
+    Render(governor, 1.0, now, 3.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 96, 54));
+
+    governor.PresetSwitched("heavy.milk", now);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 32, 18));
+}
+
+void TestTargetFPS()
+{
+    // Without a configured budget, half the frame time is used.
+    auto config = CreateConfig(0.0, "64x36");
+    double now{0.0};
+    MeshGovernor governor(*config, now);
+    governor.ConfiguredMeshSize(96, 54);
+    governor.PresetSwitched("a.milk", now);
+
+    governor.TargetFPS(30);
+    Render(governor, 15.0, now, 5.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 96, 54));
+
+    governor.TargetFPS(60);
+    Render(governor, 15.0, now, 5.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+
+    // Unlimited uses the default of 60 FPS.
+    governor.PresetSwitched("b.milk", now);
+    governor.TargetFPS(0);
+    Render(governor, 9.0, now, 5.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 64, 36));
+}
+
+void TestDisabled()
+{
+    Poco::AutoPtr<Poco::Util::MapConfiguration> config(new Poco::Util::MapConfiguration);
+    double now{0.0};
+    MeshGovernor governor(*config, now);
+    governor.ConfiguredMeshSize(96, 54);
+    governor.PresetSwitched("a.milk", now);
+
+    UNIT_TEST_CHECK(!governor.Enabled());
+    Render(governor, 1000.0, now, 10.0);
+    UNIT_TEST_CHECK(HasMeshSize(governor, 96, 54));
+}
+
+} // namespace
+
+int main()
+{
+    TestLadder();
+    TestStepDown();
+    TestStepUp();
+    TestPresetLevels();
+    TestTargetFPS();
+    TestDisabled();
+
+    return UnitTest::Result();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+/**
+ * @file UnitTest.h
+ * @brief Minimal check macros for the unit test executables.
+ *
+ * Each test is a plain executable registered with CTest. Failed checks print the location and the
+ * expression, but don't abort, so a single run reports all failures. main() returns UnitTest::Result().
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace UnitTest {
+
+/**
+ * @brief Returns the number of failed checks.
+ * @return A reference to the failure counter.
+ */
+inline int& Failures()
+{
+    static int failures{0};
+    return failures;
+}
+
+/**
+ * @brief Records a failed check.
+ * @param file Source file of the check.
+ * @param line Source line of the check.
+ * @param expression The failed expression.
+ */
+inline void Fail(const char* file, int line, const char* expression)
+{
+    std::fprintf(stderr, "%s:%d: Check failed: %s\n", file, line, expression);
+    Failures()++;
+}
+
+/**
+ * @brief Prints a summary and returns the process exit code.
+ * @return EXIT_SUCCESS if all checks passed, EXIT_FAILURE otherwise.
+ */
+inline int Result()
+{
+    if (Failures() > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed.\n", Failures());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace UnitTest
+
+#define UNIT_TEST_CHECK(condition)                             \
+    do                                                         \
+    {                                                          \
+        if (!(condition))                                      \
+        {                                                      \
+            UnitTest::Fail(__FILE__, __LINE__, #condition);    \
+        }                                                      \
+    } while (false)